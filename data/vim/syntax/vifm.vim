@@ -17,11 +17,11 @@ syntax keyword vifmCommand contained
 		\ alink apropos bmark bmarks bmgo cds change chmod chown clone compare
 		\ cope[n] co[py] cq[uit] d[elete] delbmarks delm[arks] delsession di[splay]
 		\ dirs e[dit] el[se] empty en[dif] exi[t] file fin[d] fini[sh] go[to] gr[ep]
-		\ h[elp] hideui histnext his[tory] histprev keepsel jobs locate ls lstrash
-		\ marks media mes[sages] mkdir m[ove] noh[lsearch] on[ly] plugin plugins
-		\ popd pushd pu[t] pw[d] qa[ll] q[uit] redr[aw] reg[isters] regular rename
-		\ restart restore rlink screen sh[ell] siblnext siblprev sor[t] sp[lit]
-		\ st[op] s[ubstitute] tabc[lose] tabm[ove] tabname tabnew tabn[ext]
+		\ h[elp] hideui histnext his[tory] histprev keepsel jobs jump locate ls
+		\ lstrash marks media mes[sages] mkdir m[ove] noh[lsearch] on[ly] plugin
+		\ plugins popd pushd pu[t] pw[d] qa[ll] q[uit] redr[aw] reg[isters] regular
+		\ rename restart restore rlink screen sh[ell] siblnext siblprev sor[t]
+		\ sp[lit] st[op] s[ubstitute] tabc[lose] tabm[ove] tabname tabnew tabn[ext]
 		\ tabo[nly] tabp[revious] touch tr trashes tree session sync undol[ist]
 		\ ve[rsion] vie[w] vifm vs[plit] winc[md] w[rite] wq wqa[ll] xa[ll] x[it]
 		\ y[ank]
@@ -30,13 +30,13 @@ syntax keyword vifmCommandCN contained
 		\ alink apropos bmark bmarks bmgo cds change chmod chown clone compare
 		\ cope[n] co[py] cq[uit] d[elete] delbmarks delm[arks] delsession di[splay]
 		\ dirs e[dit] el[se] empty en[dif] exi[t] file fin[d] fini[sh] go[to] gr[ep]
-		\ h[elp] hideui histnext his[tory] histprev jobs locate ls lstrash marks
-		\ media mes[sages] mkdir m[ove] noh[lsearch] on[ly] popd pushd pu[t] pw[d]
-		\ qa[ll] q[uit] redr[aw] reg[isters] regular rename restart restore rlink
-		\ screen sh[ell] siblnext siblprev sor[t] sp[lit] s[ubstitute] tabc[lose]
-		\ tabm[ove] tabname tabnew tabn[ext] tabo[nly] tabp[revious] touch tr
-		\ trashes tree session sync undol[ist] ve[rsion] vie[w] vifm vs[plit]
-		\ winc[md] w[rite] wq wqa[ll] xa[ll] x[it] y[ank]
+		\ h[elp] hideui histnext his[tory] histprev jobs jump locate ls lstrash
+		\ marks media mes[sages] mkdir m[ove] noh[lsearch] on[ly] popd pushd pu[t]
+		\ pw[d] qa[ll] q[uit] redr[aw] reg[isters] regular rename restart restore
+		\ rlink screen sh[ell] siblnext siblprev sor[t] sp[lit] s[ubstitute]
+		\ tabc[lose] tabm[ove] tabname tabnew tabn[ext] tabo[nly] tabp[revious]
+		\ touch tr trashes tree session sync undol[ist] ve[rsion] vie[w] vifm
+		\ vs[plit] winc[md] w[rite] wq wqa[ll] xa[ll] x[it] y[ank]
 		\ nextgroup=vifmArgsCN
 
 " commands that might be prepended to a command without changing everything else
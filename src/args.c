@@ -61,6 +61,7 @@ static struct option long_opts[] = {
 	{ "choose-dir",   required_argument, .flag = NULL, .val = 'D' },
 	{ "delimiter",    required_argument, .flag = NULL, .val = 'd' },
 	{ "on-choose",    required_argument, .flag = NULL, .val = 'o' },
+	{ "startuptime",  required_argument, .flag = NULL, .val = 'S' },
 
 #ifdef ENABLE_REMOTE_CMDS
 	{ "server-list",  no_argument,       .flag = NULL, .val = 'L' },
@@ -147,6 +148,9 @@ args_parse(args_t *args, int argc, char *argv[], const char dir[])
 			case 'n': /* --no-configs */
 				args->no_configs = 1;
 				break;
+			case 'S': /* --startuptime <path> */
+				args->startup_time_path = optarg;
+				break;
 
 			case 's': /* --select <path> */
 				handle_arg_or_fail(optarg, 1, dir, args);
@@ -418,6 +422,9 @@ show_help_msg(const char wrong_arg[])
 	puts("    permissions allow to open it for writing, then logging of early");
 	puts("    initialization (before configuration directories are determined)");
 	puts("    is put there.\n");
+	puts("  vifm --startuptime <path>");
+	puts("    write timings of startup phases, sourced files and loaded plugins");
+	puts("    into the file.\n");
 
 #ifdef ENABLE_REMOTE_CMDS
 	puts("  vifm --server-list");
@@ -42,6 +42,8 @@ typedef struct
 	int logging;            /* Enable logging. */
 	char *startup_log_path; /* Path for startup log (during initialization). */
 
+	const char *startup_time_path; /* Where to record timings of startup. */
+
 	int no_configs;  /* Skip reading configuration files. */
 	int file_picker; /* Use predefined $VIFM/vimfiles for list of files. */
 
@@ -21,19 +21,20 @@
 
 #ifdef _WIN32
 #include <windows.h>
+#include <io.h> /* _pipe() */
 #endif
 
-#include <fcntl.h> /* open() */
+#include <fcntl.h> /* FD_CLOEXEC F_SETFD O_* fcntl() open() */
 #include <sys/stat.h> /* O_RDONLY */
 #include <sys/types.h> /* pid_t ssize_t */
 #ifndef _WIN32
 #include <sys/wait.h> /* waitpid() */
 #endif
 #include <signal.h> /* SIG* kill() */
-#include <unistd.h> /* execve() fork() setsid() */
+#include <unistd.h> /* execve() fork() pipe() read() setsid() */
 
 #include <assert.h> /* assert() */
-#include <errno.h> /* errno */
+#include <errno.h> /* EAGAIN EINTR errno */
 #include <stddef.h> /* NULL wchar_t */
 #include <stdint.h> /* uintptr_t */
 #include <stdlib.h> /* EXIT_FAILURE _Exit() free() malloc() */
@@ -57,6 +58,7 @@
 #include "utils/utils.h"
 #include "cmd_completion.h"
 #include "status.h"
+#include "trace.h"
 
 /**
  * This unit implements three kinds of backgrounded operations:
@@ -106,9 +108,13 @@
  * correct initialization/cleanup. */
 typedef struct
 {
-	bg_task_func func; /* Function to execute in a background thread. */
-	void *args;        /* Argument to pass. */
-	bg_job_t *job;     /* Job identifier that corresponds to the task. */
+	bg_task_func func;            /* Function to execute in a background thread
+	                                 or NULL. */
+	bg_output_task_func out_func; /* Function to execute when func is NULL. */
+	FILE *out;                    /* Output stream for out_func. */
+	void *args;                   /* Argument to pass. */
+	bg_job_t *job;                /* Job identifier that corresponds to the
+	                                 task. */
 }
 background_task_args;
 
@@ -125,9 +131,12 @@ static void rip_children(void);
 static void rip_child(pid_t pid, int status);
 static void report_error_msg(const char title[], const char text[]);
 #endif
+static bg_job_t * start_external_job(const char cmd[], BgJobFlags flags,
+		FILE *in);
 static bg_job_t * launch_external(const char cmd[], BgJobFlags flags,
-		ShellRequester by);
+		ShellRequester by, FILE *in);
 static void append_error_msg(bg_job_t *job, const char err_msg[]);
+static int make_task_pipe(FILE **read_end, FILE **write_end);
 static void place_on_job_bar(bg_job_t *job);
 static void get_off_job_bar(bg_job_t *job);
 static bg_job_t * add_background_job(pid_t pid, const char cmd[],
@@ -857,7 +866,7 @@ bg_run_external(const char cmd[], int skip_errors, ShellRequester by,
 	}
 
 	const BgJobFlags flags = (input == NULL ? BJF_NONE : BJF_SUPPLY_INPUT);
-	bg_job_t *job = launch_external(command, flags, by);
+	bg_job_t *job = launch_external(command, flags, by, NULL);
 	free(command);
 	if(job == NULL)
 	{
@@ -883,7 +892,24 @@ bg_run_external(const char cmd[], int skip_errors, ShellRequester by,
 bg_job_t *
 bg_run_external_job(const char cmd[], BgJobFlags flags)
 {
-	bg_job_t *job = launch_external(cmd, flags, SHELL_BY_APP);
+	return start_external_job(cmd, flags, NULL);
+}
+
+bg_job_t *
+bg_run_external_job_in(const char cmd[], BgJobFlags flags, FILE *in)
+{
+	return start_external_job(cmd, flags & ~BJF_SUPPLY_INPUT, in);
+}
+
+/* Implementation of bg_run_external_job() and bg_run_external_job_in().
+ * Returns the job or NULL on error. */
+static bg_job_t *
+start_external_job(const char cmd[], BgJobFlags flags, FILE *in)
+{
+	const ShellRequester by = (flags & BJF_USER_SHELL)
+	                        ? SHELL_BY_USER
+	                        : SHELL_BY_APP;
+	bg_job_t *job = launch_external(cmd, flags, by, in);
 	if(job == NULL)
 	{
 		return NULL;
@@ -904,9 +930,11 @@ bg_run_external_job(const char cmd[], BgJobFlags flags)
 	return job;
 }
 
-/* Starts a new external command job.  Returns the new job or NULL on error. */
+/* Starts a new external command job.  Standard input is redirected from the
+ * file if it's not NULL.  Returns the new job or NULL on error. */
 static bg_job_t *
-launch_external(const char cmd[], BgJobFlags flags, ShellRequester by)
+launch_external(const char cmd[], BgJobFlags flags, ShellRequester by,
+		FILE *in)
 {
 	/* TODO: simplify this function (launch_external()) somehow, maybe split in
 	 *       two. */
@@ -954,6 +982,12 @@ launch_external(const char cmd[], BgJobFlags flags, ShellRequester by)
 		}
 	}
 
+	if(in != NULL)
+	{
+		/* Also flushes the stream. */
+		rewind(in);
+	}
+
 	if((pid = fork()) == -1)
 	{
 		close(error_pipe[0]);
@@ -1001,6 +1035,11 @@ launch_external(const char cmd[], BgJobFlags flags, ShellRequester by)
 			/* Close write end of pipe. */
 			close(input_pipe[1]);
 		}
+		else if(in != NULL && dup2(fileno(in), STDIN_FILENO) == -1)
+		{
+			perror("dup2");
+			_Exit(EXIT_FAILURE);
+		}
 
 		if(capture_output)
 		{
@@ -1017,7 +1056,7 @@ launch_external(const char cmd[], BgJobFlags flags, ShellRequester by)
 		int nullfd = open("/dev/null", O_RDWR);
 		if(nullfd != -1)
 		{
-			if(!supply_input && dup2(nullfd, STDIN_FILENO) == -1)
+			if(!supply_input && in == NULL && dup2(nullfd, STDIN_FILENO) == -1)
 			{
 				perror("dup2 for stdin");
 				_Exit(EXIT_FAILURE);
@@ -1045,10 +1084,17 @@ launch_external(const char cmd[], BgJobFlags flags, ShellRequester by)
 			_Exit(EXIT_FAILURE);
 		}
 
+		/* Commands composed by the application might rely on POSIX syntax. */
+		char *sh = cfg.shell;
+		if(by != SHELL_BY_USER && (flags & BJF_POSIX_SHELL))
+		{
+			sh = "/bin/sh";
+		}
+
 		prepare_for_exec();
 		char *sh_flag = (by == SHELL_BY_USER ? cfg.shell_cmd_flag : "-c");
-		execve(get_execv_path(cfg.shell),
-				make_execv_array(cfg.shell, sh_flag, strdup(cmd)), environ);
+		execve(get_execv_path(sh), make_execv_array(sh, sh_flag, strdup(cmd)),
+				environ);
 		_Exit(127);
 	}
 
@@ -1118,6 +1164,20 @@ launch_external(const char cmd[], BgJobFlags flags, ShellRequester by)
 		return NULL;
 	}
 
+	/* Handle of the file is duplicated to be able to close it like a pipe. */
+	if(in != NULL)
+	{
+		rewind(in);
+		if(!DuplicateHandle(GetCurrentProcess(),
+					(HANDLE)_get_osfhandle(_fileno(in)), GetCurrentProcess(),
+					&startup.hStdInput, 0, TRUE, DUPLICATE_SAME_ACCESS))
+		{
+			CloseHandle(herr);
+			CloseHandle(hnul);
+			return NULL;
+		}
+	}
+
 	HANDLE hout = INVALID_HANDLE_VALUE;
 	if(capture_output)
 	{
@@ -1236,6 +1296,8 @@ bg_execute(const char descr[], const char op_descr[], int total, int important,
 	}
 
 	task_args->func = task_func;
+	task_args->out_func = NULL;
+	task_args->out = NULL;
 	task_args->args = args;
 	task_args->job = add_background_job(WRONG_PID, descr, (uintptr_t)NO_JOB_ID,
 			(uintptr_t)NO_JOB_ID, important ? BJT_OPERATION : BJT_TASK, 1);
@@ -1270,6 +1332,104 @@ bg_execute(const char descr[], const char op_descr[], int total, int important,
 	return ret;
 }
 
+bg_job_t *
+bg_execute_capture(const char descr[], bg_output_task_func task_func,
+		void *args)
+{
+	background_task_args *const task_args = malloc(sizeof(*task_args));
+	if(task_args == NULL)
+	{
+		return NULL;
+	}
+
+	FILE *read_end, *write_end;
+	if(make_task_pipe(&read_end, &write_end) != 0)
+	{
+		free(task_args);
+		return NULL;
+	}
+
+	bg_job_t *const job = add_background_job(WRONG_PID, descr,
+			(uintptr_t)NO_JOB_ID, (uintptr_t)NO_JOB_ID, BJT_TASK, 1);
+	if(job == NULL)
+	{
+		fclose(read_end);
+		fclose(write_end);
+		free(task_args);
+		return NULL;
+	}
+
+	job->output = read_end;
+	bg_job_incref(job);
+
+	task_args->func = NULL;
+	task_args->out_func = task_func;
+	task_args->out = write_end;
+	task_args->args = args;
+	task_args->job = job;
+
+	pthread_t id;
+	if(pthread_create(&id, NULL, &background_task_bootstrap, task_args) != 0)
+	{
+		fclose(write_end);
+		free(task_args);
+		mark_job_finished(job, 1);
+		bg_job_decref(job);
+		return NULL;
+	}
+
+	return job;
+}
+
+/* Creates a pipe for passing output of a task to the main thread.  Returns zero
+ * on success, otherwise non-zero is returned. */
+static int
+make_task_pipe(FILE **read_end, FILE **write_end)
+{
+	int fds[2];
+#ifndef _WIN32
+	if(pipe(fds) != 0)
+	{
+		return 1;
+	}
+	/* External commands shouldn't inherit the pipe or the reader won't see end
+	 * of the stream until they exit. */
+	(void)fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+	(void)fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+#else
+	if(_pipe(fds, 64*1024, O_BINARY | O_NOINHERIT) != 0)
+	{
+		return 1;
+	}
+#endif
+
+	*read_end = fdopen(fds[0], "rb");
+	*write_end = fdopen(fds[1], "wb");
+	if(*read_end == NULL || *write_end == NULL)
+	{
+		if(*read_end == NULL)
+		{
+			close(fds[0]);
+		}
+		else
+		{
+			fclose(*read_end);
+		}
+
+		if(*write_end == NULL)
+		{
+			close(fds[1]);
+		}
+		else
+		{
+			fclose(*write_end);
+		}
+		return 1;
+	}
+
+	return 0;
+}
+
 /* Makes the job appear on the job bar. */
 static void
 place_on_job_bar(bg_job_t *job)
@@ -1318,6 +1478,7 @@ add_background_job(pid_t pid, const char cmd[], uintptr_t err, uintptr_t data,
 	new->running = 1;
 	new->use_count = 0;
 	new->exit_code = -1;
+	new->trace_start = trace_begin();
 
 	new->input = NULL;
 	new->output = NULL;
@@ -1373,7 +1534,17 @@ background_task_bootstrap(void *arg)
 	block_all_thread_signals();
 	set_current_job(task_args->job);
 
-	task_args->func(&task_args->job->bg_op, task_args->args);
+	if(task_args->func != NULL)
+	{
+		task_args->func(&task_args->job->bg_op, task_args->args);
+	}
+	else
+	{
+		task_args->out_func(&task_args->job->bg_op, task_args->out,
+				task_args->args);
+		/* This signals end of output to the reader. */
+		fclose(task_args->out);
+	}
 
 	/* Mark task as finished normally. */
 	mark_job_finished(task_args->job, 0);
@@ -1554,6 +1725,58 @@ bg_job_wait(bg_job_t *job)
 #endif
 }
 
+int
+bg_job_read_output(bg_job_t *job, char buf[], size_t buf_len)
+{
+	const int fd = fileno(job->output);
+
+	selector_t *const selector = selector_alloc();
+	if(selector == NULL)
+	{
+		return 0;
+	}
+
+#ifndef _WIN32
+	selector_add(selector, fd);
+#else
+	HANDLE hpipe = (HANDLE)_get_osfhandle(fd);
+	selector_add(selector, hpipe);
+#endif
+
+	const int has_data = selector_wait(selector, 0);
+	selector_free(selector);
+	if(!has_data)
+	{
+		return 0;
+	}
+
+#ifdef _WIN32
+	/* Simulate asynchronous reading by not reading more than stream has. */
+	DWORD bytes_available = 0;
+	if(!PeekNamedPipe(hpipe, NULL, 0, NULL, &bytes_available, NULL))
+	{
+		return -1;
+	}
+	if(bytes_available == 0)
+	{
+		return 0;
+	}
+	if(bytes_available < buf_len)
+	{
+		buf_len = bytes_available;
+	}
+#endif
+
+	/* Using read() instead of fread(), because the latter can block trying to
+	 * fill the buffer completely. */
+	const ssize_t len = read(fd, buf, buf_len);
+	if(len < 0)
+	{
+		return (errno == EAGAIN || errno == EINTR ? 0 : -1);
+	}
+	return (len == 0 ? -1 : (int)len);
+}
+
 /* Retrieves exit code of a process associated with the job.  Returns zero on
  * success (job has just finished), otherwise non-zero is returned. */
 static int
@@ -1586,9 +1809,15 @@ static void
 mark_job_finished(bg_job_t *job, int exit_code)
 {
 	pthread_spin_lock(&job->status_lock);
+	const int was_running = job->running;
 	job->running = 0;
 	job->exit_code = exit_code;
 	pthread_spin_unlock(&job->status_lock);
+
+	if(was_running)
+	{
+		trace_end(TP_BG_JOB, job->trace_start);
+	}
 }
 
 void
@@ -1656,6 +1885,16 @@ bg_op_cancel(bg_op_t *bg_op)
 	return was_cancelled;
 }
 
+void
+bg_task_report_error(const char msg[])
+{
+	bg_job_t *const job = pthread_getspecific(current_job);
+	if(job != NULL)
+	{
+		append_error_msg(job, msg);
+	}
+}
+
 int
 bg_op_cancelled(bg_op_t *bg_op)
 {
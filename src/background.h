@@ -60,6 +60,8 @@ typedef enum
 	BJF_CAPTURE_OUT     = 1 << 3, /* Capture output stream(s). */
 	BJF_MERGE_STREAMS   = 1 << 4, /* Merge error stream into output stream. */
 	BJF_KEEP_SESSION    = 1 << 5, /* Do not detach from terminal session. */
+	BJF_USER_SHELL      = 1 << 6, /* Invoke shell as if requested by the user. */
+	BJF_POSIX_SHELL     = 1 << 7, /* Use /bin/sh unless it's user's command. */
 }
 BgJobFlags;
 
@@ -99,6 +101,8 @@ typedef struct bg_job_t
 	int use_count; /* Count of uses of this job entry. */
 	int exit_code; /* Exit code of external command. */
 
+	long long trace_start; /* When the job was started for tracing purposes. */
+
 	FILE *input;  /* File stream of standard input or NULL. */
 	FILE *output; /* File stream of standard output or NULL. */
 
@@ -131,6 +135,9 @@ bg_job_t;
 /* Background task entry point function signature. */
 typedef void (*bg_task_func)(bg_op_t *bg_op, void *arg);
 
+/* Signature of entry point of a background task that produces output. */
+typedef void (*bg_output_task_func)(bg_op_t *bg_op, FILE *out, void *arg);
+
 /* List of background jobs. */
 extern bg_job_t *bg_jobs;
 
@@ -150,6 +157,14 @@ int bg_run_external(const char cmd[], int skip_errors, ShellRequester by,
  * the job or NULL on error. */
 bg_job_t * bg_run_external_job(const char cmd[], BgJobFlags flags);
 
+/* Same as bg_run_external_job(), but standard input of the command is
+ * redirected from the file (BJF_SUPPLY_INPUT flag is ignored).  Use this
+ * instead of writing into job's input when output is read after writing, or
+ * the command might block on writing its output.  Returns the job or NULL on
+ * error. */
+bg_job_t * bg_run_external_job_in(const char cmd[], BgJobFlags flags,
+		FILE *in);
+
 struct cancellation_t;
 
 /* Runs command in background and displays its errors to a user.  To determine
@@ -176,6 +191,15 @@ void bg_check(void);
 int bg_execute(const char descr[], const char op_descr[], int total,
 		int important, bg_task_func task_func, void *args);
 
+/* Starts new background task, which is run in a separate thread and whose
+ * output is available via output field of the job and bg_job_read_output()
+ * like for bg_run_external_job() with BJF_CAPTURE_OUT flag.  The output stream
+ * is closed after the task function returns.  Upon creation the job has one
+ * extra use, which needs to be decremented for it to be freed.  Returns the job
+ * or NULL on error (the task isn't started in this case). */
+bg_job_t * bg_execute_capture(const char descr[],
+		bg_output_task_func task_func, void *args);
+
 /* Checks whether there are any internal jobs (important_only is non-zero) or
  * jobs or tasks (important_only is zero) running in background.  External
  * applications whose state is tracked are always ignored by this function. */
@@ -207,6 +231,12 @@ int bg_job_was_killed(bg_job_t *job);
  * Returns zero on success, otherwise non-zero is returned. */
 int bg_job_wait(bg_job_t *job);
 
+/* Reads at most buf_len bytes of captured output of the job, but only as much
+ * as can be read without blocking.  Returns number of read bytes, zero if there
+ * is nothing to read at the moment or negative number on reaching end of the
+ * stream. */
+int bg_job_read_output(bg_job_t *job, char buf[], size_t buf_len);
+
 /* Increases use counter of the job.  Doing this prevents object deletion while
  * it's still in use. */
 void bg_job_incref(bg_job_t *job);
@@ -232,6 +262,10 @@ void bg_op_changed(bg_op_t *bg_op);
  * operation change. */
 void bg_op_set_descr(bg_op_t *bg_op, const char descr[]);
 
+/* Adds error message to errors of the background task that runs on the current
+ * thread to display it to the user.  Does nothing outside of tasks. */
+void bg_task_report_error(const char msg[]);
+
 /* Convenience method to check for background job cancellation, use
  * lock -> <check> -> unlock -> changed sequence for more generic cases.
  * Returns non-zero if cancellation requested, otherwise zero is returned. */
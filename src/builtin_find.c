@@ -0,0 +1,590 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "builtin_find.h"
+
+#include <stddef.h> /* NULL size_t */
+#include <stdio.h> /* FILE fflush() fwrite() snprintf() */
+#include <stdlib.h> /* calloc() free() realloc() */
+#include <string.h> /* memcpy() strcmp() strdup() strlen() */
+
+#include "compat/fs_limits.h"
+#include "compat/pthread.h"
+#include "compat/reallocarray.h"
+#include "utils/cancellation.h"
+#include "utils/darray.h"
+#include "utils/matcher.h"
+#include "utils/path.h"
+#include "utils/str.h"
+#include "utils/string_array.h"
+#include "utils/utils.h"
+#include "utils/walker.h"
+#include "background.h"
+#include "filelist.h"
+#include "flist_stream.h"
+
+enum
+{
+	NWORKERS = 4,                /* Number of threads that traverse trees. */
+	FLUSH_SIZE = 4*1024,         /* Amount of buffered output to write out. */
+	SNAPSHOT_TTL = 10*1000,      /* For how long snapshot is used (in ms). */
+	MAX_SNAPSHOT_SIZE = 1000000, /* Maximum number of paths in a snapshot. */
+	CANCEL_CHECK_PERIOD = 1024,  /* How often scanning of snapshot is checked for
+	                                being cancelled. */
+};
+
+/* Listing of a directory tree. */
+typedef struct
+{
+	char *base;      /* Directory that was traversed. */
+	long long taken; /* When the listing was made (in ms). */
+	char **paths;    /* Paths of all entries in the form "./dir/name". */
+	int npaths;      /* Number of paths. */
+	int refs;        /* Number of users, protected by snapshot_lock. */
+}
+snapshot_t;
+
+/* State of a single traversing thread. */
+typedef struct
+{
+	matcher_t *matcher; /* Own copy of the matcher. */
+	char *out;          /* Output that wasn't written yet. */
+	size_t out_len;     /* Length of the out. */
+	size_t out_size;    /* Capacity of the out. */
+	char **recorded;    /* Visited paths to be put into a snapshot. */
+	DA_INSTANCE_FIELD(recorded); /* Declarations to enable use of DA_* on it. */
+	int overflow;       /* Whether too many paths were visited to record them. */
+}
+worker_t;
+
+/* State of searching. */
+typedef struct
+{
+	char **targets;   /* Files and directories to search in. */
+	int ntargets;     /* Number of targets. */
+	char *base;       /* Base for relative targets. */
+	int use_snapshot; /* Whether snapshot can be used and made. */
+
+	flist_stream_t *stream; /* Receiver of entries or NULL. */
+	bg_op_t *bg_op;         /* Cancellation state when there is no stream. */
+	pthread_mutex_t lock;   /* Protects fields below. */
+	FILE *out;              /* Where to print paths when there is no stream. */
+	int failed;             /* Whether writing to output has failed. */
+
+	worker_t workers[NWORKERS]; /* State of traversing threads. */
+}
+find_t;
+
+static find_t * make_find(const char pattern[], char *targets[], int ntargets,
+		const char base[], int snapshot, char **error);
+static void find_task(bg_op_t *bg_op, FILE *out, void *arg);
+static void find_producer(flist_stream_t *s, void *arg);
+static void run_find(find_t *f);
+static int is_cancelled(void *arg);
+static int visit(const walker_entry_t *entry, void *arg);
+static void record(worker_t *w, const char path[]);
+static void scan_snapshot(find_t *f, const snapshot_t *snapshot,
+		const cancellation_t *cancellation);
+static void report(find_t *f, worker_t *w, const char path[],
+		const char full_path[]);
+static void flush_output(find_t *f, worker_t *w);
+static snapshot_t * get_snapshot(const char base[]);
+static void store_snapshot(find_t *f);
+static void release_snapshot(snapshot_t *snapshot);
+static void free_recorded(worker_t *w);
+static void free_find(find_t *f);
+
+/* Protects last_snapshot and reference counters of snapshots. */
+static pthread_mutex_t snapshot_lock = PTHREAD_MUTEX_INITIALIZER;
+/* The most recent listing of a directory or NULL. */
+static snapshot_t *last_snapshot;
+
+bg_job_t *
+bfind_run(const char pattern[], char *targets[], int ntargets,
+		const char base[], int snapshot, char **error)
+{
+	find_t *const f = make_find(pattern, targets, ntargets, base, snapshot,
+			error);
+	if(f == NULL)
+	{
+		return NULL;
+	}
+
+	char *const descr = format_str("Builtin find: %s", pattern);
+	bg_job_t *const job = bg_execute_capture(descr == NULL ? pattern : descr,
+			&find_task, f);
+	free(descr);
+
+	if(job == NULL)
+	{
+		free_find(f);
+		*error = strdup("Failed to start background task");
+	}
+	return job;
+}
+
+flist_stream_t *
+bfind_stream(view_t *view, const char pattern[], char *targets[],
+		int ntargets, int snapshot, char **error)
+{
+	find_t *const f = make_find(pattern, targets, ntargets, flist_get_dir(view),
+			snapshot, error);
+	if(f == NULL)
+	{
+		return NULL;
+	}
+
+	/* The stream isn't known until the producer is started. */
+	flist_stream_t *const s = flist_stream_start_producer(view, &find_producer,
+			f);
+	if(s == NULL)
+	{
+		free_find(f);
+		*error = strdup("Failed to start background task");
+	}
+	return s;
+}
+
+void
+bfind_drop_snapshot(void)
+{
+	pthread_mutex_lock(&snapshot_lock);
+	snapshot_t *const snapshot = last_snapshot;
+	last_snapshot = NULL;
+	pthread_mutex_unlock(&snapshot_lock);
+
+	release_snapshot(snapshot);
+}
+
+/* Parses the pattern and allocates state of searching.  Returns the state or
+ * NULL on error, in which case *error is set. */
+static find_t *
+make_find(const char pattern[], char *targets[], int ntargets,
+		const char base[], int snapshot, char **error)
+{
+	if(pattern[0] == '\0')
+	{
+		*error = strdup("No pattern specified");
+		return NULL;
+	}
+
+#ifdef _WIN32
+	const int cs_by_def = 0;
+#else
+	const int cs_by_def = 1;
+#endif
+
+	matcher_t *const matcher = matcher_alloc(pattern, cs_by_def,
+			/*glob_by_def=*/1, "", error);
+	if(matcher == NULL)
+	{
+		return NULL;
+	}
+
+	/* Detection of mime types isn't thread-safe. */
+	if(matcher_is_mime(matcher))
+	{
+		matcher_free(matcher);
+		*error = strdup("Mime-type patterns aren't supported");
+		return NULL;
+	}
+
+	find_t *const f = calloc(1, sizeof(*f));
+	if(f == NULL)
+	{
+		matcher_free(matcher);
+		*error = strdup("Not enough memory");
+		return NULL;
+	}
+
+	pthread_mutex_init(&f->lock, NULL);
+	f->workers[0].matcher = matcher;
+	f->base = strdup(base);
+	f->ntargets = ntargets;
+	f->targets = copy_string_array(targets, ntargets);
+	f->use_snapshot = snapshot && ntargets == 1 && strcmp(targets[0], ".") == 0;
+	if(f->base == NULL || f->targets == NULL)
+	{
+		free_find(f);
+		*error = strdup("Not enough memory");
+		return NULL;
+	}
+
+	return f;
+}
+
+/* Entry point of background task that prints found paths. */
+static void
+find_task(bg_op_t *bg_op, FILE *out, void *arg)
+{
+	find_t *const f = arg;
+	f->bg_op = bg_op;
+	f->out = out;
+
+	run_find(f);
+	free_find(f);
+}
+
+/* Entry point of stream's producer that loads found files. */
+static void
+find_producer(flist_stream_t *s, void *arg)
+{
+	find_t *const f = arg;
+	f->stream = s;
+
+	run_find(f);
+	free_find(f);
+}
+
+/* Performs the search either by traversing file system or by scanning
+ * a snapshot. */
+static void
+run_find(find_t *f)
+{
+	const cancellation_t cancellation = { .hook = &is_cancelled, .arg = f };
+
+	snapshot_t *const snapshot = (f->use_snapshot ? get_snapshot(f->base) : NULL);
+	if(snapshot != NULL)
+	{
+		scan_snapshot(f, snapshot, &cancellation);
+		release_snapshot(snapshot);
+		flush_output(f, &f->workers[0]);
+		return;
+	}
+
+	int nworkers;
+	for(nworkers = 1; nworkers < NWORKERS; ++nworkers)
+	{
+		worker_t *const w = &f->workers[nworkers];
+		w->matcher = matcher_clone(f->workers[0].matcher);
+		if(w->matcher == NULL)
+		{
+			break;
+		}
+	}
+
+	const int cancelled = walker_run(f->targets, f->ntargets, f->base, nworkers,
+			&visit, f, &cancellation);
+
+	int i;
+	for(i = 0; i < nworkers; ++i)
+	{
+		flush_output(f, &f->workers[i]);
+	}
+
+	if(f->use_snapshot && !cancelled)
+	{
+		store_snapshot(f);
+	}
+}
+
+/* Checks whether searching should stop.  Returns non-zero if so. */
+static int
+is_cancelled(void *arg)
+{
+	find_t *const f = arg;
+
+	if(f->stream != NULL)
+	{
+		return flist_stream_stopped(f->stream);
+	}
+
+	pthread_mutex_lock(&f->lock);
+	const int failed = f->failed;
+	pthread_mutex_unlock(&f->lock);
+
+	return failed || bg_op_cancelled(f->bg_op);
+}
+
+/* Reports entries whose names match.  Returns non-zero for directories to
+ * descend into them. */
+static int
+visit(const walker_entry_t *entry, void *arg)
+{
+	find_t *const f = arg;
+	worker_t *const w = &f->workers[entry->worker];
+
+	/* Directories to search in aren't search results. */
+	if(entry->depth == 0 && entry->type == WT_DIR)
+	{
+		return 1;
+	}
+
+	if(f->use_snapshot)
+	{
+		record(w, entry->path);
+	}
+
+	if(matcher_matches(w->matcher, entry->full_path))
+	{
+		report(f, w, entry->path, entry->full_path);
+	}
+
+	return (entry->type == WT_DIR);
+}
+
+/* Remembers visited path for a snapshot unless there are too many of them. */
+static void
+record(worker_t *w, const char path[])
+{
+	if(w->overflow)
+	{
+		return;
+	}
+
+	char **const slot = DA_EXTEND(w->recorded);
+	if(slot == NULL || DA_SIZE(w->recorded) >= MAX_SNAPSHOT_SIZE ||
+			(*slot = strdup(path)) == NULL)
+	{
+		w->overflow = 1;
+		free_recorded(w);
+		return;
+	}
+
+	DA_COMMIT(w->recorded);
+}
+
+/* Reports paths of the snapshot whose names match. */
+static void
+scan_snapshot(find_t *f, const snapshot_t *snapshot,
+		const cancellation_t *cancellation)
+{
+	worker_t *const w = &f->workers[0];
+	const char *const sep = (ends_with_slash(snapshot->base) ? "" : "/");
+
+	int i;
+	for(i = 0; i < snapshot->npaths; ++i)
+	{
+		if(i%CANCEL_CHECK_PERIOD == 0 && cancellation_requested(cancellation))
+		{
+			break;
+		}
+
+		/* Skip "./" prefix when making full path. */
+		const char *const path = snapshot->paths[i];
+		char full_path[PATH_MAX + 1];
+		snprintf(full_path, sizeof(full_path), "%s%s%s", snapshot->base, sep,
+				path + 2);
+
+		if(matcher_matches(w->matcher, full_path))
+		{
+			report(f, w, path, full_path);
+		}
+	}
+}
+
+/* Passes found file to the stream or appends its path to the output. */
+static void
+report(find_t *f, worker_t *w, const char path[], const char full_path[])
+{
+	if(f->stream != NULL)
+	{
+		dir_entry_t entry;
+		if(fentry_load(&entry, full_path) == 0)
+		{
+			(void)flist_stream_put(f->stream, &entry);
+		}
+		return;
+	}
+
+	const size_t len = strlen(path);
+	const size_t needed = w->out_len + len + 1U;
+	if(needed > w->out_size)
+	{
+		char *const out = realloc(w->out, needed*2U);
+		if(out == NULL)
+		{
+			return;
+		}
+		w->out = out;
+		w->out_size = needed*2U;
+	}
+
+	memcpy(w->out + w->out_len, path, len);
+	w->out[needed - 1U] = '\n';
+	w->out_len = needed;
+
+	if(w->out_len >= FLUSH_SIZE)
+	{
+		flush_output(f, w);
+	}
+}
+
+/* Writes out buffered output of a worker. */
+static void
+flush_output(find_t *f, worker_t *w)
+{
+	if(w->out_len == 0U)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&f->lock);
+	if(!f->failed)
+	{
+		/* Write error means that nobody is interested in results anymore. */
+		f->failed = (fwrite(w->out, 1U, w->out_len, f->out) != w->out_len ||
+				fflush(f->out) != 0);
+	}
+	pthread_mutex_unlock(&f->lock);
+
+	w->out_len = 0U;
+}
+
+/* Looks up recent snapshot of the directory.  Expired snapshot is freed to
+ * not keep its paths in memory until the next search.  Returns the snapshot,
+ * which should be released, or NULL. */
+static snapshot_t *
+get_snapshot(const char base[])
+{
+	snapshot_t *snapshot = NULL;
+	snapshot_t *expired = NULL;
+
+	pthread_mutex_lock(&snapshot_lock);
+	if(last_snapshot != NULL)
+	{
+		if(time_in_ms() - last_snapshot->taken >= SNAPSHOT_TTL)
+		{
+			expired = last_snapshot;
+			last_snapshot = NULL;
+		}
+		else if(strcmp(last_snapshot->base, base) == 0)
+		{
+			snapshot = last_snapshot;
+			++snapshot->refs;
+		}
+	}
+	pthread_mutex_unlock(&snapshot_lock);
+
+	release_snapshot(expired);
+	return snapshot;
+}
+
+/* Makes a snapshot out of paths recorded by workers replacing the previous
+ * one. */
+static void
+store_snapshot(find_t *f)
+{
+	int npaths = 0;
+	int i;
+	for(i = 0; i < NWORKERS; ++i)
+	{
+		if(f->workers[i].overflow)
+		{
+			return;
+		}
+		npaths += DA_SIZE(f->workers[i].recorded);
+	}
+	if(npaths > MAX_SNAPSHOT_SIZE)
+	{
+		return;
+	}
+
+	snapshot_t *const snapshot = calloc(1, sizeof(*snapshot));
+	if(snapshot == NULL)
+	{
+		return;
+	}
+
+	snapshot->base = strdup(f->base);
+	snapshot->paths = reallocarray(NULL, npaths, sizeof(*snapshot->paths));
+	if(snapshot->base == NULL || (snapshot->paths == NULL && npaths != 0))
+	{
+		free(snapshot->base);
+		free(snapshot->paths);
+		free(snapshot);
+		return;
+	}
+
+	/* Move paths instead of copying them. */
+	for(i = 0; i < NWORKERS; ++i)
+	{
+		worker_t *const w = &f->workers[i];
+		const size_t n = DA_SIZE(w->recorded);
+		if(n != 0U)
+		{
+			memcpy(snapshot->paths + snapshot->npaths, w->recorded,
+					n*sizeof(*w->recorded));
+			snapshot->npaths += n;
+		}
+		DA_REMOVE_ALL(w->recorded);
+	}
+
+	snapshot->taken = time_in_ms();
+	snapshot->refs = 1;
+
+	pthread_mutex_lock(&snapshot_lock);
+	snapshot_t *const previous = last_snapshot;
+	last_snapshot = snapshot;
+	pthread_mutex_unlock(&snapshot_lock);
+
+	release_snapshot(previous);
+}
+
+/* Drops a reference to the snapshot freeing it when it's unused.  The snapshot
+ * can be NULL. */
+static void
+release_snapshot(snapshot_t *snapshot)
+{
+	if(snapshot == NULL)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&snapshot_lock);
+	const int unused = (--snapshot->refs == 0);
+	pthread_mutex_unlock(&snapshot_lock);
+
+	if(unused)
+	{
+		free_string_array(snapshot->paths, snapshot->npaths);
+		free(snapshot->base);
+		free(snapshot);
+	}
+}
+
+/* Frees paths recorded by the worker. */
+static void
+free_recorded(worker_t *w)
+{
+	free_string_array(w->recorded, DA_SIZE(w->recorded));
+	w->recorded = NULL;
+	DA_SIZE(w->recorded) = 0U;
+}
+
+/* Frees state of searching. */
+static void
+free_find(find_t *f)
+{
+	int i;
+	for(i = 0; i < NWORKERS; ++i)
+	{
+		worker_t *const w = &f->workers[i];
+		matcher_free(w->matcher);
+		free(w->out);
+		free_recorded(w);
+	}
+
+	pthread_mutex_destroy(&f->lock);
+	free_string_array(f->targets, f->ntargets);
+	free(f->base);
+	free(f);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
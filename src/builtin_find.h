@@ -0,0 +1,53 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__BUILTIN_FIND_H__
+#define VIFM__BUILTIN_FIND_H__
+
+/* Implementation of :find that doesn't run external commands.  Trees are
+ * traversed in parallel in background looking for files whose names match a
+ * pattern.  Listing of a directory can be remembered for a short time to
+ * answer several searches in a row without traversing it again. */
+
+struct bg_job_t;
+struct flist_stream_t;
+struct view_t;
+
+/* Starts looking for files whose names match the pattern (a matcher expression,
+ * like "*.c" or "/regex/") under the targets, relative paths are resolved
+ * against the base.  Directories that are targets aren't reported themselves.
+ * Non-zero snapshot allows reusing and remembering listing of the base when
+ * the only target is ".".  Returns job whose output lists found paths or NULL
+ * on error, in which case *error is set to a newly allocated message. */
+struct bg_job_t * bfind_run(const char pattern[], char *targets[],
+		int ntargets, const char base[], int snapshot, char **error);
+
+/* Same as bfind_run(), but found files are loaded in background and passed to
+ * custom view that is being composed for the view and the base is the
+ * location of the view.  Returns the stream or NULL on error, in which case
+ * *error is set to a newly allocated message. */
+struct flist_stream_t * bfind_stream(struct view_t *view, const char pattern[],
+		char *targets[], int ntargets, int snapshot, char **error);
+
+/* Forgets remembered listing of a directory if there is one. */
+void bfind_drop_snapshot(void);
+
+#endif /* VIFM__BUILTIN_FIND_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
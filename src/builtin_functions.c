@@ -46,6 +46,7 @@
 #include "utils/utils.h"
 #include "filelist.h"
 #include "macros.h"
+#include "trace.h"
 #include "types.h"
 
 /* A single entry of cache of external commands. */
@@ -72,6 +73,7 @@ static var_t paneisat_builtin(const call_info_t *call_info);
 static var_t system_builtin(const call_info_t *call_info);
 static var_t tabpagenr_builtin(const call_info_t *call_info);
 static var_t term_builtin(const call_info_t *call_info);
+static var_t trace_builtin(const call_info_t *call_info);
 static var_t execute_cmd(var_t cmd_arg, int interactive, int preserve_stdin);
 
 /* Function descriptions. */
@@ -90,6 +92,7 @@ static const function_t functions[] = {
 	{ "system",      "execute external command",   {1,1}, &system_builtin },
 	{ "tabpagenr",   "number of current/last tab", {0,1}, &tabpagenr_builtin },
 	{ "term",        "run interactive command",    {1,1}, &term_builtin },
+	{ "trace",       "query performance counters", {1,2}, &trace_builtin },
 };
 
 /* Kind of monitor used by the extcached(). */
@@ -530,6 +533,64 @@ term_builtin(const call_info_t *call_info)
 	return execute_cmd(call_info->argv[0], call_info->interactive, 1);
 }
 
+/* Queries or manages performance counters depending on the action.  Returns
+ * report for "stats" action and an empty string for others. */
+static var_t
+trace_builtin(const call_info_t *call_info)
+{
+	char *const action = var_to_str(call_info->argv[0]);
+
+	if(strcmp(action, "stats") == 0 && call_info->argc == 1)
+	{
+		free(action);
+
+		char *report = NULL;
+		size_t len = 0U;
+		int i;
+		for(i = 0; i < TP_COUNT; ++i)
+		{
+			char line[128];
+			if(i != 0)
+			{
+				(void)strappendch(&report, &len, '\n');
+			}
+			(void)strappend(&report, &len, trace_format_stats(i, line, sizeof(line)));
+		}
+
+		var_t result = var_from_str(report == NULL ? "" : report);
+		free(report);
+		return result;
+	}
+
+	if(strcmp(action, "reset") == 0 && call_info->argc == 1)
+	{
+		free(action);
+		trace_reset();
+		return var_from_str("");
+	}
+
+	if(strcmp(action, "dump") == 0 && call_info->argc == 2)
+	{
+		free(action);
+
+		char *const path = var_to_str(call_info->argv[1]);
+		char *const full_path = expand_tilde(path);
+		free(path);
+
+		const int failed = trace_dump(full_path);
+		if(failed)
+		{
+			vle_tb_append_linef(vle_err, "Failed to write trace to: %s", full_path);
+		}
+		free(full_path);
+		return (failed ? var_error() : var_from_str(""));
+	}
+
+	vle_tb_append_linef(vle_err, "Invalid arguments of trace(): %s", action);
+	free(action);
+	return var_error();
+}
+
 /* Runs interactive command in a shell and returns its output (joined standard
  * output and standard error streams).  All trailing newline characters are
  * stripped to allow easy appending to command output.  Returns the output. */
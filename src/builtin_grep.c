@@ -0,0 +1,808 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "builtin_grep.h"
+
+#include <regex.h> /* REG_* regcomp() regexec() regfree() regex_t */
+
+#include <stddef.h> /* NULL size_t */
+#include <stdio.h> /* FILE _IONBF fclose() fflush() fread() fwrite() setvbuf()
+                      snprintf() */
+#include <stdlib.h> /* calloc() free() malloc() realloc() */
+#include <string.h> /* memchr() memcmp() memcpy() memmove() strchr() strdup()
+                       strlen() strstr() */
+
+#include "compat/os.h"
+#include "compat/pthread.h"
+#include "utils/cancellation.h"
+#include "utils/macros.h"
+#include "utils/regexp.h"
+#include "utils/str.h"
+#include "utils/string_array.h"
+#include "utils/walker.h"
+#include "background.h"
+
+enum
+{
+	NWORKERS = 4,                /* Number of threads that search. */
+	BINARY_CHECK_SIZE = 32*1024, /* How much of a file is checked for NUL. */
+	CHUNK_SIZE = 256*1024,       /* How much of a file is read at a time. */
+	MAX_LINE_LEN = 16*1024*1024, /* Files with longer lines aren't searched
+	                                past them. */
+	FLUSH_SIZE = 64*1024,        /* Amount of buffered output to write out. */
+};
+
+/* State of a single searching thread. */
+typedef struct
+{
+	regex_t re;       /* Own copy of the regular expression. */
+	char *buf;        /* Unprocessed part of a file being searched. */
+	size_t buf_size;  /* Capacity of the buf. */
+	char *line;       /* Null-terminated copy of a line being matched. */
+	size_t line_size; /* Capacity of the line. */
+	char *out;        /* Output that wasn't written yet. */
+	size_t out_len;   /* Length of the out. */
+	size_t out_size;  /* Capacity of the out. */
+}
+worker_t;
+
+/* State of searching. */
+typedef struct
+{
+	char *pattern;      /* Regular expression. */
+	int cflags;         /* Flags to compile the expression with. */
+	int invert;         /* Whether non-matching lines are looked for. */
+	char *literal;      /* String that every matching line contains or NULL. */
+	size_t literal_len; /* Length of the literal. */
+	char **targets;     /* Files and directories to search in. */
+	int ntargets;       /* Number of targets. */
+	char *base;         /* Base for relative targets. */
+
+	bg_op_t *bg_op;       /* Cancellation state. */
+	pthread_mutex_t lock; /* Protects fields below. */
+	FILE *out;            /* Where to print matches. */
+	int failed;           /* Whether writing to output has failed. */
+
+	worker_t workers[NWORKERS]; /* State of searching threads. */
+}
+grep_t;
+
+static const char * parse_args(const char args[], int *cflags, int *fixed,
+		char **error);
+static char * escape_fixed(const char str[]);
+static char * extract_literal(const char pattern[], int extended);
+static const char * skip_bracket(const char p[]);
+static const char * skip_interval(const char p[], int extended);
+static void drop_last_char(char run[], size_t *len);
+static void take_run(const char run[], size_t len, char **best,
+		size_t *best_len);
+static void grep_task(bg_op_t *bg_op, FILE *out, void *arg);
+static int is_cancelled(void *arg);
+static int visit(const walker_entry_t *entry, void *arg);
+static void grep_file(grep_t *g, worker_t *w, const char path[],
+		const char full_path[]);
+static int search(grep_t *g, worker_t *w, const char path[],
+		const char data[], size_t size, int *lineno);
+static int count_text_lines(const char data[], size_t size);
+static const char * find_literal(const grep_t *g, const char data[],
+		size_t size);
+static int line_matches(worker_t *w, const char line[], size_t len);
+static void add_match(grep_t *g, worker_t *w, const char path[], int lineno,
+		const char line[], size_t len);
+static void flush_output(grep_t *g, worker_t *w);
+static int ensure_size(char **buf, size_t *size, size_t needed);
+static void free_grep(grep_t *g);
+
+bg_job_t *
+bgrep_run(const char args[], int invert, char *targets[], int ntargets,
+		const char base[], char **error)
+{
+	int cflags, fixed;
+	const char *const pattern = parse_args(args, &cflags, &fixed, error);
+	if(pattern == NULL)
+	{
+		return NULL;
+	}
+
+	grep_t *const g = calloc(1, sizeof(*g));
+	if(g == NULL)
+	{
+		*error = strdup("Not enough memory");
+		return NULL;
+	}
+
+	pthread_mutex_init(&g->lock, NULL);
+	g->cflags = cflags;
+	g->invert = invert;
+	g->pattern = (fixed ? escape_fixed(pattern) : strdup(pattern));
+	g->base = strdup(base);
+	g->ntargets = ntargets;
+	g->targets = copy_string_array(targets, ntargets);
+	if(g->pattern == NULL || g->base == NULL || g->targets == NULL)
+	{
+		free_grep(g);
+		*error = strdup("Not enough memory");
+		return NULL;
+	}
+
+	regex_t re;
+	const int err = regcomp(&re, g->pattern, g->cflags);
+	if(err != 0)
+	{
+		*error = format_str("Invalid pattern: %s", get_regexp_error(err, &re));
+		regfree(&re);
+		free_grep(g);
+		return NULL;
+	}
+	regfree(&re);
+
+	/* The prefilter is an exact comparison of bytes. */
+	if(!(g->cflags & REG_ICASE))
+	{
+		g->literal = fixed ? strdup(pattern)
+		                   : extract_literal(g->pattern, g->cflags & REG_EXTENDED);
+		g->literal_len = (g->literal == NULL ? 0U : strlen(g->literal));
+	}
+
+	char *const descr = format_str("Builtin grep: %s", args);
+	bg_job_t *const job = bg_execute_capture(descr == NULL ? args : descr,
+			&grep_task, g);
+	free(descr);
+
+	if(job == NULL)
+	{
+		free_grep(g);
+		*error = strdup("Failed to start background task");
+	}
+	return job;
+}
+
+/* Parses options at the beginning of :grep arguments.  Returns pointer to the
+ * pattern or NULL on error, in which case *error is set. */
+static const char *
+parse_args(const char args[], int *cflags, int *fixed, char **error)
+{
+	*cflags = REG_NOSUB;
+	*fixed = 0;
+
+	const char *p = args;
+	while(*p == '-')
+	{
+		if(p[1] == '-' && (p[2] == ' ' || p[2] == '\0'))
+		{
+			p = skip_whitespace(p + 2);
+			break;
+		}
+
+		for(++p; *p != ' ' && *p != '\0'; ++p)
+		{
+			switch(*p)
+			{
+				case 'i': *cflags |= REG_ICASE; break;
+				case 'E': *cflags |= REG_EXTENDED; break;
+				case 'F': *fixed = 1; break;
+
+				default:
+					*error = format_str("Unknown option: -%c", *p);
+					return NULL;
+			}
+		}
+		p = skip_whitespace(p);
+	}
+
+	if(*p == '\0')
+	{
+		*error = strdup("No pattern specified");
+		return NULL;
+	}
+
+	if(*fixed)
+	{
+		*cflags &= ~REG_EXTENDED;
+	}
+	return p;
+}
+
+/* Turns a string into basic regular expression that matches it literally.
+ * Returns newly allocated string or NULL on error. */
+static char *
+escape_fixed(const char str[])
+{
+	char *const escaped = malloc(strlen(str)*2U + 1U);
+	if(escaped == NULL)
+	{
+		return NULL;
+	}
+
+	char *e = escaped;
+	for(; *str != '\0'; ++str)
+	{
+		if(strchr("\\.[]*^$", *str) != NULL)
+		{
+			*e++ = '\\';
+		}
+		*e++ = *str;
+	}
+	*e = '\0';
+	return escaped;
+}
+
+/* Finds the longest string that's part of every match of the pattern.  The
+ * analysis is conservative and only considers characters outside of groups,
+ * alternation disables it completely.  Returns newly allocated string or NULL
+ * if there is no such string. */
+static char *
+extract_literal(const char pattern[], int extended)
+{
+	char *const run = malloc(strlen(pattern) + 1U);
+	if(run == NULL)
+	{
+		return NULL;
+	}
+
+	char *best = NULL;
+	size_t best_len = 0U;
+	size_t len = 0U;
+	int depth = 0;
+
+	const char *p = pattern;
+	while(*p != '\0')
+	{
+		const char c = *p++;
+		int literal = 0;
+
+		if(c == '\\' && *p != '\0')
+		{
+			const char n = *p++;
+			if(strchr(".[]*^$\\/", n) != NULL ||
+					(extended && strchr("+?(){}|", n) != NULL))
+			{
+				literal = n;
+			}
+			else if(n == '|')
+			{
+				len = 0U;
+				best_len = 0U;
+				break;
+			}
+			else if(n == '?' || n == '+' || n == '{')
+			{
+				drop_last_char(run, &len);
+				take_run(run, len, &best, &best_len);
+				len = 0U;
+				if(n == '{')
+				{
+					p = skip_interval(p, extended);
+				}
+			}
+			else
+			{
+				take_run(run, len, &best, &best_len);
+				len = 0U;
+				depth += (n == '(') - (n == ')');
+			}
+		}
+		else if(extended && c == '|')
+		{
+			len = 0U;
+			best_len = 0U;
+			break;
+		}
+		else if(c == '*' || (extended && strchr("?+{", c) != NULL))
+		{
+			drop_last_char(run, &len);
+			take_run(run, len, &best, &best_len);
+			len = 0U;
+			if(c == '{')
+			{
+				p = skip_interval(p, extended);
+			}
+		}
+		else if(strchr(".^$[", c) != NULL || (extended && strchr("()", c)))
+		{
+			take_run(run, len, &best, &best_len);
+			len = 0U;
+			if(c == '[')
+			{
+				p = skip_bracket(p);
+			}
+			if(extended)
+			{
+				depth += (c == '(') - (c == ')');
+			}
+		}
+		else
+		{
+			literal = c;
+		}
+
+		if(literal != 0 && depth == 0)
+		{
+			run[len++] = literal;
+		}
+	}
+	take_run(run, len, &best, &best_len);
+	free(run);
+
+	if(best_len == 0U)
+	{
+		free(best);
+		return NULL;
+	}
+	return best;
+}
+
+/* Skips bracket expression.  Returns pointer past its end. */
+static const char *
+skip_bracket(const char p[])
+{
+	if(*p == '^')
+	{
+		++p;
+	}
+	if(*p == ']')
+	{
+		++p;
+	}
+
+	while(*p != '\0' && *p != ']')
+	{
+		/* Character classes, equivalence classes and collating symbols. */
+		if(*p == '[' && p[1] != '\0' && strchr(":.=", p[1]) != NULL)
+		{
+			const char end[] = { p[1], ']', '\0' };
+			const char *const class_end = strstr(p + 2, end);
+			if(class_end != NULL)
+			{
+				p = class_end + 2;
+				continue;
+			}
+		}
+		++p;
+	}
+
+	return (*p == ']' ? p + 1 : p);
+}
+
+/* Skips interval expression.  Returns pointer past its end. */
+static const char *
+skip_interval(const char p[], int extended)
+{
+	const char *const end = strstr(p, extended ? "}" : "\\}");
+	if(end == NULL)
+	{
+		return p + strlen(p);
+	}
+	return end + (extended ? 1 : 2);
+}
+
+/* Removes last character, which might consist of several bytes, from the
+ * run. */
+static void
+drop_last_char(char run[], size_t *len)
+{
+	while(*len > 0U && ((unsigned char)run[*len - 1U] & 0xc0) == 0x80)
+	{
+		--*len;
+	}
+	if(*len > 0U)
+	{
+		--*len;
+	}
+}
+
+/* Replaces the best run with the current one if it's longer. */
+static void
+take_run(const char run[], size_t len, char **best, size_t *best_len)
+{
+	if(len <= *best_len)
+	{
+		return;
+	}
+
+	char *const copy = malloc(len + 1U);
+	if(copy != NULL)
+	{
+		memcpy(copy, run, len);
+		copy[len] = '\0';
+		free(*best);
+		*best = copy;
+		*best_len = len;
+	}
+}
+
+/* Entry point of the background task. */
+static void
+grep_task(bg_op_t *bg_op, FILE *out, void *arg)
+{
+	grep_t *const g = arg;
+	g->bg_op = bg_op;
+	g->out = out;
+
+	int nworkers;
+	for(nworkers = 0; nworkers < NWORKERS; ++nworkers)
+	{
+		const int err = regcomp(&g->workers[nworkers].re, g->pattern, g->cflags);
+		if(err != 0)
+		{
+			/* Fewer workers is fine, but there must be at least one. */
+			if(nworkers == 0)
+			{
+				char *const msg = format_str("Failed to compile pattern: %s",
+						get_regexp_error(err, &g->workers[0].re));
+				bg_task_report_error(msg == NULL ? "Failed to compile pattern" : msg);
+				free(msg);
+
+				regfree(&g->workers[0].re);
+				free_grep(g);
+				return;
+			}
+			regfree(&g->workers[nworkers].re);
+			break;
+		}
+	}
+
+	const cancellation_t cancellation = { .hook = &is_cancelled, .arg = g };
+	(void)walker_run(g->targets, g->ntargets, g->base, nworkers, &visit, g,
+			&cancellation);
+
+	int i;
+	for(i = 0; i < nworkers; ++i)
+	{
+		regfree(&g->workers[i].re);
+	}
+	free_grep(g);
+}
+
+/* Checks whether searching should stop.  Returns non-zero if so. */
+static int
+is_cancelled(void *arg)
+{
+	grep_t *const g = arg;
+
+	pthread_mutex_lock(&g->lock);
+	const int failed = g->failed;
+	pthread_mutex_unlock(&g->lock);
+
+	return failed || bg_op_cancelled(g->bg_op);
+}
+
+/* Searches in regular files.  Returns non-zero for directories to descend into
+ * them. */
+static int
+visit(const walker_entry_t *entry, void *arg)
+{
+	grep_t *const g = arg;
+
+	if(entry->type == WT_FILE)
+	{
+		worker_t *const w = &g->workers[entry->worker];
+		grep_file(g, w, entry->path, entry->full_path);
+		flush_output(g, w);
+	}
+
+	return (entry->type == WT_DIR);
+}
+
+/* Prints matching lines of a file.  The file is read in chunks, lines that
+ * cross boundary of a chunk are carried over to the next one. */
+static void
+grep_file(grep_t *g, worker_t *w, const char path[], const char full_path[])
+{
+	FILE *const fp = os_fopen(full_path, "rb");
+	if(fp == NULL)
+	{
+		return;
+	}
+	/* Data is read in large portions, no need to copy it via stdio buffer. */
+	(void)setvbuf(fp, NULL, _IONBF, 0U);
+
+	size_t len = 0U;
+	int lineno = 1;
+	int first = 1;
+	while(1)
+	{
+		if(ensure_size(&w->buf, &w->buf_size, len + CHUNK_SIZE) != 0)
+		{
+			break;
+		}
+
+		const size_t n = fread(w->buf + len, 1U, w->buf_size - len, fp);
+		const int eof = (n == 0U);
+		len += n;
+
+		/* Like "grep -I", skip files that look like binary ones. */
+		if(first)
+		{
+			first = 0;
+			const size_t check_size = MIN(len, BINARY_CHECK_SIZE);
+			if(memchr(w->buf, '\0', check_size) != NULL)
+			{
+				break;
+			}
+		}
+
+		/* Last line is complete only at the end of the file. */
+		size_t complete = len;
+		if(!eof)
+		{
+			while(complete != 0U && w->buf[complete - 1U] != '\n')
+			{
+				--complete;
+			}
+		}
+
+		if(complete == 0U && len > MAX_LINE_LEN)
+		{
+			/* Lines of such length are unlikely to be part of a text file. */
+			break;
+		}
+
+		if(search(g, w, path, w->buf, complete, &lineno) != 0)
+		{
+			break;
+		}
+
+		memmove(w->buf, w->buf + complete, len - complete);
+		len -= complete;
+
+		if(eof)
+		{
+			break;
+		}
+	}
+
+	fclose(fp);
+
+	/* Buffer that had to grow to fit a long line isn't kept around. */
+	if(w->buf_size > 2*CHUNK_SIZE)
+	{
+		free(w->buf);
+		w->buf = NULL;
+		w->buf_size = 0U;
+	}
+}
+
+/* Prints lines of the data that match.  The lineno is number of the first line
+ * of the data and is advanced past its last line.  Returns non-zero if the
+ * file turned out to be binary, otherwise zero is returned. */
+static int
+search(grep_t *g, worker_t *w, const char path[], const char data[],
+		size_t size, int *lineno)
+{
+	const char *const end = data + size;
+
+	/* The literal is looked up across lines to skip those that can't match
+	 * without running the regular expression on them. */
+	const char *hit = NULL;
+	if(g->literal != NULL)
+	{
+		hit = find_literal(g, data, size);
+		if(hit == NULL && !g->invert)
+		{
+			*lineno += count_text_lines(data, size);
+			return 0;
+		}
+	}
+
+	const char *line = data;
+	while(line < end)
+	{
+		const char *eol = memchr(line, '\n', end - line);
+		if(eol == NULL)
+		{
+			eol = end;
+		}
+
+		if(hit != NULL && hit < line)
+		{
+			hit = find_literal(g, line, end - line);
+			if(hit == NULL && !g->invert)
+			{
+				*lineno += count_text_lines(line, end - line);
+				break;
+			}
+		}
+
+		const size_t len = eol - line;
+		const int matches = (g->literal != NULL && (hit == NULL || hit >= eol))
+		                  ? 0
+		                  : line_matches(w, line, len);
+		if(matches != g->invert)
+		{
+			/* Null character in the middle of a file means it's binary after
+			 * all. */
+			if(memchr(line, '\0', len) != NULL)
+			{
+				return 1;
+			}
+			add_match(g, w, path, *lineno, line, len);
+		}
+
+		line = eol + 1;
+		++*lineno;
+	}
+
+	return 0;
+}
+
+/* Counts lines of the data including the last one that has no newline.
+ * Returns the number. */
+static int
+count_text_lines(const char data[], size_t size)
+{
+	const char *const end = data + size;
+	int count = 0;
+	while(data < end)
+	{
+		const char *const eol = memchr(data, '\n', end - data);
+		++count;
+		if(eol == NULL)
+		{
+			break;
+		}
+		data = eol + 1;
+	}
+	return count;
+}
+
+/* Looks for the literal in the data using memchr() to find candidates.
+ * Returns pointer to the first occurrence or NULL. */
+static const char *
+find_literal(const grep_t *g, const char data[], size_t size)
+{
+	if(size < g->literal_len)
+	{
+		return NULL;
+	}
+
+	const char first = g->literal[0];
+	const char *const last = data + size - g->literal_len;
+
+	const char *p = data;
+	while(p <= last)
+	{
+		p = memchr(p, first, last - p + 1);
+		if(p == NULL)
+		{
+			break;
+		}
+		if(memcmp(p + 1, g->literal + 1, g->literal_len - 1U) == 0)
+		{
+			return p;
+		}
+		++p;
+	}
+	return NULL;
+}
+
+/* Runs the regular expression on a line.  Returns non-zero on a match. */
+static int
+line_matches(worker_t *w, const char line[], size_t len)
+{
+	if(ensure_size(&w->line, &w->line_size, len + 1U) != 0)
+	{
+		return 0;
+	}
+
+	memcpy(w->line, line, len);
+	w->line[len] = '\0';
+	return (regexec(&w->re, w->line, 0, NULL, 0) == 0);
+}
+
+/* Appends a match to the output buffer writing it out when it gets large. */
+static void
+add_match(grep_t *g, worker_t *w, const char path[], int lineno,
+		const char line[], size_t len)
+{
+	/* Path is copied as is because there is no limit on its length. */
+	char num[32];
+	const int num_len = snprintf(num, sizeof(num), ":%d:", lineno);
+	const size_t path_len = strlen(path);
+
+	const size_t needed = w->out_len + path_len + num_len + len + 1U;
+	if(ensure_size(&w->out, &w->out_size, needed) != 0)
+	{
+		return;
+	}
+
+	char *p = w->out + w->out_len;
+	memcpy(p, path, path_len);
+	p += path_len;
+	memcpy(p, num, num_len);
+	p += num_len;
+	memcpy(p, line, len);
+	p[len] = '\n';
+	w->out_len = needed;
+
+	if(w->out_len >= FLUSH_SIZE)
+	{
+		flush_output(g, w);
+	}
+}
+
+/* Writes out buffered output of a worker. */
+static void
+flush_output(grep_t *g, worker_t *w)
+{
+	if(w->out_len == 0U)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&g->lock);
+	if(!g->failed)
+	{
+		/* Write error means that nobody is interested in results anymore. */
+		g->failed = (fwrite(w->out, 1U, w->out_len, g->out) != w->out_len ||
+				fflush(g->out) != 0);
+	}
+	pthread_mutex_unlock(&g->lock);
+
+	w->out_len = 0U;
+}
+
+/* Makes sure that buffer is at least of the specified size.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+ensure_size(char **buf, size_t *size, size_t needed)
+{
+	if(*size >= needed)
+	{
+		return 0;
+	}
+
+	size_t new_size = (*size == 0U ? 4096U : *size);
+	while(new_size < needed)
+	{
+		new_size *= 2U;
+	}
+
+	char *const new_buf = realloc(*buf, new_size);
+	if(new_buf == NULL)
+	{
+		return 1;
+	}
+
+	*buf = new_buf;
+	*size = new_size;
+	return 0;
+}
+
+/* Frees state of searching. */
+static void
+free_grep(grep_t *g)
+{
+	int i;
+	for(i = 0; i < NWORKERS; ++i)
+	{
+		free(g->workers[i].buf);
+		free(g->workers[i].line);
+		free(g->workers[i].out);
+	}
+
+	pthread_mutex_destroy(&g->lock);
+	free(g->pattern);
+	free(g->literal);
+	free_string_array(g->targets, g->ntargets);
+	free(g->base);
+	free(g);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,41 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__BUILTIN_GREP_H__
+#define VIFM__BUILTIN_GREP_H__
+
+/* Implementation of :grep that doesn't run external commands.  Searching is
+ * done in parallel in background and results are printed in the same format
+ * as "grep -n -H" uses. */
+
+struct bg_job_t;
+
+/* Starts searching for lines that match (or don't match if invert is
+ * non-zero) a pattern.  The args consist of optional -i (ignore case), -E
+ * (extended regular expression) and -F (fixed string) options followed by the
+ * pattern, options can be terminated by --.  Targets are files or directories
+ * to search in, relative paths are resolved against the base.  Returns job
+ * whose output lists matches as "path:line:text" or NULL on error, in which
+ * case *error is set to a newly allocated message. */
+struct bg_job_t * bgrep_run(const char args[], int invert, char *targets[],
+		int ntargets, const char base[], char **error);
+
+#endif /* VIFM__BUILTIN_GREP_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -24,6 +24,7 @@
 #define MYVIFMRC_EV "MYVIFMRC"
 #define TRASH "Trash"
 #define LOG "log"
+#define LUAC "luac"
 #define VIFMRC "vifmrc"
 
 #ifndef __APPLE__
@@ -64,6 +65,7 @@
 #include "../flist_hist.h"
 #include "../marks.h"
 #include "../opt_handlers.h"
+#include "../startup_time.h"
 #include "../status.h"
 #include "../types.h"
 #include "../vifm.h"
@@ -216,6 +218,7 @@ cfg_init(void)
 	cfg.view_dir_size = VDS_SIZE;
 
 	cfg.log_file[0] = '\0';
+	cfg.luac_dir[0] = '\0';
 
 	cfg_set_shell(env_get_def("SHELL", DEFAULT_SHELL_CMD));
 	cfg.shell_cmd_flag = strdup((curr_stats.shell_type == ST_CMD) ? "/C" : "-c");
@@ -598,6 +601,7 @@ store_config_paths(const char data_dir[])
 	free(trash_base);
 
 	snprintf(cfg.log_file, sizeof(cfg.log_file), "%s/" LOG, base);
+	snprintf(cfg.luac_dir, sizeof(cfg.luac_dir), "%s/" LUAC, base);
 
 	char *fuse_home = format_str("%s/fuse/", base);
 	(void)cfg_set_fuse_home(fuse_home);
@@ -772,7 +776,9 @@ cfg_source_file(const char filename[])
 	SourcingState sourcing_state = curr_stats.sourcing_state;
 	curr_stats.sourcing_state = SOURCING_PROCESSING;
 
+	const long long start = stime_begin();
 	int result = source_file_internal(lines, filename);
+	stime_end(start, "sourcing %s", filename);
 
 	curr_stats.sourcing_state = sourcing_state;
 
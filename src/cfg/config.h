@@ -179,6 +179,9 @@ typedef struct config_t
 	/* This one should be set using trash_set_specs() function. */
 	char trash_dir[PATH_MAX + 64];
 	char log_file[PATH_MAX + 8];
+	/* Where compiled Lua chunks of plugins are cached.  Empty value disables
+	 * the cache. */
+	char luac_dir[PATH_MAX + 8];
 	char *vi_command;
 	int vi_cmd_bg;
 	char *vi_x_command;
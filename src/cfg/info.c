@@ -181,8 +181,12 @@
  *    by time of storing of the array) which are being merged
  */
 
+static JSON_Value * read_info_file(void);
 static JSON_Value * read_legacy_info_file(const char info_file[]);
+static void drop_deferred_state(void);
 static void load_state(JSON_Object *root, int reread);
+static void load_visible_state(JSON_Object *root, int reread);
+static void load_rest_of_state(JSON_Object *root, int grow_histories);
 static void load_gtabs(JSON_Object *root, int reread);
 static tab_layout_t load_gtab_layout(const JSON_Object *gtab, int apply,
 		int reread);
@@ -199,7 +203,8 @@ static void load_bmarks(JSON_Object *root);
 static void load_regs(JSON_Object *root);
 static void load_dir_stack(JSON_Object *root);
 static void load_trash(JSON_Object *root);
-static void load_history(JSON_Object *root, const char node[], hist_t *hist);
+static void load_history(JSON_Object *root, const char node[], hist_t *hist,
+		int grow);
 static void load_sorting(JSON_Object *ptab, view_t *view);
 static void ensure_history_not_full(hist_t *hist);
 static void put_dhistory_entry(view_t *view, int reread, const char dir[],
@@ -294,6 +299,9 @@ static filemon_t vifminfo_mon;
 static filemon_t session_mon;
 /* Callback to be invoked when active session has changed.  Can be NULL. */
 static sessions_changed session_changed_cb;
+/* Contents of vifminfo read by state_load_deferred() whose loading isn't
+ * finished yet or NULL. */
+static JSON_Value *deferred_state;
 
 void
 state_store(void)
@@ -308,6 +316,57 @@ state_store(void)
 
 void
 state_load(int reread)
+{
+	/* Everything is loaded anew. */
+	drop_deferred_state();
+
+	JSON_Value *state = read_info_file();
+	if(state == NULL)
+	{
+		return;
+	}
+
+	load_state(json_object(state), reread);
+	json_value_free(state);
+
+	dir_stack_freeze();
+}
+
+void
+state_load_deferred(void)
+{
+	drop_deferred_state();
+
+	JSON_Value *state = read_info_file();
+	if(state == NULL)
+	{
+		return;
+	}
+
+	load_visible_state(json_object(state), /*reread=*/0);
+	deferred_state = state;
+
+	dir_stack_freeze();
+}
+
+void
+state_load_rest(void)
+{
+	if(deferred_state == NULL)
+	{
+		return;
+	}
+
+	/* Configuration has been processed by now and it's what defines size of
+	 * histories. */
+	load_rest_of_state(json_object(deferred_state), /*grow_histories=*/0);
+	drop_deferred_state();
+}
+
+/* Reads vifminfo in either of the formats and starts monitoring it for
+ * changes.  Returns JSON value or NULL on error. */
+static JSON_Value *
+read_info_file(void)
 {
 	char info_file[PATH_MAX + 16];
 	snprintf(info_file, sizeof(info_file), "%s/vifminfo.json", cfg.config_dir);
@@ -323,17 +382,12 @@ state_load(int reread)
 				cfg.config_dir);
 		state = read_legacy_info_file(legacy_info_file);
 	}
-	if(state == NULL)
+
+	if(state != NULL)
 	{
-		return;
+		(void)filemon_from_file(info_file, FMT_MODIFIED, &vifminfo_mon);
 	}
-
-	load_state(json_object(state), reread);
-	json_value_free(state);
-
-	(void)filemon_from_file(info_file, FMT_MODIFIED, &vifminfo_mon);
-
-	dir_stack_freeze();
+	return state;
 }
 
 /* Reads legacy barely-structured vifminfo format as a JSON.  Returns JSON
@@ -648,9 +702,29 @@ read_legacy_info_file(const char info_file[])
 	return root_value;
 }
 
+/* Frees vifminfo state that wasn't loaded completely, if any. */
+static void
+drop_deferred_state(void)
+{
+	if(deferred_state != NULL)
+	{
+		json_value_free(deferred_state);
+		deferred_state = NULL;
+	}
+}
+
 /* Loads state of the application from JSON. */
 static void
 load_state(JSON_Object *root, int reread)
+{
+	load_visible_state(root, reread);
+	load_rest_of_state(root, /*grow_histories=*/1);
+}
+
+/* Loads part of the state that affects how the application looks and what
+ * configuration file can override. */
+static void
+load_visible_state(JSON_Object *root, int reread)
 {
 	int use_term_multiplexer;
 	if(get_bool(root, "use-term-multiplexer", &use_term_multiplexer))
@@ -673,14 +747,23 @@ load_state(JSON_Object *root, int reread)
 	load_cmds(root);
 	load_marks(root);
 	load_bmarks(root);
-	load_regs(root);
 	load_dir_stack(root);
 	load_trash(root);
-	load_history(root, "cmd-hist", &curr_stats.cmd_hist);
-	load_history(root, "exprreg-hist", &curr_stats.exprreg_hist);
-	load_history(root, "search-hist", &curr_stats.search_hist);
-	load_history(root, "prompt-hist", &curr_stats.prompt_hist);
-	load_history(root, "lfilt-hist", &curr_stats.filter_hist);
+}
+
+/* Loads part of the state that isn't needed until user starts interacting with
+ * the application.  Histories are extended to fit all of their entries if
+ * grow_histories is set. */
+static void
+load_rest_of_state(JSON_Object *root, int grow_histories)
+{
+	load_regs(root);
+	load_history(root, "cmd-hist", &curr_stats.cmd_hist, grow_histories);
+	load_history(root, "exprreg-hist", &curr_stats.exprreg_hist,
+			grow_histories);
+	load_history(root, "search-hist", &curr_stats.search_hist, grow_histories);
+	load_history(root, "prompt-hist", &curr_stats.prompt_hist, grow_histories);
+	load_history(root, "lfilt-hist", &curr_stats.filter_hist, grow_histories);
 }
 
 /* Loads global tabs from JSON. */
@@ -1151,9 +1234,10 @@ load_trash(JSON_Object *root)
 	}
 }
 
-/* Loads history data from JSON. */
+/* Loads history data from JSON.  If grow is set, history is extended to fit
+ * all entries, otherwise the oldest entries are dropped when it's full. */
 static void
-load_history(JSON_Object *root, const char node[], hist_t *hist)
+load_history(JSON_Object *root, const char node[], hist_t *hist, int grow)
 {
 	JSON_Array *entries = json_object_get_array(root, node);
 
@@ -1168,7 +1252,10 @@ load_history(JSON_Object *root, const char node[], hist_t *hist)
 			double ts = -1;
 			get_double(entry, "ts", &ts);
 
-			ensure_history_not_full(hist);
+			if(grow)
+			{
+				ensure_history_not_full(hist);
+			}
 			hist_add(hist, text, (time_t)ts);
 		}
 	}
@@ -2520,6 +2607,8 @@ store_dir_stack(JSON_Object *root)
 static void
 store_trash(JSON_Object *root)
 {
+	trash_prune_emptied_entries();
+
 	if(trash_list_size > 0)
 	{
 		int i;
@@ -2926,6 +3015,8 @@ sessions_load(const char name[])
 	snprintf(session_file, sizeof(session_file), "%s/%s.json", sessions_dir,
 			name);
 
+	drop_deferred_state();
+
 	char *locale = drop_locale();
 	JSON_Value *session = json_parse_file(session_file);
 
@@ -30,6 +30,15 @@ typedef void (*sessions_changed)(const char new_session[]);
  * during startup process. */
 void state_load(int reread);
 
+/* Same as state_load(0), but loads only what's needed to display the
+ * application and postpones loading the rest (registers and histories) until
+ * state_load_rest() is called. */
+void state_load_deferred(void);
+
+/* Finishes loading started by state_load_deferred().  Loaded histories don't
+ * grow beyond their current size.  Does nothing if there is nothing to load. */
+void state_load_rest(void);
+
 /* Stores state of the application.  Always writes vifminfo and stores session
  * if any is active. */
 void state_store(void);
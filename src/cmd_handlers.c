@@ -223,6 +223,7 @@ static int invert_cmd(const cmd_info_t *cmd_info);
 static void print_inversion_state(char state_type);
 static void invert_state(char state_type);
 static int jobs_cmd(const cmd_info_t *cmd_info);
+static int jump_cmd(const cmd_info_t *cmd_info);
 static int keepsel_cmd(const cmd_info_t *cmd_info);
 static int let_cmd(const cmd_info_t *cmd_info);
 static int locate_cmd(const cmd_info_t *cmd_info);
@@ -600,6 +601,10 @@ const cmd_add_t cmds_list[] = {
 	  .descr = "display active jobs",
 	  .flags = HAS_COMMENT,
 	  .handler = &jobs_cmd,        .min_args = 0,   .max_args = 0, },
+	{ .name = "jump",              .abbr = NULL,    .id = -1,
+	  .descr = "go to best fuzzy match among indexed files",
+	  .flags = HAS_EMARK,
+	  .handler = &jump_cmd,        .min_args = 1,   .max_args = NOT_DEF, },
 	{ .name = "keepsel",           .abbr = NULL,    .id = COM_KEEPSEL,
 	  .descr = "preserve selection during :command by default",
 	  .flags = 0,
@@ -3474,6 +3479,16 @@ let_cmd(const cmd_info_t *cmd_info)
 	return 0;
 }
 
+static int
+jump_cmd(const cmd_info_t *cmd_info)
+{
+	if(cmd_info->emark)
+	{
+		return show_jump_menu(curr_view, cmd_info->args) != 0;
+	}
+	return jump_to_best_match(curr_view, cmd_info->args) != 0;
+}
+
 static int
 locate_cmd(const cmd_info_t *cmd_info)
 {
@@ -1222,6 +1222,7 @@ compare_move(view_t *from, view_t *to)
 		/* Update the other entry to not be fake. */
 		remove_last_path_component(canonical);
 		replace_string(&other->name, curr->name);
+		other->name_width = curr->name_width;
 		replace_string(&other->origin, canonical);
 	}
 	else
@@ -0,0 +1 @@
+const char GIT_INFO[] = "dc3f99a980ed-dirty";
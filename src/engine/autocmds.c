@@ -22,7 +22,7 @@
 
 #include <stddef.h> /* size_t */
 #include <stdlib.h> /* free() */
-#include <string.h> /* strcasecmp() strchr() strdup() */
+#include <string.h> /* strcasecmp() strchr() strdup() strpbrk() */
 
 #include "../compat/fs_limits.h"
 #include "../compat/reallocarray.h"
@@ -41,12 +41,19 @@ typedef struct
 	char *action;              /* Action to perform via handler. */
 	vle_aucmd_handler handler; /* Handler to invoke on event firing. */
 	int negated;               /* Whether pattern is negated. */
+	int full_path;             /* Whether pattern is matched against full path
+	                              instead of its last component. */
+	int literal;               /* Whether pattern is an ASCII string without
+	                              wildcards, which can be compared directly. */
 }
 aucmd_info_t;
 
 static int add_aucmd(const char event[], const char pattern[], int negated,
 		const char action[], vle_aucmd_handler handler);
-static int is_pattern_match(const aucmd_info_t *autocmd, const char path[]);
+static int is_literal_pattern(const char pattern[]);
+static int is_pattern_match(const aucmd_info_t *autocmd, const char path[],
+		const char name[], int ascii_path, int ascii_name);
+static int is_ascii(const char str[]);
 static void free_autocmd_data(aucmd_info_t *autocmd);
 static char ** get_patterns(const char patterns[], int *len);
 
@@ -134,6 +141,8 @@ add_aucmd(const char event[], const char pattern[], int negated,
 	autocmd->event = strdup(event);
 	autocmd->pattern = strdup(pattern);
 	autocmd->negated = negated;
+	autocmd->full_path = (strchr(pattern, '/') != NULL);
+	autocmd->literal = is_literal_pattern(pattern);
 	autocmd->action = strdup(action);
 	autocmd->handler = handler;
 	if(autocmd->event == NULL || autocmd->pattern == NULL ||
@@ -148,6 +157,14 @@ add_aucmd(const char event[], const char pattern[], int negated,
 	return 0;
 }
 
+/* Checks whether pattern can be matched by comparing strings.  Returns
+ * non-zero if so, otherwise zero is returned. */
+static int
+is_literal_pattern(const char pattern[])
+{
+	return is_ascii(pattern) && strpbrk(pattern, "*?[\\") == NULL;
+}
+
 void
 vle_aucmd_execute(const char event[], const char path[], void *arg)
 {
@@ -160,24 +177,38 @@ vle_aucmd_execute(const char event[], const char path[], void *arg)
 		chosp(canonic_path);
 	}
 
+	/* These don't depend on autocommand, so compute them once. */
+	const char *const name = get_last_path_component(canonic_path);
+	const int ascii_path = is_ascii(canonic_path);
+	const int ascii_name = ascii_path || is_ascii(name);
+
 	for(i = 0U; i < DA_SIZE(autocmds); ++i)
 	{
 		if(strcasecmp(event, autocmds[i].event) == 0 &&
-				is_pattern_match(&autocmds[i], canonic_path))
+				is_pattern_match(&autocmds[i], canonic_path, name, ascii_path,
+					ascii_name))
 		{
 			autocmds[i].handler(autocmds[i].action, arg);
 		}
 	}
 }
 
-/* Checks whether path matches pattern in the autocommand.  Returns non-zero if
- * so, otherwise zero is returned. */
+/* Checks whether path (or its last component, which is passed in name) matches
+ * pattern in the autocommand.  Returns non-zero if so, otherwise zero is
+ * returned. */
 static int
-is_pattern_match(const aucmd_info_t *autocmd, const char path[])
+is_pattern_match(const aucmd_info_t *autocmd, const char path[],
+		const char name[], int ascii_path, int ascii_name)
 {
-	const char *const part = (strchr(autocmd->pattern, '/') == NULL)
-	                       ? get_last_path_component(path)
-	                       : path;
+	const char *const part = autocmd->full_path ? path : name;
+	const int ascii_part = autocmd->full_path ? ascii_path : ascii_name;
+
+	/* Case-insensitive comparison of ASCII strings is equivalent to matching
+	 * against a regular expression made of escaped literal, but much faster. */
+	if(autocmd->literal && ascii_part)
+	{
+		return (strcasecmp(autocmd->pattern, part) == 0)^autocmd->negated;
+	}
 
 	/* Leading start shouldn't match dot at the first character.  Can't be
 	 * handled by globs->regex translation. */
@@ -189,6 +220,21 @@ is_pattern_match(const aucmd_info_t *autocmd, const char path[])
 	return (regexec(&autocmd->regex, part, 0, NULL, 0) == 0)^autocmd->negated;
 }
 
+/* Checks whether string consists of ASCII characters only.  Returns non-zero
+ * if so, otherwise zero is returned. */
+static int
+is_ascii(const char str[])
+{
+	while(*str != '\0')
+	{
+		if((unsigned char)*str++ >= 0x80)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
 void
 vle_aucmd_remove(const char event[], const char patterns[])
 {
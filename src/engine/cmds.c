@@ -31,6 +31,7 @@
 #include "../utils/str.h"
 #include "../utils/string_array.h"
 #include "../utils/test_helpers.h"
+#include "../utils/trie.h"
 #include "../utils/utils.h"
 #include "completion.h"
 
@@ -44,6 +45,8 @@ typedef struct
 	cmd_add_t user_cmd_handler;
 	cmd_handler command_handler;
 	int custom_cmd_count;        /* Number of non-builtin commands. */
+	trie_t *index;               /* Maps full names of commands to nodes of the
+	                                list, removed commands map to NULL. */
 }
 inner_t;
 
@@ -61,6 +64,10 @@ static const char * get_cmd_name(const char cmd[], char buf[], size_t buf_len);
 static void init_cmd_info(cmd_info_t *cmd_info);
 static const char * skip_prefix_commands(const char cmd[]);
 static cmd_t * find_cmd(const char name[]);
+static cmd_t * find_cmd_exact(const char name[]);
+static void index_cmd(cmd_t *cmd);
+static void unindex_cmd(const char name[]);
+static void reindex_cmds(void);
 static cmd_t * find_cmd_advance(cmd_t *cmd, const char name[]);
 static int find_cmd_match(cmd_t *cmd, const char name[]);
 static const char * parse_range(const char cmd[], cmd_info_t *cmd_info);
@@ -155,6 +162,7 @@ vle_cmds_reset(void)
 
 	inner->head.next = NULL;
 	inner->user_cmd_handler.handler = NULL;
+	trie_free(inner->index);
 
 	free(inner);
 	inner = NULL;
@@ -592,10 +600,79 @@ skip_prefix_commands(const char cmd[])
 static cmd_t *
 find_cmd(const char name[])
 {
-	cmd_t *const cmd = find_cmd_advance(inner->head.next, name);
+	/* Exact match is always the first one among commands which start with the
+	 * name, so there is no need to walk the list in this case. */
+	cmd_t *cmd = find_cmd_exact(name);
+	if(cmd != NULL)
+	{
+		return cmd;
+	}
+
+	cmd = find_cmd_advance(inner->head.next, name);
 	return (find_cmd_match(cmd, name) ? cmd : NULL);
 }
 
+/* Looks up a command whose name matches the parameter completely.  Returns the
+ * command or NULL. */
+static cmd_t *
+find_cmd_exact(const char name[])
+{
+	void *data;
+	if(name[0] == '\0' || trie_get(inner->index, name, &data) != 0)
+	{
+		return NULL;
+	}
+	return data;
+}
+
+/* Adds command to the index of commands. */
+static void
+index_cmd(cmd_t *cmd)
+{
+	if(inner->index == NULL)
+	{
+		inner->index = trie_create(/*free_func=*/NULL);
+	}
+	if(inner->index != NULL && trie_set(inner->index, cmd->name, cmd) < 0)
+	{
+		/* Lookup without index is slower, but still correct. */
+		trie_free(inner->index);
+		inner->index = NULL;
+	}
+}
+
+/* Removes command from the index of commands.  Commands missing in the index
+ * are still found by walking the list. */
+static void
+unindex_cmd(const char name[])
+{
+	if(inner->index != NULL)
+	{
+		(void)trie_set(inner->index, name, NULL);
+	}
+}
+
+/* Builds index of commands anew. */
+static void
+reindex_cmds(void)
+{
+	trie_free(inner->index);
+	inner->index = trie_create(/*free_func=*/NULL);
+
+	cmd_t *cur;
+	for(cur = inner->head.next; cur != NULL; cur = cur->next)
+	{
+		if(inner->index == NULL ||
+				trie_set(inner->index, cur->name, cur) < 0)
+		{
+			/* Lookup without index is slower, but still correct. */
+			trie_free(inner->index);
+			inner->index = NULL;
+			break;
+		}
+	}
+}
+
 /* Advances to the first command whose name is not less than the parameter.
  * Returns advanced values (could be unchanged or NULL). */
 static cmd_t *
@@ -782,7 +859,12 @@ get_cmd_name(const char cmd[], char buf[], size_t buf_len)
 		int cmp;
 		cmd_t *cur;
 
-		cur = inner->head.next;
+		/* Commands preceding exact match can't start with the buffer. */
+		cur = find_cmd_exact(buf);
+		if(cur == NULL)
+		{
+			cur = inner->head.next;
+		}
 		while(cur != NULL && (cmp = strncmp(cur->name, buf, len)) <= 0)
 		{
 			if(cmp == 0)
@@ -1011,6 +1093,7 @@ add_builtin_cmd(const char name[], CMD_TYPE type, const cmd_add_t *conf)
 	new->deleted = 0;
 	init_command_flags(new, conf->flags);
 
+	index_cmd(new);
 	return 0;
 }
 
@@ -1079,6 +1162,9 @@ remove_commands(CMD_TYPE type)
 		}
 	}
 	inner->custom_cmd_count = 0;
+
+	/* Drop names of removed commands from the index. */
+	reindex_cmds();
 }
 
 /* Implements :command builtin command mostly provided by this unit. */
@@ -1170,6 +1256,7 @@ vle_cmds_add_user(const char name[], const char body[], const char descr[],
 	new->deleted = 0;
 	init_command_flags(new, inner->user_cmd_handler.flags);
 
+	index_cmd(new);
 	++inner->custom_cmd_count;
 	return 0;
 }
@@ -1333,6 +1420,7 @@ vle_cmds_del_user(const char name[])
 
 	cmd = cur->next;
 	cur->next = cmd->next;
+	unindex_cmd(cmd->name);
 	free(cmd->name);
 	free(cmd->cmd);
 	free(cmd);
@@ -35,6 +35,7 @@
 #include <wctype.h> /* iswdigit() */
 #include <wchar.h> /* wcscat() wcslen() */
 
+#include "../compat/reallocarray.h"
 #include "../utils/macros.h"
 #include "../utils/str.h"
 #include "mode.h"
@@ -72,6 +73,10 @@ typedef struct key_chunk_t
 	struct key_chunk_t *child;
 	struct key_chunk_t *parent;
 	struct key_chunk_t *prev, *next;
+	/* Direct children sorted by their keys for lookup by binary search. */
+	struct key_chunk_t **index;
+	/* Number of elements in the index. */
+	int index_len;
 }
 key_chunk_t;
 
@@ -108,6 +113,11 @@ static void remove_foreign_in_forest(key_chunk_t *forest, size_t size);
 static void free_forest(key_chunk_t *forest, size_t size);
 static void free_tree(key_chunk_t *root);
 static void free_chunk(key_chunk_t *chunk);
+static key_chunk_t * find_child(const key_chunk_t *chunk, wchar_t key);
+static int find_child_pos(const key_chunk_t *chunk, wchar_t key);
+static int has_nim_child(const key_chunk_t *chunk);
+static int index_child(key_chunk_t *chunk, int pos, key_chunk_t *child);
+static void unindex_child(key_chunk_t *chunk, const key_chunk_t *child);
 static int execute_keys_general_wrapper(const wchar_t keys[], int timed_out,
 		int mapped, int no_remap);
 static int execute_keys_general(const wchar_t keys[], int timed_out, int mapped,
@@ -281,6 +291,10 @@ free_tree(key_chunk_t *root)
 	{
 		free(root->conf.data.cmd);
 	}
+
+	free(root->index);
+	root->index = NULL;
+	root->index_len = 0;
 }
 
 static void
@@ -288,6 +302,7 @@ free_chunk(key_chunk_t *chunk)
 {
 	if(chunk->enters == 0)
 	{
+		free(chunk->index);
 		free(chunk);
 	}
 	else
@@ -296,6 +311,91 @@ free_chunk(key_chunk_t *chunk)
 	}
 }
 
+/* Looks up direct child of the chunk by its key.  Returns the child or
+ * NULL. */
+static key_chunk_t *
+find_child(const key_chunk_t *chunk, wchar_t key)
+{
+	const int pos = find_child_pos(chunk, key);
+	if(pos < chunk->index_len && chunk->index[pos]->key == key)
+	{
+		return chunk->index[pos];
+	}
+	return NULL;
+}
+
+/* Finds position of the first direct child of the chunk whose key is not less
+ * than the key.  Returns the position, which can be equal to number of
+ * children. */
+static int
+find_child_pos(const key_chunk_t *chunk, wchar_t key)
+{
+	int l = 0, u = chunk->index_len;
+	while(l < u)
+	{
+		const int i = l + (u - l)/2;
+		if(chunk->index[i]->key < key)
+		{
+			l = i + 1;
+		}
+		else
+		{
+			u = i;
+		}
+	}
+	return l;
+}
+
+/* Checks whether any of direct children of the chunk accepts number in the
+ * middle.  Returns non-zero if so, otherwise zero is returned. */
+static int
+has_nim_child(const key_chunk_t *chunk)
+{
+	const key_chunk_t *p;
+	for(p = chunk->child; p != NULL; p = p->next)
+	{
+		if(p->type == BUILTIN_NIM_KEYS)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* Inserts child into index of the chunk at specified position.  Returns zero
+ * on success, otherwise non-zero is returned. */
+static int
+index_child(key_chunk_t *chunk, int pos, key_chunk_t *child)
+{
+	key_chunk_t **const index = reallocarray(chunk->index, chunk->index_len + 1,
+			sizeof(*index));
+	if(index == NULL)
+	{
+		return 1;
+	}
+
+	memmove(&index[pos + 1], &index[pos],
+			sizeof(*index)*(chunk->index_len - pos));
+	index[pos] = child;
+
+	chunk->index = index;
+	++chunk->index_len;
+	return 0;
+}
+
+/* Removes child from index of the chunk. */
+static void
+unindex_child(key_chunk_t *chunk, const key_chunk_t *child)
+{
+	const int pos = find_child_pos(chunk, child->key);
+	assert(pos < chunk->index_len && chunk->index[pos] == child &&
+			"Child must be in the index.");
+
+	--chunk->index_len;
+	memmove(&chunk->index[pos], &chunk->index[pos + 1],
+			sizeof(*chunk->index)*(chunk->index_len - pos));
+}
+
 void
 vle_keys_set_def_handler(int mode, default_handler handler)
 {
@@ -421,29 +521,13 @@ dispatch_keys_at_root(const wchar_t keys[], keys_info_t *keys_info,
 	curr = root;
 	while(*keys != L'\0')
 	{
-		key_chunk_t *p;
-		int number_in_the_middle = 0;
-
-		for(p = curr->child; p != NULL && p->key < *keys; p = p->next)
-		{
-			if(p->type == BUILTIN_NIM_KEYS)
-			{
-				number_in_the_middle = 1;
-			}
-		}
-
-		if(p == NULL || p->key != *keys)
+		key_chunk_t *const p = find_child(curr, *keys);
+		if(p == NULL)
 		{
 			if(curr == root)
 				return KEYS_UNKNOWN;
 
-			for(; p != NULL; p = p->next)
-			{
-				if(p->type == BUILTIN_NIM_KEYS)
-				{
-					number_in_the_middle = 1;
-				}
-			}
+			const int number_in_the_middle = has_nim_child(curr);
 
 			if(curr->conf.followed != FOLLOWED_BY_NONE &&
 					(!number_in_the_middle || !is_at_count(keys)))
@@ -542,13 +626,8 @@ dispatch_selector(const wchar_t keys[], keys_info_t *keys_info,
 	 * shortcuts. */
 	while(*keys != L'\0')
 	{
-		key_chunk_t *p;
-
-		for(p = curr->child; p != NULL && p->key < *keys; p = p->next)
-		{
-			/* Advance. */
-		}
-		if(p == NULL || p->key != *keys)
+		key_chunk_t *const p = find_child(curr, *keys);
+		if(p == NULL)
 		{
 			break;
 		}
@@ -642,13 +721,8 @@ contains_chain(key_chunk_t *root, const wchar_t *begin, const wchar_t *end)
 	curr = root;
 	while(begin != end)
 	{
-		key_chunk_t *p;
-
-		p = curr->child;
-		while(p != NULL && p->key < *begin)
-			p = p->next;
-
-		if(p == NULL || p->key != *begin)
+		key_chunk_t *const p = find_child(curr, *begin);
+		if(p == NULL)
 			return 0;
 
 		begin++;
@@ -898,6 +972,7 @@ leave_chunk(key_chunk_t *chunk)
 	{
 		/* Removal of the chunk was postponed because it was in use, proceed with
 		 * this now. */
+		free(chunk->index);
 		free(chunk);
 	}
 }
@@ -1074,10 +1149,8 @@ find_keys(key_chunk_t *root, const wchar_t keys[])
 	key_chunk_t *curr = root;
 	while(*keys != L'\0')
 	{
-		key_chunk_t *p = curr->child;
-		while(p != NULL && p->key < *keys)
-			p = p->next;
-		if(p == NULL || p->key != *keys)
+		key_chunk_t *const p = find_child(curr, *keys);
+		if(p == NULL)
 			return NULL;
 		curr = p;
 		keys++;
@@ -1111,6 +1184,7 @@ remove_chunk(key_chunk_t *chunk)
 	do
 	{
 		key_chunk_t *const parent = chunk->parent;
+		unindex_child(parent, chunk);
 		if(chunk->prev != NULL)
 			chunk->prev->next = chunk->next;
 		else
@@ -1175,19 +1249,19 @@ add_keys_inner(key_chunk_t *root, const wchar_t *keys)
 	key_chunk_t *curr = root;
 	while(*keys != L'\0')
 	{
-		key_chunk_t *prev, *p;
-		prev = NULL;
-		p = curr->child;
-		while(p != NULL && p->key < *keys)
-		{
-			prev = p;
-			p = p->next;
-		}
+		const int pos = find_child_pos(curr, *keys);
+		key_chunk_t *prev = (pos > 0) ? curr->index[pos - 1] : NULL;
+		key_chunk_t *p = (pos < curr->index_len) ? curr->index[pos] : NULL;
 		if(p == NULL || p->key != *keys)
 		{
 			key_chunk_t *c = malloc(sizeof(*c));
 			if(c == NULL)
 				return NULL;
+			if(index_child(curr, pos, c) != 0)
+			{
+				free(c);
+				return NULL;
+			}
 			c->key = *keys;
 			c->type = (keys[1] == L'\0') ? BUILTIN_KEYS : BUILTIN_WAIT_POINT;
 			c->conf.data.handler = NULL;
@@ -1200,6 +1274,8 @@ add_keys_inner(key_chunk_t *root, const wchar_t *keys)
 			c->prev = prev;
 			c->next = p;
 			c->child = NULL;
+			c->index = NULL;
+			c->index_len = 0;
 			c->parent = curr;
 			c->children_count = 0;
 			c->enters = 0;
@@ -1362,21 +1438,11 @@ keys_suggest(const key_chunk_t *root, const wchar_t keys[],
 
 	while(*keys != L'\0')
 	{
-		const key_chunk_t *p;
-		int number_in_the_middle = 0;
-
-		/* Look up current key among children of current node (might be root), while
-		 * inspecting NIM as well. */
-		for(p = curr->child; p != NULL && p->key < *keys; p = p->next)
-		{
-			if(p->type == BUILTIN_NIM_KEYS)
-			{
-				number_in_the_middle = 1;
-			}
-		}
+		/* Look up current key among children of current node (might be root). */
+		const key_chunk_t *const p = find_child(curr, *keys);
 
 		/* Go to the next character if a match is found. */
-		if(p != NULL && p->key == *keys)
+		if(p != NULL)
 		{
 			++keys;
 			curr = p;
@@ -1402,13 +1468,7 @@ keys_suggest(const key_chunk_t *root, const wchar_t keys[],
 		}
 
 		/* Need to inspect all children for NIM. */
-		for(; p != NULL && !number_in_the_middle; p = p->next)
-		{
-			if(p->type == BUILTIN_NIM_KEYS)
-			{
-				number_in_the_middle = 1;
-			}
-		}
+		const int number_in_the_middle = has_nim_child(curr);
 
 		/* Give up if this isn't one of cases where next character is not presented
 		 * in the tree by design. */
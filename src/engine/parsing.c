@@ -21,7 +21,8 @@
  *
  * Output of parsing phase is an expression tree, which is made of nodes of type
  * expr_t.  After parsing they either contain literals or specification of how
- * their value should be evaluated.  Expression value is evaluated at most once.
+ * their value should be evaluated.  Value of a node is recomputed on every
+ * evaluation, which allows reusing trees.
  *
  * There are two types of evaluation-time operations (part of Ops enumeration):
  *  1. With specific evaluation order requirements.
@@ -38,7 +39,12 @@
  *
  * If parsing stops before the end of an expression, partial result is stored in
  * global variables to be queried by client code (this way expressions can
- * follow one another on a line and parsed sequentially). */
+ * follow one another on a line and parsed sequentially).
+ *
+ * Successfully parsed expressions that don't depend on state at the moment of
+ * parsing (no environment variables, builtin variables or options) are kept in
+ * a small cache keyed by input string and are reused on subsequent parsing of
+ * the same input. */
 
 #include "parsing.h"
 
@@ -63,6 +69,9 @@
 /* Maximum number of characters in option's name. */
 static const size_t OPTION_NAME_MAX = 64;
 
+/* Number of entries in the cache of parsed expressions. */
+#define PARSE_CACHE_SIZE 32
+
 /* Supported types of tokens. */
 typedef enum
 {
@@ -96,7 +105,7 @@ TOKENS_TYPE;
 /* Types of evaluation operations. */
 typedef enum
 {
-	OP_NONE, /* The node has already been evaluated or is a literal. */
+	OP_NONE, /* The node is a literal. */
 	OP_OR,   /* Logical OR. */
 	OP_AND,  /* Logical AND. */
 	OP_CALL, /* Builtin operator implemented as a function or builtin function. */
@@ -122,6 +131,19 @@ typedef struct expr_t
 }
 expr_t;
 
+/* Entry of the cache of parsed expressions. */
+typedef struct
+{
+	char *input;           /* Parsed string or NULL for an unused entry. */
+	unsigned int hash;     /* Hash of the input to speed up lookup. */
+	expr_t expr;           /* Expression tree. */
+	size_t parsed_len;     /* Number of characters consumed by the parser. */
+	TOKENS_TYPE last_type; /* Type of the last read token. */
+	TOKENS_TYPE prev_type; /* Type of the token before the last one. */
+	int in_use;            /* Whether the entry is being evaluated. */
+}
+parse_cache_entry_t;
+
 /* Metadata container for static buffer. */
 typedef struct
 {
@@ -142,6 +164,12 @@ static int compare_variables(TOKENS_TYPE operation, var_t lhs, var_t rhs);
 static var_t eval_concat(eval_context_t *ctx, int nops, expr_t ops[]);
 static int add_expr_op(expr_t *expr, const expr_t *arg);
 static void free_expr(const expr_t *expr);
+static parse_cache_entry_t * cache_lookup(const char input[], unsigned int hash);
+static int functions_are_registered(const expr_t *expr);
+static parse_cache_entry_t * cache_store(const char input[], unsigned int hash,
+		const expr_t *expr);
+static void cache_clear(void);
+static unsigned int hash_input(const char input[]);
 static expr_t parse_or_expr(const char **in);
 static expr_t parse_and_expr(const char **in);
 static expr_t parse_comp_expr(const char **in);
@@ -181,6 +209,13 @@ static ParsingErrors last_error;
 static const char *last_position;
 static const char *last_parsed_char;
 static var_t res_val;
+/* Whether currently parsed expression depends on state at parse-time. */
+static int state_dependent;
+
+/* Cache of parsed expressions. */
+static parse_cache_entry_t parse_cache[PARSE_CACHE_SIZE];
+/* Index of the next entry of the cache to be replaced. */
+static int parse_cache_next;
 
 /* Empty expression to be returned on errors. */
 static expr_t null_expr;
@@ -192,6 +227,7 @@ init_parser(getenv_func getenv_f)
 {
 	getenv_fu = getenv_f;
 	initialized = 1;
+	cache_clear();
 }
 
 const char *
@@ -211,16 +247,43 @@ get_last_parsed_char(void)
 ParsingErrors
 parse(const char input[], int interactive, var_t *result)
 {
-	expr_t expr_root;
+	expr_t parsed;
+	expr_t *expr_root = &parsed;
+	const unsigned int hash = hash_input(input);
+	parse_cache_entry_t *entry;
 
 	assert(initialized && "Parser must be initialized before use.");
 
 	last_error = PE_NO_ERROR;
-	last_token.type = BEGIN;
 
-	last_position = input;
-	get_next(&last_position);
-	expr_root = parse_or_expr(&last_position);
+	entry = cache_lookup(input, hash);
+	if(entry == NULL)
+	{
+		last_token.type = BEGIN;
+		state_dependent = 0;
+
+		last_position = input;
+		get_next(&last_position);
+		parsed = parse_or_expr(&last_position);
+
+		if(last_error == PE_NO_ERROR && !state_dependent)
+		{
+			entry = cache_store(input, hash, &parsed);
+		}
+	}
+	else
+	{
+		last_position = input + entry->parsed_len;
+		last_token.type = entry->last_type;
+		prev_token.type = entry->prev_type;
+	}
+
+	if(entry != NULL)
+	{
+		/* Evaluation can parse other expressions, make sure the tree stays. */
+		expr_root = &entry->expr;
+		entry->in_use = 1;
+	}
 	last_parsed_char = last_position;
 
 	var_free(res_val);
@@ -241,9 +304,9 @@ parse(const char input[], int interactive, var_t *result)
 				/* This is a comment, just ignore it. */
 				last_position += strlen(last_position);
 			}
-			else if(eval_expr(&ctx, &expr_root) == 0)
+			else if(eval_expr(&ctx, expr_root) == 0)
 			{
-				res_val = var_clone(expr_root.value);
+				res_val = var_clone(expr_root->value);
 				last_error = PE_INVALID_EXPRESSION;
 			}
 		}
@@ -251,10 +314,10 @@ parse(const char input[], int interactive, var_t *result)
 
 	if(last_error == PE_NO_ERROR)
 	{
-		if(eval_expr(&ctx, &expr_root) == 0)
+		if(eval_expr(&ctx, expr_root) == 0)
 		{
-			res_val = var_clone(expr_root.value);
-			*result = var_clone(expr_root.value);
+			res_val = var_clone(expr_root->value);
+			*result = var_clone(expr_root->value);
 		}
 	}
 
@@ -263,7 +326,14 @@ parse(const char input[], int interactive, var_t *result)
 		last_position = skip_whitespace(input);
 	}
 
-	free_expr(&expr_root);
+	if(entry == NULL)
+	{
+		free_expr(&parsed);
+	}
+	else
+	{
+		entry->in_use = 0;
+	}
 	return last_error;
 }
 
@@ -289,11 +359,22 @@ static int
 eval_expr(eval_context_t *ctx, expr_t *expr)
 {
 	int result = 1;
+
+	if(expr->op_type == OP_NONE)
+	{
+		/* Do nothing, value is already available. */
+		return 0;
+	}
+
+	/* Drop result of previous evaluation of the tree. */
+	var_free(expr->value);
+	expr->value = var_false();
+
 	switch(expr->op_type)
 	{
 		case OP_NONE:
-			/* Do nothing, value is already available. */
-			return 0;
+			/* Handled above. */
+			break;
 		case OP_OR:
 			result = eval_or_op(ctx, expr->nops, expr->ops, &expr->value);
 			break;
@@ -306,10 +387,6 @@ eval_expr(eval_context_t *ctx, expr_t *expr)
 					&expr->value);
 			break;
 	}
-	if(result == 0)
-	{
-		expr->op_type = OP_NONE;
-	}
 	return result;
 }
 
@@ -602,6 +679,129 @@ free_expr(const expr_t *expr)
 	free(expr->ops);
 }
 
+/* Cache of parsed expressions ---------------------------------------------- */
+
+/* Looks up parsed expression for the input in the cache.  Returns the entry or
+ * NULL if there is no usable one. */
+static parse_cache_entry_t *
+cache_lookup(const char input[], unsigned int hash)
+{
+	int i;
+	for(i = 0; i < PARSE_CACHE_SIZE; ++i)
+	{
+		parse_cache_entry_t *const entry = &parse_cache[i];
+		if(entry->input == NULL || entry->in_use || entry->hash != hash ||
+				strcmp(entry->input, input) != 0)
+		{
+			continue;
+		}
+
+		/* Set of functions could have changed since the entry was added. */
+		if(!functions_are_registered(&entry->expr))
+		{
+			free_expr(&entry->expr);
+			update_string(&entry->input, NULL);
+			return NULL;
+		}
+		return entry;
+	}
+	return NULL;
+}
+
+/* Checks that all functions called by the expression are still available.
+ * Returns non-zero if so, otherwise zero is returned. */
+static int
+functions_are_registered(const expr_t *expr)
+{
+	int i;
+
+	if(expr->op_type == OP_CALL && isalpha(expr->func[0]) &&
+			!function_registered(expr->func))
+	{
+		return 0;
+	}
+
+	for(i = 0; i < expr->nops; ++i)
+	{
+		if(!functions_are_registered(&expr->ops[i]))
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* Puts just parsed expression into the cache, which takes ownership of the
+ * expression tree on success.  Entries that are being evaluated are never
+ * replaced.  Returns the entry or NULL if expression wasn't cached. */
+static parse_cache_entry_t *
+cache_store(const char input[], unsigned int hash, const expr_t *expr)
+{
+	parse_cache_entry_t *entry = NULL;
+	int i;
+
+	for(i = 0; i < PARSE_CACHE_SIZE && entry == NULL; ++i)
+	{
+		parse_cache_entry_t *const candidate = &parse_cache[parse_cache_next];
+		parse_cache_next = (parse_cache_next + 1)%PARSE_CACHE_SIZE;
+		if(!candidate->in_use)
+		{
+			entry = candidate;
+		}
+	}
+
+	if(entry == NULL)
+	{
+		return NULL;
+	}
+
+	if(entry->input != NULL)
+	{
+		free_expr(&entry->expr);
+	}
+
+	if(update_string(&entry->input, input) != 0)
+	{
+		update_string(&entry->input, NULL);
+		return NULL;
+	}
+
+	entry->hash = hash;
+	entry->expr = *expr;
+	entry->parsed_len = last_position - input;
+	entry->last_type = last_token.type;
+	entry->prev_type = prev_token.type;
+	return entry;
+}
+
+/* Empties the cache of parsed expressions. */
+static void
+cache_clear(void)
+{
+	int i;
+	for(i = 0; i < PARSE_CACHE_SIZE; ++i)
+	{
+		if(parse_cache[i].input != NULL)
+		{
+			free_expr(&parse_cache[i].expr);
+			update_string(&parse_cache[i].input, NULL);
+		}
+	}
+	parse_cache_next = 0;
+}
+
+/* Computes hash of the input string.  Returns the hash. */
+static unsigned int
+hash_input(const char input[])
+{
+	unsigned int hash = 5381U;
+	while(*input != '\0')
+	{
+		hash = hash*33U + (unsigned char)*input++;
+	}
+	return hash;
+}
+
 /* Input parsing ------------------------------------------------------------ */
 
 /* or_expr ::= and_expr | and_expr '||' or_expr */
@@ -1112,6 +1312,7 @@ eval_envvar(const char **in)
 		return var_false();
 	}
 
+	state_dependent = 1;
 	return var_from_str(getenv_fu(name));
 }
 
@@ -1140,6 +1341,7 @@ eval_builtinvar(const char **in)
 		return var_false();
 	}
 
+	state_dependent = 1;
 	var_value = getvar(name);
 	if(var_value.type == VTYPE_ERROR)
 	{
@@ -1173,6 +1375,7 @@ eval_opt(const char **in)
 		return var_false();
 	}
 
+	state_dependent = 1;
 	option = vle_opts_find(name, scope);
 	if(option == NULL)
 	{
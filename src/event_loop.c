@@ -37,13 +37,16 @@
 #include "engine/mode.h"
 #include "lua/vlua.h"
 #include "modes/dialogs/msg_dialog.h"
+#include "modes/menu.h"
 #include "modes/modes.h"
 #include "modes/wk.h"
 #include "ui/fileview.h"
 #include "ui/quickview.h"
 #include "ui/statusbar.h"
 #include "ui/statusline.h"
+#include "ui/tabs.h"
 #include "ui/ui.h"
+#include "utils/idcache.h"
 #include "utils/log.h"
 #include "utils/macros.h"
 #include "utils/test_helpers.h"
@@ -52,6 +55,7 @@
 #include "background.h"
 #include "bracket_notation.h"
 #include "filelist.h"
+#include "flist_stream.h"
 #include "instance.h"
 #include "ipc.h"
 #include "registers.h"
@@ -63,6 +67,8 @@ static int ensure_term_is_ready(void);
 static int get_char_async_loop(WINDOW *win, wint_t *c, int timeout);
 static int is_previewed(const char path[]);
 static void process_scheduled_updates(void);
+static void check_for_resolved_ids(void);
+static void check_for_streamed_entries(void);
 TSTATIC int process_scheduled_updates_of_view(view_t *view);
 static void update_hardware_cursor(void);
 static int should_check_views_for_changes(void);
@@ -387,6 +393,8 @@ get_char_async_loop(WINDOW *win, wint_t *c, int timeout)
 			check_view_for_changes(other_view);
 		}
 
+		check_for_resolved_ids();
+		check_for_streamed_entries();
 		process_scheduled_updates();
 
 		for(i = 0; i < IPC_F && timeout > 0; ++i)
@@ -401,6 +409,8 @@ get_char_async_loop(WINDOW *win, wint_t *c, int timeout)
 				stats_redraw_later();
 			}
 
+			modmenu_check_for_updates();
+
 			wtimeout(win, delay_slice);
 			timeout -= delay_slice;
 
@@ -506,6 +516,43 @@ process_scheduled_updates(void)
 	}
 }
 
+/* Schedules redraw of views if names of users or groups became known, because
+ * until then numbers are displayed in their place. */
+static void
+check_for_resolved_ids(void)
+{
+#ifndef _WIN32
+	if(!idcache_check())
+	{
+		return;
+	}
+
+	int i;
+	tab_info_t tab_info;
+	for(i = 0; tabs_enum_all(i, &tab_info); ++i)
+	{
+		fview_formats_updated(tab_info.view);
+	}
+
+	ui_view_schedule_redraw(curr_view);
+	ui_view_schedule_redraw(other_view);
+#endif
+}
+
+/* Adds entries to custom views that are still being populated by commands and
+ * subtrees of directories unfolded in tree-views. */
+static void
+check_for_streamed_entries(void)
+{
+	int i;
+	tab_info_t tab_info;
+	for(i = 0; tabs_enum_all(i, &tab_info); ++i)
+	{
+		flist_stream_update(tab_info.view);
+		flist_finish_unfolding(tab_info.view);
+	}
+}
+
 /* Performs postponed updates for the view, if any.  Returns non-zero if
  * something was indeed updated, and zero otherwise. */
 TSTATIC int
@@ -29,6 +29,7 @@
 #include <curses.h>
 
 #include <sys/stat.h> /* stat */
+#include <unistd.h> /* usleep() */
 
 #include <assert.h> /* assert() */
 #include <errno.h> /* errno */
@@ -57,11 +58,15 @@
 #include "ui/statusline.h"
 #include "ui/tabs.h"
 #include "ui/ui.h"
+#include "utils/cancellation.h"
+#include "utils/darray.h"
 #include "utils/dynarray.h"
 #include "utils/env.h"
+#include "utils/filter.h"
 #include "utils/fs.h"
 #include "utils/fsdata.h"
 #include "utils/fswatch.h"
+#include "utils/idcache.h"
 #include "utils/log.h"
 #include "utils/macros.h"
 #include "utils/matcher.h"
@@ -73,11 +78,14 @@
 #include "utils/trie.h"
 #include "utils/utf8.h"
 #include "utils/utils.h"
+#include "utils/walker.h"
 #include "filtering.h"
 #include "flist_hist.h"
+#include "flist_stream.h"
 #include "flist_pos.h"
 #include "flist_sel.h"
 #include "fops_misc.h"
+#include "locate_index.h"
 #include "macros.h"
 #include "marks.h"
 #include "opt_handlers.h"
@@ -85,6 +93,7 @@
 #include "running.h"
 #include "sort.h"
 #include "status.h"
+#include "trace.h"
 #include "types.h"
 
 /* State of a fold. */
@@ -99,11 +108,84 @@ typedef enum
 }
 FoldState;
 
+enum
+{
+	TREE_WORKERS = 4,      /* Number of threads listing directories of a tree. */
+	TREE_POLL_PERIOD = 10, /* Period of checking listing of a tree in ms. */
+};
+
+/* Information about a file of a tree obtained by a worker thread. */
+typedef struct
+{
+	char *name;        /* Name of the file. */
+	dir_entry_t entry; /* Loaded entry, valid only if loaded is set. */
+	int loaded;        /* Whether the entry was loaded and not yet consumed. */
+	int dir;           /* Whether it's a directory or a symbolic link to one. */
+	int real_dir;      /* Whether it's a directory and not a link to one. */
+}
+tree_item_t;
+
+/* List of files of a single directory of a tree. */
+typedef struct
+{
+	char *path;              /* Path to the directory. */
+	tree_item_t *items;      /* Files of the directory in the order of listing. */
+	DA_INSTANCE_FIELD(items);
+	int broken;              /* Set if some of the files are missing. */
+}
+tree_listing_t;
+
+/* Listings of directories of a tree made in parallel before building it. */
+typedef struct
+{
+	view_t *view;           /* View whose filters are checked or NULL. */
+	const char *base_dir;   /* Base for relative paths of entries. */
+	int hide_dot;           /* Whether dot files are hidden. */
+	trie_t *excluded_paths; /* Paths that shouldn't be in the tree. */
+	trie_t *folded_paths;   /* States of folds. */
+	int depth;              /* Limit on nesting level. */
+
+	/* Listings made by each of the workers. */
+	struct
+	{
+		tree_listing_t **listings;
+		DA_INSTANCE_FIELD(listings);
+	}
+	workers[TREE_WORKERS];
+
+	trie_t *listings; /* Maps path of a directory onto its listing. */
+
+	/* If not NULL, directories that would be expanded while building a tree are
+	 * collected here instead, so that their subtrees can be added later. */
+	strlist_t *deferred;
+}
+tree_prefetch_t;
+
+/* State of listing a directory that was unfolded in a tree view or the whole
+ * tree while its top level is already shown. */
+typedef struct tree_unfold_t
+{
+	char *path;               /* Path to the directory being listed. */
+	strlist_t dirs;           /* Directories whose subtrees are to be added. */
+	char *base_dir;           /* Root of the tree. */
+	trie_t *excluded_paths;   /* Copy of excluded paths of the view. */
+	trie_t *folded_paths;     /* Copy of fold states of the view. */
+	tree_prefetch_t prefetch; /* Listings of the subtree. */
+
+	pthread_t thread;         /* Thread that lists the subtree. */
+	pthread_mutex_t lock;     /* Protects fields below. */
+	int done;                 /* Whether listing has finished. */
+	int cancelled;            /* Whether listing should be stopped. */
+}
+tree_unfold_t;
+
 static void init_flist(view_t *view);
 static void reset_view(view_t *view);
 static void init_view_history(view_t *view);
 static int navigate_to_file_in_custom_view(view_t *view, const char dir[],
 		const char file[]);
+static dir_entry_t * copy_entry_to(dir_entry_t **list, int *list_size,
+		const dir_entry_t *entry);
 static int fill_dir_entry_by_path(dir_entry_t *entry, const char path[]);
 #ifndef _WIN32
 static int fill_dir_entry(dir_entry_t *entry, const char path[],
@@ -127,6 +209,7 @@ static int is_temporary(view_t *view, const dir_entry_t *entry, void *arg);
 static void flist_custom_drop_save(view_t *view);
 static uint64_t recalc_entry_size(const dir_entry_t *entry, uint64_t old_size);
 static uint64_t entry_calc_nitems(const dir_entry_t *entry);
+static void request_ids(const view_t *view);
 static void load_dir_list_internal(view_t *view, int reload, int draw_only);
 static int populate_dir_list_internal(view_t *view, int reload);
 static int populate_custom_view(view_t *view, int reload);
@@ -161,9 +244,22 @@ static int correct_pos(view_t *view, int pos, int dist, int closest);
 static int rescue_from_empty_filelist(view_t *view);
 static void add_parent_entry(view_t *view, dir_entry_t **entries, int *count);
 static void init_dir_entry(view_t *view, dir_entry_t *entry, const char name[]);
+static void reset_dir_entry(dir_entry_t *entry, const char name[]);
 static dir_entry_t * alloc_dir_entry(dir_entry_t **list, int list_size);
 static int tree_has_changed(const dir_entry_t *entries, size_t nchildren);
 static FSWatchState poll_watcher(fswatch_t *watch, const char path[]);
+static int start_unfolding(view_t *view, const char path[]);
+static tree_unfold_t * list_in_background(view_t *view, const char path[],
+		trie_t *excluded_paths, trie_t *folded_paths);
+static void * unfold_thread(void *arg);
+static int unfolding_cancelled(void *arg);
+static int unfolding_is_done(tree_unfold_t *unfold);
+static int splice_subtree(view_t *view, tree_unfold_t *unfold,
+		const char path[]);
+static int insert_subtree(view_t *view, int pos, dir_entry_t *entries,
+		int count);
+static void free_unfolding(tree_unfold_t *unfold);
+static void free_unfolding_data(tree_unfold_t *unfold);
 static void remove_child_entries(view_t *view, dir_entry_t *entry);
 static void find_dir_in_cdpath(const char base_dir[], const char dst[],
 		char buf[], size_t buf_size);
@@ -180,14 +276,33 @@ static int flist_load_tree_internal(view_t *view, const char path[], int reload,
 		int depth);
 static int make_tree(view_t *view, const char path[], int reload,
 		trie_t *excluded_paths, trie_t *folded_paths, int depth);
+static int add_tree_files(view_t *view, const char path[], int progressive,
+		trie_t *excluded_paths, trie_t *folded_paths, int depth,
+		tree_unfold_t **unfold);
 static void tree_from_cv(view_t *view);
 static int complete_tree(const char name[], int valid, const void *parent_data,
 		void *data, void *arg);
 static void reset_entry_list(view_t *view, dir_entry_t **entries, int *count);
 static void drop_tops(dir_entry_t *entries, int *nentries, int extra);
+static void prefetch_tree(tree_prefetch_t *prefetch, view_t *view,
+		const char path[], trie_t *excluded_paths, trie_t *folded_paths,
+		int depth);
+static void init_prefetch(tree_prefetch_t *prefetch, view_t *view,
+		const char base_dir[], int hide_dot, trie_t *excluded_paths,
+		trie_t *folded_paths, int depth);
+static void run_prefetch(tree_prefetch_t *prefetch, const char path[],
+		const cancellation_t *cancellation);
+static int prefetch_visitor(const walker_entry_t *entry, void *arg);
+static tree_listing_t * get_listing(tree_prefetch_t *prefetch,
+		const walker_entry_t *entry);
+static int should_descend(const tree_prefetch_t *prefetch,
+		const tree_listing_t *listing, const walker_entry_t *entry);
+static int prefetch_is_visible(const tree_prefetch_t *prefetch,
+		const char dir[], const char name[], int is_dir, int apply_local_filter);
+static void free_tree_prefetch(tree_prefetch_t *prefetch);
 static int add_files_recursively(view_t *view, const char path[],
-		trie_t *excluded_paths, trie_t *folded_paths, int parent_pos,
-		int no_direct_parent, int depth);
+		trie_t *excluded_paths, trie_t *folded_paths, tree_prefetch_t *prefetch,
+		int parent_pos, int no_direct_parent, int depth);
 static FoldState get_fold_state(trie_t *folded_paths, const char full_path[]);
 static int set_fold_state(trie_t *folded_paths, const char full_path[],
 		FoldState state);
@@ -198,6 +313,10 @@ static int add_directory_leaf(view_t *view, const char path[], int parent_pos);
 static int init_parent_entry(view_t *view, dir_entry_t *entry,
 		const char path[]);
 
+/* How long building of a tree can wait for its listing before showing only the
+ * top level (in ms). */
+TSTATIC int tree_build_budget_ms = 250;
+
 void
 init_filelists(void)
 {
@@ -242,6 +361,8 @@ init_flist(view_t *view)
 	view->custom.entry_count = 0;
 	view->custom.orig_dir = NULL;
 	view->custom.title = NULL;
+	view->custom.stream = NULL;
+	view->custom.unfolding = NULL;
 
 	/* Load fake empty element to make dir_entry valid. */
 	view->dir_entry = dynarray_cextend(NULL, sizeof(dir_entry_t));
@@ -274,6 +395,12 @@ flist_free_view(view_t *view)
 
 	free_dir_entries(&view->custom.full.entries, &view->custom.full.nentries);
 
+	flist_stream_free(view->custom.stream);
+	view->custom.stream = NULL;
+
+	free_unfolding(view->custom.unfolding);
+	view->custom.unfolding = NULL;
+
 	/* Two pointer fields below don't contain valid data that needs to be freed,
 	 * zeroing them for tests and to at least mention them to signal that they
 	 * weren't forgotten. */
@@ -284,6 +411,9 @@ flist_free_view(view_t *view)
 	update_string(&view->local_filter.prev, NULL);
 	free(view->local_filter.poshist);
 	view->local_filter.poshist = NULL;
+	free(view->local_filter.rejected);
+	view->local_filter.rejected = NULL;
+	update_string(&view->local_filter.rejected_by, NULL);
 
 	filter_dispose(&view->local_filter.filter);
 	filter_dispose(&view->auto_filter);
@@ -882,6 +1012,69 @@ flist_custom_put(view_t *view, dir_entry_t *entry)
 	return dir_entry;
 }
 
+dir_entry_t *
+flist_custom_append(view_t *view, dir_entry_t *entry)
+{
+	if(!filter_is_empty(&view->local_filter.filter) &&
+			!local_filter_matches(view, entry))
+	{
+		/* Filtered out entry is still part of the full list. */
+		flist_custom_save(view);
+		(void)copy_entry_to(&view->custom.full.entries,
+				&view->custom.full.nentries, entry);
+		++view->filtered;
+		fentry_free(entry);
+		return NULL;
+	}
+
+	if(view->custom.full.nentries != 0)
+	{
+		(void)copy_entry_to(&view->custom.full.entries,
+				&view->custom.full.nentries, entry);
+	}
+
+	dir_entry_t *const dir_entry = alloc_dir_entry(&view->dir_entry,
+			view->list_rows);
+	if(dir_entry == NULL)
+	{
+		fentry_free(entry);
+		return NULL;
+	}
+
+	*dir_entry = *entry;
+	++view->list_rows;
+
+	/* New entry wasn't matched against the last search pattern, so results of
+	 * the next search can't be narrowed from those of the last one. */
+	view->matches = 0;
+	return dir_entry;
+}
+
+/* Appends a deep copy of the entry to the list.  Returns pointer to the copy or
+ * NULL on failure. */
+static dir_entry_t *
+copy_entry_to(dir_entry_t **list, int *list_size, const dir_entry_t *entry)
+{
+	dir_entry_t *const copy = alloc_dir_entry(list, *list_size);
+	if(copy == NULL)
+	{
+		return NULL;
+	}
+
+	*copy = *entry;
+	copy->name = strdup(entry->name);
+	copy->origin = strdup(entry->origin);
+	copy->owns_origin = 1;
+	if(copy->name == NULL || copy->origin == NULL)
+	{
+		fentry_free(copy);
+		return NULL;
+	}
+
+	++*list_size;
+	return copy;
+}
+
 void
 flist_custom_add_separator(view_t *view, int id)
 {
@@ -1161,6 +1354,12 @@ on_location_change(view_t *view, int force)
 {
 	view->has_dups = 0;
 
+	flist_stream_free(view->custom.stream);
+	view->custom.stream = NULL;
+
+	free_unfolding(view->custom.unfolding);
+	view->custom.unfolding = NULL;
+
 	flist_custom_drop_save(view);
 
 	if(force || (cfg.cvoptions & CVO_LOCALFILTER))
@@ -1639,7 +1838,15 @@ entry_calc_nitems(const dir_entry_t *entry)
 int
 populate_dir_list(view_t *view, int reload)
 {
+	const long long start = trace_begin();
 	const int result = populate_dir_list_internal(view, reload);
+	trace_end(TP_POPULATE_DIR, start);
+
+	if(result == 0)
+	{
+		request_ids(view);
+	}
+
 	if(view->list_pos > view->list_rows - 1)
 	{
 		view->list_pos = view->list_rows - 1;
@@ -1647,6 +1854,35 @@ populate_dir_list(view_t *view, int reload)
 	return result;
 }
 
+/* Starts resolving names of owners and groups of entries of the view in
+ * background, so they are ready by the time they are displayed. */
+static void
+request_ids(const view_t *view)
+{
+#ifndef _WIN32
+	uid_t last_uid = (uid_t)-1;
+	gid_t last_gid = (gid_t)-1;
+
+	int i;
+	for(i = 0; i < view->list_rows; ++i)
+	{
+		const dir_entry_t *const entry = &view->dir_entry[i];
+
+		/* Neighbouring entries often have the same owner. */
+		if(entry->uid != last_uid)
+		{
+			last_uid = entry->uid;
+			idcache_request(IK_USER, last_uid);
+		}
+		if(entry->gid != last_gid)
+		{
+			last_gid = entry->gid;
+			idcache_request(IK_GROUP, last_gid);
+		}
+	}
+#endif
+}
+
 void
 load_dir_list(view_t *view, int reload)
 {
@@ -1989,6 +2225,7 @@ zap_compare_view(view_t *view, view_t *other, zap_filter filter, void *arg)
 				continue;
 			}
 			replace_string(&entry->name, "");
+			entry->name_width = 0;
 			entry->type = FT_UNK;
 			entry->id = other->dir_entry[i].id;
 		}
@@ -2635,8 +2872,16 @@ add_parent_entry(view_t *view, dir_entry_t **entries, int *count)
 static void
 init_dir_entry(view_t *view, dir_entry_t *entry, const char name[])
 {
-	entry->name = strdup(name);
+	reset_dir_entry(entry, name);
 	entry->origin = &view->curr_dir[0];
+}
+
+/* Initializes dir_entry_t with name and all other fields except for origin with
+ * default values. */
+static void
+reset_dir_entry(dir_entry_t *entry, const char name[])
+{
+	entry->name = strdup(name);
 
 	entry->size = 0ULL;
 #ifndef _WIN32
@@ -2657,6 +2902,7 @@ init_dir_entry(view_t *view, dir_entry_t *entry, const char name[])
 	entry->dir_link = 0;
 	entry->hi_num = -1;
 	entry->name_dec_num = -1;
+	entry->name_width = 0;
 
 	entry->child_count = 0;
 	entry->child_pos = 0;
@@ -2756,25 +3002,37 @@ entry_list_add(view_t *view, dir_entry_t **list, int *list_size,
 		const char path[])
 {
 	dir_entry_t *const dir_entry = alloc_dir_entry(list, *list_size);
-	if(dir_entry == NULL)
+	if(dir_entry == NULL || fentry_load(dir_entry, path) != 0)
 	{
 		return NULL;
 	}
 
-	init_dir_entry(view, dir_entry, get_last_path_component(path));
+	++*list_size;
+	return dir_entry;
+}
+
+int
+fentry_load(dir_entry_t *entry, const char path[])
+{
+	reset_dir_entry(entry, get_last_path_component(path));
 
-	dir_entry->origin = strdup(path);
-	dir_entry->owns_origin = 1;
-	remove_last_path_component(dir_entry->origin);
+	entry->origin = strdup(path);
+	entry->owns_origin = 1;
+	if(entry->name == NULL || entry->origin == NULL)
+	{
+		fentry_free(entry);
+		return 1;
+	}
 
-	if(fill_dir_entry_by_path(dir_entry, path) != 0)
+	remove_last_path_component(entry->origin);
+
+	if(fill_dir_entry_by_path(entry, path) != 0)
 	{
-		fentry_free(dir_entry);
-		return NULL;
+		fentry_free(entry);
+		return 1;
 	}
 
-	++*list_size;
-	return dir_entry;
+	return 0;
 }
 
 /* Allocates one more directory entry for the *list of size list_size by
@@ -2818,6 +3076,11 @@ check_if_filelist_has_changed(view_t *view)
 		FSWatchState state = poll_watcher(view->watch, curr_dir);
 		changed = (state != FSWS_UNCHANGED);
 		failed = (state == FSWS_ERRORED);
+
+		if(changed && !failed)
+		{
+			locidx_dir_changed(curr_dir);
+		}
 	}
 
 	/* Check if we still have permission to visit this directory. */
@@ -2935,7 +3198,9 @@ flist_update_cache(view_t *view, cached_entries_t *cache, const char path[])
 static FSWatchState
 poll_watcher(fswatch_t *watch, const char path[])
 {
+	const long long start = trace_begin();
 	FSWatchState state = fswatch_poll(watch);
+	trace_end(TP_FSWATCH_POLL, start);
 
 	if(state == FSWS_ERRORED || state == FSWS_REPLACED)
 	{
@@ -3011,12 +3276,307 @@ flist_toggle_fold(view_t *view)
 	if(set_fold_state(view->custom.folded_paths, full_path, state))
 	{
 		curr->folded = !curr->folded;
+
+		/* Folded directories of a tree have no children loaded, so instead of
+		 * reloading whole tree only the unfolded subtree is listed in
+		 * background. */
+		if(!curr->folded && view->custom.type == CV_TREE &&
+				curr->child_count == 0 && start_unfolding(view, full_path) == 0)
+		{
+			ui_view_schedule_redraw(view);
+			return;
+		}
+
 		/* We reload even on folding to update number of filtered entries
 		 * properly. */
 		ui_view_schedule_reload(view);
 	}
 }
 
+void
+flist_finish_unfolding(view_t *view)
+{
+	tree_unfold_t *const unfold = view->custom.unfolding;
+	if(unfold == NULL)
+	{
+		return;
+	}
+
+	/* Changing the list would break interactive filtering. */
+	if(view->local_filter.in_progress)
+	{
+		return;
+	}
+
+	if(!unfolding_is_done(unfold))
+	{
+		return;
+	}
+
+	view->custom.unfolding = NULL;
+	if(flist_custom_active(view) && view->custom.type == CV_TREE)
+	{
+		int i;
+		for(i = 0; i < unfold->dirs.nitems; ++i)
+		{
+			if(splice_subtree(view, unfold, unfold->dirs.items[i]) != 0)
+			{
+				ui_view_schedule_reload(view);
+				break;
+			}
+		}
+
+		resort_dir_list(0, view);
+		fview_list_updated(view);
+		ui_view_schedule_redraw(view);
+	}
+	free_unfolding(unfold);
+}
+
+/* Starts listing subtree of an unfolded directory of a tree in background.
+ * Returns zero on success, otherwise non-zero is returned. */
+static int
+start_unfolding(view_t *view, const char path[])
+{
+	/* Only one directory is listed at a time, reloading takes care of the
+	 * rest. */
+	if(view->custom.unfolding != NULL)
+	{
+		return 1;
+	}
+
+	tree_unfold_t *const unfold = list_in_background(view, path,
+			view->custom.excluded_paths, view->custom.folded_paths);
+	if(unfold == NULL)
+	{
+		return 1;
+	}
+
+	if(add_to_string_array(&unfold->dirs.items, unfold->dirs.nitems, path) == 0)
+	{
+		free_unfolding(unfold);
+		return 1;
+	}
+	unfold->dirs.nitems = 1;
+
+	view->custom.unfolding = unfold;
+	return 0;
+}
+
+/* Starts listing subtree of a directory of a tree in background.  Which
+ * directories are added to the tree is up to the caller.  Returns the listing
+ * or NULL on error. */
+static tree_unfold_t *
+list_in_background(view_t *view, const char path[], trie_t *excluded_paths,
+		trie_t *folded_paths)
+{
+	tree_unfold_t *const unfold = calloc(1, sizeof(*unfold));
+	if(unfold == NULL)
+	{
+		return NULL;
+	}
+
+	pthread_mutex_init(&unfold->lock, NULL);
+
+	unfold->path = strdup(path);
+	unfold->base_dir = strdup(flist_get_dir(view));
+	unfold->excluded_paths = (excluded_paths == NULL)
+	                       ? trie_create(/*free_func=*/NULL)
+	                       : trie_clone(excluded_paths);
+	unfold->folded_paths = trie_clone(folded_paths);
+	if(unfold->path == NULL || unfold->base_dir == NULL ||
+			unfold->excluded_paths == NULL || unfold->folded_paths == NULL)
+	{
+		free_unfolding_data(unfold);
+		return NULL;
+	}
+
+	/* The view can change while the listing is being made, hence copies of its
+	 * data are used and filters are applied later on the main thread. */
+	init_prefetch(&unfold->prefetch, /*view=*/NULL, unfold->base_dir,
+			view->hide_dot, unfold->excluded_paths, unfold->folded_paths, INT_MAX);
+
+	if(pthread_create(&unfold->thread, NULL, &unfold_thread, unfold) != 0)
+	{
+		free_unfolding_data(unfold);
+		return NULL;
+	}
+
+	return unfold;
+}
+
+/* Entry point of a thread that lists subtree of an unfolded directory.
+ * Returns NULL. */
+static void *
+unfold_thread(void *arg)
+{
+	block_all_thread_signals();
+
+	tree_unfold_t *const unfold = arg;
+
+	const cancellation_t cancellation = {
+		.hook = &unfolding_cancelled,
+		.arg = unfold,
+	};
+	run_prefetch(&unfold->prefetch, unfold->path, &cancellation);
+
+	pthread_mutex_lock(&unfold->lock);
+	unfold->done = 1;
+	pthread_mutex_unlock(&unfold->lock);
+	return NULL;
+}
+
+/* Cancellation hook for listing of an unfolded directory.  Returns non-zero if
+ * listing should be stopped. */
+static int
+unfolding_cancelled(void *arg)
+{
+	tree_unfold_t *const unfold = arg;
+
+	pthread_mutex_lock(&unfold->lock);
+	const int cancelled = unfold->cancelled;
+	pthread_mutex_unlock(&unfold->lock);
+	return cancelled;
+}
+
+/* Checks whether listing in background has finished.  Returns non-zero if so,
+ * otherwise zero is returned. */
+static int
+unfolding_is_done(tree_unfold_t *unfold)
+{
+	pthread_mutex_lock(&unfold->lock);
+	const int done = unfold->done;
+	pthread_mutex_unlock(&unfold->lock);
+	return done;
+}
+
+/* Builds subtree of a directory out of its listing and puts it into the view.
+ * Returns zero on success or if the directory is gone, otherwise non-zero is
+ * returned. */
+static int
+splice_subtree(view_t *view, tree_unfold_t *unfold, const char path[])
+{
+	dir_entry_t *const dir = entry_from_path(view, view->dir_entry,
+			view->list_rows, path);
+	if(dir == NULL || dir->type != FT_DIR || dir->folded || dir->child_count != 0)
+	{
+		/* The directory was folded again or removed. */
+		return 0;
+	}
+
+	const int pos = dir - view->dir_entry;
+
+	/* Custom list of the view is empty unless it's being composed. */
+	assert(view->custom.entry_count == 0 && view->custom.paths_cache == NULL &&
+			"Custom list is in use.");
+	view->custom.paths_cache = trie_create(/*free_func=*/NULL);
+
+	int nfiltered = add_files_recursively(view, path,
+			view->custom.excluded_paths, view->custom.folded_paths,
+			&unfold->prefetch, -1, 0, INT_MAX);
+
+	int show_empty_dir_leafs = (cfg.dot_dirs & DD_TREE_LEAFS_PARENT);
+	if(nfiltered >= 0 && show_empty_dir_leafs && view->custom.entry_count == 0)
+	{
+		if(add_directory_leaf(view, path, -1) != 0)
+		{
+			nfiltered = -1;
+		}
+	}
+
+	dir_entry_t *entries = view->custom.entries;
+	int count = view->custom.entry_count;
+	view->custom.entries = NULL;
+	view->custom.entry_count = 0;
+	trie_free(view->custom.paths_cache);
+	view->custom.paths_cache = NULL;
+
+	if(nfiltered < 0 || insert_subtree(view, pos, entries, count) != 0)
+	{
+		free_dir_entries(&entries, &count);
+		return 1;
+	}
+	dynarray_free(entries);
+
+	view->filtered += nfiltered;
+	return 0;
+}
+
+/* Moves entries of a subtree into the view after a directory at the specified
+ * position, which has no children.  Returns zero on success, otherwise non-zero
+ * is returned. */
+static int
+insert_subtree(view_t *view, int pos, dir_entry_t *entries, int count)
+{
+	if(count == 0)
+	{
+		return 0;
+	}
+
+	dir_entry_t *const list = dynarray_extend(view->dir_entry,
+			count*sizeof(*list));
+	if(list == NULL)
+	{
+		return 1;
+	}
+	view->dir_entry = list;
+
+	dir_entry_t *const dir = &list[pos];
+	fix_tree_links(list, dir, pos, pos, 0, count);
+
+	memmove(dir + 1 + count, dir + 1,
+			sizeof(*dir)*(view->list_rows - (pos + 1)));
+	memcpy(dir + 1, entries, sizeof(*dir)*count);
+	dir->child_count = count;
+	view->list_rows += count;
+
+	/* Top-level entries of the subtree become children of the directory. */
+	int i;
+	for(i = 0; i < count; i += dir[1 + i].child_count + 1)
+	{
+		dir[1 + i].child_pos = 1 + i;
+	}
+
+	if(view->list_pos > pos)
+	{
+		view->list_pos += count;
+	}
+
+	return 0;
+}
+
+/* Stops listing of an unfolded directory and frees it.  The unfold can be
+ * NULL. */
+static void
+free_unfolding(tree_unfold_t *unfold)
+{
+	if(unfold == NULL)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&unfold->lock);
+	unfold->cancelled = 1;
+	pthread_mutex_unlock(&unfold->lock);
+
+	pthread_join(unfold->thread, NULL);
+	free_unfolding_data(unfold);
+}
+
+/* Frees state of listing of an unfolded directory, which isn't running. */
+static void
+free_unfolding_data(tree_unfold_t *unfold)
+{
+	free_tree_prefetch(&unfold->prefetch);
+	free_string_array(unfold->dirs.items, unfold->dirs.nitems);
+	trie_free(unfold->excluded_paths);
+	trie_free(unfold->folded_paths);
+	free(unfold->base_dir);
+	free(unfold->path);
+	pthread_mutex_destroy(&unfold->lock);
+	free(unfold);
+}
+
 /* Folds a single entry by removing all of its children and updating tree
  * metadata accordingly. */
 static void
@@ -3801,6 +4361,7 @@ fentry_rename(view_t *view, dir_entry_t *entry, const char to[])
 	 * the caches. */
 	entry->hi_num = -1;
 	entry->name_dec_num = -1;
+	entry->name_width = 0;
 
 	/* Update origins of entries which include the one we're renaming. */
 	if(flist_custom_active(view) && fentry_is_dir(entry))
@@ -3998,11 +4559,16 @@ make_tree(view_t *view, const char path[], int reload, trie_t *excluded_paths,
 	char canonic_path[PATH_MAX + 1];
 	int nfiltered;
 	CVType type;
+	tree_unfold_t *unfold = NULL;
 	const int from_custom = flist_custom_active(view)
 	                     && ONE_OF(view->custom.type, CV_REGULAR, CV_VERY);
 
 	flist_custom_start(view, from_custom ? view->custom.title : "");
 
+	/* Listing of an unfolded directory is redundant after rebuilding. */
+	free_unfolding(view->custom.unfolding);
+	view->custom.unfolding = NULL;
+
 	show_progress("Building tree...", 0);
 
 	ui_cancellation_push_on();
@@ -4014,8 +4580,10 @@ make_tree(view_t *view, const char path[], int reload, trie_t *excluded_paths,
 	}
 	else
 	{
-		nfiltered = add_files_recursively(view, path, excluded_paths, folded_paths,
-				-1, 0, depth);
+		/* Rebuilding a tree progressively would make it collapse and expand. */
+		const int progressive = (!reload && depth == INT_MAX);
+		nfiltered = add_tree_files(view, path, progressive, excluded_paths,
+				folded_paths, depth, &unfold);
 		type = CV_TREE;
 	}
 	ui_cancellation_pop();
@@ -4024,11 +4592,13 @@ make_tree(view_t *view, const char path[], int reload, trie_t *excluded_paths,
 
 	if(ui_cancellation_requested())
 	{
+		free_unfolding(unfold);
 		return 1;
 	}
 
 	if(nfiltered < 0)
 	{
+		free_unfolding(unfold);
 		show_error_msg("Tree View", "Failed to list directory");
 		return 1;
 	}
@@ -4038,15 +4608,80 @@ make_tree(view_t *view, const char path[], int reload, trie_t *excluded_paths,
 
 	if(flist_custom_finish_internal(view, type, reload, canonic_path, 1) != 0)
 	{
+		free_unfolding(unfold);
 		return 1;
 	}
 	view->filtered = nfiltered;
 
 	replace_string(&view->custom.orig_dir, canonic_path);
 
+	/* Finishing custom view drops previous listing, so this goes after it. */
+	view->custom.unfolding = unfold;
+
 	return 0;
 }
 
+/* Adds files of a tree to custom list of the view.  If listing of the tree
+ * takes long and building is progressive, only the top level is added and
+ * *unfold is set to listing in background that provides the rest via
+ * flist_finish_unfolding().  Returns number of filtered out files or negative
+ * value on error. */
+static int
+add_tree_files(view_t *view, const char path[], int progressive,
+		trie_t *excluded_paths, trie_t *folded_paths, int depth,
+		tree_unfold_t **unfold_out)
+{
+	tree_unfold_t *unfold = NULL;
+	if(progressive)
+	{
+		unfold = list_in_background(view, path, excluded_paths, folded_paths);
+	}
+
+	if(unfold == NULL)
+	{
+		tree_prefetch_t prefetch;
+		prefetch_tree(&prefetch, view, path, excluded_paths, folded_paths, depth);
+		const int nfiltered = add_files_recursively(view, path, excluded_paths,
+				folded_paths, &prefetch, -1, 0, depth);
+		free_tree_prefetch(&prefetch);
+		return nfiltered;
+	}
+
+	/* Trees that are listed quickly are shown in full right away. */
+	int done = 0;
+	const long long deadline = time_in_ms() + tree_build_budget_ms;
+	while(time_in_ms() < deadline && !ui_cancellation_requested())
+	{
+		done = unfolding_is_done(unfold);
+		if(done)
+		{
+			break;
+		}
+		usleep(TREE_POLL_PERIOD*1000);
+	}
+
+	if(done)
+	{
+		const int nfiltered = add_files_recursively(view, path, excluded_paths,
+				folded_paths, &unfold->prefetch, -1, 0, depth);
+		free_unfolding(unfold);
+		return nfiltered;
+	}
+
+	/* Directories are listed here only for the top level, subtrees of visible
+	 * directories are added once the listing in background is done. */
+	tree_prefetch_t top;
+	init_prefetch(&top, view, flist_get_dir(view), view->hide_dot,
+			excluded_paths, folded_paths, depth);
+	top.deferred = &unfold->dirs;
+	const int nfiltered = add_files_recursively(view, path, excluded_paths,
+			folded_paths, &top, -1, 0, depth);
+	free_tree_prefetch(&top);
+
+	*unfold_out = unfold;
+	return nfiltered;
+}
+
 /* Turns custom list into custom tree. */
 static void
 tree_from_cv(view_t *view)
@@ -4209,6 +4844,254 @@ drop_tops(dir_entry_t *entries, int *nentries, int extra)
 	}
 }
 
+/* Lists directories of a tree using several threads, so that building the tree
+ * mostly consists of putting already loaded entries in order.  Directories
+ * that won't be expanded (folded ones, those beyond depth limit or filtered
+ * out) aren't listed.  Listing can be incomplete, in which case directories are
+ * listed while building the tree. */
+static void
+prefetch_tree(tree_prefetch_t *prefetch, view_t *view, const char path[],
+		trie_t *excluded_paths, trie_t *folded_paths, int depth)
+{
+	init_prefetch(prefetch, view, flist_get_dir(view), view->hide_dot,
+			excluded_paths, folded_paths, depth);
+
+	/* Matching against MIME-types isn't safe to do concurrently. */
+	if(!matcher_is_mime(view->manual_filter))
+	{
+		run_prefetch(prefetch, path, &ui_cancellation_info);
+	}
+}
+
+/* Initializes listing of a tree.  If view is NULL, filters aren't checked and
+ * only dot files are skipped if hide_dot is set.  All data must stay valid
+ * until listing is freed. */
+static void
+init_prefetch(tree_prefetch_t *prefetch, view_t *view, const char base_dir[],
+		int hide_dot, trie_t *excluded_paths, trie_t *folded_paths, int depth)
+{
+	memset(prefetch, 0, sizeof(*prefetch));
+	prefetch->view = view;
+	prefetch->base_dir = base_dir;
+	prefetch->hide_dot = hide_dot;
+	prefetch->excluded_paths = excluded_paths;
+	prefetch->folded_paths = folded_paths;
+	prefetch->depth = depth;
+	prefetch->listings = trie_create(/*free_func=*/NULL);
+}
+
+/* Lists tree at the path (relative paths are resolved against current working
+ * directory) and indexes the listings. */
+static void
+run_prefetch(tree_prefetch_t *prefetch, const char path[],
+		const cancellation_t *cancellation)
+{
+	char cwd[PATH_MAX + 1];
+	if(prefetch->listings == NULL || get_cwd(cwd, sizeof(cwd)) == NULL)
+	{
+		return;
+	}
+
+	char *roots[] = { (char *)path };
+	(void)walker_run(roots, ARRAY_LEN(roots), cwd, TREE_WORKERS,
+			&prefetch_visitor, prefetch, cancellation);
+
+	int i;
+	for(i = 0; i < TREE_WORKERS; ++i)
+	{
+		size_t j;
+		for(j = 0U; j < DA_SIZE(prefetch->workers[i].listings); ++j)
+		{
+			tree_listing_t *const listing = prefetch->workers[i].listings[j];
+			if(trie_set(prefetch->listings, listing->path, listing) < 0)
+			{
+				listing->broken = 1;
+			}
+		}
+	}
+}
+
+/* Visitor of files of a tree, which is called from several threads.  Returns
+ * non-zero to descend into a directory. */
+static int
+prefetch_visitor(const walker_entry_t *entry, void *arg)
+{
+	tree_prefetch_t *const prefetch = arg;
+
+	if(entry->depth == 0)
+	{
+		return 1;
+	}
+
+	void *dummy;
+	if(trie_get(prefetch->excluded_paths, entry->path, &dummy) == 0)
+	{
+		return 0;
+	}
+
+	tree_listing_t *const listing = get_listing(prefetch, entry);
+	if(listing == NULL)
+	{
+		return 0;
+	}
+
+	tree_item_t *const item = DA_EXTEND(listing->items);
+	if(item == NULL)
+	{
+		listing->broken = 1;
+		return 0;
+	}
+
+	item->name = strdup(entry->name);
+	if(item->name == NULL)
+	{
+		listing->broken = 1;
+		return 0;
+	}
+
+	item->real_dir = (entry->type == WT_DIR);
+	item->dir = item->real_dir
+	         || (entry->type == WT_LINK && is_dir(entry->full_path));
+
+	/* Only files that will end up in the tree are worth loading. */
+	item->loaded = 0;
+	if(prefetch_is_visible(prefetch, listing->path, entry->name, item->dir, 1))
+	{
+		char canonic_path[PATH_MAX + 1];
+		to_canonic_path(entry->path, prefetch->base_dir, canonic_path,
+				sizeof(canonic_path));
+		item->loaded = (fentry_load(&item->entry, canonic_path) == 0);
+	}
+
+	DA_COMMIT(listing->items);
+
+	return item->real_dir && should_descend(prefetch, listing, entry);
+}
+
+/* Retrieves listing of the parent directory of the entry.  Children of a
+ * directory are visited by the same thread one after another, so only the last
+ * listing of the thread needs to be checked.  Returns the listing or NULL. */
+static tree_listing_t *
+get_listing(tree_prefetch_t *prefetch, const walker_entry_t *entry)
+{
+	size_t dir_len = strlen(entry->path) - strlen(entry->name);
+	if(dir_len > 1U && entry->path[dir_len - 1U] == '/')
+	{
+		--dir_len;
+	}
+
+	tree_listing_t **const listings = prefetch->workers[entry->worker].listings;
+	const size_t count = DA_SIZE(prefetch->workers[entry->worker].listings);
+	if(count != 0U)
+	{
+		tree_listing_t *const last = listings[count - 1U];
+		if(strlen(last->path) == dir_len &&
+				strncmp(last->path, entry->path, dir_len) == 0)
+		{
+			return last;
+		}
+	}
+
+	tree_listing_t **const slot = DA_EXTEND(
+			prefetch->workers[entry->worker].listings);
+	if(slot == NULL)
+	{
+		return NULL;
+	}
+
+	tree_listing_t *const listing = calloc(1, sizeof(*listing));
+	if(listing == NULL)
+	{
+		return NULL;
+	}
+
+	listing->path = format_str("%.*s", (int)dir_len, entry->path);
+	if(listing->path == NULL)
+	{
+		free(listing);
+		return NULL;
+	}
+
+	*slot = listing;
+	DA_COMMIT(prefetch->workers[entry->worker].listings);
+	return listing;
+}
+
+/* Checks whether a directory of a tree is going to be expanded on building the
+ * tree.  Mirrors the logic of add_files_recursively().  Returns non-zero if
+ * so, otherwise zero is returned. */
+static int
+should_descend(const tree_prefetch_t *prefetch, const tree_listing_t *listing,
+		const walker_entry_t *entry)
+{
+	if(entry->depth > prefetch->depth)
+	{
+		return 0;
+	}
+
+	const FoldState state = get_fold_state(prefetch->folded_paths, entry->path);
+	if(state == FOLD_USER_CLOSED || state == FOLD_AUTO_CLOSED)
+	{
+		return 0;
+	}
+
+	if(state == FOLD_UNDEFINED &&
+			get_fold_state(prefetch->folded_paths, listing->path) == FOLD_AUTO_OPENED)
+	{
+		return 0;
+	}
+
+	return prefetch_is_visible(prefetch, listing->path, entry->name, 1, 0);
+}
+
+/* Checks whether file is visible in a tree.  Returns non-zero if so, otherwise
+ * zero is returned. */
+static int
+prefetch_is_visible(const tree_prefetch_t *prefetch, const char dir[],
+		const char name[], int is_dir, int apply_local_filter)
+{
+	if(prefetch->view == NULL)
+	{
+		return !(prefetch->hide_dot && name[0] == '.');
+	}
+
+	return tree_candidate_is_visible(prefetch->view, dir, name, is_dir,
+			apply_local_filter);
+}
+
+/* Frees listings along with entries that weren't put into the tree. */
+static void
+free_tree_prefetch(tree_prefetch_t *prefetch)
+{
+	int i;
+	for(i = 0; i < TREE_WORKERS; ++i)
+	{
+		size_t j;
+		for(j = 0U; j < DA_SIZE(prefetch->workers[i].listings); ++j)
+		{
+			tree_listing_t *const listing = prefetch->workers[i].listings[j];
+
+			size_t k;
+			for(k = 0U; k < DA_SIZE(listing->items); ++k)
+			{
+				tree_item_t *const item = &listing->items[k];
+				if(item->loaded)
+				{
+					fentry_free(&item->entry);
+				}
+				free(item->name);
+			}
+			DA_REMOVE_ALL(listing->items);
+
+			free(listing->path);
+			free(listing);
+		}
+		DA_REMOVE_ALL(prefetch->workers[i].listings);
+	}
+
+	trie_free(prefetch->listings);
+}
+
 /* Adds custom view entries corresponding to file system tree.  parent_pos is
  * expected to be negative for the outermost invocation.  The depth parameter
  * is used to limit nesting level, when it's negative, parent node is just
@@ -4216,17 +5099,35 @@ drop_tops(dir_entry_t *entries, int *nentries, int extra)
  * success and negative value on serious error. */
 static int
 add_files_recursively(view_t *view, const char path[], trie_t *excluded_paths,
-		trie_t *folded_paths, int parent_pos, int no_direct_parent, int depth)
+		trie_t *folded_paths, tree_prefetch_t *prefetch, int parent_pos,
+		int no_direct_parent, int depth)
 {
 	int i;
 	const int prev_count = view->custom.entry_count;
 	int nfiltered = 0;
 
+	/* Prefer listing made in advance if it's complete. */
+	tree_listing_t *listing = NULL;
+	void *data;
+	if(trie_get(prefetch->listings, path, &data) == 0 &&
+			!((tree_listing_t *)data)->broken)
+	{
+		listing = data;
+	}
+
 	int len;
-	char **lst = list_all_files(path, &len);
-	if(len < 0)
+	char **lst = NULL;
+	if(listing != NULL)
 	{
-		return -1;
+		len = DA_SIZE(listing->items);
+	}
+	else
+	{
+		lst = list_all_files(path, &len);
+		if(len < 0)
+		{
+			return -1;
+		}
 	}
 
 	FoldState parent_fold = get_fold_state(folded_paths, path);
@@ -4236,7 +5137,12 @@ add_files_recursively(view_t *view, const char path[], trie_t *excluded_paths,
 		int dir;
 		void *dummy;
 		dir_entry_t *entry;
-		char *const full_path = format_str("%s/%s", path, lst[i]);
+		tree_item_t *const item = (listing == NULL ? NULL : &listing->items[i]);
+		const char *const name = (item == NULL ? lst[i] : item->name);
+		/* Path is formatted the same way walker does this to be able to find
+		 * listings of subdirectories. */
+		char *const full_path = format_str("%s%s%s", path,
+				ends_with_slash(path) ? "" : "/", name);
 
 		if(trie_get(excluded_paths, full_path, &dummy) == 0)
 		{
@@ -4244,10 +5150,12 @@ add_files_recursively(view_t *view, const char path[], trie_t *excluded_paths,
 			continue;
 		}
 
-		dir = is_dir(full_path);
-		if(!tree_candidate_is_visible(view, path, lst[i], dir, 1))
+		dir = (item == NULL ? is_dir(full_path) : item->dir);
+		if(!tree_candidate_is_visible(view, path, name, dir, 1))
 		{
-			const int real_dir = (dir && !is_symlink(full_path));
+			const int real_dir = (item == NULL)
+			                   ? (dir && !is_symlink(full_path))
+			                   : item->real_dir;
 
 			FoldState state;
 			if(real_dir)
@@ -4268,12 +5176,12 @@ add_files_recursively(view_t *view, const char path[], trie_t *excluded_paths,
 			/* Traverse directory (but not symlink to it) even if we're skipping it,
 			 * because we might need files that are inside of it. */
 			if(real_dir && depth > 0 &&
-					tree_candidate_is_visible(view, path, lst[i], dir, 0))
+					tree_candidate_is_visible(view, path, name, dir, 0))
 			{
 				if(state != FOLD_AUTO_CLOSED && state != FOLD_USER_CLOSED)
 				{
 					nfiltered += add_files_recursively(view, full_path, excluded_paths,
-							folded_paths, parent_pos, 1, depth - 1);
+							folded_paths, prefetch, parent_pos, 1, depth - 1);
 				}
 			}
 
@@ -4282,11 +5190,24 @@ add_files_recursively(view_t *view, const char path[], trie_t *excluded_paths,
 			continue;
 		}
 
-		entry = flist_custom_add(view, full_path);
+		if(item != NULL && item->loaded)
+		{
+			entry = flist_custom_put(view, &item->entry);
+			/* The entry is owned by the view now. */
+			item->loaded = (entry == NULL);
+		}
+		else
+		{
+			entry = flist_custom_add(view, full_path);
+		}
+
 		if(entry == NULL)
 		{
 			free(full_path);
-			free_string_array(lst, len);
+			if(listing == NULL)
+			{
+				free_string_array(lst, len);
+			}
 			return -1;
 		}
 
@@ -4311,11 +5232,18 @@ add_files_recursively(view_t *view, const char path[], trie_t *excluded_paths,
 					entry->folded = 1;
 				}
 			}
+			else if(prefetch->deferred != NULL)
+			{
+				/* Subtree is added after it's listed. */
+				strlist_t *const deferred = prefetch->deferred;
+				deferred->nitems = add_to_string_array(&deferred->items,
+						deferred->nitems, full_path);
+			}
 			else
 			{
 				const int idx = view->custom.entry_count - 1;
 				const int filtered = add_files_recursively(view, full_path,
-						excluded_paths, folded_paths, idx, 0, depth - 1);
+						excluded_paths, folded_paths, prefetch, idx, 0, depth - 1);
 				/* Keep going in case of error and load partial list. */
 				if(filtered >= 0)
 				{
@@ -4333,7 +5261,10 @@ add_files_recursively(view_t *view, const char path[], trie_t *excluded_paths,
 		show_progress("Building tree...", 1000);
 	}
 
-	free_string_array(lst, len);
+	if(listing == NULL)
+	{
+		free_string_array(lst, len);
+	}
 
 	/* The prev_count != 0 check is to make sure that we won't create leaf instead
 	 * of the whole tree (this is handled in flist_custom_finish()). */
@@ -125,6 +125,10 @@ dir_entry_t * flist_custom_add(view_t *view, const char path[]);
 /* Puts an entry to custom list of files, contents of the entry gets stolen.
  * Returns pointer to just added entry or NULL on error. */
 dir_entry_t * flist_custom_put(view_t *view, dir_entry_t *entry);
+/* Appends an entry to list of an active custom view applying local filter to
+ * it, contents of the entry gets stolen.  Returns pointer to just added entry
+ * or NULL if it was filtered out or on error. */
+dir_entry_t * flist_custom_append(view_t *view, dir_entry_t *entry);
 /* Parses line to extract path and adds it to custom view or does nothing. */
 void flist_custom_add_spec(view_t *view, const char line[]);
 /* Appends entry separator to the list with specified id. */
@@ -275,6 +279,10 @@ dir_entry_t * add_dir_entry(dir_entry_t **list, size_t *list_size,
  * entry or NULL on error. */
 dir_entry_t * entry_list_add(view_t *view, dir_entry_t **list, int *list_size,
 		const char path[]);
+/* Fills the entry with data about file at the path.  Doesn't depend on any
+ * view, so can be called from any thread.  Returns zero on success, otherwise
+ * non-zero is returned and the entry is left freed. */
+int fentry_load(dir_entry_t *entry, const char path[]);
 /* Frees list of directory entries.  Sets *entries and *count to safe values. */
 void free_dir_entries(dir_entry_t **entries, int *count);
 /* Frees single directory entry. */
@@ -313,14 +321,21 @@ void flist_free_cache(cached_entries_t *cache);
 /* Updates non-heap-allocated origin pointers of entries in file list
  * entries. */
 void flist_update_origins(view_t *view);
-/* Toggles fold of the current entry if applicable. */
+/* Toggles fold of the current entry if applicable.  Subtree of a directory
+ * unfolded in tree-view can be listed in background, in which case it's added
+ * to the view by flist_finish_unfolding(). */
 void flist_toggle_fold(view_t *view);
+
+/* Adds subtree of a directory unfolded in tree-view once it's listed.  Does
+ * nothing if there is no such directory or its listing isn't finished yet. */
+void flist_finish_unfolding(view_t *view);
 /* Checks whether file list synchronizes with FS.  Returns non-zero if so,
  * otherwise zero is returned. */
 int flist_is_fs_backed(const view_t *view);
 
 TSTATIC_DEFS(
 	void check_file_uniqueness(view_t *view);
+	int tree_build_budget_ms;
 )
 
 #endif /* VIFM__FILELIST_H__ */
@@ -20,6 +20,7 @@
 #include "filtering.h"
 
 #include <assert.h> /* assert() */
+#include <stdlib.h> /* calloc() free() */
 #include <string.h> /* strdup() */
 
 #include "cfg/config.h"
@@ -45,6 +46,7 @@ static int load_unfiltered_list(view_t *view);
 static int list_is_incomplete(view_t *view);
 static void store_local_filter_position(view_t *view, int pos);
 static int update_filtering_lists(view_t *view, int add, int clear);
+static int filter_narrows_last_one(const view_t *view);
 static void reparent_tree_node(dir_entry_t *original, dir_entry_t *filtered);
 static void ensure_filtered_list_not_empty(view_t *view,
 		dir_entry_t *parent_entry);
@@ -69,6 +71,8 @@ filters_view_reset(view_t *view)
 	reset_filter(&view->local_filter.filter);
 	view->local_filter.in_progress = 0;
 	view->local_filter.saved = NULL;
+	view->local_filter.rejected = NULL;
+	view->local_filter.rejected_by = NULL;
 	view->local_filter.poshist = NULL;
 	view->local_filter.poshist_len = 0U;
 }
@@ -469,6 +473,9 @@ load_unfiltered_list(view_t *view)
 	view->local_filter.prefiltered_count = view->filtered;
 	view->dir_entry = NULL;
 
+	view->local_filter.rejected = calloc(view->list_rows, 1U);
+	update_string(&view->local_filter.rejected_by, NULL);
+
 	return current_file_pos;
 }
 
@@ -533,6 +540,12 @@ update_filtering_lists(view_t *view, int add, int clear)
 	dir_entry_t *parent_entry = NULL;
 	int parent_added = 0;
 
+	/* Entries rejected by the last filter don't need to be matched against the
+	 * current one if it can only match a subset of what the last one did, which
+	 * is the usual case of typing in a filter. */
+	char *const rejected = view->local_filter.rejected;
+	const int narrowing = (rejected != NULL && filter_narrows_last_one(view));
+
 	for(i = 0; i < view->local_filter.unfiltered_count; ++i)
 	{
 		/* FIXME: some very long file names won't be matched against some
@@ -574,7 +587,14 @@ update_filtering_lists(view_t *view, int add, int clear)
 		/* tag links to position of nodes passed through filter in list of visible
 		 * files.  Nodes that didn't pass have -1. */
 		entry->tag = -1;
-		if(filter_matches(&view->local_filter.filter, name) != 0)
+		const int matches = !(narrowing && rejected[i])
+		                 && filter_matches(&view->local_filter.filter, name) != 0;
+		if(rejected != NULL)
+		{
+			rejected[i] = !matches;
+		}
+
+		if(matches)
 		{
 			if(add)
 			{
@@ -607,8 +627,20 @@ update_filtering_lists(view_t *view, int add, int clear)
 			fentry_free(parent_entry);
 		}
 	}
+	if(rejected != NULL)
+	{
+		const filter_t *const filter = &view->local_filter.filter;
+		update_string(&view->local_filter.rejected_by,
+				filter->is_regex_valid ? filter->raw : NULL);
+		view->local_filter.rejected_cflags = filter->cflags;
+	}
+
 	if(add)
 	{
+		/* Entries that weren't visible during the last search might have become
+		 * visible, so search results are outdated. */
+		view->matches = 0;
+
 		view->list_rows = list_size;
 		view->filtered = view->local_filter.prefiltered_count
 		               + view->local_filter.unfiltered_count - list_size;
@@ -620,6 +652,21 @@ update_filtering_lists(view_t *view, int add, int clear)
 	return 0;
 }
 
+/* Checks whether current value of the local filter can't match anything that
+ * wasn't matched by the last applied filter.  Returns non-zero if so, otherwise
+ * zero is returned. */
+static int
+filter_narrows_last_one(const view_t *view)
+{
+	const filter_t *const filter = &view->local_filter.filter;
+	const char *const last = view->local_filter.rejected_by;
+
+	return last != NULL
+	    && filter->is_regex_valid
+	    && regexp_narrows(last, view->local_filter.rejected_cflags, filter->raw,
+	                      filter->cflags);
+}
+
 /* Reparents *filtered node by attaching it to the closes ancestor of *original
  * mapped onto the list of filtered nodes.  tag field of entries is used to
  * perform the mapping. */
@@ -824,6 +871,10 @@ local_filter_finish(view_t *view)
 	free(view->local_filter.saved);
 	view->local_filter.in_progress = 0;
 
+	free(view->local_filter.rejected);
+	view->local_filter.rejected = NULL;
+	update_string(&view->local_filter.rejected_by, NULL);
+
 	free(view->local_filter.poshist);
 	view->local_filter.poshist = NULL;
 	view->local_filter.poshist_len = 0U;
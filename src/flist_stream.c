@@ -0,0 +1,701 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "flist_stream.h"
+
+#include <assert.h> /* assert() */
+#include <stddef.h> /* NULL ptrdiff_t size_t */
+#include <stdio.h> /* fclose() */
+#include <stdlib.h> /* calloc() free() */
+#include <string.h> /* memcpy() strdup() */
+
+#include "compat/fs_limits.h"
+#include "compat/pthread.h"
+#include "compat/reallocarray.h"
+#include "ui/fileview.h"
+#include "ui/ui.h"
+#include "utils/darray.h"
+#include "utils/path.h"
+#include "utils/string_array.h"
+#include "utils/trie.h"
+#include "utils/utils.h"
+#include "background.h"
+#include "filelist.h"
+
+enum
+{
+	NWORKERS = 4,     /* Number of threads that load entries. */
+	BATCH_SIZE = 128, /* Maximum number of paths in a batch. */
+	MAX_READS = 64,   /* Maximum number of reads of output per pull. */
+};
+
+/* Group of paths that is loaded by a worker thread at once or a group of
+ * entries created by a producer. */
+typedef struct
+{
+	char **paths;         /* Paths to load or NULL for batch of a producer. */
+	dir_entry_t *entries; /* Loaded entries, failed ones have NULL name. */
+	int count;            /* Number of paths and entries. */
+	int loaded;           /* Whether entries have been loaded. */
+}
+batch_t;
+
+struct flist_stream_t
+{
+	bg_job_t *job;            /* Command that prints paths or NULL on its end. */
+	char *dir;                /* Base for relative paths. */
+	line_splitter_t splitter; /* Splits output of the command into lines. */
+	trie_t *seen;             /* Paths that were queued to skip duplicates. */
+	batch_t *filling;         /* Batch that's being filled or NULL. */
+
+	flist_stream_producer producer; /* Function that produces entries or NULL. */
+	void *producer_arg;             /* Argument of the producer. */
+	pthread_t producer_thread;      /* Thread that runs the producer. */
+	int producing;                  /* Whether producer thread wasn't joined. */
+
+	pthread_mutex_t lock;       /* Protects fields below. */
+	pthread_cond_t queued;      /* Signaled on new batches and on stopping. */
+	batch_t **batches;          /* Queued batches in order of their arrival. */
+	DA_INSTANCE_FIELD(batches); /* Declarations to enable use of DA_* on it. */
+	size_t next;                /* Index of the first batch not yet taken. */
+	int stop;                   /* Whether workers should quit. */
+	batch_t *produced;          /* Batch filled by the producer or NULL. */
+	int produced_all;           /* Whether producer has finished. */
+
+	pthread_t workers[NWORKERS]; /* Threads that load batches. */
+	int nworkers;                /* Number of started threads. */
+};
+
+static void * producer_thread(void *arg);
+static void take_produced(flist_stream_t *s);
+static void read_output(flist_stream_t *s);
+static void path_handler(const char line[], void *arg);
+static void add_path(flist_stream_t *s, const char path[]);
+static void queue_batch(flist_stream_t *s);
+static int append_batch(flist_stream_t *s, batch_t *batch);
+static int add_loaded(flist_stream_t *s, view_t *view);
+static int add_entries(flist_stream_t *s, view_t *view, batch_t *batch);
+static void finish_reading(flist_stream_t *s);
+static void * worker(void *arg);
+static void load_batch(batch_t *batch);
+static void free_batch(batch_t *batch);
+
+flist_stream_t *
+flist_stream_start(view_t *view, bg_job_t *job)
+{
+	flist_stream_t *const s = calloc(1, sizeof(*s));
+	if(s == NULL)
+	{
+		(void)bg_job_cancel(job);
+		bg_job_decref(job);
+		return NULL;
+	}
+
+	pthread_mutex_init(&s->lock, NULL);
+	pthread_cond_init(&s->queued, NULL);
+
+	s->job = job;
+	s->dir = strdup(flist_get_dir(view));
+	s->seen = trie_create(/*free_func=*/NULL);
+	if(s->dir == NULL || s->seen == NULL)
+	{
+		flist_stream_free(s);
+		return NULL;
+	}
+
+	/* Errors are reported by background unit while the view is being
+	 * populated. */
+	job->skip_errors = 0;
+
+	int i;
+	for(i = 0; i < NWORKERS; ++i)
+	{
+		if(pthread_create(&s->workers[s->nworkers], NULL, &worker, s) == 0)
+		{
+			++s->nworkers;
+		}
+	}
+
+	return s;
+}
+
+flist_stream_t *
+flist_stream_start_producer(view_t *view, flist_stream_producer producer,
+		void *arg)
+{
+	flist_stream_t *const s = calloc(1, sizeof(*s));
+	if(s == NULL)
+	{
+		return NULL;
+	}
+
+	pthread_mutex_init(&s->lock, NULL);
+	pthread_cond_init(&s->queued, NULL);
+
+	s->producer = producer;
+	s->producer_arg = arg;
+	s->dir = strdup(flist_get_dir(view));
+	s->seen = trie_create(/*free_func=*/NULL);
+	if(s->dir == NULL || s->seen == NULL ||
+			pthread_create(&s->producer_thread, NULL, &producer_thread, s) != 0)
+	{
+		flist_stream_free(s);
+		return NULL;
+	}
+
+	/* Entries arrive loaded, so there is no need in worker threads. */
+	s->producing = 1;
+	return s;
+}
+
+/* Entry point of thread that runs producer. */
+static void *
+producer_thread(void *arg)
+{
+	flist_stream_t *const s = arg;
+
+	block_all_thread_signals();
+
+	s->producer(s, s->producer_arg);
+
+	pthread_mutex_lock(&s->lock);
+	s->produced_all = 1;
+	pthread_mutex_unlock(&s->lock);
+
+	return NULL;
+}
+
+int
+flist_stream_put(flist_stream_t *s, dir_entry_t *entry)
+{
+	pthread_mutex_lock(&s->lock);
+
+	if(s->stop)
+	{
+		pthread_mutex_unlock(&s->lock);
+		fentry_free(entry);
+		return 1;
+	}
+
+	if(s->produced == NULL)
+	{
+		s->produced = calloc(1, sizeof(*s->produced));
+		if(s->produced != NULL)
+		{
+			s->produced->loaded = 1;
+			s->produced->entries = reallocarray(NULL, BATCH_SIZE,
+					sizeof(*s->produced->entries));
+			if(s->produced->entries == NULL)
+			{
+				free_batch(s->produced);
+				s->produced = NULL;
+			}
+		}
+
+		if(s->produced == NULL)
+		{
+			pthread_mutex_unlock(&s->lock);
+			fentry_free(entry);
+			return 0;
+		}
+	}
+
+	s->produced->entries[s->produced->count++] = *entry;
+	if(s->produced->count == BATCH_SIZE)
+	{
+		if(append_batch(s, s->produced) != 0)
+		{
+			free_batch(s->produced);
+		}
+		s->produced = NULL;
+	}
+
+	pthread_mutex_unlock(&s->lock);
+	return 0;
+}
+
+int
+flist_stream_stopped(flist_stream_t *s)
+{
+	pthread_mutex_lock(&s->lock);
+	const int stop = s->stop;
+	pthread_mutex_unlock(&s->lock);
+	return stop;
+}
+
+int
+flist_stream_pull(flist_stream_t *s, view_t *view)
+{
+	if(s->producing)
+	{
+		take_produced(s);
+	}
+	else
+	{
+		read_output(s);
+	}
+	return add_loaded(s, view);
+}
+
+/* Queues partially filled batch of the producer and joins its thread once it's
+ * done. */
+static void
+take_produced(flist_stream_t *s)
+{
+	pthread_mutex_lock(&s->lock);
+	if(s->produced != NULL)
+	{
+		if(append_batch(s, s->produced) != 0)
+		{
+			free_batch(s->produced);
+		}
+		s->produced = NULL;
+	}
+	const int done = s->produced_all;
+	pthread_mutex_unlock(&s->lock);
+
+	if(done)
+	{
+		pthread_join(s->producer_thread, NULL);
+		s->producing = 0;
+	}
+}
+
+/* Splits available output of the command into paths and queues them for
+ * loading. */
+static void
+read_output(flist_stream_t *s)
+{
+	int i;
+	for(i = 0; i < MAX_READS && s->job != NULL; ++i)
+	{
+		char piece[16*1024];
+		const int len = bg_job_read_output(s->job, piece, sizeof(piece));
+		if(len == 0)
+		{
+			break;
+		}
+
+		if(len < 0)
+		{
+			split_lines(&s->splitter, "", 0U, /*final=*/1, &path_handler, s);
+			finish_reading(s);
+			break;
+		}
+
+		split_lines(&s->splitter, piece, len, /*final=*/0, &path_handler, s);
+	}
+
+	/* Don't hold back paths of a command that prints them slowly. */
+	queue_batch(s);
+}
+
+/* Extracts path from a line of output and adds it to a batch unless it was seen
+ * before. */
+static void
+path_handler(const char line[], void *arg)
+{
+	flist_stream_t *const s = arg;
+
+	char *const path = parse_line_for_path(line, s->dir);
+	if(path == NULL)
+	{
+		return;
+	}
+
+	char canonic_path[PATH_MAX + 1];
+	to_canonic_path(path, s->dir, canonic_path, sizeof(canonic_path));
+	free(path);
+
+	/* Don't add duplicates. */
+	if(trie_put(s->seen, canonic_path) == 0)
+	{
+		add_path(s, canonic_path);
+	}
+}
+
+/* Appends path to the batch that's being filled queuing it once it's full. */
+static void
+add_path(flist_stream_t *s, const char path[])
+{
+	if(s->filling == NULL)
+	{
+		s->filling = calloc(1, sizeof(*s->filling));
+		if(s->filling == NULL)
+		{
+			return;
+		}
+
+		s->filling->paths = reallocarray(NULL, BATCH_SIZE,
+				sizeof(*s->filling->paths));
+		if(s->filling->paths == NULL)
+		{
+			free_batch(s->filling);
+			s->filling = NULL;
+			return;
+		}
+	}
+
+	char *const copy = strdup(path);
+	if(copy == NULL)
+	{
+		return;
+	}
+
+	s->filling->paths[s->filling->count++] = copy;
+	if(s->filling->count == BATCH_SIZE)
+	{
+		queue_batch(s);
+	}
+}
+
+/* Hands the batch that's being filled over to workers or loads it right away if
+ * there are none. */
+static void
+queue_batch(flist_stream_t *s)
+{
+	batch_t *const batch = s->filling;
+	if(batch == NULL)
+	{
+		return;
+	}
+	s->filling = NULL;
+
+	if(s->nworkers == 0)
+	{
+		load_batch(batch);
+		batch->loaded = 1;
+	}
+
+	pthread_mutex_lock(&s->lock);
+	const int failed = append_batch(s, batch);
+	pthread_mutex_unlock(&s->lock);
+
+	if(failed)
+	{
+		free_batch(batch);
+	}
+}
+
+/* Appends the batch to the queue and notifies workers about it.  Must be called
+ * with the lock held.  Returns non-zero on error, otherwise zero is
+ * returned. */
+static int
+append_batch(flist_stream_t *s, batch_t *batch)
+{
+	batch_t **const slot = DA_EXTEND(s->batches);
+	if(slot == NULL)
+	{
+		return 1;
+	}
+
+	*slot = batch;
+	DA_COMMIT(s->batches);
+	pthread_cond_signal(&s->queued);
+	return 0;
+}
+
+/* Adds entries of loaded batches preserving order of batches.  Returns number
+ * of added entries. */
+static int
+add_loaded(flist_stream_t *s, view_t *view)
+{
+	int added = 0;
+
+	while(1)
+	{
+		batch_t *batch = NULL;
+
+		pthread_mutex_lock(&s->lock);
+		if(DA_SIZE(s->batches) != 0U && s->batches[0]->loaded)
+		{
+			batch = s->batches[0];
+			DA_REMOVE(s->batches, &s->batches[0]);
+			if(s->next != 0U)
+			{
+				--s->next;
+			}
+		}
+		pthread_mutex_unlock(&s->lock);
+
+		if(batch == NULL)
+		{
+			break;
+		}
+
+		added += add_entries(s, view, batch);
+		free_batch(batch);
+	}
+
+	return added;
+}
+
+/* Moves entries of the batch either to the list that's being composed or to
+ * the list of the view (once the stream is attached to it).  Returns number of
+ * added entries. */
+static int
+add_entries(flist_stream_t *s, view_t *view, batch_t *batch)
+{
+	if(batch->entries == NULL)
+	{
+		return 0;
+	}
+
+	const int attached = (view->custom.stream == s);
+
+	int added = 0;
+	int i;
+	for(i = 0; i < batch->count; ++i)
+	{
+		dir_entry_t *const entry = &batch->entries[i];
+		if(entry->name == NULL)
+		{
+			continue;
+		}
+
+		/* Paths of a command are checked for duplicates as they are read. */
+		if(s->producer != NULL)
+		{
+			char path[PATH_MAX + 1];
+			get_full_path_of(entry, sizeof(path), path);
+			if(trie_put(s->seen, path) != 0)
+			{
+				fentry_free(entry);
+				continue;
+			}
+		}
+
+		if(attached)
+		{
+			added += (flist_custom_append(view, entry) != NULL);
+		}
+		else if(flist_custom_put(view, entry) != NULL)
+		{
+			++added;
+		}
+		else
+		{
+			fentry_free(entry);
+		}
+	}
+
+	/* Contents of the entries have been moved out. */
+	free(batch->entries);
+	batch->entries = NULL;
+
+	return added;
+}
+
+int
+flist_stream_is_done(const flist_stream_t *s)
+{
+	return s->job == NULL
+	    && !s->producing
+	    && s->filling == NULL
+	    && DA_SIZE(s->batches) == 0U;
+}
+
+void
+flist_stream_free(flist_stream_t *s)
+{
+	if(s == NULL)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&s->lock);
+	s->stop = 1;
+	pthread_cond_broadcast(&s->queued);
+	pthread_mutex_unlock(&s->lock);
+
+	int i;
+	for(i = 0; i < s->nworkers; ++i)
+	{
+		pthread_join(s->workers[i], NULL);
+	}
+
+	if(s->producing)
+	{
+		pthread_join(s->producer_thread, NULL);
+	}
+
+	if(s->job != NULL)
+	{
+		if(bg_job_is_running(s->job))
+		{
+			(void)bg_job_cancel(s->job);
+		}
+		finish_reading(s);
+	}
+
+	size_t j;
+	for(j = 0U; j < DA_SIZE(s->batches); ++j)
+	{
+		free_batch(s->batches[j]);
+	}
+	DA_REMOVE_ALL(s->batches);
+	free_batch(s->filling);
+	free_batch(s->produced);
+
+	split_lines_reset(&s->splitter);
+	trie_free(s->seen);
+	free(s->dir);
+
+	pthread_cond_destroy(&s->queued);
+	pthread_mutex_destroy(&s->lock);
+	free(s);
+}
+
+/* Releases the command once there is no more output to read. */
+static void
+finish_reading(flist_stream_t *s)
+{
+	/* Closing output stream makes writing to it fail in the job. */
+	if(s->job->output != NULL)
+	{
+		fclose(s->job->output);
+		s->job->output = NULL;
+	}
+	bg_job_decref(s->job);
+	s->job = NULL;
+
+	split_lines_reset(&s->splitter);
+}
+
+void
+flist_stream_update(view_t *view)
+{
+	flist_stream_t *const s = view->custom.stream;
+	if(s == NULL)
+	{
+		return;
+	}
+
+	/* Streaming makes sense only for the kind of view it was started for. */
+	if(!flist_custom_active(view) ||
+			(view->custom.type != CV_REGULAR && view->custom.type != CV_VERY))
+	{
+		view->custom.stream = NULL;
+		flist_stream_free(s);
+		return;
+	}
+
+	/* Changing the list would break interactive filtering. */
+	if(view->local_filter.in_progress)
+	{
+		return;
+	}
+
+	if(flist_stream_pull(s, view) != 0)
+	{
+		fview_list_updated(view);
+		ui_view_schedule_redraw(view);
+	}
+
+	if(flist_stream_is_done(s))
+	{
+		view->custom.stream = NULL;
+		flist_stream_free(s);
+
+		/* Unsorted view is already in its final state, others are sorted only
+		 * once to avoid jumping of the cursor while entries are arriving. */
+		if(!cv_unsorted(view->custom.type))
+		{
+			resort_dir_list(0, view);
+			fview_list_updated(view);
+			ui_view_schedule_redraw(view);
+		}
+	}
+}
+
+/* Entry point of threads that load queued batches. */
+static void *
+worker(void *arg)
+{
+	flist_stream_t *const s = arg;
+
+	block_all_thread_signals();
+
+	pthread_mutex_lock(&s->lock);
+	while(!s->stop)
+	{
+		if(s->next == DA_SIZE(s->batches))
+		{
+			pthread_cond_wait(&s->queued, &s->lock);
+			continue;
+		}
+
+		batch_t *const batch = s->batches[s->next++];
+		pthread_mutex_unlock(&s->lock);
+
+		load_batch(batch);
+
+		pthread_mutex_lock(&s->lock);
+		batch->loaded = 1;
+	}
+	pthread_mutex_unlock(&s->lock);
+
+	return NULL;
+}
+
+/* Queries information about files of the batch. */
+static void
+load_batch(batch_t *batch)
+{
+	batch->entries = calloc(batch->count, sizeof(*batch->entries));
+	if(batch->entries == NULL)
+	{
+		return;
+	}
+
+	int i;
+	for(i = 0; i < batch->count; ++i)
+	{
+		/* Failed entry is left with NULL name. */
+		(void)fentry_load(&batch->entries[i], batch->paths[i]);
+	}
+}
+
+/* Frees the batch and all its data.  The batch can be NULL. */
+static void
+free_batch(batch_t *batch)
+{
+	if(batch == NULL)
+	{
+		return;
+	}
+
+	int i;
+	for(i = 0; i < batch->count; ++i)
+	{
+		if(batch->paths != NULL)
+		{
+			free(batch->paths[i]);
+		}
+		if(batch->entries != NULL)
+		{
+			fentry_free(&batch->entries[i]);
+		}
+	}
+	free(batch->paths);
+	free(batch->entries);
+	free(batch);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
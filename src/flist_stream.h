@@ -0,0 +1,84 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__FLIST_STREAM_H__
+#define VIFM__FLIST_STREAM_H__
+
+/* This unit fills custom views with paths printed by an external command while
+ * it's still running.  Output is read without blocking, paths are loaded in
+ * batches by a pool of threads and entries are added to the view in the order
+ * in which the command printed them.  Alternatively, entries can be loaded and
+ * handed over by a producer that runs in a separate thread. */
+
+struct bg_job_t;
+struct dir_entry_t;
+struct view_t;
+
+/* Opaque state of streaming. */
+typedef struct flist_stream_t flist_stream_t;
+
+/* Function that produces entries via flist_stream_put() from a separate
+ * thread.  It should return soon after flist_stream_put() or
+ * flist_stream_stopped() report that the stream is stopped. */
+typedef void (*flist_stream_producer)(flist_stream_t *s, void *arg);
+
+/* Starts streaming paths from output of the job into custom view that is being
+ * composed for the view, takes ownership of the job.  Until the stream is
+ * attached to the view via its custom.stream field, entries are added to the
+ * list being composed.  Returns the stream or NULL on error (the job is
+ * released in this case too). */
+flist_stream_t * flist_stream_start(struct view_t *view, struct bg_job_t *job);
+
+/* Starts streaming entries created by the producer, which is run in a separate
+ * thread with the arg, into custom view that is being composed for the view.
+ * Returns the stream or NULL on error, in which case the producer isn't
+ * run. */
+flist_stream_t * flist_stream_start_producer(struct view_t *view,
+		flist_stream_producer producer, void *arg);
+
+/* Hands loaded entry over to the stream taking ownership of its data.  Can be
+ * called from several threads at the same time.  Returns non-zero if the stream
+ * was stopped and the entry was freed, otherwise zero is returned. */
+int flist_stream_put(flist_stream_t *s, struct dir_entry_t *entry);
+
+/* Checks whether producer should stop.  Returns non-zero if so, otherwise zero
+ * is returned. */
+int flist_stream_stopped(flist_stream_t *s);
+
+/* Processes output that's available at the moment and adds entries that are
+ * loaded.  Returns number of added entries. */
+int flist_stream_pull(flist_stream_t *s, struct view_t *view);
+
+/* Checks whether all output of the command or all entries of the producer were
+ * processed.  Returns non-zero if so, otherwise zero is returned. */
+int flist_stream_is_done(const flist_stream_t *s);
+
+/* Stops the command or the producer if it's still running and frees the
+ * stream.  The s can be
+ * NULL. */
+void flist_stream_free(flist_stream_t *s);
+
+/* Adds newly available entries to custom view and finishes streaming when
+ * there will be no more of them.  Does nothing if the view has no stream
+ * attached. */
+void flist_stream_update(struct view_t *view);
+
+#endif /* VIFM__FLIST_STREAM_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -38,7 +38,6 @@
 #include <stdio.h> /* snprintf() */
 #include <stdlib.h> /* free() malloc() */
 #include <string.h> /* memset() strcat() strcmp() strdup() strlen() */
-#include <time.h> /* clock_gettime() */
 
 #include "cfg/config.h"
 #include "compat/dtype.h"
@@ -135,7 +134,6 @@ static int ui_cancellation_hook(void *arg);
 TSTATIC char ** edit_list(struct ext_edit_t *ext_edit, size_t orig_len,
 		char *orig[], int *edited_len, int load_always);
 TSTATIC progress_data_t * alloc_progress_data(int bg, void *info);
-static long long time_in_ms(void);
 
 line_prompt_func fops_line_prompt;
 options_prompt_func fops_options_prompt;
@@ -993,19 +991,6 @@ alloc_progress_data(int bg, void *info)
 	return pdata;
 }
 
-/* Retrieves current time in milliseconds. */
-static long long
-time_in_ms(void)
-{
-	struct timespec current_time;
-	if(clock_gettime(CLOCK_MONOTONIC, &current_time) != 0)
-	{
-		return 0;
-	}
-
-	return current_time.tv_sec*1000 + current_time.tv_nsec/1000000;
-}
-
 void
 fops_free_ops(ops_t *ops)
 {
@@ -35,6 +35,7 @@
 #include "../utils/str.h"
 #include "../utils/utils.h"
 #include "../background.h"
+#include "../trace.h"
 #include "private/ioc.h"
 #include "private/ioe.h"
 #include "private/ioeta.h"
@@ -42,6 +43,8 @@
 #include "ioc.h"
 #include "iop.h"
 
+static IoRes copy_tree(io_args_t *args);
+static IoRes move_tree(io_args_t *args);
 static VisitResult rm_visitor(const char full_path[], VisitAction action,
 		void *param);
 static VisitResult cp_visitor(const char full_path[], VisitAction action,
@@ -59,8 +62,10 @@ static VisitResult vr_from_io_res(IoRes result);
 IoRes
 ior_rm(io_args_t *args)
 {
-	const char *const path = args->arg1.path;
-	return traverse(path, &rm_visitor, args);
+	const long long start = trace_begin();
+	const IoRes result = traverse(args->arg1.path, &rm_visitor, args);
+	trace_end(TP_IOR_RM, start);
+	return result;
 }
 
 /* Implementation of traverse() visitor for subtree removal.  Returns 0 on
@@ -119,6 +124,16 @@ rm_visitor(const char full_path[], VisitAction action, void *param)
 
 IoRes
 ior_cp(io_args_t *args)
+{
+	const long long start = trace_begin();
+	const IoRes result = copy_tree(args);
+	trace_end(TP_IOR_CP, start);
+	return result;
+}
+
+/* Implementation of ior_cp().  Returns status. */
+static IoRes
+copy_tree(io_args_t *args)
 {
 	const char *const src = args->arg1.src;
 	const char *const dst = args->arg2.dst;
@@ -167,6 +182,16 @@ cp_visitor(const char full_path[], VisitAction action, void *param)
 
 IoRes
 ior_mv(io_args_t *args)
+{
+	const long long start = trace_begin();
+	const IoRes result = move_tree(args);
+	trace_end(TP_IOR_MV, start);
+	return result;
+}
+
+/* Implementation of ior_mv().  Returns status. */
+static IoRes
+move_tree(io_args_t *args)
 {
 	const char *const src = args->arg1.src;
 	const char *const dst = args->arg2.dst;
@@ -128,6 +128,12 @@ struct ipc_t
 	char pipe_path[PATH_MAX + 1];
 	/* Opened file of the pipe. */
 	read_pipe_t pipe_file;
+#ifndef WIN32_PIPE_READ
+	/* Write end of our own pipe, which is never written to.  Keeping pipe open
+	 * for writing prevents it from getting into EOF state after writers close
+	 * it, which makes waiting on the pipe with select() possible. */
+	int pipe_wfd;
+#endif
 	/* Holds result of expression evaluation or NULL on evaluation error. */
 	char *eval_result;
 };
@@ -148,6 +154,7 @@ static int add_to_list(const char name[], const void *data, void *param);
 static const char * get_ipc_dir(void);
 static int sorter(const void *first, const void *second);
 #ifndef WIN32_PIPE_READ
+static int wait_for_data(ipc_t *ipc, long long ms);
 static int pipe_is_in_use(const char path[]);
 #endif
 
@@ -193,6 +200,16 @@ ipc_init(const char name[], ipc_args_cb args_cb, ipc_eval_cb eval_cb)
 		return NULL;
 	}
 
+#ifndef WIN32_PIPE_READ
+	/* This won't block as the pipe has a reader.  The descriptor must not leak
+	 * into child processes, which would keep the pipe open for writing. */
+	ipc->pipe_wfd = open(ipc->pipe_path, O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+	if(ipc->pipe_wfd == -1)
+	{
+		LOG_SERROR_MSG(errno, "Failed to open own pipe for writing");
+	}
+#endif
+
 	return ipc;
 }
 
@@ -205,6 +222,10 @@ ipc_free(ipc_t *ipc)
 	}
 
 #ifndef WIN32_PIPE_READ
+	if(ipc->pipe_wfd != -1)
+	{
+		close(ipc->pipe_wfd);
+	}
 	fclose(ipc->pipe_file);
 	unlink(ipc->pipe_path);
 #else
@@ -276,18 +297,23 @@ receive_pkg(ipc_t *ipc, int *len)
 	FD_ZERO(&ready);
 	FD_SET(max_fd, &ready);
 
+	/* Part of the packet is likely to be in the buffer of the stream already, so
+	 * try reading before checking file descriptor for new data. */
 	p = pkg;
-	while(size != 0U && select(max_fd + 1, &ready, NULL, NULL, &ts) > 0)
+	while(size != 0U)
 	{
+		clearerr(ipc->pipe_file);
 		const size_t nread = fread(p, 1U, size, ipc->pipe_file);
 		size -= nread;
 		p += nread;
 
-		if(nread == 0U)
+		if(size == 0U || (nread == 0U &&
+					select(max_fd + 1, &ready, NULL, NULL, &ts) <= 0))
 		{
 			break;
 		}
 
+		FD_SET(max_fd, &ready);
 		ts.tv_sec = 0;
 		ts.tv_usec = 10000;
 	}
@@ -595,7 +621,6 @@ char *
 ipc_eval(ipc_t *ipc, const char whom[], const char expr[])
 {
 	enum { MAX_USEC = 1000000, MAX_REPEATS = 20 };
-	int repeats;
 
 	char *data[] = { (char *)expr, NULL };
 	if(format_and_send(ipc, whom, data, EVAL_TYPE) != 0)
@@ -604,9 +629,21 @@ ipc_eval(ipc_t *ipc, const char whom[], const char expr[])
 		return NULL;
 	}
 
-	/* Using sleep is just easier than doing read with timeout due to differences
-	 * between platforms... */
-	repeats = 0;
+#ifndef WIN32_PIPE_READ
+	/* Wait for the response to arrive instead of polling, so that the result is
+	 * picked up as soon as it's available. */
+	const long long deadline = time_in_ms() + MAX_USEC/1000;
+	while(!ipc_check(ipc))
+	{
+		if(wait_for_data(ipc, deadline - time_in_ms()) != 0)
+		{
+			LOG_ERROR_MSG("Timed out on waiting for --remote-expr response");
+			return NULL;
+		}
+	}
+#else
+	/* Using sleep is just easier than doing read with timeout on Windows... */
+	int repeats = 0;
 	while(!ipc_check(ipc))
 	{
 		if(++repeats > MAX_REPEATS)
@@ -616,6 +653,7 @@ ipc_eval(ipc_t *ipc, const char whom[], const char expr[])
 		}
 		usleep(MAX_USEC/MAX_REPEATS);
 	}
+#endif
 
 	return ipc->eval_result;
 }
@@ -878,6 +916,26 @@ sorter(const void *first, const void *second)
 
 #ifndef WIN32_PIPE_READ
 
+/* Waits for data to appear in the pipe of the instance for at most ms
+ * milliseconds.  Returns zero if there is something to read and non-zero on
+ * timeout or error. */
+static int
+wait_for_data(ipc_t *ipc, long long ms)
+{
+	if(ms <= 0)
+	{
+		return 1;
+	}
+
+	const int fd = fileno(ipc->pipe_file);
+	fd_set ready;
+	FD_ZERO(&ready);
+	FD_SET(fd, &ready);
+
+	struct timeval ts = { .tv_sec = ms/1000, .tv_usec = (ms%1000)*1000 };
+	return (select(fd + 1, &ready, NULL, NULL, &ts) <= 0);
+}
+
 /* Tries to open a pipe to check whether it has any readers or it's
  * abandoned.  Returns non-zero if somebody is reading from the pipe and zero
  * otherwise. */
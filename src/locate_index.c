@@ -0,0 +1,1421 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "locate_index.h"
+
+#include <sys/stat.h> /* stat */
+#include <dirent.h> /* DIR dirent */
+#include <regex.h> /* REG_* regcomp() regexec() regfree() regex_t */
+
+#include <ctype.h> /* isupper() tolower() */
+#include <stddef.h> /* NULL size_t */
+#include <stdio.h> /* FILE fclose() fflush() fprintf() fputs() fwrite()
+                      snprintf() */
+#include <stdlib.h> /* calloc() free() qsort() realloc() strtol() */
+#include <string.h> /* memcpy() memmove() strchr() strcmp() strdup() strlen()
+                       strncmp() strstr() */
+#include <time.h> /* time() time_t */
+
+#include "cfg/config.h"
+#include "compat/dtype.h"
+#include "compat/fs_limits.h"
+#include "compat/os.h"
+#include "compat/pthread.h"
+#include "compat/reallocarray.h"
+#include "utils/cancellation.h"
+#include "utils/file_streams.h"
+#include "utils/fs.h"
+#include "utils/globs.h"
+#include "utils/path.h"
+#include "utils/regexp.h"
+#include "utils/str.h"
+#include "utils/string_array.h"
+#include "utils/walker.h"
+#include "background.h"
+
+enum
+{
+	NWORKERS = 4,              /* Number of threads that traverse roots. */
+	MAX_AGE = 60*60,           /* Age after which index is rebuilt (in s). */
+	CANCEL_CHECK_PERIOD = 4096, /* How often query is checked for being
+	                               cancelled. */
+	FLUSH_SIZE = 64*1024,       /* Amount of found paths to write out. */
+	MAX_RANKED = 1000,          /* Maximum number of fuzzy matches to print. */
+};
+
+/* First line of index file, changes along with format of the file. */
+#define INDEX_HEADER "vifm-locate-index 1"
+
+/* Kind of a pattern. */
+typedef enum
+{
+	PK_SUBSTR, /* Substring of a path. */
+	PK_REGEX,  /* Regular expression that matches (part of) a path. */
+	PK_FUZZY,  /* Characters that appear in a path in the same order. */
+}
+PatternKind;
+
+/* Growing list of paths. */
+typedef struct
+{
+	char **items;    /* Paths. */
+	size_t count;    /* Number of paths. */
+	size_t capacity; /* Number of allocated items. */
+}
+paths_t;
+
+/* Path that matched fuzzy pattern along with its rank. */
+typedef struct
+{
+	char *path; /* The path. */
+	int score;  /* Quality of the match, bigger is better. */
+	size_t len; /* Length of the path, shorter is better. */
+}
+ranked_t;
+
+/* Best fuzzy matches.  Can hold up to twice MAX_RANKED items before getting
+ * trimmed. */
+typedef struct
+{
+	ranked_t *items; /* Matches. */
+	size_t count;    /* Number of matches. */
+}
+ranking_t;
+
+/* State of the index. */
+typedef struct
+{
+	char **roots;   /* Roots the index lists files of. */
+	int nroots;     /* Number of roots. */
+	char *file;     /* Where the index is stored. */
+	paths_t paths;  /* Sorted list of paths. */
+	time_t built;   /* When the index was built. */
+	int loaded;     /* Whether the fields above are set. */
+	int rebuilding; /* Whether rebuilding is in progress. */
+}
+index_t;
+
+/* Parameters of a query or of rebuilding. */
+typedef struct
+{
+	char **roots;     /* Roots to list files of. */
+	int nroots;       /* Number of roots. */
+	char *file;       /* Where the index is stored. */
+	PatternKind kind; /* What kind of pattern it is. */
+	char *pattern;    /* The pattern. */
+	int icase;        /* Whether case should be ignored. */
+	regex_t re;       /* Compiled pattern for PK_REGEX. */
+}
+query_t;
+
+static const char * parse_args(const char args[], int *icase, char **error);
+static query_t * make_query(char *roots[], int nroots);
+static bg_job_t * start_query(query_t *q, const char descr[], char **error);
+static void maybe_rebuild(const query_t *q);
+static void query_task(bg_op_t *bg_op, FILE *out, void *arg);
+static int matches(const query_t *q, const char path[], int *score);
+static int fuzzy_score(const char pattern[], const char path[], int icase);
+static int chars_equal(char a, char b, int icase);
+static int rank(ranking_t *ranking, const char path[], int score);
+static void trim_ranking(ranking_t *ranking, size_t max);
+static int ranked_cmp(const void *a, const void *b);
+static void rebuild_task(bg_op_t *bg_op, void *arg);
+static void update_task(bg_op_t *bg_op, void *arg);
+static int update_dir(const char dir[], const cancellation_t *cancellation);
+static int list_dir(const char dir[], strlist_t *names, paths_t *subdirs);
+static void drop_indexed(paths_t *paths);
+static int is_indexed(const char path[]);
+static size_t lower_bound(const paths_t *paths, const char key[]);
+static int has_name(const strlist_t *names, const char name[], size_t len);
+static void ensure_index(const query_t *q, const cancellation_t *cancellation);
+static int is_current(char *roots[], int nroots, const char file[]);
+static int build(char *roots[], int nroots, paths_t *paths,
+		const cancellation_t *cancellation);
+static int collect(const walker_entry_t *entry, void *arg);
+static void sort_paths(paths_t *paths);
+static int path_cmp(const void *a, const void *b);
+static void install(const query_t *q, paths_t *paths, time_t built);
+static int load(const query_t *q, paths_t *paths, time_t *built);
+static int save(char *roots[], int nroots, const char file[],
+		const paths_t *paths);
+static int paths_add(paths_t *paths, char path[]);
+static void paths_free(paths_t *paths);
+static void free_query(query_t *q);
+static int bg_cancellation_hook(void *arg);
+
+/* Protects the index. */
+static pthread_mutex_t index_lock = PTHREAD_MUTEX_INITIALIZER;
+/* The index. */
+static index_t idx;
+
+/* Serializes building and updating to avoid doing the same work twice.  Should
+ * be locked before index_lock.  Paths, roots and file of the index are changed
+ * only with both locks held, so either one is enough to read them. */
+static pthread_mutex_t build_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Protects fields below. */
+static pthread_mutex_t changes_lock = PTHREAD_MUTEX_INITIALIZER;
+/* Whether index is in use and needs to track changes. */
+static int active;
+/* Whether a task that processes changes is running. */
+static int updating;
+/* Directories that wait to be read again. */
+static strlist_t changed_dirs;
+
+bg_job_t *
+locidx_query(char *roots[], int nroots, const char args[], char **error)
+{
+	int icase;
+	const char *const pattern = parse_args(args, &icase, error);
+	if(pattern == NULL)
+	{
+		return NULL;
+	}
+
+	query_t *const q = make_query(roots, nroots);
+	if(q == NULL || (q->pattern = strdup(pattern)) == NULL)
+	{
+		free_query(q);
+		*error = strdup("Not enough memory");
+		return NULL;
+	}
+
+	q->icase = icase;
+	q->kind = PK_SUBSTR;
+
+	char *re = NULL;
+	const size_t len = strlen(pattern);
+	if(len > 1U && pattern[0] == '/' && pattern[len - 1U] == '/')
+	{
+		re = format_str("%.*s", (int)(len - 2U), pattern + 1);
+	}
+	else if(strpbrk(pattern, "*?[") != NULL)
+	{
+		re = glob_to_regex(pattern, /*extended=*/0);
+	}
+
+	if(re != NULL)
+	{
+		const int err = regcomp(&q->re, re, REG_EXTENDED | REG_NOSUB |
+				(icase ? REG_ICASE : 0));
+		free(re);
+		if(err != 0)
+		{
+			*error = format_str("Invalid pattern: %s", get_regexp_error(err, &q->re));
+			regfree(&q->re);
+			free_query(q);
+			return NULL;
+		}
+		q->kind = PK_REGEX;
+	}
+
+	return start_query(q, args, error);
+}
+
+bg_job_t *
+locidx_fuzzy_query(char *roots[], int nroots, const char pattern[],
+		char **error)
+{
+	if(pattern[0] == '\0')
+	{
+		*error = strdup("No pattern specified");
+		return NULL;
+	}
+
+	query_t *const q = make_query(roots, nroots);
+	if(q == NULL || (q->pattern = strdup(pattern)) == NULL)
+	{
+		free_query(q);
+		*error = strdup("Not enough memory");
+		return NULL;
+	}
+
+	q->kind = PK_FUZZY;
+
+	/* Case matters only if pattern contains upper case letters. */
+	q->icase = 1;
+	const char *p;
+	for(p = pattern; *p != '\0' && q->icase; ++p)
+	{
+		q->icase = !isupper((unsigned char)*p);
+	}
+
+	return start_query(q, pattern, error);
+}
+
+/* Parses options at the beginning of :locate arguments.  Returns pointer to the
+ * pattern or NULL on error, in which case *error is set. */
+static const char *
+parse_args(const char args[], int *icase, char **error)
+{
+	*icase = 0;
+
+	const char *p = skip_whitespace(args);
+	while(*p == '-')
+	{
+		if(p[1] == '-' && (p[2] == ' ' || p[2] == '\0'))
+		{
+			p = skip_whitespace(p + 2);
+			break;
+		}
+
+		if(p[1] != 'i' || (p[2] != ' ' && p[2] != '\0'))
+		{
+			*error = format_str("Unknown option: %.*s",
+					(int)(until_first(p, ' ') - p), p);
+			return NULL;
+		}
+
+		*icase = 1;
+		p = skip_whitespace(p + 2);
+	}
+
+	if(*p == '\0')
+	{
+		*error = strdup("No pattern specified");
+		return NULL;
+	}
+
+	return p;
+}
+
+/* Allocates query for the roots and default location of the index.  Returns
+ * the query or NULL on error. */
+static query_t *
+make_query(char *roots[], int nroots)
+{
+	query_t *const q = calloc(1, sizeof(*q));
+	if(q == NULL)
+	{
+		return NULL;
+	}
+
+	q->nroots = nroots;
+	q->roots = copy_string_array(roots, nroots);
+	q->file = format_str("%s/locate-index", cfg.config_dir);
+	if(q->roots == NULL || q->file == NULL)
+	{
+		free_query(q);
+		return NULL;
+	}
+
+	return q;
+}
+
+/* Starts background job that prints results of the query.  Takes ownership of
+ * the query.  Returns the job or NULL on error, in which case *error is
+ * set. */
+static bg_job_t *
+start_query(query_t *q, const char descr[], char **error)
+{
+	pthread_mutex_lock(&changes_lock);
+	active = 1;
+	pthread_mutex_unlock(&changes_lock);
+
+	maybe_rebuild(q);
+
+	char *const full_descr = format_str("Builtin locate: %s", descr);
+	bg_job_t *const job = bg_execute_capture(
+			full_descr == NULL ? descr : full_descr, &query_task, q);
+	free(full_descr);
+
+	if(job == NULL)
+	{
+		free_query(q);
+		*error = strdup("Failed to start background task");
+	}
+	return job;
+}
+
+/* Starts rebuilding of the index in background if it's old. */
+static void
+maybe_rebuild(const query_t *q)
+{
+	const time_t now = time(NULL);
+
+	pthread_mutex_lock(&index_lock);
+	int old;
+	if(idx.loaded && is_current(q->roots, q->nroots, q->file))
+	{
+		old = (now - idx.built > MAX_AGE);
+	}
+	else
+	{
+		/* Missing index is built on the first query. */
+		struct stat st;
+		old = (os_stat(q->file, &st) == 0 && now - st.st_mtime > MAX_AGE);
+	}
+	const int start = (old && !idx.rebuilding);
+	idx.rebuilding |= start;
+	pthread_mutex_unlock(&index_lock);
+
+	if(!start)
+	{
+		return;
+	}
+
+	query_t *const rq = make_query(q->roots, q->nroots);
+	if(rq == NULL || bg_execute("Rebuilding locate index", "...",
+				BG_UNDEFINED_TOTAL, /*important=*/0, &rebuild_task, rq) != 0)
+	{
+		free_query(rq);
+
+		pthread_mutex_lock(&index_lock);
+		idx.rebuilding = 0;
+		pthread_mutex_unlock(&index_lock);
+	}
+}
+
+/* Entry point of background task that prints paths that match.  Fuzzy matches
+ * are printed at the end, best ones first. */
+static void
+query_task(bg_op_t *bg_op, FILE *out, void *arg)
+{
+	query_t *const q = arg;
+
+	const cancellation_t cancellation = {
+		.arg = bg_op,
+		.hook = &bg_cancellation_hook,
+	};
+	ensure_index(q, &cancellation);
+
+	/* Matches are collected to not write to the pipe with the lock held and are
+	 * written out in portions to show them as soon as possible. */
+	char *found = NULL;
+	size_t found_len = 0U;
+	/* Last written path, searching continues after it. */
+	char *last = NULL;
+	size_t checked = 0U;
+	ranking_t ranking = {};
+	if(q->kind == PK_FUZZY)
+	{
+		ranking.items = reallocarray(NULL, 2*MAX_RANKED, sizeof(*ranking.items));
+	}
+
+	int done = 0;
+	while(!done)
+	{
+		done = 1;
+
+		pthread_mutex_lock(&index_lock);
+
+		/* Index could have been updated while the lock was released, so position
+		 * is looked up by the path. */
+		size_t i = 0U;
+		if(last != NULL)
+		{
+			i = lower_bound(&idx.paths, last);
+			if(i < idx.paths.count && strcmp(idx.paths.items[i], last) == 0)
+			{
+				++i;
+			}
+		}
+
+		for(; i < idx.paths.count; ++i)
+		{
+			if(checked++%CANCEL_CHECK_PERIOD == 0U && bg_op_cancelled(bg_op))
+			{
+				break;
+			}
+
+			const char *const path = idx.paths.items[i];
+			int score = 0;
+			if(!matches(q, path, &score))
+			{
+				continue;
+			}
+
+			if(q->kind == PK_FUZZY)
+			{
+				if(rank(&ranking, path, score) != 0)
+				{
+					break;
+				}
+				/* Ranking is trimmed outside of the lock. */
+				if(ranking.count == 2*MAX_RANKED)
+				{
+					done = (replace_string(&last, path) != 0);
+					break;
+				}
+				continue;
+			}
+
+			if(strappend(&found, &found_len, path) != 0 ||
+					strappendch(&found, &found_len, '\n') != 0)
+			{
+				break;
+			}
+
+			if(found_len >= FLUSH_SIZE)
+			{
+				done = (replace_string(&last, path) != 0);
+				break;
+			}
+		}
+
+		pthread_mutex_unlock(&index_lock);
+
+		if(found_len != 0U)
+		{
+			/* Write error means that nobody is interested in results anymore. */
+			if(fwrite(found, 1U, found_len, out) != found_len || fflush(out) != 0)
+			{
+				done = 1;
+			}
+			found_len = 0U;
+		}
+
+		if(ranking.count == 2*MAX_RANKED)
+		{
+			trim_ranking(&ranking, MAX_RANKED);
+		}
+	}
+
+	if(q->kind == PK_FUZZY && !bg_op_cancelled(bg_op))
+	{
+		trim_ranking(&ranking, MAX_RANKED);
+
+		size_t i;
+		for(i = 0U; i < ranking.count; ++i)
+		{
+			if(fprintf(out, "%s\n", ranking.items[i].path) < 0)
+			{
+				break;
+			}
+		}
+	}
+	if(ranking.items != NULL)
+	{
+		trim_ranking(&ranking, 0U);
+		free(ranking.items);
+	}
+
+	free(found);
+	free(last);
+
+	free_query(q);
+}
+
+/* Checks whether the path matches the query.  For fuzzy queries *score is set
+ * to quality of the match.  Returns non-zero if so, otherwise zero is
+ * returned. */
+static int
+matches(const query_t *q, const char path[], int *score)
+{
+	switch(q->kind)
+	{
+		case PK_FUZZY:
+			*score = fuzzy_score(q->pattern, path, q->icase);
+			return (*score >= 0);
+		case PK_SUBSTR:
+			return (q->icase ? strcasestr(path, q->pattern)
+			                 : strstr(path, q->pattern)) != NULL;
+		case PK_REGEX:
+			return regexec(&q->re, path, 0, NULL, 0) == 0;
+	}
+	return 0;
+}
+
+/* Looks for characters of the pattern in the path in the same order starting
+ * from the end of the path, so that matches in file name are found first.
+ * Consecutive matches and matches at the beginning of words or in the file
+ * name increase the score.  Returns the score or -1 on no match. */
+static int
+fuzzy_score(const char pattern[], const char path[], int icase)
+{
+	const size_t path_len = strlen(path);
+	const size_t name_pos = get_last_path_component(path) - path;
+
+	int score = 0;
+	size_t i = strlen(pattern);
+	size_t j = path_len;
+	/* Position of the previous match or a value that can't be next to any. */
+	size_t prev = path_len + 1U;
+	while(i > 0U)
+	{
+		--i;
+		while(j > 0U && !chars_equal(path[j - 1U], pattern[i], icase))
+		{
+			--j;
+		}
+		if(j == 0U)
+		{
+			return -1;
+		}
+		--j;
+
+		score += 1;
+		if(j + 1U == prev)
+		{
+			score += 4;
+		}
+		if(j == 0U || strchr("/-_. ", path[j - 1U]) != NULL)
+		{
+			score += 6;
+		}
+		if(j >= name_pos)
+		{
+			score += 2;
+		}
+		prev = j;
+	}
+
+	return score;
+}
+
+/* Compares two characters possibly ignoring their case.  Returns non-zero if
+ * they are equal, otherwise zero is returned. */
+static int
+chars_equal(char a, char b, int icase)
+{
+	return icase ? tolower((unsigned char)a) == tolower((unsigned char)b)
+	             : a == b;
+}
+
+/* Adds a copy of the path to the ranking.  Returns zero on success, otherwise
+ * non-zero is returned. */
+static int
+rank(ranking_t *ranking, const char path[], int score)
+{
+	if(ranking->items == NULL)
+	{
+		return 1;
+	}
+
+	char *const copy = strdup(path);
+	if(copy == NULL)
+	{
+		return 1;
+	}
+
+	ranking->items[ranking->count++] = (ranked_t){
+		.path = copy,
+		.score = score,
+		.len = strlen(path),
+	};
+	return 0;
+}
+
+/* Sorts matches from best to worst and leaves at most max of them. */
+static void
+trim_ranking(ranking_t *ranking, size_t max)
+{
+	qsort(ranking->items, ranking->count, sizeof(*ranking->items), &ranked_cmp);
+
+	size_t i;
+	for(i = max; i < ranking->count; ++i)
+	{
+		free(ranking->items[i].path);
+	}
+	if(ranking->count > max)
+	{
+		ranking->count = max;
+	}
+}
+
+/* qsort() comparer that puts better matches first.  Returns standard -1, 0, 1
+ * for comparisons. */
+static int
+ranked_cmp(const void *a, const void *b)
+{
+	const ranked_t *const x = a;
+	const ranked_t *const y = b;
+
+	if(x->score != y->score)
+	{
+		return (x->score > y->score) ? -1 : 1;
+	}
+	if(x->len != y->len)
+	{
+		return (x->len < y->len) ? -1 : 1;
+	}
+	return strcmp(x->path, y->path);
+}
+
+/* Entry point of background task that builds the index anew. */
+static void
+rebuild_task(bg_op_t *bg_op, void *arg)
+{
+	query_t *const q = arg;
+
+	const cancellation_t cancellation = {
+		.arg = bg_op,
+		.hook = &bg_cancellation_hook,
+	};
+
+	pthread_mutex_lock(&build_lock);
+
+	/* Partial listing isn't stored and current index is kept. */
+	paths_t paths = {};
+	if(build(q->roots, q->nroots, &paths, &cancellation) == 0)
+	{
+		(void)save(q->roots, q->nroots, q->file, &paths);
+		install(q, &paths, time(NULL));
+	}
+	paths_free(&paths);
+
+	pthread_mutex_unlock(&build_lock);
+
+	pthread_mutex_lock(&index_lock);
+	idx.rebuilding = 0;
+	pthread_mutex_unlock(&index_lock);
+
+	free_query(q);
+}
+
+void
+locidx_dir_changed(const char path[])
+{
+	pthread_mutex_lock(&changes_lock);
+	if(!active)
+	{
+		pthread_mutex_unlock(&changes_lock);
+		return;
+	}
+
+	if(!is_in_string_array(changed_dirs.items, changed_dirs.nitems, path))
+	{
+		changed_dirs.nitems = add_to_string_array(&changed_dirs.items,
+				changed_dirs.nitems, path);
+	}
+	const int start = !updating;
+	updating = 1;
+	pthread_mutex_unlock(&changes_lock);
+
+	if(start && bg_execute("Updating locate index", path, BG_UNDEFINED_TOTAL,
+				/*important=*/0, &update_task, NULL) != 0)
+	{
+		pthread_mutex_lock(&changes_lock);
+		updating = 0;
+		pthread_mutex_unlock(&changes_lock);
+	}
+}
+
+/* Entry point of background task that updates changed directories in the
+ * index. */
+static void
+update_task(bg_op_t *bg_op, void *arg)
+{
+	const cancellation_t cancellation = {
+		.arg = bg_op,
+		.hook = &bg_cancellation_hook,
+	};
+
+	pthread_mutex_lock(&build_lock);
+
+	int changed = 0;
+	while(1)
+	{
+		pthread_mutex_lock(&changes_lock);
+		if(changed_dirs.nitems == 0)
+		{
+			updating = 0;
+			pthread_mutex_unlock(&changes_lock);
+			break;
+		}
+		char *const dir = changed_dirs.items[--changed_dirs.nitems];
+		pthread_mutex_unlock(&changes_lock);
+
+		changed |= update_dir(dir, &cancellation);
+		free(dir);
+	}
+
+	/* The index is saved without index_lock to not block queries. */
+	if(changed && idx.loaded)
+	{
+		(void)save(idx.roots, idx.nroots, idx.file, &idx.paths);
+	}
+
+	pthread_mutex_unlock(&build_lock);
+}
+
+/* Replaces entries of the directory in the index with what's on the file
+ * system now.  Newly appeared subdirectories are traversed and disappeared ones
+ * are dropped along with their contents.  Nothing is changed if listing of new
+ * subdirectories gets cancelled.  Returns non-zero if the index was changed,
+ * otherwise zero is returned. */
+static int
+update_dir(const char dir[], const cancellation_t *cancellation)
+{
+	if(!is_indexed(dir))
+	{
+		return 0;
+	}
+
+	char prefix[PATH_MAX + 1];
+	snprintf(prefix, sizeof(prefix), "%s%s", dir,
+			ends_with_slash(dir) ? "" : "/");
+	const size_t prefix_len = strlen(prefix);
+
+	strlist_t names = {};
+	paths_t subdirs = {};
+	const int exists = (list_dir(dir, &names, &subdirs) == 0);
+	if(!exists && path_exists(dir, NODEREF))
+	{
+		/* Directory is there, but can't be read. */
+		return 0;
+	}
+
+	/* List new entries. */
+	paths_t added = {};
+	drop_indexed(&subdirs);
+	const int cancelled = build(subdirs.items, (int)subdirs.count, &added,
+			cancellation);
+	paths_free(&subdirs);
+	if(cancelled)
+	{
+		paths_free(&added);
+		free_string_array(names.items, names.nitems);
+		return 0;
+	}
+
+	int k;
+	for(k = 0; k < names.nitems; ++k)
+	{
+		(void)paths_add(&added, format_str("%s%s", prefix, names.items[k]));
+	}
+	sort_paths(&added);
+
+	qsort(names.items, names.nitems, sizeof(*names.items), &path_cmp);
+
+	pthread_mutex_lock(&index_lock);
+
+	int changed = 0;
+
+	/* Directory that no longer exists is removed as well.  Its entry doesn't
+	 * necessarily precede entries under it, because names like "dir.txt" sort
+	 * between "dir" and "dir/". */
+	if(!exists)
+	{
+		const size_t pos = lower_bound(&idx.paths, dir);
+		if(pos < idx.paths.count && strcmp(idx.paths.items[pos], dir) == 0)
+		{
+			free(idx.paths.items[pos]);
+			memmove(&idx.paths.items[pos], &idx.paths.items[pos + 1U],
+					(idx.paths.count - pos - 1U)*sizeof(*idx.paths.items));
+			--idx.paths.count;
+			changed = 1;
+		}
+	}
+
+	/* Entries of the directory form a continuous range in sorted list. */
+	const size_t lo = lower_bound(&idx.paths, prefix);
+	prefix[prefix_len - 1U] = '/' + 1;
+	const size_t hi = lower_bound(&idx.paths, prefix);
+	prefix[prefix_len - 1U] = '/';
+
+	/* Allocate everything beforehand to not fail in the middle of updating. */
+	const size_t max_range = (hi - lo) + added.count;
+	const size_t capacity = idx.paths.count - (hi - lo) + max_range;
+	char **const range = reallocarray(NULL, max_range + 1U, sizeof(*range));
+	char **const items = reallocarray(NULL, capacity + 1U, sizeof(*items));
+	if(range != NULL && items != NULL)
+	{
+		size_t n = 0U;
+		size_t i = lo, j = 0U;
+		while(i < hi || j < added.count)
+		{
+			char *const old = (i < hi ? idx.paths.items[i] : NULL);
+			const int cmp = (old == NULL) ? 1
+			              : (j == added.count) ? -1
+			              : strcmp(old, added.items[j]);
+			if(cmp < 0)
+			{
+				/* Entry is kept if its top-level component still exists. */
+				const char *const name = old + prefix_len;
+				if(strncmp(old, prefix, prefix_len) == 0 &&
+						has_name(&names, name, until_first(name, '/') - name))
+				{
+					range[n++] = old;
+				}
+				else
+				{
+					free(old);
+					changed = 1;
+				}
+				++i;
+			}
+			else if(cmp == 0)
+			{
+				range[n++] = old;
+				++i;
+				++j;
+			}
+			else
+			{
+				range[n++] = added.items[j];
+				added.items[j++] = NULL;
+				changed = 1;
+			}
+		}
+
+		const size_t tail = idx.paths.count - hi;
+		memcpy(items, idx.paths.items, lo*sizeof(*items));
+		memcpy(items + lo, range, n*sizeof(*items));
+		memcpy(items + lo + n, idx.paths.items + hi, tail*sizeof(*items));
+
+		free(idx.paths.items);
+		idx.paths.items = items;
+		idx.paths.count = lo + n + tail;
+		idx.paths.capacity = capacity + 1U;
+	}
+	else
+	{
+		free(items);
+	}
+
+	pthread_mutex_unlock(&index_lock);
+
+	free(range);
+	paths_free(&added);
+	free_string_array(names.items, names.nitems);
+	return changed;
+}
+
+/* Lists names of entries of the directory and full paths of its
+ * subdirectories.  Returns zero on success, otherwise non-zero is returned. */
+static int
+list_dir(const char dir[], strlist_t *names, paths_t *subdirs)
+{
+	DIR *const d = os_opendir(dir);
+	if(d == NULL)
+	{
+		return 1;
+	}
+
+	struct dirent *entry;
+	while((entry = os_readdir(d)) != NULL)
+	{
+		const char *const name = entry->d_name;
+		if(is_builtin_dir(name) || strchr(name, '\n') != NULL)
+		{
+			continue;
+		}
+
+		names->nitems = add_to_string_array(&names->items, names->nitems, name);
+
+		char *const path = join_paths(dir, name);
+		if(path != NULL && get_dirent_type(entry, path) == DT_DIR)
+		{
+			(void)paths_add(subdirs, path);
+		}
+		else
+		{
+			free(path);
+		}
+	}
+
+	os_closedir(d);
+	return 0;
+}
+
+/* Removes paths that are already in the index from the list. */
+static void
+drop_indexed(paths_t *paths)
+{
+	size_t kept = 0U;
+
+	pthread_mutex_lock(&index_lock);
+	size_t i;
+	for(i = 0U; i < paths->count; ++i)
+	{
+		const size_t pos = lower_bound(&idx.paths, paths->items[i]);
+		if(pos < idx.paths.count &&
+				strcmp(idx.paths.items[pos], paths->items[i]) == 0)
+		{
+			free(paths->items[i]);
+		}
+		else
+		{
+			paths->items[kept++] = paths->items[i];
+		}
+	}
+	pthread_mutex_unlock(&index_lock);
+
+	paths->count = kept;
+}
+
+/* Checks whether the path is under one of the roots of the index.  Paths are
+ * compared as strings, because the index stores them that way and the path
+ * might not exist anymore.  Returns non-zero if so, otherwise zero is
+ * returned. */
+static int
+is_indexed(const char path[])
+{
+	int indexed = 0;
+
+	pthread_mutex_lock(&index_lock);
+	int i;
+	for(i = 0; i < idx.nroots && idx.loaded && !indexed; ++i)
+	{
+		indexed = path_starts_with(path, idx.roots[i]);
+	}
+	pthread_mutex_unlock(&index_lock);
+
+	return indexed;
+}
+
+/* Finds position of the first path that isn't less than the key.  Returns the
+ * position. */
+static size_t
+lower_bound(const paths_t *paths, const char key[])
+{
+	size_t lo = 0U, hi = paths->count;
+	while(lo < hi)
+	{
+		const size_t mid = lo + (hi - lo)/2U;
+		if(strcmp(paths->items[mid], key) < 0)
+		{
+			lo = mid + 1U;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+/* Checks whether sorted list of names contains the name of the specified
+ * length.  Returns non-zero if so, otherwise zero is returned. */
+static int
+has_name(const strlist_t *names, const char name[], size_t len)
+{
+	int lo = 0, hi = names->nitems;
+	while(lo < hi)
+	{
+		const int mid = lo + (hi - lo)/2;
+		const char *const item = names->items[mid];
+		int cmp = strncmp(item, name, len);
+		if(cmp == 0)
+		{
+			cmp = (item[len] != '\0');
+		}
+
+		if(cmp == 0)
+		{
+			return 1;
+		}
+		if(cmp < 0)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+	return 0;
+}
+
+/* Makes sure that the index is available by loading or building it if
+ * necessary.  Index stays unavailable if building it gets cancelled. */
+static void
+ensure_index(const query_t *q, const cancellation_t *cancellation)
+{
+	pthread_mutex_lock(&index_lock);
+	int current = (idx.loaded && is_current(q->roots, q->nroots, q->file));
+	pthread_mutex_unlock(&index_lock);
+
+	if(current)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&build_lock);
+
+	/* The index could have been made while waiting for the lock. */
+	pthread_mutex_lock(&index_lock);
+	current = (idx.loaded && is_current(q->roots, q->nroots, q->file));
+	pthread_mutex_unlock(&index_lock);
+
+	if(!current)
+	{
+		paths_t paths = {};
+		time_t built;
+		int ok = (load(q, &paths, &built) == 0);
+		if(!ok && build(q->roots, q->nroots, &paths, cancellation) == 0)
+		{
+			built = time(NULL);
+			(void)save(q->roots, q->nroots, q->file, &paths);
+			ok = 1;
+		}
+
+		if(ok)
+		{
+			install(q, &paths, built);
+		}
+		paths_free(&paths);
+	}
+
+	pthread_mutex_unlock(&build_lock);
+}
+
+/* Checks whether the index is for the specified roots and file.  Must be
+ * called with the index_lock held.  Returns non-zero if so, otherwise zero is
+ * returned. */
+static int
+is_current(char *roots[], int nroots, const char file[])
+{
+	if(idx.nroots != nroots || strcmp(idx.file, file) != 0)
+	{
+		return 0;
+	}
+
+	int i;
+	for(i = 0; i < nroots; ++i)
+	{
+		if(strcmp(idx.roots[i], roots[i]) != 0)
+		{
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* Traverses the roots collecting paths of everything they contain including
+ * the roots.  Returns zero on success and non-zero if traversal was
+ * cancelled, in which case paths are incomplete. */
+static int
+build(char *roots[], int nroots, paths_t *paths,
+		const cancellation_t *cancellation)
+{
+	if(nroots == 0)
+	{
+		return 0;
+	}
+
+	paths_t lists[NWORKERS] = {};
+	const int cancelled = walker_run(roots, nroots, "/", NWORKERS, &collect,
+			lists, cancellation);
+
+	int i;
+	for(i = 0; i < NWORKERS; ++i)
+	{
+		size_t j;
+		for(j = 0U; j < lists[i].count; ++j)
+		{
+			(void)paths_add(paths, lists[i].items[j]);
+		}
+		lists[i].count = 0U;
+		paths_free(&lists[i]);
+	}
+
+	sort_paths(paths);
+	return cancelled;
+}
+
+/* Records path of an entry in the list of the worker.  Returns non-zero for
+ * directories to descend into them. */
+static int
+collect(const walker_entry_t *entry, void *arg)
+{
+	paths_t *const lists = arg;
+
+	/* Such paths can't be stored. */
+	if(strchr(entry->full_path, '\n') == NULL)
+	{
+		(void)paths_add(&lists[entry->worker], strdup(entry->full_path));
+	}
+
+	return (entry->type == WT_DIR);
+}
+
+/* Sorts paths and removes duplicates. */
+static void
+sort_paths(paths_t *paths)
+{
+	if(paths->count == 0U)
+	{
+		return;
+	}
+
+	qsort(paths->items, paths->count, sizeof(*paths->items), &path_cmp);
+
+	size_t i, n = 1U;
+	for(i = 1U; i < paths->count; ++i)
+	{
+		if(strcmp(paths->items[i], paths->items[n - 1U]) == 0)
+		{
+			free(paths->items[i]);
+		}
+		else
+		{
+			paths->items[n++] = paths->items[i];
+		}
+	}
+	paths->count = n;
+}
+
+/* qsort() comparer for paths.  Returns standard -1, 0, 1 for comparisons. */
+static int
+path_cmp(const void *a, const void *b)
+{
+	return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/* Replaces the index with the paths taking ownership of them. */
+static void
+install(const query_t *q, paths_t *paths, time_t built)
+{
+	char **const roots = copy_string_array(q->roots, q->nroots);
+	char *const file = strdup(q->file);
+
+	pthread_mutex_lock(&index_lock);
+
+	free_string_array(idx.roots, idx.nroots);
+	free(idx.file);
+	paths_free(&idx.paths);
+
+	idx.roots = roots;
+	idx.nroots = q->nroots;
+	idx.file = file;
+	idx.paths = *paths;
+	idx.built = built;
+	idx.loaded = (roots != NULL && file != NULL);
+	if(!idx.loaded)
+	{
+		free_string_array(idx.roots, idx.nroots);
+		idx.roots = NULL;
+		idx.nroots = 0;
+		free(idx.file);
+		idx.file = NULL;
+		paths_free(&idx.paths);
+	}
+
+	pthread_mutex_unlock(&index_lock);
+
+	*paths = (paths_t){};
+}
+
+/* Reads index of the query from its file.  Returns zero on success, otherwise
+ * non-zero is returned. */
+static int
+load(const query_t *q, paths_t *paths, time_t *built)
+{
+	FILE *const fp = os_fopen(q->file, "r");
+	if(fp == NULL)
+	{
+		return 1;
+	}
+
+	struct stat st;
+	char *line = read_line(fp, NULL);
+	int ok = (os_stat(q->file, &st) == 0)
+	      && line != NULL
+	      && strcmp(line, INDEX_HEADER) == 0;
+
+	/* Index of different roots is of no use. */
+	int i;
+	for(i = 0; i < q->nroots && ok; ++i)
+	{
+		ok = (line = read_line(fp, line)) != NULL
+		  && strcmp(line, q->roots[i]) == 0;
+	}
+	ok = ok && (line = read_line(fp, line)) != NULL && line[0] == '\0';
+
+	/* Paths aren't limited in length here, because nothing limits them when
+	 * the index is built. */
+	char *path = NULL;
+	size_t path_len = 0U;
+	while(ok && (line = read_line(fp, line)) != NULL)
+	{
+		char *suffix;
+		const long common = strtol(line, &suffix, 10);
+		if(suffix == line || *suffix++ != '\t' || common < 0 ||
+				(size_t)common > path_len)
+		{
+			ok = 0;
+			break;
+		}
+
+		const size_t suffix_len = strlen(suffix);
+		char *const new_path = realloc(path, common + suffix_len + 1U);
+		if(new_path == NULL)
+		{
+			ok = 0;
+			break;
+		}
+
+		path = new_path;
+		memcpy(path + common, suffix, suffix_len + 1U);
+		path_len = common + suffix_len;
+		ok = (paths_add(paths, strdup(path)) == 0);
+	}
+
+	free(path);
+	free(line);
+	fclose(fp);
+
+	if(!ok)
+	{
+		paths_free(paths);
+		return 1;
+	}
+
+	*built = st.st_mtime;
+	return 0;
+}
+
+/* Writes index into the file replacing it atomically.  Each path is preceded
+ * by length of prefix it shares with the previous path and a tabulation and
+ * contains only the rest of the path.  Returns zero on success, otherwise
+ * non-zero is returned. */
+static int
+save(char *roots[], int nroots, const char file[], const paths_t *paths)
+{
+	char *const tmp = format_str("%s.tmp", file);
+	if(tmp == NULL)
+	{
+		return 1;
+	}
+
+	FILE *const fp = os_fopen(tmp, "w");
+	if(fp == NULL)
+	{
+		free(tmp);
+		return 1;
+	}
+
+	fprintf(fp, "%s\n", INDEX_HEADER);
+	int i;
+	for(i = 0; i < nroots; ++i)
+	{
+		fprintf(fp, "%s\n", roots[i]);
+	}
+	fputc('\n', fp);
+
+	const char *prev = "";
+	size_t j;
+	for(j = 0U; j < paths->count; ++j)
+	{
+		const char *const path = paths->items[j];
+
+		size_t common = 0U;
+		while(prev[common] != '\0' && prev[common] == path[common])
+		{
+			++common;
+		}
+
+		fprintf(fp, "%d\t%s\n", (int)common, path + common);
+		prev = path;
+	}
+
+	int error = ferror(fp);
+	error |= (fclose(fp) != 0);
+	error = error || (os_rename(tmp, file) != 0);
+	if(error)
+	{
+		(void)remove(tmp);
+	}
+
+	free(tmp);
+	return error;
+}
+
+void
+locidx_reset(void)
+{
+	pthread_mutex_lock(&build_lock);
+	pthread_mutex_lock(&index_lock);
+	free_string_array(idx.roots, idx.nroots);
+	free(idx.file);
+	paths_free(&idx.paths);
+	idx = (index_t){};
+	pthread_mutex_unlock(&index_lock);
+	pthread_mutex_unlock(&build_lock);
+
+	pthread_mutex_lock(&changes_lock);
+	active = 0;
+	free_string_array(changed_dirs.items, changed_dirs.nitems);
+	changed_dirs.items = NULL;
+	changed_dirs.nitems = 0;
+	pthread_mutex_unlock(&changes_lock);
+}
+
+/* Appends path to the list taking ownership of it.  The path can be NULL.
+ * Returns zero on success, otherwise non-zero is returned and the path is
+ * freed. */
+static int
+paths_add(paths_t *paths, char path[])
+{
+	if(path == NULL)
+	{
+		return 1;
+	}
+
+	if(paths->count == paths->capacity)
+	{
+		const size_t capacity = (paths->capacity == 0U ? 64U : paths->capacity*2U);
+		char **const items = reallocarray(paths->items, capacity,
+				sizeof(*items));
+		if(items == NULL)
+		{
+			free(path);
+			return 1;
+		}
+
+		paths->items = items;
+		paths->capacity = capacity;
+	}
+
+	paths->items[paths->count++] = path;
+	return 0;
+}
+
+/* Frees all paths of the list and resets it. */
+static void
+paths_free(paths_t *paths)
+{
+	size_t i;
+	for(i = 0U; i < paths->count; ++i)
+	{
+		free(paths->items[i]);
+	}
+	free(paths->items);
+	*paths = (paths_t){};
+}
+
+/* Frees the query.  The query can be NULL. */
+static void
+free_query(query_t *q)
+{
+	if(q == NULL)
+	{
+		return;
+	}
+
+	if(q->kind == PK_REGEX)
+	{
+		regfree(&q->re);
+	}
+	free_string_array(q->roots, q->nroots);
+	free(q->file);
+	free(q->pattern);
+	free(q);
+}
+
+/* Implementation of cancellation hook for background tasks. */
+static int
+bg_cancellation_hook(void *arg)
+{
+	return bg_op_cancelled(arg);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,59 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__LOCATE_INDEX_H__
+#define VIFM__LOCATE_INDEX_H__
+
+/* Database of file names for :locate and :jump maintained by vifm itself.  It
+ * lists all files under a set of roots and is stored on disk as a sorted list
+ * of paths in which each path omits prefix that it shares with the previous
+ * one.  The index is rebuilt in background once it gets old and directories
+ * whose changes are noticed while vifm runs are updated in it incrementally. */
+
+struct bg_job_t;
+
+/* Starts looking for paths under the roots (absolute paths) that match the
+ * args, which consist of an optional -i (ignore case) followed by a pattern.
+ * Pattern in the form /regex/ is matched against the whole path, pattern that
+ * contains any of *?[ is a glob that needs to match the whole path and any
+ * other pattern is looked up as a substring.  The index is loaded or built if
+ * necessary, results are produced from what's in the index at the moment.
+ * Returns job whose output lists found paths or NULL on error, in which case
+ * *error is set to a newly allocated message. */
+struct bg_job_t * locidx_query(char *roots[], int nroots, const char args[],
+		char **error);
+
+/* Same as locidx_query(), but looks for paths that contain characters of the
+ * pattern in the same order.  Case is ignored unless the pattern contains upper
+ * case letters.  Results are printed at once when searching is done and are
+ * ordered from best to worst, with matches in file names and at beginnings of
+ * words being preferred. */
+struct bg_job_t * locidx_fuzzy_query(char *roots[], int nroots,
+		const char pattern[], char **error);
+
+/* Notifies the index that contents of the directory has changed, which is
+ * then re-read in background if it's indexed. */
+void locidx_dir_changed(const char path[]);
+
+/* Forgets in-memory state of the index, but doesn't remove it from disk. */
+void locidx_reset(void);
+
+#endif /* VIFM__LOCATE_INDEX_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -18,20 +18,28 @@
 
 #include "vlua.h"
 
+#include <sys/stat.h> /* S_IRWXU stat */
+#include <unistd.h> /* unlink() */
+
 #include <assert.h> /* assert() */
 #include <stddef.h> /* NULL size_t */
-#include <stdlib.h> /* free() */
-#include <string.h> /* strdup() */
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* FILE fclose() fread() fwrite() snprintf() */
+#include <stdlib.h> /* free() malloc() realloc() */
+#include <string.h> /* memcmp() memcpy() memset() strcmp() strcpy() strdup()
+                       strlen() */
 
 #include "../cfg/config.h"
 #include "../cfg/info.h"
 #include "../compat/dtype.h"
 #include "../compat/fs_limits.h"
+#include "../compat/os.h"
 #include "../engine/options.h"
 #include "../engine/variables.h"
 #include "../modes/dialogs/msg_dialog.h"
 #include "../ui/statusbar.h"
 #include "../ui/ui.h"
+#include "../utils/filemon.h"
 #include "../utils/fs.h"
 #include "../utils/path.h"
 #include "../utils/str.h"
@@ -59,6 +67,36 @@
 #include "vlua_cbacks.h"
 #include "vlua_state.h"
 
+/* Marker at the start of files with compiled Lua chunks, it changes with
+ * format of the files. */
+#define CHUNK_MAGIC "vifm-luac2\n"
+
+/* Maximum size of a compiled chunk that is read from the cache. */
+#define MAX_CHUNK_SIZE (16*1024*1024)
+
+/* Header of a file in the cache of compiled chunks.  It's followed by path to
+ * the source file and the chunk. */
+typedef struct
+{
+	char magic[sizeof(CHUNK_MAGIC) - 1]; /* CHUNK_MAGIC without terminator. */
+	char lua_release[32]; /* LUA_RELEASE of the Lua that compiled the chunk. */
+	filemon_t mon;        /* Modification time and identity of the source. */
+	uint64_t src_size;    /* Size of the source file. */
+	uint64_t path_len;    /* Length of path to the source file. */
+	uint64_t chunk_size;  /* Size of the chunk. */
+	uint64_t chunk_hash;  /* Hash of the chunk to detect corruption. */
+}
+chunk_header_t;
+
+/* Buffer for dumping a chunk into memory. */
+typedef struct
+{
+	char *data; /* Contents of the chunk. */
+	size_t len; /* Number of bytes in data. */
+	int failed; /* Whether memory allocation has failed. */
+}
+chunk_buf_t;
+
 static void patch_env(lua_State *lua);
 static void load_api(lua_State *lua);
 static int VLUA_API(api_is_at_least)(lua_State *lua);
@@ -82,6 +120,17 @@ static int VLUA_API(sb_error)(lua_State *lua);
 static int VLUA_API(sb_quick)(lua_State *lua);
 static int load_plugin(lua_State *lua, const char name[], plug_t *plug);
 static void setup_plugin_env(lua_State *lua, plug_t *plug);
+static int load_file(lua_State *lua, const char path[]);
+static int make_chunk_header(const char path[], chunk_header_t *header);
+static int load_cached_chunk(lua_State *lua, const char path[],
+		const char cache_path[], const chunk_header_t *expected);
+static int read_chunk_header(FILE *fp, chunk_header_t *header, char path[]);
+static void store_cached_chunk(lua_State *lua, const char path[],
+		const char cache_path[], const chunk_header_t *header);
+static int write_chunk(lua_State *lua, const void *p, size_t sz, void *data);
+static uint64_t hash_chunk(const char chunk[], size_t len);
+TSTATIC int get_chunk_cache_path(const char path[], char buf[],
+		size_t buf_len);
 
 VLUA_DECLARE_SAFE(api_is_at_least);
 VLUA_DECLARE_SAFE(api_has);
@@ -544,7 +593,7 @@ load_plugin(lua_State *lua, const char name[], plug_t *plug)
 	snprintf(full_path, sizeof(full_path), "%s/plugins/%s/init.lua",
 			cfg.config_dir, name);
 
-	if(luaL_loadfile(lua, full_path) != LUA_OK)
+	if(load_file(lua, full_path) != LUA_OK)
 	{
 		const char *error = lua_tostring(lua, -1);
 		plug_log(plug, error);
@@ -693,7 +742,7 @@ static int
 VLUA_IMPL(require_plugin_module)(lua_State *lua)
 {
 	const char *mod = luaL_checkstring(lua, 1);
-	if(luaL_loadfile(lua, mod) != LUA_OK)
+	if(load_file(lua, mod) != LUA_OK)
 	{
 		const char *error = lua_tostring(lua, -1);
 		return luaL_error(lua, "vifm.plugin.require('%s'): %s", mod, error);
@@ -726,6 +775,283 @@ VLUA_IMPL(require_plugin_module)(lua_State *lua)
 	return 1;
 }
 
+/* Loads Lua file as a chunk reusing its compiled form from the previous run if
+ * the source hasn't changed since then.  Returns status of the loading, which
+ * is LUA_OK on success. */
+static int
+load_file(lua_State *lua, const char path[])
+{
+	chunk_header_t header;
+	char cache_path[PATH_MAX + 1];
+	if(get_chunk_cache_path(path, cache_path, sizeof(cache_path)) != 0 ||
+			make_chunk_header(path, &header) != 0)
+	{
+		return luaL_loadfile(lua, path);
+	}
+
+	if(load_cached_chunk(lua, path, cache_path, &header) == LUA_OK)
+	{
+		return LUA_OK;
+	}
+
+	int status = luaL_loadfile(lua, path);
+	if(status == LUA_OK)
+	{
+		store_cached_chunk(lua, path, cache_path, &header);
+	}
+	return status;
+}
+
+/* Fills header of a cached chunk with information about the source file and
+ * the Lua that compiles it.  Returns zero on success, otherwise non-zero is
+ * returned. */
+static int
+make_chunk_header(const char path[], chunk_header_t *header)
+{
+	/* Zeroing the structure makes it safe to be written to a file. */
+	memset(header, 0, sizeof(*header));
+
+	struct stat st;
+	if(os_stat(path, &st) != 0 ||
+			filemon_from_file(path, FMT_MODIFIED, &header->mon) != 0)
+	{
+		return 1;
+	}
+
+	memcpy(header->magic, CHUNK_MAGIC, sizeof(header->magic));
+	copy_str(header->lua_release, sizeof(header->lua_release), LUA_RELEASE);
+	header->src_size = st.st_size;
+	header->path_len = strlen(path);
+	return 0;
+}
+
+/* Loads compiled chunk from the cache if it corresponds to the source file.
+ * Returns LUA_OK and places the chunk onto the stack on success, otherwise
+ * returns something else and leaves the stack unchanged. */
+static int
+load_cached_chunk(lua_State *lua, const char path[], const char cache_path[],
+		const chunk_header_t *expected)
+{
+	FILE *fp = os_fopen(cache_path, "rb");
+	if(fp == NULL)
+	{
+		return LUA_ERRFILE;
+	}
+
+	/* The path is checked because names of cache files aren't unique. */
+	chunk_header_t header;
+	char cached_path[PATH_MAX + 1];
+	char *chunk = NULL;
+	const int valid = read_chunk_header(fp, &header, cached_path) == 0
+	               && strcmp(header.lua_release, expected->lua_release) == 0
+	               && filemon_equal(&header.mon, &expected->mon)
+	               && header.src_size == expected->src_size
+	               && strcmp(cached_path, path) == 0
+	               && header.chunk_size <= MAX_CHUNK_SIZE
+	               && (chunk = malloc(header.chunk_size + 1U)) != NULL
+	               && fread(chunk, 1U, header.chunk_size + 1U, fp)
+	                  == header.chunk_size
+	               && hash_chunk(chunk, header.chunk_size) == header.chunk_hash;
+	fclose(fp);
+
+	/* Lua doesn't verify bytecode, so it must be loaded only if it's exactly
+	 * what was dumped. */
+	if(!valid)
+	{
+		free(chunk);
+		return LUA_ERRFILE;
+	}
+
+	char chunk_name[PATH_MAX + 2];
+	snprintf(chunk_name, sizeof(chunk_name), "@%s", path);
+
+	int status = luaL_loadbufferx(lua, chunk, header.chunk_size, chunk_name,
+			"b");
+	free(chunk);
+
+	if(status != LUA_OK)
+	{
+		lua_pop(lua, 1);
+	}
+	return status;
+}
+
+/* Reads header of a cached chunk and path to its source that follows it.  The
+ * path buffer should be at least PATH_MAX + 1 bytes long.  Returns zero on
+ * success, otherwise non-zero is returned. */
+static int
+read_chunk_header(FILE *fp, chunk_header_t *header, char path[])
+{
+	if(fread(header, sizeof(*header), 1, fp) != 1 ||
+			memcmp(header->magic, CHUNK_MAGIC, sizeof(header->magic)) != 0 ||
+			header->path_len > PATH_MAX ||
+			fread(path, 1U, header->path_len, fp) != header->path_len)
+	{
+		return 1;
+	}
+
+	header->lua_release[sizeof(header->lua_release) - 1U] = '\0';
+	path[header->path_len] = '\0';
+	return 0;
+}
+
+/* Writes compiled chunk at the top of the stack to the cache.  Failures are
+ * ignored as the cache is only an optimization. */
+static void
+store_cached_chunk(lua_State *lua, const char path[], const char cache_path[],
+		const chunk_header_t *header)
+{
+	if(make_path(cfg.luac_dir, S_IRWXU) != 0)
+	{
+		return;
+	}
+
+	/* Dump the chunk to memory first as its size and hash go to the header. */
+	chunk_buf_t buf = {};
+	if(lua_dump(lua, &write_chunk, &buf, 0) != 0 || buf.failed)
+	{
+		free(buf.data);
+		return;
+	}
+
+	chunk_header_t full_header = *header;
+	full_header.chunk_size = buf.len;
+	full_header.chunk_hash = hash_chunk(buf.data, buf.len);
+
+	/* Write to a temporary file first to never leave a partially written chunk
+	 * at the final location. */
+	char tmp_path[PATH_MAX + 8];
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", cache_path);
+
+	FILE *fp = os_fopen(tmp_path, "wb");
+	if(fp == NULL)
+	{
+		free(buf.data);
+		return;
+	}
+
+	int failed = (fwrite(&full_header, sizeof(full_header), 1, fp) != 1)
+	          || (fwrite(path, 1U, header->path_len, fp) != header->path_len)
+	          || (fwrite(buf.data, 1U, buf.len, fp) != buf.len);
+	failed |= (fclose(fp) != 0);
+	free(buf.data);
+
+	if(failed || os_rename(tmp_path, cache_path) != 0)
+	{
+		(void)unlink(tmp_path);
+	}
+}
+
+/* Writer for lua_dump() that appends a piece of a chunk to a buffer.  Returns
+ * zero on success and non-zero otherwise. */
+static int
+write_chunk(lua_State *lua, const void *p, size_t sz, void *data)
+{
+	chunk_buf_t *const buf = data;
+
+	char *const new_data = realloc(buf->data, buf->len + sz);
+	if(new_data == NULL)
+	{
+		buf->failed = 1;
+		return 1;
+	}
+
+	memcpy(new_data + buf->len, p, sz);
+	buf->data = new_data;
+	buf->len += sz;
+	return 0;
+}
+
+/* Computes FNV-1a hash of a chunk to detect its corruption.  Returns the
+ * hash. */
+static uint64_t
+hash_chunk(const char chunk[], size_t len)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	size_t i;
+	for(i = 0U; i < len; ++i)
+	{
+		hash ^= (unsigned char)chunk[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+void
+vlua_prune_chunk_cache(void)
+{
+	if(cfg.luac_dir[0] == '\0')
+	{
+		return;
+	}
+
+	int len;
+	char **const names = list_all_files(cfg.luac_dir, &len);
+	if(len < 0)
+	{
+		return;
+	}
+
+	int i;
+	for(i = 0; i < len; ++i)
+	{
+		char *const cache_path = format_str("%s/%s", cfg.luac_dir, names[i]);
+
+		chunk_header_t header;
+		char path[PATH_MAX + 1];
+		FILE *const fp = os_fopen(cache_path, "rb");
+		const int keep = fp != NULL
+		              && read_chunk_header(fp, &header, path) == 0
+		              && strcmp(header.lua_release, LUA_RELEASE) == 0
+		              && path_exists(path, NODEREF);
+		if(fp != NULL)
+		{
+			fclose(fp);
+		}
+
+		/* Drop leftovers of interrupted writes, entries of sources that are gone
+		 * and entries that can't be loaded by this version of Lua. */
+		if(!keep)
+		{
+			(void)unlink(cache_path);
+		}
+
+		free(cache_path);
+	}
+
+	free_string_array(names, len);
+}
+
+/* Forms path to the file that caches compiled version of the source file.
+ * Returns zero on success, otherwise non-zero is returned. */
+TSTATIC int
+get_chunk_cache_path(const char path[], char buf[], size_t buf_len)
+{
+	if(cfg.luac_dir[0] == '\0')
+	{
+		return 1;
+	}
+
+	/* Encode full path of the source file into a name like Vim does for its
+	 * undo files. */
+	char name[NAME_MAX + 1];
+	size_t len = 0U;
+	for(; *path != '\0'; ++path)
+	{
+		if(len + 2U >= sizeof(name))
+		{
+			return 1;
+		}
+		name[len++] = (*path == '/' || *path == '\\' || *path == ':')
+		            ? '%'
+		            : *path;
+	}
+	strcpy(name + len, "c");
+
+	int written = snprintf(buf, buf_len, "%s/%s", cfg.luac_dir, name);
+	return (written < 0 || (size_t)written >= buf_len);
+}
+
 int
 vlua_run_string(vlua_t *vlua, const char str[])
 {
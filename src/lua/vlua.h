@@ -19,6 +19,10 @@
 #ifndef VIFM__LUA__VLUA_H__
 #define VIFM__LUA__VLUA_H__
 
+#include <stddef.h> /* size_t */
+
+#include "../utils/test_helpers.h"
+
 /* This unit implements Lua interface.  It provides API for the rest of the
  * application and thus this is the only header that needs to be included from
  * the outside. */
@@ -119,6 +123,14 @@ void vlua_process_callbacks(struct vlua_t *vlua);
 /* Schedules all handlers for exit event as callbacks to process. */
 void vlua_events_app_exit(struct vlua_t *vlua);
 
+/* Removes compiled chunks whose source files no longer exist or which can't be
+ * used by this version of Lua from the cache. */
+void vlua_prune_chunk_cache(void);
+
+TSTATIC_DEFS(
+	int get_chunk_cache_path(const char path[], char buf[], size_t buf_len);
+)
+
 #endif /* VIFM__LUA__VLUA_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -19,8 +19,9 @@
 
 #include "find_menu.h"
 
+#include <stddef.h> /* size_t */
 #include <stdlib.h> /* free() */
-#include <string.h> /* strdup() */
+#include <string.h> /* strdup() strlen() */
 
 #include "../cfg/config.h"
 #include "../modes/dialogs/msg_dialog.h"
@@ -29,7 +30,13 @@
 #include "../utils/macros.h"
 #include "../utils/path.h"
 #include "../utils/str.h"
+#include "../utils/string_array.h"
+#include "../background.h"
+#include "../builtin_find.h"
+#include "../filelist.h"
+#include "../flist_stream.h"
 #include "../macros.h"
+#include "../running.h"
 #include "menus.h"
 
 #ifdef _WIN32
@@ -38,6 +45,9 @@
 #define DEFAULT_PREDICATE "-name"
 #endif
 
+static int run_builtin_find(view_t *view, int with_path, const char args[],
+		menu_data_t *m, MacroFlags flags);
+static int uses_snapshot(void);
 static int execute_find_cb(view_t *view, menu_data_t *m);
 
 int
@@ -64,6 +74,9 @@ show_find_menu(view_t *view, int with_path, const char args[])
 
 	static menu_data_t m;
 
+	/* Builtin implementation doesn't need targets to be escaped. */
+	const int builtin = menus_uses_builtin(cfg.find_prg);
+
 	if(with_path)
 	{
 		macros[M_s].value = args;
@@ -73,7 +86,7 @@ show_find_menu(view_t *view, int with_path, const char args[])
 	}
 	else
 	{
-		targets = menus_get_targets(view);
+		targets = (builtin ? strdup("") : menus_get_targets(view));
 		if(targets == NULL)
 		{
 			show_error_msg("Find", "Failed to setup target directory.");
@@ -121,6 +134,13 @@ show_find_menu(view_t *view, int with_path, const char args[])
 		ma_flags_set(&flags, MF_VERYCUSTOMVIEW_OUTPUT);
 	}
 
+	if(builtin)
+	{
+		/* Expanded command isn't used, only the flags are. */
+		free(cmd);
+		return run_builtin_find(view, with_path, args, &m, flags);
+	}
+
 	ui_sb_msg("find...");
 	save_msg = menus_capture(view, cmd, /*user_sh=*/0, &m, flags);
 	free(cmd);
@@ -128,6 +148,94 @@ show_find_menu(view_t *view, int with_path, const char args[])
 	return save_msg;
 }
 
+/* Searches using builtin implementation and presents results either as a menu
+ * or as a custom view.  Returns non-zero if status bar message should be
+ * saved. */
+static int
+run_builtin_find(view_t *view, int with_path, const char args[],
+		menu_data_t *m, MacroFlags flags)
+{
+	const char *pattern = args;
+	char **targets = NULL;
+	int ntargets;
+	if(with_path)
+	{
+		/* The first word is the path and the rest is the pattern. */
+		const char *const end = until_first(args, ' ');
+		char *const path = format_str("%.*s", (int)(end - args), args);
+		ntargets = add_to_string_array(&targets, 0, path);
+		free(path);
+		pattern = skip_whitespace(end);
+	}
+	else
+	{
+		ntargets = menus_get_target_list(view, &targets);
+	}
+
+	if(ntargets == 0)
+	{
+		menus_reset_data(m);
+		show_error_msg("Find", "Failed to setup target directory.");
+		return 0;
+	}
+
+	const int snapshot = uses_snapshot();
+	const int custom = ma_flags_present(flags, MF_CUSTOMVIEW_OUTPUT)
+	                || ma_flags_present(flags, MF_VERYCUSTOMVIEW_OUTPUT);
+
+	char *error = NULL;
+	bg_job_t *job = NULL;
+	flist_stream_t *stream = NULL;
+	if(custom)
+	{
+		stream = bfind_stream(view, pattern, targets, ntargets, snapshot, &error);
+	}
+	else
+	{
+		job = bfind_run(pattern, targets, ntargets, flist_get_dir(view), snapshot,
+				&error);
+	}
+	free_string_array(targets, ntargets);
+
+	if(job == NULL && stream == NULL)
+	{
+		menus_reset_data(m);
+		show_error_msg("Find", error == NULL ? "Failed to start search" : error);
+		free(error);
+		return 0;
+	}
+
+	if(custom)
+	{
+		const int very = ma_flags_present(flags, MF_VERYCUSTOMVIEW_OUTPUT);
+		rn_for_flist_stream(view, stream, m->title, very);
+		menus_reset_data(m);
+		return 0;
+	}
+
+	ui_sb_msg("find...");
+	return menus_capture_job(view, job, m);
+}
+
+/* Checks whether 'findprg' allows reusing listing of a directory between
+ * searches.  Returns non-zero if so, otherwise zero is returned. */
+static int
+uses_snapshot(void)
+{
+	const char *word = cfg.find_prg;
+	while(*(word = skip_whitespace(word)) != '\0')
+	{
+		const char *const end = until_first(word, ' ');
+		const size_t len = end - word;
+		if(len == strlen("snapshot") && starts_with_lit(word, "snapshot"))
+		{
+			return 1;
+		}
+		word = end;
+	}
+	return 0;
+}
+
 /* Callback that is called when menu item is selected.  Should return non-zero
  * to stay in menu mode. */
 static int
@@ -29,9 +29,16 @@
 #include "../utils/macros.h"
 #include "../utils/path.h"
 #include "../utils/str.h"
+#include "../utils/string_array.h"
+#include "../background.h"
+#include "../builtin_grep.h"
+#include "../filelist.h"
 #include "../macros.h"
+#include "../running.h"
 #include "menus.h"
 
+static int run_builtin_grep(view_t *view, const char args[], int invert,
+		menu_data_t *m, MacroFlags flags);
 static int execute_grep_cb(view_t *view, menu_data_t *m);
 
 int
@@ -56,7 +63,10 @@ show_grep_menu(view_t *view, const char args[], int invert)
 
 	static menu_data_t m;
 
-	targets = menus_get_targets(view);
+	/* Builtin implementation doesn't need targets to be escaped. */
+	const int builtin = menus_uses_builtin(cfg.grep_prg);
+
+	targets = (builtin ? strdup("") : menus_get_targets(view));
 	if(targets == NULL)
 	{
 		show_error_msg("Grep", "Failed to setup target directory.");
@@ -95,6 +105,13 @@ show_grep_menu(view_t *view, const char args[], int invert)
 		ma_flags_set(&flags, MF_VERYCUSTOMVIEW_OUTPUT);
 	}
 
+	if(builtin)
+	{
+		/* Expanded command isn't used, only the flags are. */
+		free(cmd);
+		return run_builtin_grep(view, args, invert, &m, flags);
+	}
+
 	ui_sb_msg("grep...");
 	save_msg = menus_capture(view, cmd, /*user_sh=*/0, &m, flags);
 	free(cmd);
@@ -102,6 +119,51 @@ show_grep_menu(view_t *view, const char args[], int invert)
 	return save_msg;
 }
 
+/* Searches using builtin implementation and presents results either as a menu
+ * or as a custom view.  Returns non-zero if status bar message should be
+ * saved. */
+static int
+run_builtin_grep(view_t *view, const char args[], int invert, menu_data_t *m,
+		MacroFlags flags)
+{
+	char **targets;
+	const int ntargets = menus_get_target_list(view, &targets);
+	if(ntargets == 0)
+	{
+		menus_reset_data(m);
+		show_error_msg("Grep", "Failed to setup target directory.");
+		return 0;
+	}
+
+	char *error = NULL;
+	bg_job_t *const job = bgrep_run(args, invert, targets, ntargets,
+			flist_get_dir(view), &error);
+	free_string_array(targets, ntargets);
+
+	if(job == NULL)
+	{
+		menus_reset_data(m);
+		show_error_msg("Grep", error == NULL ? "Failed to start search" : error);
+		free(error);
+		return 0;
+	}
+
+	if(ma_flags_present(flags, MF_CUSTOMVIEW_OUTPUT) ||
+			ma_flags_present(flags, MF_VERYCUSTOMVIEW_OUTPUT))
+	{
+		const int very = ma_flags_present(flags, MF_VERYCUSTOMVIEW_OUTPUT);
+		if(rn_for_flist_job(view, job, m->title, very) != 0)
+		{
+			show_error_msg("Grep", "Failed to load results");
+		}
+		menus_reset_data(m);
+		return 0;
+	}
+
+	ui_sb_msg("grep...");
+	return menus_capture_job(view, job, m);
+}
+
 /* Callback that is called when menu item is selected.  Should return non-zero
  * to stay in menu mode. */
 static int
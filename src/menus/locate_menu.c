@@ -19,19 +19,34 @@
 
 #include "locate_menu.h"
 
+#include <unistd.h> /* usleep() */
+
 #include <stdlib.h> /* free() */
-#include <string.h> /* strdup() */
+#include <string.h> /* strdup() strlen() */
 
 #include "../cfg/config.h"
+#include "../compat/fs_limits.h"
+#include "../modes/dialogs/msg_dialog.h"
+#include "../ui/cancellation.h"
 #include "../ui/statusbar.h"
 #include "../ui/ui.h"
 #include "../utils/macros.h"
 #include "../utils/path.h"
 #include "../utils/str.h"
+#include "../utils/string_array.h"
+#include "../background.h"
+#include "../filelist.h"
+#include "../locate_index.h"
 #include "../macros.h"
 #include "../running.h"
 #include "menus.h"
 
+static int run_builtin_locate(view_t *view, const char args[], menu_data_t *m,
+		MacroFlags flags);
+static bg_job_t * start_fuzzy_query(const char pattern[]);
+static char * read_first_line(bg_job_t *job);
+static void first_line_handler(const char line[], void *arg);
+static int get_roots(char ***roots);
 static int execute_locate_cb(view_t *view, menu_data_t *m);
 
 int
@@ -71,6 +86,13 @@ show_locate_menu(view_t *view, const char args[])
 		ma_flags_set(&flags, MF_VERYCUSTOMVIEW_OUTPUT);
 	}
 
+	if(menus_uses_builtin(cfg.locate_prg))
+	{
+		/* Expanded command isn't used, only the flags are. */
+		free(cmd);
+		return run_builtin_locate(view, args, &m, flags);
+	}
+
 	ui_sb_msg("locate...");
 	save_msg = menus_capture(view, cmd, /*user_sh=*/0, &m, flags);
 	free(cmd);
@@ -78,6 +100,233 @@ show_locate_menu(view_t *view, const char args[])
 	return save_msg;
 }
 
+/* Queries index maintained by vifm and presents results either as a menu or as
+ * a custom view.  Returns non-zero if status bar message should be saved. */
+static int
+run_builtin_locate(view_t *view, const char args[], menu_data_t *m,
+		MacroFlags flags)
+{
+	char **roots;
+	const int nroots = get_roots(&roots);
+	if(nroots == 0)
+	{
+		menus_reset_data(m);
+		show_error_msg("Locate", "Failed to determine what to index.");
+		return 0;
+	}
+
+	char *error = NULL;
+	bg_job_t *const job = locidx_query(roots, nroots, args, &error);
+	free_string_array(roots, nroots);
+
+	if(job == NULL)
+	{
+		menus_reset_data(m);
+		show_error_msg("Locate", error == NULL ? "Failed to start search" : error);
+		free(error);
+		return 0;
+	}
+
+	if(ma_flags_present(flags, MF_CUSTOMVIEW_OUTPUT) ||
+			ma_flags_present(flags, MF_VERYCUSTOMVIEW_OUTPUT))
+	{
+		const int very = ma_flags_present(flags, MF_VERYCUSTOMVIEW_OUTPUT);
+		if(rn_for_flist_job(view, job, m->title, very) != 0)
+		{
+			show_error_msg("Locate", "Failed to load results");
+		}
+		menus_reset_data(m);
+		return 0;
+	}
+
+	ui_sb_msg("locate...");
+	return menus_capture_job(view, job, m);
+}
+
+int
+show_jump_menu(view_t *view, const char pattern[])
+{
+	static menu_data_t m;
+	menus_init_data(&m, view, format_str("Jump %s", pattern),
+			strdup("No files found"));
+
+	m.stashable = 1;
+	m.execute_handler = &execute_locate_cb;
+	m.key_handler = &menus_def_khandler;
+
+	bg_job_t *const job = start_fuzzy_query(pattern);
+	if(job == NULL)
+	{
+		menus_reset_data(&m);
+		return 0;
+	}
+
+	ui_sb_msg("jump...");
+	return menus_capture_job(view, job, &m);
+}
+
+int
+jump_to_best_match(view_t *view, const char pattern[])
+{
+	bg_job_t *const job = start_fuzzy_query(pattern);
+	if(job == NULL)
+	{
+		return 0;
+	}
+
+	ui_sb_msg("jump...");
+	char *const path = read_first_line(job);
+	if(path == NULL)
+	{
+		ui_sb_err("No files found");
+		return 1;
+	}
+
+	char *const dir = strdup(path);
+	if(dir != NULL)
+	{
+		remove_last_path_component(dir);
+		navigate_to_file(view, dir, get_last_path_component(path), 0);
+		ui_sb_clear();
+	}
+	free(dir);
+	free(path);
+	return 0;
+}
+
+/* Starts fuzzy search in the index maintained by vifm.  Returns the job or NULL
+ * on error, which is reported to the user. */
+static bg_job_t *
+start_fuzzy_query(const char pattern[])
+{
+	char **roots;
+	const int nroots = get_roots(&roots);
+	if(nroots == 0)
+	{
+		show_error_msg("Jump", "Failed to determine what to index.");
+		return NULL;
+	}
+
+	char *error = NULL;
+	bg_job_t *const job = locidx_fuzzy_query(roots, nroots, pattern, &error);
+	free_string_array(roots, nroots);
+
+	if(job == NULL)
+	{
+		show_error_msg("Jump", error == NULL ? "Failed to start search" : error);
+		free(error);
+	}
+	return job;
+}
+
+/* Waits for the job to print the first line of its output and stops the job.
+ * Waiting can be cancelled by the user.  Returns newly allocated line or NULL
+ * if there is none. */
+static char *
+read_first_line(bg_job_t *job)
+{
+	enum { POLL_PERIOD_MS = 10 };
+
+	char *line = NULL;
+	line_splitter_t splitter = {};
+
+	ui_cancellation_push_on();
+	while(line == NULL && !ui_cancellation_requested())
+	{
+		char buf[1024];
+		const int len = bg_job_read_output(job, buf, sizeof(buf));
+		if(len == 0)
+		{
+			usleep(POLL_PERIOD_MS*1000);
+			continue;
+		}
+
+		split_lines(&splitter, buf, len < 0 ? 0U : (size_t)len, len < 0,
+				&first_line_handler, &line);
+		if(len < 0)
+		{
+			break;
+		}
+	}
+	const int cancelled = ui_cancellation_requested();
+	ui_cancellation_pop();
+
+	split_lines_reset(&splitter);
+
+	if(bg_job_is_running(job))
+	{
+		(void)bg_job_cancel(job);
+	}
+	/* Closing output stream makes writing to it fail in the job. */
+	if(job->output != NULL)
+	{
+		fclose(job->output);
+		job->output = NULL;
+	}
+	bg_job_decref(job);
+
+	if(cancelled)
+	{
+		free(line);
+		return NULL;
+	}
+	return line;
+}
+
+/* Remembers the first non-empty line in *arg. */
+static void
+first_line_handler(const char line[], void *arg)
+{
+	char **const first = arg;
+	if(*first == NULL && line[0] != '\0')
+	{
+		*first = strdup(line);
+	}
+}
+
+/* Lists roots of the index, which are words of 'locateprg' after "builtin"
+ * that aren't macros or home directory if there are none or external program is
+ * used.  Returns number of roots, which is zero on error. */
+static int
+get_roots(char ***roots)
+{
+	*roots = NULL;
+	int nroots = 0;
+
+	const char *word = "";
+	if(menus_uses_builtin(cfg.locate_prg))
+	{
+		word = skip_whitespace(cfg.locate_prg) + strlen("builtin");
+	}
+	while(*(word = skip_whitespace(word)) != '\0')
+	{
+		const char *const end = until_first(word, ' ');
+		if(word[0] != '%')
+		{
+			char *const raw = format_str("%.*s", (int)(end - word), word);
+			char *const expanded = (raw == NULL ? NULL : expand_tilde(raw));
+			if(expanded != NULL)
+			{
+				char root[PATH_MAX + 1];
+				to_canonic_path(expanded, cfg.home_dir, root, sizeof(root));
+				nroots = add_to_string_array(roots, nroots, root);
+			}
+			free(expanded);
+			free(raw);
+		}
+		word = end;
+	}
+
+	if(nroots == 0)
+	{
+		char root[PATH_MAX + 1];
+		to_canonic_path(cfg.home_dir, "/", root, sizeof(root));
+		nroots = add_to_string_array(roots, nroots, root);
+	}
+
+	return nroots;
+}
+
 /* Callback that is called when menu item is selected.  Should return non-zero
  * to stay in menu mode. */
 static int
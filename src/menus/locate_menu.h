@@ -25,6 +25,15 @@ struct view_t;
 /* Returns non-zero if status bar message should be saved. */
 int show_locate_menu(struct view_t *view, const char args[]);
 
+/* Displays files of the index maintained by vifm that fuzzily match the
+ * pattern, best matches first.  Returns non-zero if status bar message should
+ * be saved. */
+int show_jump_menu(struct view_t *view, const char pattern[]);
+
+/* Navigates to the file of the index maintained by vifm that matches the
+ * pattern best.  Returns non-zero if status bar message should be saved. */
+int jump_to_best_match(struct view_t *view, const char pattern[]);
+
 #endif /* VIFM__MENUS__LOCATE_MENU_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -20,6 +20,7 @@
 #include "menus.h"
 
 #include <curses.h>
+#include <unistd.h> /* usleep() */
 
 #include <assert.h> /* assert() */
 #include <stddef.h> /* NULL size_t */
@@ -32,6 +33,7 @@
 #include "../cfg/config.h"
 #include "../compat/fs_limits.h"
 #include "../compat/os.h"
+#include "../compat/pthread.h"
 #include "../compat/reallocarray.h"
 #include "../engine/mode.h"
 #include "../int/term_title.h"
@@ -64,6 +66,45 @@
 #include "../search.h"
 #include "../status.h"
 
+/* Settings of parallel matching of menu items. */
+enum
+{
+	MATCH_WORKERS = 4,     /* Maximum number of threads that match items. */
+	MATCH_CHUNK = 16*1024, /* Minimal number of items matched by a thread. */
+};
+
+/* Search match of a menu item. */
+typedef struct
+{
+	int item;  /* Index of the item. */
+	int start; /* Start position of the match in escaped item. */
+	int end;   /* End position of the match in escaped item. */
+}
+menu_match_t;
+
+/* List of search matches ordered by index of their items. */
+typedef struct
+{
+	menu_match_t *items; /* Matches. */
+	int count;           /* Number of matches. */
+	int capacity;        /* Number of allocated elements. */
+}
+match_list_t;
+
+/* Part of items matched by a single thread. */
+typedef struct
+{
+	const menu_data_t *m;     /* Menu whose items are being matched. */
+	const regex_t *re;        /* Compiled pattern or NULL to compile it. */
+	const char *regexp;       /* Pattern to match items against. */
+	int cflags;               /* Flags to compile the pattern with. */
+	const menu_match_t *prev; /* Matches to recheck or NULL to check items. */
+	int from;                 /* Start of the range of items or prev. */
+	int to;                   /* End of the range (exclusive). */
+	match_list_t found;       /* Matches found in the range. */
+}
+match_job_t;
+
 static void reset_menu_state(menu_state_t *ms);
 static void show_position_in_menu(const menu_data_t *m);
 static void open_selected_file(const char path[], int line_num);
@@ -80,11 +121,22 @@ static void init_menu_state(menu_state_t *ms, view_t *view);
 static const char * get_relative_path_base(const menu_data_t *m,
 		const view_t *view);
 static int menu_and_view_are_in_sync(const menu_data_t *m, const view_t *view);
-static int search_menu(menu_state_t *ms, int start_pos, int print_errors);
+static void finish_loading(menu_state_t *ms);
+static int search_menu(menu_state_t *ms, int narrowing, int print_errors);
+static void update_matches(menu_state_t *ms, int from);
+static void find_matches(const menu_data_t *m, const regex_t *re,
+		const char regexp[], int cflags, const menu_match_t prev[], int from,
+		int to, match_list_t *list);
+static void * match_thread(void *arg);
+static void match_range(match_job_t *job);
+static void append_matches(match_list_t *list, const match_list_t *tail);
+static menu_match_t * add_match(match_list_t *list);
 static int search_menu_forwards(menu_state_t *m, int start_pos);
 static int search_menu_backwards(menu_state_t *m, int start_pos);
 static int navigate_to_match(menu_state_t *m, int pos);
 static int get_match_index(const menu_state_t *m);
+static const menu_match_t * find_match(const menu_state_t *ms, int item);
+static int first_match_from(const menu_state_t *ms, int item);
 
 struct menu_state_t
 {
@@ -92,18 +144,24 @@ struct menu_state_t
 	int current; /* Cursor position on the menu_win. */
 	int win_rows;
 	int backward_search; /* Search direction. */
-	/* Number of menu entries that actually match the regexp. */
-	int matching_entries;
 	/* Whether search highlight matches are currently highlighted. */
 	int search_highlight;
-	/* Start and end positions of search match.  If there is no match, values are
-	 * equal to -1. */
-	short int (*matches)[2];
+	/* Menu entries that match the regexp.  Shared by navigation and drawing. */
+	match_list_t matches;
+	/* Whether search was performed and matches correspond to the regexp. */
+	int searched;
 	char *regexp;
+	/* Flags with which the regexp was compiled to find the matches. */
+	int regexp_cflags;
 	/* Number of times to repeat search. */
 	int search_repeat;
 	/* View associated with the menu (e.g. to navigate to a file in it). */
 	view_t *view;
+
+	/* Job that is still producing items of the menu or NULL. */
+	bg_job_t *job;
+	/* Splits output of the job into items. */
+	line_splitter_t splitter;
 }
 menu_state;
 
@@ -129,14 +187,17 @@ menus_remove_current(menu_state_t *ms)
 				sizeof(*m->void_data)*((m->len - 1) - m->pos));
 	}
 
-	if(ms->matches != NULL)
+	match_list_t *const matches = &ms->matches;
+	int i = first_match_from(ms, m->pos);
+	if(i < matches->count && matches->items[i].item == m->pos)
 	{
-		if(ms->matches[m->pos][0] >= 0)
-		{
-			--ms->matching_entries;
-		}
-		memmove(ms->matches + m->pos, ms->matches + m->pos + 1,
-				sizeof(*ms->matches)*((m->len - 1) - m->pos));
+		--matches->count;
+		memmove(matches->items + i, matches->items + i + 1,
+				sizeof(*matches->items)*(matches->count - i));
+	}
+	for(; i < matches->count; ++i)
+	{
+		--matches->items[i].item;
 	}
 
 	--m->len;
@@ -159,6 +220,8 @@ menus_init_data(menu_data_t *m, view_t *view, char title[], char empty_msg[])
 		menus_reset_data(m);
 	}
 
+	menus_stop_loading(&menu_state);
+
 	if(menu_state.d != NULL)
 	{
 		menu_state.d->state = NULL;
@@ -192,6 +255,12 @@ menus_reset_data(menu_data_t *m)
 		return;
 	}
 
+	/* Do this before the menu is stashed to not leave it partially updated. */
+	if(m->state != NULL)
+	{
+		menus_stop_loading(m->state);
+	}
+
 	/* On releasing of non-empty stashable menu, but not the stash. */
 	if(m->stashable && m->len > 0 && m != &menu_data_stash)
 	{
@@ -235,8 +304,9 @@ reset_menu_state(menu_state_t *ms)
 	}
 
 	update_string(&ms->regexp, NULL);
-	free(ms->matches);
-	ms->matches = NULL;
+	free(ms->matches.items);
+	ms->matches = (match_list_t){};
+	ms->searched = 0;
 
 	if(menu_state.d != NULL)
 	{
@@ -461,11 +531,11 @@ draw_menu_item(menu_state_t *ms, int pos, int line, int clear)
 	int off;
 	char *item_tail;
 	const int width = (curr_stats.load_stage == 0) ? 100 : getmaxx(menu_win) - 2;
+	const menu_match_t *const match = find_match(ms, pos);
 
 	/* Calculate color for the line. */
 	col_attr_t col = cfg.cs.color[WIN_COLOR];
-	if(cfg.hl_search && ms->search_highlight &&
-			ms->matches != NULL && ms->matches[pos][0] >= 0)
+	if(cfg.hl_search && ms->search_highlight && match != NULL)
 	{
 		cs_mix_colors(&col, &cfg.cs.color[SELECTED_COLOR]);
 	}
@@ -514,11 +584,11 @@ draw_menu_item(menu_state_t *ms, int pos, int line, int clear)
 	checked_wmove(menu_win, line, 2);
 	wprint(menu_win, item_tail);
 
-	if(ms->search_highlight && ms->matches != NULL && ms->matches[pos][0] >= 0)
+	if(ms->search_highlight && match != NULL)
 	{
 		const cchar_t cch = cs_color_to_cchar(&col, color_pair);
-		draw_search_match(item_tail, ms->matches[pos][0] - off,
-				ms->matches[pos][1] - off, line, width, &cch);
+		draw_search_match(item_tail, match->start - off, match->end - off, line,
+				width, &cch);
 	}
 
 	free(escaped);
@@ -597,7 +667,11 @@ draw_menu_frame(const menu_state_t *m)
 	                         ? ""
 	                         : replace_home_part(m->d->cwd);
 	const char *const at = (suffix[0] == '\0' ? "" : " @ ");
-	char *const title = format_str("%s%s%s", m->d->title, at, suffix);
+	char *const running = (m->job == NULL)
+	                    ? strdup("")
+	                    : format_str(" (running: %d)", m->d->len);
+	char *const title = format_str("%s%s%s%s", m->d->title, running, at, suffix);
+	free(running);
 	char *const ellipsed = right_ellipsis(title, title_len, curr_stats.ellipsis);
 	free(title);
 
@@ -614,7 +688,7 @@ draw_menu_frame(const menu_state_t *m)
 	free(ellipsed);
 }
 
-/* Implements process_cmd_output() callback that loads lines to a menu. */
+/* Appends the line to items of the menu expanding tabulation characters. */
 static void
 output_handler(const char line[], void *arg)
 {
@@ -695,10 +769,11 @@ init_menu_state(menu_state_t *ms, view_t *view)
 	ms->current = 1;
 	ms->win_rows = getmaxy(menu_win);
 	ms->backward_search = 0;
-	ms->matching_entries = 0;
 	ms->search_highlight = 1;
-	ms->matches = NULL;
+	ms->matches = (match_list_t){};
+	ms->searched = 0;
 	ms->regexp = NULL;
+	ms->regexp_cflags = 0;
 	ms->search_repeat = 0;
 	ms->view = view;
 }
@@ -720,6 +795,38 @@ menus_get_targets(view_t *view)
 	return (vifm_chdir(flist_get_dir(view)) == 0) ? strdup(".") : NULL;
 }
 
+int
+menus_get_target_list(view_t *view, char ***targets)
+{
+	*targets = NULL;
+	int ntargets = 0;
+
+	if(view->selected_files > 0 ||
+			(view->pending_marking && flist_count_marked(view) > 0))
+	{
+		flist_set_marking(view, 0);
+
+		dir_entry_t *entry = NULL;
+		while(iter_marked_entries(view, &entry))
+		{
+			char path[PATH_MAX + 1];
+			get_short_path_of(view, entry, NF_NONE, 0, sizeof(path), path);
+			ntargets = add_to_string_array(targets, ntargets, path);
+		}
+		return ntargets;
+	}
+
+	return add_to_string_array(targets, ntargets, ".");
+}
+
+int
+menus_uses_builtin(const char prg[])
+{
+	prg = skip_whitespace(prg);
+	return starts_with_lit(prg, "builtin")
+	    && (prg[7] == '\0' || prg[7] == ' ' || prg[7] == '\t');
+}
+
 int
 menus_unstash(view_t *view)
 {
@@ -869,27 +976,168 @@ menus_capture(view_t *view, const char cmd[], int user_sh, menu_data_t *m,
 		return 0;
 	}
 
-	FILE *input_tmp = make_in_file(view, flags);
+	BgJobFlags bg_flags = BJF_CAPTURE_OUT | BJF_POSIX_SHELL;
+	if(user_sh)
+	{
+		bg_flags |= BJF_USER_SHELL;
+	}
+
+	LOG_INFO_MSG("Capturing output of the command: %s", cmd);
+
+	/* List of files is passed via a file to not block on writing it while the
+	 * command waits for its output to be read. */
+	FILE *const input_tmp = make_in_file(view, flags);
+	bg_job_t *job = bg_run_external_job_in(cmd, bg_flags, input_tmp);
+	if(input_tmp != NULL)
+	{
+		fclose(input_tmp);
+	}
 
-	if(process_cmd_output("Loading menu", cmd, input_tmp, user_sh, 0,
-				&output_handler, m) != 0)
+	if(job == NULL || job->output == NULL)
 	{
+		if(job != NULL)
+		{
+			bg_job_cancel(job);
+			bg_job_decref(job);
+		}
 		show_error_msgf("Trouble running command", "Unable to run: %s", cmd);
 		return 0;
 	}
 
-	if(input_tmp != NULL)
+	return menus_capture_job(view, job, m);
+}
+
+int
+menus_capture_job(view_t *view, bg_job_t *job, menu_data_t *m)
+{
+	/* Time to wait for the job to finish before displaying the menu and period
+	 * of checking for its output. */
+	enum { LOADING_DELAY_MS = 250, POLL_PERIOD_MS = 10 };
+
+	/* Errors are reported by background unit while the menu is active. */
+	job->skip_errors = 0;
+
+	menu_state_t *const ms = m->state;
+	ms->job = job;
+
+	/* Jobs that finish quickly produce complete menu at once, others get
+	 * some time to produce the first screen of items and continue populating
+	 * the menu in background after it's displayed. */
+	const long long deadline = time_in_ms() + LOADING_DELAY_MS;
+
+	ui_cancellation_push_on();
+	while(ms->job != NULL && !ui_cancellation_requested())
 	{
-		fclose(input_tmp);
+		if(m->len > 0 && time_in_ms() >= deadline)
+		{
+			break;
+		}
+
+		if(!menus_pull_items(ms))
+		{
+			usleep(POLL_PERIOD_MS*1000);
+		}
 	}
+	const int cancelled = ui_cancellation_requested();
+	ui_cancellation_pop();
 
-	if(ui_cancellation_requested())
+	if(cancelled)
 	{
-		append_to_string(&m->title, "(cancelled)");
+		menus_stop_loading(ms);
 		append_to_string(&m->empty_msg, " (cancelled)");
 	}
 
-	return menus_enter(m->state, view);
+	return menus_enter(ms, view);
+}
+
+int
+menus_is_loading(const menu_state_t *ms)
+{
+	return (ms->job != NULL);
+}
+
+int
+menus_pull_items(menu_state_t *ms)
+{
+	/* Limits amount of work performed per call to keep UI responsive. */
+	enum { MAX_READS = 64 };
+
+	if(ms->job == NULL)
+	{
+		return 0;
+	}
+
+	const int old_len = ms->d->len;
+	int eof = 0;
+
+	int i;
+	for(i = 0; i < MAX_READS; ++i)
+	{
+		char piece[16*1024];
+		const int len = bg_job_read_output(ms->job, piece, sizeof(piece));
+		if(len == 0)
+		{
+			break;
+		}
+		if(len < 0)
+		{
+			eof = 1;
+			break;
+		}
+
+		split_lines(&ms->splitter, piece, len, /*final=*/0, &output_handler,
+				ms->d);
+	}
+
+	if(eof)
+	{
+		split_lines(&ms->splitter, "", 0U, /*final=*/1, &output_handler, ms->d);
+		finish_loading(ms);
+	}
+
+	if(ms->d->len != old_len)
+	{
+		update_matches(ms, old_len);
+	}
+
+	return (eof || ms->d->len != old_len);
+}
+
+void
+menus_stop_loading(menu_state_t *ms)
+{
+	if(ms->job == NULL)
+	{
+		return;
+	}
+
+	if(bg_job_is_running(ms->job))
+	{
+		(void)bg_job_cancel(ms->job);
+	}
+
+	if(ms->d != NULL)
+	{
+		append_to_string(&ms->d->title, "(cancelled)");
+	}
+
+	finish_loading(ms);
+}
+
+/* Releases resources associated with populating the menu. */
+static void
+finish_loading(menu_state_t *ms)
+{
+	/* Closing output stream makes writing to it fail in the job. */
+	if(ms->job->output != NULL)
+	{
+		fclose(ms->job->output);
+		ms->job->output = NULL;
+	}
+	bg_job_decref(ms->job);
+	ms->job = NULL;
+
+	split_lines_reset(&ms->splitter);
 }
 
 void
@@ -906,9 +1154,9 @@ menus_search_repeat(menu_state_t *m, int backward)
 	(void)menus_search(NULL, m->d, 1);
 	ui_refresh_win(menu_win);
 
-	if(m->matching_entries > 0)
+	if(m->matches.count > 0)
 	{
-		ui_sb_msgf("(%d of %d) %c%s", get_match_index(m), m->matching_entries,
+		ui_sb_msgf("(%d of %d) %c%s", get_match_index(m), m->matches.count,
 				backward ? '?' : '/', m->regexp);
 	}
 
@@ -919,12 +1167,20 @@ int
 menus_search(const char pattern[], menu_data_t *m, int print_errors)
 {
 	menu_state_t *const ms = m->state;
-	const int do_search = (pattern != NULL || ms->matches == NULL);
+	const int do_search = (pattern != NULL || !ms->searched);
+	int narrowing = 0;
 	int save = 0;
 	int i;
 
 	if(pattern != NULL)
 	{
+		/* Items that didn't match previous pattern can't match a narrower one, so
+		 * only current matches need to be rechecked, which speeds up incremental
+		 * search. */
+		narrowing = ms->searched
+		         && ms->regexp != NULL
+		         && regexp_narrows(ms->regexp, ms->regexp_cflags, pattern,
+		                           get_regexp_cflags(pattern));
 		replace_string(&ms->regexp, pattern);
 	}
 
@@ -932,7 +1188,7 @@ menus_search(const char pattern[], menu_data_t *m, int print_errors)
 	{
 		/* Reactivate match highlighting on search. */
 		ms->search_highlight = 1;
-		if(search_menu(ms, m->pos, print_errors) != 0)
+		if(search_menu(ms, narrowing, print_errors) != 0)
 		{
 			menus_partial_redraw(ms);
 			menus_set_pos(ms, m->pos);
@@ -955,27 +1211,23 @@ menus_search(const char pattern[], menu_data_t *m, int print_errors)
 	return save;
 }
 
-/* Goes through all menu items and marks those that match search pattern.
- * Returns non-zero on error. */
+/* Goes through menu items (or only current matches if narrowing) and collects
+ * those that match search pattern.  Returns non-zero on error. */
 static int
-search_menu(menu_state_t *ms, int start_pos, int print_errors)
+search_menu(menu_state_t *ms, int narrowing, int print_errors)
 {
 	menu_data_t *const m = ms->d;
 	int cflags;
 	regex_t re;
 	int err;
-	int i;
-
-	if(ms->matches == NULL)
-	{
-		ms->matches = reallocarray(NULL, m->len, sizeof(*ms->matches));
-	}
 
-	memset(ms->matches, -1, 2*sizeof(**ms->matches)*m->len);
-	ms->matching_entries = 0;
+	match_list_t prev = ms->matches;
+	ms->matches = (match_list_t){};
+	ms->searched = 1;
 
 	if(ms->regexp[0] == '\0')
 	{
+		free(prev.items);
 		return 0;
 	}
 
@@ -988,53 +1240,202 @@ search_menu(menu_state_t *ms, int start_pos, int print_errors)
 			ui_sb_errf("Regexp error: %s", get_regexp_error(err, &re));
 		}
 		regfree(&re);
+		free(prev.items);
 		return -1;
 	}
 
-	for(i = 0; i < m->len; ++i)
+	if(narrowing)
 	{
-		regmatch_t matches[1];
-		const char *item = m->items[i];
-		if(regexec(&re, item, 1, matches, 0) == 0)
-		{
-			ms->matches[i][0] = matches[0].rm_so
-			                  + escape_unreadableo(item, matches[0].rm_so);
-			ms->matches[i][1] = matches[0].rm_eo
-			                  + escape_unreadableo(item, matches[0].rm_eo);
-
-			++ms->matching_entries;
-		}
+		find_matches(m, &re, ms->regexp, cflags, prev.items, 0, prev.count,
+				&ms->matches);
 	}
+	else
+	{
+		find_matches(m, &re, ms->regexp, cflags, NULL, 0, m->len, &ms->matches);
+	}
+	ms->regexp_cflags = cflags;
+
 	regfree(&re);
+	free(prev.items);
 	return 0;
 }
 
-/* Looks for next matching element in forward direction from current position.
- * Returns new value for save_msg flag. */
-static int
-search_menu_forwards(menu_state_t *m, int start_pos)
+/* Extends search results with items starting at the specified index, which
+ * were added to the menu after the search. */
+static void
+update_matches(menu_state_t *ms, int from)
 {
-	int match_up = -1;
-	int match_down = -1;
+	menu_data_t *const m = ms->d;
+
+	if(!ms->searched || is_null_or_empty(ms->regexp))
+	{
+		return;
+	}
+
+	regex_t re;
+	if(regexp_compile(&re, ms->regexp, ms->regexp_cflags) == 0)
+	{
+		find_matches(m, &re, ms->regexp, ms->regexp_cflags, NULL, from, m->len,
+				&ms->matches);
+	}
+	regfree(&re);
+}
+
+/* Appends matches of the regular expression among items in the range (or among
+ * items of the range of previous matches if prev isn't NULL) to the list.
+ * Large ranges are split among several threads, each of which compiles its own
+ * copy of the pattern as regexec() might serialize calls on a shared one. */
+static void
+find_matches(const menu_data_t *m, const regex_t *re, const char regexp[],
+		int cflags, const menu_match_t prev[], int from, int to,
+		match_list_t *list)
+{
+	const int njobs = MAX(1, MIN(MATCH_WORKERS, (to - from)/MATCH_CHUNK));
+	match_job_t jobs[njobs];
+	pthread_t threads[njobs];
+	int started[njobs];
+
 	int i;
+	for(i = 0; i < njobs; ++i)
+	{
+		jobs[i] = (match_job_t) {
+			.m = m,
+			.re = (i == 0 ? re : NULL),
+			.regexp = regexp,
+			.cflags = cflags,
+			.prev = prev,
+			.from = from + (long long)(to - from)*i/njobs,
+			.to = from + (long long)(to - from)*(i + 1)/njobs,
+		};
+	}
 
-	for(i = 0; i < m->d->len; ++i)
+	/* The first part is processed by this thread. */
+	started[0] = 0;
+	for(i = 1; i < njobs; ++i)
+	{
+		started[i] = (pthread_create(&threads[i], NULL, &match_thread,
+					&jobs[i]) == 0);
+	}
+
+	for(i = 0; i < njobs; ++i)
+	{
+		if(started[i])
+		{
+			(void)pthread_join(threads[i], NULL);
+		}
+		else
+		{
+			match_range(&jobs[i]);
+		}
+
+		append_matches(list, &jobs[i].found);
+		free(jobs[i].found.items);
+	}
+}
+
+/* Entry point of a thread that matches part of menu items.  Returns NULL. */
+static void *
+match_thread(void *arg)
+{
+	block_all_thread_signals();
+	match_range(arg);
+	return NULL;
+}
+
+/* Collects matches of items in the range of the job. */
+static void
+match_range(match_job_t *job)
+{
+	regex_t own_re;
+	const regex_t *re = job->re;
+	if(re == NULL)
 	{
-		if(m->matches[i][0] < 0)
+		if(regexp_compile(&own_re, job->regexp, job->cflags) != 0)
+		{
+			regfree(&own_re);
+			return;
+		}
+		re = &own_re;
+	}
+
+	int i;
+	for(i = job->from; i < job->to; ++i)
+	{
+		const int item = (job->prev == NULL ? i : job->prev[i].item);
+		const char *text = job->m->items[item];
+
+		regmatch_t match;
+		if(regexec(re, text, 1, &match, 0) != 0)
 		{
 			continue;
 		}
 
-		if(match_up < 0 && i < start_pos)
+		menu_match_t *const found = add_match(&job->found);
+		if(found == NULL)
+		{
+			break;
+		}
+
+		found->item = item;
+		found->start = match.rm_so + escape_unreadableo(text, match.rm_so);
+		found->end = match.rm_eo + escape_unreadableo(text, match.rm_eo);
+	}
+
+	if(re == &own_re)
+	{
+		regfree(&own_re);
+	}
+}
+
+/* Appends all elements of the tail to the list. */
+static void
+append_matches(match_list_t *list, const match_list_t *tail)
+{
+	int i;
+	for(i = 0; i < tail->count; ++i)
+	{
+		menu_match_t *const match = add_match(list);
+		if(match == NULL)
 		{
-			match_up = i;
+			break;
 		}
-		if(match_down < 0 && i >= start_pos)
+		*match = tail->items[i];
+	}
+}
+
+/* Adds an element to the end of the list.  Returns pointer to it or NULL on
+ * memory allocation error. */
+static menu_match_t *
+add_match(match_list_t *list)
+{
+	if(list->count == list->capacity)
+	{
+		const int capacity = (list->capacity == 0 ? 64 : list->capacity*2);
+		menu_match_t *const items = reallocarray(list->items, capacity,
+				sizeof(*items));
+		if(items == NULL)
 		{
-			match_down = i;
+			return NULL;
 		}
+
+		list->items = items;
+		list->capacity = capacity;
 	}
 
+	return &list->items[list->count++];
+}
+
+/* Looks for next matching element in forward direction from current position.
+ * Returns new value for save_msg flag. */
+static int
+search_menu_forwards(menu_state_t *m, int start_pos)
+{
+	const match_list_t *const matches = &m->matches;
+	const int i = first_match_from(m, start_pos);
+
+	const int match_down = (i < matches->count ? matches->items[i].item : -1);
+	const int match_up = (i > 0 ? matches->items[0].item : -1);
+
 	if(!cfg.wrap_scan && match_down <= -1)
 	{
 		ui_sb_errf("Search hit BOTTOM without match for: %s", m->regexp);
@@ -1049,26 +1450,13 @@ search_menu_forwards(menu_state_t *m, int start_pos)
 static int
 search_menu_backwards(menu_state_t *m, int start_pos)
 {
-	int match_up = -1;
-	int match_down = -1;
-	int i;
-
-	for(i = m->d->len - 1; i > -1; --i)
-	{
-		if(m->matches[i][0] < 0)
-		{
-			continue;
-		}
+	const match_list_t *const matches = &m->matches;
+	const int i = first_match_from(m, start_pos + 1);
 
-		if(match_up < 0 && i <= start_pos)
-		{
-			match_up = i;
-		}
-		if(match_down < 0 && i > start_pos)
-		{
-			match_down = i;
-		}
-	}
+	const int match_up = (i > 0 ? matches->items[i - 1].item : -1);
+	const int match_down = (i < matches->count
+	                     ? matches->items[matches->count - 1].item
+	                     : -1);
 
 	if(!cfg.wrap_scan && match_up <= -1)
 	{
@@ -1138,10 +1526,10 @@ menus_search_print_msg(const menu_data_t *m)
 
 	regfree(&re);
 
-	if(ms->matching_entries > 0)
+	if(ms->matches.count > 0)
 	{
-		ui_sb_msgf("%d of %d %s", get_match_index(ms), ms->matching_entries,
-				(ms->matching_entries == 1) ? "match" : "matches");
+		ui_sb_msgf("%d of %d %s", get_match_index(ms), ms->matches.count,
+				(ms->matches.count == 1) ? "match" : "matches");
 	}
 	else
 	{
@@ -1154,19 +1542,42 @@ menus_search_print_msg(const menu_data_t *m)
 static int
 get_match_index(const menu_state_t *m)
 {
-	int n, i;
+	return first_match_from(m, m->d->pos + 1);
+}
+
+/* Finds search match of the item.  Returns pointer to it or NULL. */
+static const menu_match_t *
+find_match(const menu_state_t *ms, int item)
+{
+	const int i = first_match_from(ms, item);
+	if(i < ms->matches.count && ms->matches.items[i].item == item)
+	{
+		return &ms->matches.items[i];
+	}
+	return NULL;
+}
 
-	n = (m->matches[0][0] >= 0 ? 1 : 0);
-	i = 0;
-	while(i++ < m->d->pos)
+/* Finds the first search match of an item that isn't located before the
+ * specified one.  Returns its index in the list of matches, which is equal to
+ * number of matches if there is no such match. */
+static int
+first_match_from(const menu_state_t *ms, int item)
+{
+	int l = 0;
+	int u = ms->matches.count;
+	while(l < u)
 	{
-		if(m->matches[i][0] >= 0)
+		const int i = l + (u - l)/2;
+		if(ms->matches.items[i].item < item)
 		{
-			++n;
+			l = i + 1;
+		}
+		else
+		{
+			u = i;
 		}
 	}
-
-	return n;
+	return l;
 }
 
 void
@@ -1179,7 +1590,7 @@ menus_search_reset_hilight(menu_state_t *m)
 int
 menus_search_matched(menu_state_t *m)
 {
-	return m->matching_entries;
+	return m->matches.count;
 }
 
 void
@@ -1193,10 +1604,15 @@ menus_search_reset(menu_state_t *m, int backward, int new_repeat_count)
 void
 menus_replace_data(menu_data_t *m)
 {
+	if(menu_state.d != m)
+	{
+		menus_stop_loading(&menu_state);
+	}
+
 	menu_state.current = 1;
-	menu_state.matching_entries = 0;
-	free(menu_state.matches);
-	menu_state.matches = NULL;
+	free(menu_state.matches.items);
+	menu_state.matches = (match_list_t){};
+	menu_state.searched = 0;
 
 	if(menu_state.d != NULL)
 	{
@@ -119,6 +119,27 @@ int menus_to_custom_view(menu_state_t *m, struct view_t *view, int very);
 int menus_capture(struct view_t *view, const char cmd[], int user_sh,
 		menu_data_t *m, MacroFlags flags);
 
+struct bg_job_t;
+
+/* Makes a menu out of output of the job, which is taken over.  Returns
+ * non-zero if status bar message should be saved. */
+int menus_capture_job(struct view_t *view, struct bg_job_t *job,
+		menu_data_t *m);
+
+/* Menu loading. */
+
+/* Checks whether items of the menu are still being produced by a command.
+ * Returns non-zero if so, otherwise zero is returned. */
+int menus_is_loading(const menu_state_t *ms);
+
+/* Adds items that were produced by a command since the last call.  Returns
+ * non-zero if the menu has changed, otherwise zero is returned. */
+int menus_pull_items(menu_state_t *ms);
+
+/* Stops the command that produces items of the menu keeping items that were
+ * loaded so far. */
+void menus_stop_loading(menu_state_t *ms);
+
 /* Menu drawing. */
 
 /* Erases current menu item in menu window. */
@@ -180,6 +201,16 @@ int menus_search_matched(menu_state_t *m);
  * returned. */
 char * menus_get_targets(struct view_t *view);
 
+/* Lists marked files or current directory as paths relative to the current
+ * directory of the view.  Returns number of targets, which is zero on
+ * error. */
+int menus_get_target_list(struct view_t *view, char ***targets);
+
+/* Checks whether value of an option like 'grepprg' requests builtin
+ * implementation instead of an external command.  Returns non-zero if so,
+ * otherwise zero is returned. */
+int menus_uses_builtin(const char prg[]);
+
 /* Predefined key handler for processing keys on elements of file lists.
  * Returns code that specifies both taken actions and what should be done
  * next. */
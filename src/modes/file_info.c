@@ -48,6 +48,7 @@
 #include "../ui/ui.h"
 #include "../utils/fs.h"
 #include "../utils/fsdata.h"
+#include "../utils/idcache.h"
 #include "../utils/macros.h"
 #include "../utils/path.h"
 #include "../utils/str.h"
@@ -218,6 +219,10 @@ fill_items(view_t *view, draw_ctx_t *ctx)
 
 	char id_buf[26];
 
+	/* The dialog isn't redrawn when names get resolved in background. */
+	idcache_resolve(IK_USER, curr->uid);
+	idcache_resolve(IK_GROUP, curr->gid);
+
 	get_uid_string(curr, 0, sizeof(id_buf), id_buf);
 	if(isdigit(id_buf[0]))
 	{
@@ -46,6 +46,10 @@ void modmenu_pre(void);
  * mode. */
 void modmenu_post(void);
 
+/* Adds to the active menu items that were produced by a command since the last
+ * call and redraws it if necessary. */
+void modmenu_check_for_updates(void);
+
 /* Redraws menu mode. */
 void modmenu_full_redraw(void);
 
@@ -48,6 +48,7 @@
 #include "utils/str.h"
 #include "utils/string_array.h"
 #include "utils/utils.h"
+#include "builtin_find.h"
 #include "filelist.h"
 #include "flist_hist.h"
 #include "registers.h"
@@ -2169,6 +2170,8 @@ static void
 findprg_handler(OPT_OP op, optval_t val)
 {
 	(void)replace_string(&cfg.find_prg, val.str_val);
+	/* Listing might have been made with different settings. */
+	bfind_drop_snapshot();
 }
 
 static void
@@ -3590,6 +3593,14 @@ static void
 timefmt_handler(OPT_OP op, optval_t val)
 {
 	replace_string(&cfg.time_format, val.str_val);
+
+	int i;
+	tab_info_t tab_info;
+	for(i = 0; tabs_enum_all(i, &tab_info); ++i)
+	{
+		fview_formats_updated(tab_info.view);
+	}
+
 	redraw_lists();
 }
 
@@ -34,6 +34,7 @@
 #include "utils/string_array.h"
 #include "utils/test_helpers.h"
 #include "utils/utils.h"
+#include "startup_time.h"
 
 /* State of the unit. */
 struct plugs_t
@@ -180,18 +181,25 @@ plugs_load(plugs_t *plugs, const char base_dir[])
 			plug_log(plug, "[vifm][info]: skipped due to blacklist/whitelist");
 			plug->status = PLS_SKIPPED;
 		}
-		else if(vlua_load_plugin(plugs->vlua, entry->d_name, plug) == 0)
-		{
-			plug_log(plug, "[vifm][info]: plugin was loaded successfully");
-			plug->status = PLS_SUCCESS;
-		}
 		else
 		{
-			plug_log(plug, "[vifm][error]: loading plugin has failed");
+			const long long start = stime_begin();
+			if(vlua_load_plugin(plugs->vlua, entry->d_name, plug) == 0)
+			{
+				plug_log(plug, "[vifm][info]: plugin was loaded successfully");
+				plug->status = PLS_SUCCESS;
+			}
+			else
+			{
+				plug_log(plug, "[vifm][error]: loading plugin has failed");
+			}
+			stime_end(start, "loading plugin %s", plug->path);
 		}
 	}
 
 	os_closedir(dir);
+
+	vlua_prune_chunk_cache();
 }
 
 /* Frees a plugin.  The argument can't be NULL. */
@@ -30,7 +30,7 @@
 #define ERROR_ELEVATION_REQUIRED 740L
 #endif
 #endif
-#include <unistd.h> /* pid_t */
+#include <unistd.h> /* pid_t usleep() */
 
 #include <assert.h> /* assert() */
 #include <errno.h> /* errno */
@@ -52,6 +52,7 @@
 #include "menus/users_menu.h"
 #include "modes/dialogs/msg_dialog.h"
 #include "modes/view.h"
+#include "ui/cancellation.h"
 #include "ui/statusbar.h"
 #include "ui/quickview.h"
 #include "ui/ui.h"
@@ -69,6 +70,7 @@
 #include "flist_hist.h"
 #include "flist_pos.h"
 #include "flist_sel.h"
+#include "flist_stream.h"
 #include "macros.h"
 #include "opt_handlers.h"
 #include "status.h"
@@ -128,6 +130,11 @@ static void output_to_statusbar(const char cmd[], view_t *view,
 		MacroFlags flags);
 static int output_to_preview(view_t *view, const char cmd[], MacroFlags flags);
 static void run_in_split(const view_t *view, const char cmd[], int vert_split);
+static void start_custom_view(view_t *view, const char title[]);
+static bg_job_t * start_flist_job(view_t *view, const char cmd[],
+		MacroFlags flags);
+static void load_flist_stream(view_t *view, flist_stream_t *stream, int very);
+static int wait_for_flist_stream(view_t *view, flist_stream_t *stream);
 static void path_handler(const char line[], void *arg);
 static void line_handler(const char line[], void *arg);
 
@@ -1443,24 +1450,29 @@ int
 rn_for_flist(view_t *view, const char cmd[], const char title[],
 		MacroFlags flags)
 {
-	enum { MAX_TITLE_WIDTH = 80 };
-
 	const int very = ma_flags_present(flags, MF_VERYCUSTOMVIEW_OUTPUT)
 	              || ma_flags_present(flags, MF_VERYCUSTOMVIEW_IOUTPUT);
 	const int interactive = ma_flags_present(flags, MF_CUSTOMVIEW_IOUTPUT)
 	                     || ma_flags_present(flags, MF_VERYCUSTOMVIEW_IOUTPUT);
 
-	/* It makes sense to do escaping before adding ellipses to get a predictable
-	 * result. */
-	char *escaped_title = escape_unreadable(title);
-	char *final_title = right_ellipsis(escaped_title, MAX_TITLE_WIDTH,
-			curr_stats.ellipsis);
-	free(escaped_title);
+	start_custom_view(view, title);
 
-	flist_custom_start(view, final_title);
-	free(final_title);
+	if(!interactive)
+	{
+		bg_job_t *const job = start_flist_job(view, cmd, flags);
+		flist_stream_t *const stream = (job == NULL)
+		                             ? NULL
+		                             : flist_stream_start(view, job);
+		if(stream == NULL)
+		{
+			show_error_msgf("Trouble running command", "Unable to run: %s", cmd);
+			return 1;
+		}
+		load_flist_stream(view, stream, very);
+		return 0;
+	}
 
-	if(interactive && curr_stats.load_stage != 0)
+	if(curr_stats.load_stage != 0)
 	{
 		ui_shutdown();
 	}
@@ -1487,6 +1499,131 @@ rn_for_flist(view_t *view, const char cmd[], const char title[],
 	return 0;
 }
 
+int
+rn_for_flist_job(view_t *view, bg_job_t *job, const char title[], int very)
+{
+	start_custom_view(view, title);
+
+	flist_stream_t *const stream = flist_stream_start(view, job);
+	if(stream == NULL)
+	{
+		return 1;
+	}
+
+	load_flist_stream(view, stream, very);
+	return 0;
+}
+
+void
+rn_for_flist_stream(view_t *view, flist_stream_t *stream, const char title[],
+		int very)
+{
+	start_custom_view(view, title);
+	load_flist_stream(view, stream, very);
+}
+
+/* Begins composing custom view with the title. */
+static void
+start_custom_view(view_t *view, const char title[])
+{
+	enum { MAX_TITLE_WIDTH = 80 };
+
+	/* It makes sense to do escaping before adding ellipses to get a predictable
+	 * result. */
+	char *escaped_title = escape_unreadable(title);
+	char *final_title = right_ellipsis(escaped_title, MAX_TITLE_WIDTH,
+			curr_stats.ellipsis);
+	free(escaped_title);
+
+	flist_custom_start(view, final_title);
+	free(final_title);
+}
+
+/* Starts the command whose output is a list of paths for custom view that's
+ * being composed.  Returns the job or NULL on error. */
+static bg_job_t *
+start_flist_job(view_t *view, const char cmd[], MacroFlags flags)
+{
+	const BgJobFlags bg_flags = BJF_CAPTURE_OUT | BJF_USER_SHELL;
+
+	LOG_INFO_MSG("Capturing output of the command: %s", cmd);
+
+	/* List of files is passed via a file to not block on writing it while the
+	 * command waits for its output to be read. */
+	FILE *const input_tmp = make_in_file(view, flags);
+
+	setup_shellout_env();
+	bg_job_t *const job = bg_run_external_job_in(cmd, bg_flags, input_tmp);
+	cleanup_shellout_env();
+
+	if(input_tmp != NULL)
+	{
+		fclose(input_tmp);
+	}
+
+	if(job == NULL || job->output == NULL)
+	{
+		if(job != NULL)
+		{
+			(void)bg_job_cancel(job);
+			bg_job_decref(job);
+		}
+		return NULL;
+	}
+
+	return job;
+}
+
+/* Fills custom view that's being composed with entries of the stream, which is
+ * taken over. */
+static void
+load_flist_stream(view_t *view, flist_stream_t *stream, int very)
+{
+	if(wait_for_flist_stream(view, stream) || flist_stream_is_done(stream))
+	{
+		flist_stream_free(stream);
+		stream = NULL;
+	}
+
+	/* This drops stream of the previous custom view, if there was one. */
+	flist_custom_end(view, very);
+
+	/* Stream is present only if something was loaded, so the view has been
+	 * successfully replaced. */
+	view->custom.stream = stream;
+}
+
+/* Jobs that finish quickly produce complete list at once, others get some
+ * time to produce the first paths and continue populating the view after it's
+ * displayed.  Returns non-zero if waiting was cancelled by the user. */
+static int
+wait_for_flist_stream(view_t *view, flist_stream_t *stream)
+{
+	/* Time to wait for the command to finish before displaying the view and
+	 * period of checking for its output. */
+	enum { LOADING_DELAY_MS = 250, POLL_PERIOD_MS = 10 };
+
+	const long long deadline = time_in_ms() + LOADING_DELAY_MS;
+
+	ui_cancellation_push_on();
+	while(!flist_stream_is_done(stream) && !ui_cancellation_requested())
+	{
+		if(view->custom.entry_count > 0 && time_in_ms() >= deadline)
+		{
+			break;
+		}
+
+		if(flist_stream_pull(stream, view) == 0)
+		{
+			usleep(POLL_PERIOD_MS*1000);
+		}
+	}
+	const int cancelled = ui_cancellation_requested();
+	ui_cancellation_pop();
+
+	return cancelled;
+}
+
 /* Implements process_cmd_output() callback that loads paths into custom
  * view. */
 static void
@@ -91,6 +91,21 @@ void rn_start_bg_command(struct view_t *view, const char cmd[],
 int rn_for_flist(struct view_t *view, const char cmd[], const char title[],
 		MacroFlags flags);
 
+struct bg_job_t;
+
+/* Composes custom view or very custom view out of paths printed by the job,
+ * which is taken over.  Returns zero on success, otherwise non-zero is
+ * returned. */
+int rn_for_flist_job(struct view_t *view, struct bg_job_t *job,
+		const char title[], int very);
+
+struct flist_stream_t;
+
+/* Composes custom view or very custom view out of entries of the stream, which
+ * is taken over. */
+void rn_for_flist_stream(struct view_t *view, struct flist_stream_t *stream,
+		const char title[], int very);
+
 /* Executes external command capturing its output as list of lines.  Sets *lines
  * and *nlines.  Returns zero on success, otherwise non-zero is returned. */
 int rn_for_lines(struct view_t *view, const char cmd[], char ***lines,
@@ -103,7 +103,6 @@ int
 find_pattern(view_t *view, const char pattern[], int backward, int move,
 		int *found, int print_errors)
 {
-	int cflags;
 	int nmatches = 0;
 	regex_t re;
 	int err;
@@ -114,7 +113,20 @@ find_pattern(view_t *view, const char pattern[], int backward, int move,
 		flist_sel_stash(view);
 	}
 
-	reset_search_results(view);
+	/* Entries that didn't match previous pattern can't match a narrower one, so
+	 * they are skipped, which speeds up incremental search. */
+	const int cflags = get_regexp_cflags(pattern);
+	const int narrowing = view->matches != 0
+	                   && regexp_narrows(view->last_search,
+	                                     view->last_search_cflags, pattern, cflags);
+	if(narrowing)
+	{
+		view->matches = 0;
+	}
+	else
+	{
+		reset_search_results(view);
+	}
 
 	/* We at least could wipe out previous search results, so schedule a
 	 * redraw. */
@@ -128,7 +140,6 @@ find_pattern(view_t *view, const char pattern[], int backward, int move,
 
 	*found = 0;
 
-	cflags = get_regexp_cflags(pattern);
 	if((err = regexp_compile(&re, pattern, cflags)) == 0)
 	{
 		int i;
@@ -137,22 +148,23 @@ find_pattern(view_t *view, const char pattern[], int backward, int move,
 			regmatch_t matches[1];
 			dir_entry_t *const entry = &view->dir_entry[i];
 			const char *name = entry->name;
-			char *free_this = NULL;
+			char name_with_slash[NAME_MAX + 1 + 1];
 
-			if(is_parent_dir(name))
+			if(is_parent_dir(name) || (narrowing && entry->search_match == 0))
 			{
 				continue;
 			}
 
+			entry->search_match = 0;
+
 			if(fentry_is_dir(entry))
 			{
-				free_this = format_str("%s/", name);
-				name = free_this;
+				snprintf(name_with_slash, sizeof(name_with_slash), "%s/", name);
+				name = name_with_slash;
 			}
 
 			if(regexec(&re, name, 1, matches, 0) != 0)
 			{
-				free(free_this);
 				continue;
 			}
 
@@ -167,8 +179,6 @@ find_pattern(view_t *view, const char pattern[], int backward, int move,
 				++view->selected_files;
 			}
 			++nmatches;
-
-			free(free_this);
 		}
 		regfree(&re);
 	}
@@ -190,6 +200,7 @@ find_pattern(view_t *view, const char pattern[], int backward, int move,
 	}
 	view->matches = nmatches;
 	copy_str(view->last_search, sizeof(view->last_search), pattern);
+	view->last_search_cflags = cflags;
 
 	view->matches = nmatches;
 	if(nmatches > 0)
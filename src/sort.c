@@ -41,8 +41,10 @@
 #include "filelist.h"
 #include "filtering.h"
 #include "status.h"
+#include "trace.h"
 #include "types.h"
 
+static void sort_view_internal(view_t *v);
 static void sort_tree_slice(dir_entry_t *entries, const dir_entry_t *children,
 		size_t nchildren, int root);
 static void sort_sequence(dir_entry_t *entries, size_t nentries);
@@ -85,6 +87,15 @@ static void *sort_data;
 
 void
 sort_view(view_t *v)
+{
+	const long long start = trace_begin();
+	sort_view_internal(v);
+	trace_end(TP_SORT_VIEW, start);
+}
+
+/* Implementation of sort_view(). */
+static void
+sort_view_internal(view_t *v)
 {
 	dir_entry_t *unsorted_list;
 
@@ -0,0 +1,125 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "startup_time.h"
+
+#include <stdarg.h> /* va_list va_start() va_end() */
+#include <stdio.h> /* FILE fclose() fprintf() fputc() fputs() vfprintf() */
+
+#include "compat/os.h"
+#include "utils/utils.h"
+
+static void print_times(long long total, long long self);
+
+/* File to write records to or NULL if recording is inactive. */
+static FILE *log_file;
+/* Timestamp of the start of recording. */
+static long long start_time;
+/* Timestamp of the last record. */
+static long long last_time;
+
+int
+stime_open(const char path[])
+{
+	if(log_file != NULL)
+	{
+		return 1;
+	}
+
+	log_file = os_fopen(path, "w");
+	if(log_file == NULL)
+	{
+		return 1;
+	}
+
+	start_time = time_in_us();
+	last_time = start_time;
+
+	fputs("times in msec\n", log_file);
+	fputs(" clock    self:  phase\n", log_file);
+	fputs(" clock   total:  sourced file or plugin\n\n", log_file);
+	stime_mark("--- VIFM STARTING ---");
+	return 0;
+}
+
+void
+stime_close(void)
+{
+	if(log_file != NULL)
+	{
+		stime_mark("--- VIFM STARTED ---");
+		fclose(log_file);
+		log_file = NULL;
+	}
+}
+
+void
+stime_mark(const char format[], ...)
+{
+	if(log_file == NULL)
+	{
+		return;
+	}
+
+	const long long now = time_in_us();
+	print_times(now - start_time, now - last_time);
+	last_time = now;
+
+	va_list ap;
+	va_start(ap, format);
+	vfprintf(log_file, format, ap);
+	va_end(ap);
+	fputc('\n', log_file);
+}
+
+long long
+stime_begin(void)
+{
+	return (log_file == NULL ? 0 : time_in_us());
+}
+
+void
+stime_end(long long start, const char format[], ...)
+{
+	if(log_file == NULL)
+	{
+		return;
+	}
+
+	const long long now = time_in_us();
+	print_times(now - start_time, now - start);
+	/* Time of the item shouldn't be attributed to the next phase. */
+	last_time = now;
+
+	va_list ap;
+	va_start(ap, format);
+	vfprintf(log_file, format, ap);
+	va_end(ap);
+	fputc('\n', log_file);
+}
+
+/* Prints prefix of a record with two times in milliseconds. */
+static void
+print_times(long long total, long long self)
+{
+	fprintf(log_file, "%03lld.%03lld  %03lld.%03lld: ", total/1000, total%1000,
+			self/1000, self%1000);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
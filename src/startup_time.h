@@ -0,0 +1,49 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__STARTUP_TIME_H__
+#define VIFM__STARTUP_TIME_H__
+
+#include "utils/macros.h"
+
+/* This unit records how much time different phases of startup take (as
+ * requested by --startuptime command-line option).  All functions do nothing
+ * unless recording is active. */
+
+/* Starts recording into a file at the path, which is truncated.  Returns zero
+ * on success, otherwise non-zero is returned. */
+int stime_open(const char path[]);
+
+/* Finishes recording and closes the file. */
+void stime_close(void);
+
+/* Records end of a phase, time since previous record is reported as its
+ * duration. */
+void stime_mark(const char format[], ...) _gnuc_printf(1, 2);
+
+/* Retrieves timestamp to be passed to stime_end() for timing an item that can
+ * be nested within others (like sourcing of a file).  Returns the timestamp. */
+long long stime_begin(void);
+
+/* Records end of an item that started at the specified moment. */
+void stime_end(long long start, const char format[], ...) _gnuc_printf(2, 3);
+
+#endif /* VIFM__STARTUP_TIME_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -173,6 +173,7 @@ const char *tags[] = {
 	"vifm---select",
 	"vifm---server-list",
 	"vifm---server-name",
+	"vifm---startuptime",
 	"vifm---version",
 	"vifm--c",
 	"vifm--f",
@@ -286,6 +287,7 @@ const char *tags[] = {
 	"vifm-:if",
 	"vifm-:invert",
 	"vifm-:jobs",
+	"vifm-:jump",
 	"vifm-:keepsel",
 	"vifm-:let",
 	"vifm-:locate",
@@ -903,6 +905,7 @@ const char *tags[] = {
 	"vifm-to-s",
 	"vifm-to-u",
 	"vifm-to-v",
+	"vifm-trace()",
 	"vifm-trash",
 	"vifm-u",
 	"vifm-v",
@@ -0,0 +1,284 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "trace.h"
+
+#include <stddef.h> /* NULL size_t */
+#include <stdio.h> /* FILE fclose() fprintf() fputs() snprintf() */
+#include <stdlib.h> /* calloc() */
+#include <string.h> /* memset() */
+
+#include "compat/os.h"
+#include "compat/pthread.h"
+#include "utils/macros.h"
+#include "utils/utils.h"
+
+/* Maximum number of operations kept in history of each thread. */
+#define HISTORY_LEN 4096
+
+/* Single finished operation. */
+typedef struct
+{
+	TracePoint point; /* Where it happened. */
+	int tid;          /* Identifier of the thread that finished it. */
+	long long start;  /* When it started in microseconds. */
+	long long dur;    /* Duration in microseconds. */
+}
+span_t;
+
+/* Information collected by a single thread.  Threads don't share rings, so
+ * the lock is contended only by readers.  Rings of finished threads are reused
+ * by new ones keeping what was collected. */
+typedef struct ring_t
+{
+	pthread_mutex_t lock; /* Protects statistics and history. */
+
+	trace_stats_t stats[TP_COUNT]; /* Accumulated information about each point. */
+	span_t history[HISTORY_LEN];   /* Circular buffer of recent operations. */
+	unsigned long long count;      /* Number of operations ever put in history. */
+
+	int tid;    /* Identifier of the thread that owns the ring. */
+	int in_use; /* Whether the ring is owned by a thread (under rings_lock). */
+	struct ring_t *next; /* Next ring in the list of all rings. */
+}
+ring_t;
+
+static ring_t * get_ring(void);
+static void make_ring_key(void);
+static void release_ring(void *data);
+
+/* Names of trace points. */
+static const char *names[] = {
+	[TP_POPULATE_DIR]  = "populate_dir_list",
+	[TP_SORT_VIEW]     = "sort_view",
+	[TP_DRAW_VIEW]     = "draw_dir_list",
+	[TP_VCACHE_LOOKUP] = "vcache_lookup",
+	[TP_FSWATCH_POLL]  = "fswatch_poll",
+	[TP_BG_JOB]        = "bg_job",
+	[TP_IOR_CP]        = "ior_cp",
+	[TP_IOR_MV]        = "ior_mv",
+	[TP_IOR_RM]        = "ior_rm",
+};
+ARRAY_GUARD(names, TP_COUNT);
+
+/* Protects list of rings, their ownership and last_tid. */
+static pthread_mutex_t rings_lock = PTHREAD_MUTEX_INITIALIZER;
+/* List of all rings. */
+static ring_t *rings;
+/* Last assigned thread identifier. */
+static int last_tid;
+
+/* Key of thread-local storage of rings. */
+static pthread_key_t ring_key;
+
+long long
+trace_begin(void)
+{
+	return time_in_us();
+}
+
+void
+trace_end(TracePoint point, long long start)
+{
+	const long long dur = time_in_us() - start;
+
+	ring_t *const ring = get_ring();
+	if(ring == NULL)
+	{
+		return;
+	}
+
+	pthread_mutex_lock(&ring->lock);
+
+	trace_stats_t *const s = &ring->stats[point];
+	++s->count;
+	s->total += dur;
+	if(dur > s->max)
+	{
+		s->max = dur;
+	}
+
+	span_t *const span = &ring->history[ring->count++%HISTORY_LEN];
+	span->point = point;
+	span->tid = ring->tid;
+	span->start = start;
+	span->dur = dur;
+
+	pthread_mutex_unlock(&ring->lock);
+}
+
+/* Retrieves ring of the current thread, assigning one if necessary.  Returns
+ * the ring or NULL on error. */
+static ring_t *
+get_ring(void)
+{
+	static pthread_once_t once = PTHREAD_ONCE_INIT;
+	pthread_once(&once, &make_ring_key);
+
+	ring_t *ring = pthread_getspecific(ring_key);
+	if(ring != NULL)
+	{
+		return ring;
+	}
+
+	pthread_mutex_lock(&rings_lock);
+
+	for(ring = rings; ring != NULL; ring = ring->next)
+	{
+		if(!ring->in_use)
+		{
+			break;
+		}
+	}
+
+	if(ring == NULL)
+	{
+		ring = calloc(1, sizeof(*ring));
+		if(ring != NULL)
+		{
+			pthread_mutex_init(&ring->lock, NULL);
+			ring->next = rings;
+			rings = ring;
+		}
+	}
+
+	if(ring != NULL)
+	{
+		ring->in_use = 1;
+		/* Spans in the history keep identifier of their thread, so this doesn't
+		 * affect them. */
+		ring->tid = ++last_tid;
+		(void)pthread_setspecific(ring_key, ring);
+	}
+
+	pthread_mutex_unlock(&rings_lock);
+	return ring;
+}
+
+/* ring_key initializer for pthread_once(). */
+static void
+make_ring_key(void)
+{
+	(void)pthread_key_create(&ring_key, &release_ring);
+}
+
+/* Makes ring of a finished thread available to other threads. */
+static void
+release_ring(void *data)
+{
+	ring_t *const ring = data;
+	pthread_mutex_lock(&rings_lock);
+	ring->in_use = 0;
+	pthread_mutex_unlock(&rings_lock);
+}
+
+void
+trace_get_stats(TracePoint point, trace_stats_t *s)
+{
+	memset(s, 0, sizeof(*s));
+
+	pthread_mutex_lock(&rings_lock);
+	ring_t *ring;
+	for(ring = rings; ring != NULL; ring = ring->next)
+	{
+		pthread_mutex_lock(&ring->lock);
+		const trace_stats_t *const rs = &ring->stats[point];
+		s->count += rs->count;
+		s->total += rs->total;
+		if(rs->max > s->max)
+		{
+			s->max = rs->max;
+		}
+		pthread_mutex_unlock(&ring->lock);
+	}
+	pthread_mutex_unlock(&rings_lock);
+
+	s->name = names[point];
+}
+
+char *
+trace_format_stats(TracePoint point, char buf[], size_t buf_len)
+{
+	trace_stats_t s;
+	trace_get_stats(point, &s);
+
+	const long long avg = (s.count == 0 ? 0 : s.total/(long long)s.count);
+	snprintf(buf, buf_len, "%s: %llu calls, %lld.%03lld ms total, "
+			"%lld.%03lld ms avg, %lld.%03lld ms max", s.name, s.count,
+			s.total/1000, s.total%1000, avg/1000, avg%1000, s.max/1000, s.max%1000);
+	return buf;
+}
+
+void
+trace_reset(void)
+{
+	pthread_mutex_lock(&rings_lock);
+	ring_t *ring;
+	for(ring = rings; ring != NULL; ring = ring->next)
+	{
+		pthread_mutex_lock(&ring->lock);
+		memset(&ring->stats, 0, sizeof(ring->stats));
+		ring->count = 0;
+		pthread_mutex_unlock(&ring->lock);
+	}
+	pthread_mutex_unlock(&rings_lock);
+}
+
+int
+trace_dump(const char path[])
+{
+	FILE *fp = os_fopen(path, "w");
+	if(fp == NULL)
+	{
+		return 1;
+	}
+
+	fputs("{\"traceEvents\":[", fp);
+
+	int first_span = 1;
+	pthread_mutex_lock(&rings_lock);
+	ring_t *ring;
+	for(ring = rings; ring != NULL; ring = ring->next)
+	{
+		pthread_mutex_lock(&ring->lock);
+
+		const unsigned long long first = (ring->count > HISTORY_LEN)
+		                               ? ring->count - HISTORY_LEN
+		                               : 0;
+
+		unsigned long long i;
+		for(i = first; i < ring->count; ++i)
+		{
+			const span_t *const span = &ring->history[i%HISTORY_LEN];
+			fprintf(fp, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,"
+					"\"pid\":1,\"tid\":%d}", (first_span ? "" : ","),
+					names[span->point], span->start, span->dur, span->tid);
+			first_span = 0;
+		}
+
+		pthread_mutex_unlock(&ring->lock);
+	}
+	pthread_mutex_unlock(&rings_lock);
+
+	fputs("\n]}\n", fp);
+
+	return (fclose(fp) != 0);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,78 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__TRACE_H__
+#define VIFM__TRACE_H__
+
+#include <stddef.h> /* size_t */
+
+/* This unit collects counts and durations of operations at fixed points of
+ * interest (usually hot paths) along with a history of recent ones.  It's safe
+ * to use from any thread, each thread records into its own storage. */
+
+/* Points of interest. */
+typedef enum
+{
+	TP_POPULATE_DIR,  /* Reading list of files of a view. */
+	TP_SORT_VIEW,     /* Sorting list of files of a view. */
+	TP_DRAW_VIEW,     /* Drawing list of files of a view. */
+	TP_VCACHE_LOOKUP, /* Retrieving preview of a file. */
+	TP_FSWATCH_POLL,  /* Checking directories for changes. */
+	TP_BG_JOB,        /* Lifetime of a background job. */
+	TP_IOR_CP,        /* Copying files. */
+	TP_IOR_MV,        /* Moving files. */
+	TP_IOR_RM,        /* Removing files. */
+	TP_COUNT          /* Number of points, not a valid value. */
+}
+TracePoint;
+
+/* Accumulated information about a point. */
+typedef struct
+{
+	const char *name;         /* Name of the point. */
+	unsigned long long count; /* Number of finished operations. */
+	long long total;          /* Total duration in microseconds. */
+	long long max;            /* Longest duration in microseconds. */
+}
+trace_stats_t;
+
+/* Retrieves timestamp of the beginning of an operation to be passed to
+ * trace_end().  Returns the timestamp. */
+long long trace_begin(void);
+
+/* Records end of an operation at the point that began at the moment. */
+void trace_end(TracePoint point, long long start);
+
+/* Retrieves accumulated information about the point. */
+void trace_get_stats(TracePoint point, trace_stats_t *stats);
+
+/* Formats accumulated information about the point as a single line.  Returns
+ * the buffer. */
+char * trace_format_stats(TracePoint point, char buf[], size_t buf_len);
+
+/* Forgets all collected information. */
+void trace_reset(void);
+
+/* Writes recent operations into a file in Chrome's trace event format.
+ * Returns zero on success, otherwise non-zero is returned. */
+int trace_dump(const char path[]);
+
+#endif /* VIFM__TRACE_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -18,12 +18,17 @@
 
 #include "trash.h"
 
-#include <sys/stat.h> /* stat chmod() */
-#include <unistd.h> /* getuid() */
+#include <sys/stat.h> /* stat chmod() fchmodat() fstatat() */
+#include <dirent.h> /* DIR dirent fdopendir() readdir() closedir() */
+#ifndef _WIN32
+#include <fcntl.h> /* AT_* O_* openat() */
+#endif
+#include <unistd.h> /* getuid() unlink() unlinkat() */
 
 #include <assert.h> /* assert() */
 #include <errno.h> /* EROFS errno */
 #include <stddef.h> /* NULL size_t */
+#include <stdint.h> /* uint64_t */
 #include <stdio.h> /* remove() snprintf() */
 #include <stdlib.h> /* free() realloc() */
 #include <string.h> /* memmove() strchr() strcmp() strdup() strlen() strspn() */
@@ -31,6 +36,7 @@
 #include "cfg/config.h"
 #include "compat/fs_limits.h"
 #include "compat/os.h"
+#include "compat/pthread.h"
 #include "compat/mntent.h"
 #include "compat/reallocarray.h"
 #include "modes/dialogs/msg_dialog.h"
@@ -40,6 +46,7 @@
 #include "utils/str.h"
 #include "utils/string_array.h"
 #include "utils/test_helpers.h"
+#include "utils/trie.h"
 #include "utils/utils.h"
 #include "background.h"
 #include "ops.h"
@@ -81,6 +88,20 @@ typedef struct
 }
 trashes_list;
 
+/* State of emptying single trash directory in background. */
+typedef struct
+{
+	bg_op_t *bg_op;   /* Progress reporting and cancellation. */
+	char *trash_dir;  /* Trash directory being emptied. */
+	char *pretty_dir; /* Trash directory with home part replaced by a tilde. */
+	int can_delete;   /* Whether trash directory itself should be removed. */
+
+	uint64_t items; /* Number of removed files and directories. */
+	uint64_t bytes; /* Number of bytes freed (approximated by file sizes). */
+	int cancelled;  /* Whether the process was cancelled. */
+}
+reaper_t;
+
 /* State for get_list_of_trashes() traverser. */
 typedef struct
 {
@@ -96,8 +117,20 @@ static int try_create_trash_dir(const char trash_dir[], int user_specific);
 static void empty_trash_dirs(void);
 static void empty_trash_dir(const char trash_dir[], int can_delete);
 static void empty_trash_in_bg(bg_op_t *bg_op, void *arg);
-static void remove_trash_entries(const char trash_dir[]);
+static void reaper_finished(void);
+#ifndef _WIN32
+static void reap_dir(reaper_t *reaper, int dir_fd, const char path[],
+		int depth);
+static void reap_entry(reaper_t *reaper, int dir_fd, const char path[],
+		int depth, const struct dirent *d);
+static void reap_path(reaper_t *reaper, const char path[]);
+static void reaper_progress(reaper_t *reaper);
+#endif
+static int is_in_emptied_trash(trash_entry_t *entry);
 static int find_in_trash(const char original_path[], const char trash_path[]);
+static int find_by_trash_name(const char trash_name[]);
+static void index_entry(trash_entry_t *entry);
+static void rebuild_index(void);
 static trashes_list get_list_of_trashes(int allow_empty);
 static int get_list_of_trashes_traverser(struct mntent *entry, void *arg);
 static int is_trash_valid(const char trash_dir[], int allow_empty);
@@ -129,6 +162,21 @@ int trash_list_size;
 TSTATIC char **specs;
 TSTATIC int nspecs;
 
+/* Maps real trash names of entries of trash_list onto their original paths
+ * (owned by the entries) to avoid linear scans on looking up entries by their
+ * trash name.  Removed entries are mapped onto NULL as trie doesn't support
+ * deletion, the index is rebuilt on bulk removals. */
+static trie_t *trash_index;
+
+/* Trash directories that were emptied since the last time their entries were
+ * pruned. */
+static strlist_t emptied_trashes;
+
+/* Number of background tasks emptying trash directories and a lock that
+ * protects it. */
+static int running_reapers;
+static pthread_mutex_t reapers_lock = PTHREAD_MUTEX_INITIALIZER;
+
 int
 trash_set_specs(const char new_specs[])
 {
@@ -268,7 +316,6 @@ trash_empty_all(void)
 	regs_remove_trashed_files(NULL);
 	empty_trash_dirs();
 	un_clear_cmds_with_trash(NULL);
-	remove_trash_entries(NULL);
 }
 
 /* Empties all trash directories (all specifications on all mount points are
@@ -293,11 +340,13 @@ trash_empty(const char trash_dir[])
 	regs_remove_trashed_files(trash_dir);
 	empty_trash_dir(trash_dir, 0);
 	un_clear_cmds_with_trash(trash_dir);
-	remove_trash_entries(trash_dir);
 }
 
 /* Removes all files inside given trash directory (even those that this instance
- * of vifm is not aware of). */
+ * of vifm is not aware of).  Each trash directory is emptied by its own
+ * background task, so trashes on different mounts are processed in parallel.
+ * Emptying can be cancelled, so entries of the trash are kept until
+ * trash_prune_emptied_entries() finds their files gone. */
 static void
 empty_trash_dir(const char trash_dir[], int can_delete)
 {
@@ -307,13 +356,38 @@ empty_trash_dir(const char trash_dir[], int can_delete)
 	char *const task_desc = format_str("Empty trash: %s", trash_dir);
 	char *const op_desc = format_str("Emptying %s", replace_home_part(trash_dir));
 
-	/* Yes, this isn't pretty.  It's a simple way to bundle string and bool. */
-	char *trash_dir_copy = format_str("%c%s", can_delete ? '1' : '0', trash_dir);
+	reaper_t *const reaper = malloc(sizeof(*reaper));
+	if(reaper != NULL)
+	{
+		reaper->bg_op = NULL;
+		reaper->trash_dir = strdup(trash_dir);
+		/* replace_home_part() isn't thread-safe, so call it here. */
+		reaper->pretty_dir = strdup(replace_home_part(trash_dir));
+		reaper->can_delete = can_delete;
+		reaper->items = 0U;
+		reaper->bytes = 0U;
+		reaper->cancelled = 0;
+
+		pthread_mutex_lock(&reapers_lock);
+		++running_reapers;
+		pthread_mutex_unlock(&reapers_lock);
+
+		if(reaper->trash_dir == NULL || reaper->pretty_dir == NULL ||
+				bg_execute(task_desc, op_desc, BG_UNDEFINED_TOTAL, 1, &empty_trash_in_bg,
+					reaper) != 0)
+		{
+			reaper_finished();
+			free(reaper->trash_dir);
+			free(reaper->pretty_dir);
+			free(reaper);
+		}
+	}
 
-	if(bg_execute(task_desc, op_desc, BG_UNDEFINED_TOTAL, 1, &empty_trash_in_bg,
-			trash_dir_copy) != 0)
+	if(!is_in_string_array_os(emptied_trashes.items, emptied_trashes.nitems,
+				trash_dir))
 	{
-		free(trash_dir_copy);
+		emptied_trashes.nitems = add_to_string_array(&emptied_trashes.items,
+				emptied_trashes.nitems, trash_dir);
 	}
 
 	free(op_desc);
@@ -325,28 +399,223 @@ empty_trash_dir(const char trash_dir[], int can_delete)
 static void
 empty_trash_in_bg(bg_op_t *bg_op, void *arg)
 {
-	char *const trash_info = arg;
+	reaper_t *const reaper = arg;
+	reaper->bg_op = bg_op;
+
+#ifndef _WIN32
+	const int dir_fd = open(reaper->trash_dir, O_RDONLY | O_DIRECTORY);
+	if(dir_fd != -1)
+	{
+		reap_dir(reaper, dir_fd, reaper->trash_dir, 0);
+	}
+#else
+	remove_dir_content(reaper->trash_dir);
+#endif
+
+	if(reaper->can_delete && !reaper->cancelled)
+	{
+		(void)os_rmdir(reaper->trash_dir);
+	}
+
+	free(reaper->trash_dir);
+	free(reaper->pretty_dir);
+	free(reaper);
+
+	reaper_finished();
+}
+
+/* Accounts for a background task of emptying a trash directory being done. */
+static void
+reaper_finished(void)
+{
+	pthread_mutex_lock(&reapers_lock);
+	--running_reapers;
+	pthread_mutex_unlock(&reapers_lock);
+}
+
+#ifndef _WIN32
+
+/* Removes all files inside directory specified by a descriptor, which is closed
+ * by this function.  Working relative to directory descriptors saves path
+ * resolution on every removal, which matters for huge trashes.  The path and
+ * depth are used to stop holding a descriptor per level in deep trees. */
+static void
+reap_dir(reaper_t *reaper, int dir_fd, const char path[], int depth)
+{
+	DIR *const dir = fdopendir(dir_fd);
+	if(dir == NULL)
+	{
+		close(dir_fd);
+		return;
+	}
+
+	struct dirent *d;
+	while(!reaper->cancelled && (d = readdir(dir)) != NULL)
+	{
+		if(!is_builtin_dir(d->d_name))
+		{
+			reap_entry(reaper, dir_fd, path, depth, d);
+		}
+	}
+
+	closedir(dir);
+}
+
+/* Removes single file or directory tree relative to a directory descriptor. */
+static void
+reap_entry(reaper_t *reaper, int dir_fd, const char path[], int depth,
+		const struct dirent *d)
+{
+	/* Every level of reap_dir() keeps a descriptor open, which is fine unless
+	 * the tree is deep enough to run out of descriptors. */
+	enum { MAX_FD_DEPTH = 64 };
+
+	int is_dir;
+	uint64_t size = 0U;
+
+#ifdef HAVE_STRUCT_DIRENT_D_TYPE
+	is_dir = (d->d_type == DT_DIR);
+	if(d->d_type == DT_UNKNOWN || d->d_type == DT_REG)
+#endif
+	{
+		struct stat st;
+		if(fstatat(dir_fd, d->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0)
+		{
+			return;
+		}
+		is_dir = S_ISDIR(st.st_mode);
+		size = S_ISREG(st.st_mode) ? (uint64_t)st.st_size : 0U;
+	}
+
+	if(is_dir)
+	{
+		/* Attempt to make sure that we can change the directory we are
+		 * descending into. */
+		(void)fchmodat(dir_fd, d->d_name, 0777, 0);
+
+		char *const sub_path = format_str("%s/%s", path, d->d_name);
+		if(depth < MAX_FD_DEPTH)
+		{
+			const int sub_fd = openat(dir_fd, d->d_name,
+					O_RDONLY | O_DIRECTORY | O_NOFOLLOW);
+			if(sub_fd != -1)
+			{
+				reap_dir(reaper, sub_fd, sub_path, depth + 1);
+			}
+		}
+		else
+		{
+			reap_path(reaper, sub_path);
+		}
+		free(sub_path);
 
-	remove_dir_content(trash_info + 1);
-	if(trash_info[0] == '1')
+		if(reaper->cancelled || unlinkat(dir_fd, d->d_name, AT_REMOVEDIR) != 0)
+		{
+			return;
+		}
+	}
+	else if(unlinkat(dir_fd, d->d_name, 0) != 0)
 	{
-		(void)os_rmdir(trash_info + 1);
+		return;
 	}
 
-	free(trash_info);
+	++reaper->items;
+	reaper->bytes += size;
+	reaper_progress(reaper);
 }
 
-/* Removes entries that belong to specified trash directory.  Removes all if
- * trash_dir is NULL. */
+/* Removes all files inside directory specified by a path.  Names are read
+ * before removing anything, so no descriptors are held while descending. */
 static void
-remove_trash_entries(const char trash_dir[])
+reap_path(reaper_t *reaper, const char path[])
 {
+	int len;
+	char **const names = list_all_files(path, &len);
+	if(len < 0)
+	{
+		return;
+	}
+
 	int i;
-	int j = 0;
+	for(i = 0; i < len && !reaper->cancelled; ++i)
+	{
+		char *const full_path = format_str("%s/%s", path, names[i]);
+
+		struct stat st;
+		if(os_lstat(full_path, &st) == 0)
+		{
+			int removed;
+			if(S_ISDIR(st.st_mode))
+			{
+				(void)os_chmod(full_path, 0777);
+				reap_path(reaper, full_path);
+				removed = (!reaper->cancelled && os_rmdir(full_path) == 0);
+			}
+			else
+			{
+				removed = (unlink(full_path) == 0);
+			}
+
+			if(removed)
+			{
+				++reaper->items;
+				reaper->bytes += S_ISREG(st.st_mode) ? (uint64_t)st.st_size : 0U;
+				reaper_progress(reaper);
+			}
+		}
+
+		free(full_path);
+	}
+
+	free_string_array(names, len);
+}
+
+/* Reports progress of emptying trash directory once in a while and checks
+ * whether the process should be stopped. */
+static void
+reaper_progress(reaper_t *reaper)
+{
+	/* Updating description of the job too often would slow down the process and
+	 * would be useless anyway. */
+	enum { REPORT_PERIOD = 1024 };
 
+	if(reaper->items%REPORT_PERIOD != 0U)
+	{
+		return;
+	}
+
+	char size_str[64];
+	(void)friendly_size_notation(reaper->bytes, sizeof(size_str), size_str);
+
+	char *const descr = format_str("Emptying %s: %llu items, %s",
+			reaper->pretty_dir, (unsigned long long)reaper->items, size_str);
+	bg_op_set_descr(reaper->bg_op, descr);
+	free(descr);
+
+	reaper->cancelled = bg_op_cancelled(reaper->bg_op);
+}
+
+#endif
+
+void
+trash_prune_emptied_entries(void)
+{
+	if(emptied_trashes.nitems == 0)
+	{
+		return;
+	}
+
+	/* Once emptying is over, files that are still there are there to stay. */
+	pthread_mutex_lock(&reapers_lock);
+	const int reaping_is_over = (running_reapers == 0);
+	pthread_mutex_unlock(&reapers_lock);
+
+	int i;
+	int j = 0;
 	for(i = 0; i < trash_list_size; ++i)
 	{
-		if(trash_dir == NULL || entry_is(PREFIXED_WITH, &trash_list[i], trash_dir))
+		if(is_in_emptied_trash(&trash_list[i]) &&
+				!path_exists(trash_list[i].trash_name, NODEREF))
 		{
 			free_entry(&trash_list[i]);
 			continue;
@@ -355,19 +624,51 @@ remove_trash_entries(const char trash_dir[])
 		trash_list[j++] = trash_list[i];
 	}
 
-	trash_list_size = j;
-	if(trash_list_size == 0)
+	if(j != trash_list_size)
 	{
-		free(trash_list);
-		trash_list = NULL;
+		trash_list_size = j;
+		if(trash_list_size == 0)
+		{
+			free(trash_list);
+			trash_list = NULL;
+		}
+
+		rebuild_index();
+	}
+
+	if(reaping_is_over)
+	{
+		free_string_array(emptied_trashes.items, emptied_trashes.nitems);
+		emptied_trashes.items = NULL;
+		emptied_trashes.nitems = 0;
 	}
 }
 
+/* Checks whether the entry belongs to a trash directory that was emptied.
+ * Returns non-zero if so, otherwise zero is returned. */
+static int
+is_in_emptied_trash(trash_entry_t *entry)
+{
+	int i;
+	for(i = 0; i < emptied_trashes.nitems; ++i)
+	{
+		if(entry_is(PREFIXED_WITH, entry, emptied_trashes.items[i]))
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
+
 void
 trash_file_moved(const char src[], const char dst[])
 {
 	if(trash_has_path(dst))
 	{
+		/* Trash name of the file might be shared with an entry whose file was
+		 * removed by emptying the trash. */
+		trash_prune_emptied_entries();
+
 		if(trash_add_entry(src, dst) != 0)
 		{
 			LOG_ERROR_MSG("Failed to add to trash: (`%s`, `%s`)", src, dst);
@@ -416,6 +717,7 @@ trash_add_entry(const char original_path[], const char trash_name[])
 	memmove(trash_list + pos + 1, trash_list + pos,
 			sizeof(*trash_list)*(trash_list_size - 1 - pos));
 	trash_list[pos] = entry;
+	index_entry(&trash_list[pos]);
 	return 0;
 }
 
@@ -467,6 +769,67 @@ find_in_trash(const char original_path[], const char trash_path[])
 	return -l - 1;
 }
 
+/* Finds position of an entry in trash_list by its trash name.  Returns the
+ * position or -1 if there is no such entry. */
+static int
+find_by_trash_name(const char trash_name[])
+{
+	char real_trash_name[PATH_MAX*2 + 1];
+	make_real_path(trash_name, real_trash_name, sizeof(real_trash_name));
+
+	void *original_path;
+	if(trie_get(trash_index, real_trash_name, &original_path) == 0 &&
+			original_path != NULL)
+	{
+		const int pos = find_in_trash(original_path, trash_name);
+		if(pos >= 0)
+		{
+			return pos;
+		}
+	}
+
+	/* Index remembers only one original path per trash name, fallback to a
+	 * linear search for the case when several entries share trash name. */
+	int i;
+	for(i = 0; i < trash_list_size; ++i)
+	{
+		if(stroscmp(get_real_trash_name(&trash_list[i]), real_trash_name) == 0)
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+/* Makes the entry discoverable by its trash name. */
+static void
+index_entry(trash_entry_t *entry)
+{
+	if(trash_index == NULL)
+	{
+		trash_index = trie_create(/*free_func=*/NULL);
+	}
+
+	if(trie_set(trash_index, get_real_trash_name(entry), entry->path) < 0)
+	{
+		LOG_ERROR_MSG("Failed to index trash entry: %s", entry->trash_name);
+	}
+}
+
+/* Recreates index of trash_list from scratch dropping stale keys. */
+static void
+rebuild_index(void)
+{
+	trie_free(trash_index);
+	trash_index = NULL;
+
+	int i;
+	for(i = 0; i < trash_list_size; ++i)
+	{
+		index_entry(&trash_list[i]);
+	}
+}
+
 char **
 trash_list_trashes(int *ntrashes)
 {
@@ -553,18 +916,11 @@ is_trash_valid(const char trash_dir[], int allow_empty)
 int
 trash_restore(const char trash_name[])
 {
-	int i;
 	char full[PATH_MAX + 1];
 	char path[PATH_MAX + 1];
 
-	for(i = 0; i < trash_list_size; ++i)
-	{
-		if(entry_is(SAME_AS, &trash_list[i], trash_name))
-		{
-			break;
-		}
-	}
-	if(i >= trash_list_size)
+	const int i = find_by_trash_name(trash_name);
+	if(i < 0)
 	{
 		return -1;
 	}
@@ -604,17 +960,18 @@ trash_restore(const char trash_name[])
 static void
 remove_from_trash(const char trash_name[])
 {
-	int i;
-	for(i = 0; i < trash_list_size; ++i)
+	const int i = find_by_trash_name(trash_name);
+	if(i < 0)
 	{
-		if(entry_is(SAME_AS, &trash_list[i], trash_name))
-		{
-			break;
-		}
+		return;
 	}
-	if(i >= trash_list_size)
+
+	/* The key stays in the index, but it shouldn't point to freed memory. */
+	void *original_path;
+	if(trie_get(trash_index, get_real_trash_name(&trash_list[i]),
+				&original_path) == 0 && original_path == trash_list[i].path)
 	{
-		return;
+		(void)trie_set(trash_index, trash_list[i].real_trash_name, NULL);
 	}
 
 	free_entry(&trash_list[i]);
@@ -976,14 +1333,18 @@ trash_prune_dead_entries(void)
 	{
 		if(!path_exists(trash_list[i].trash_name, NODEREF))
 		{
-			free(trash_list[i].path);
-			free(trash_list[i].trash_name);
+			free_entry(&trash_list[i]);
 			continue;
 		}
 
 		trash_list[j++] = trash_list[i];
 	}
-	trash_list_size = j;
+
+	if(j != trash_list_size)
+	{
+		trash_list_size = j;
+		rebuild_index();
+	}
 }
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -107,6 +107,10 @@ const char * trash_get_real_name_of(const char trash_path[]);
 /* Removes entries that correspond to nonexistent files in trashes. */
 void trash_prune_dead_entries(void);
 
+/* Removes entries of files that were removed by emptying trash directories.
+ * Entries outlive emptying in case it's cancelled. */
+void trash_prune_emptied_entries(void);
+
 TSTATIC_DEFS(
 	char **specs;
 	int nspecs;
@@ -20,7 +20,8 @@
 
 #include <assert.h> /* assert() */
 #include <stddef.h> /* NULL size_t */
-#include <stdlib.h> /* malloc() free() */
+#include <stdint.h> /* uint64_t uintptr_t */
+#include <stdlib.h> /* calloc() malloc() free() */
 #include <string.h> /* memmove() memset() strcpy() strdup() strlen() */
 
 #include "../compat/reallocarray.h"
@@ -32,15 +33,32 @@
 /* Character used to fill gaps in lines. */
 #define GAP_FILL_CHAR ' '
 
+/* Number of bits in index of a slot of cache of formatted values. */
+#define CACHE_BITS 10
+/* Number of slots in cache of formatted values. */
+#define CACHE_SIZE (1U << CACHE_BITS)
+
 /* Holds general column information. */
 typedef struct
 {
 	int column_id;    /* Unique column id. */
 	column_func func; /* Function, which prints column value. */
 	void *data;       /* Data to be passed to the function. */
+	int cached;       /* Whether values of the column can be cached. */
 }
 column_desc_t;
 
+/* Single formatted value of a column for a row. */
+typedef struct
+{
+	const void *key; /* Key of the row or NULL for an unused slot. */
+	uint64_t stamp;  /* Stamp of the row. */
+	size_t column;   /* Index of the column. */
+	char *value;     /* Formatted value. */
+	size_t width;    /* Screen width of the value. */
+}
+cache_slot_t;
+
 /* Column information including calculated values. */
 typedef struct
 {
@@ -58,21 +76,30 @@ struct columns_t
 	size_t max_width; /* Maximum width of one line of the view. */
 	size_t count;     /* Number of columns in the list. */
 	column_t *list;   /* Array of columns of count length. */
+	cache_slot_t *cache; /* Cache of values of CACHE_SIZE length or NULL. */
 };
 
+static int add_column_desc(int column_id, column_func func, void *data,
+		int cached);
 static int extend_column_desc_list(void);
 static void init_new_column_desc(column_desc_t *desc, int column_id,
-		column_func func, void *data);
+		column_func func, void *data, int cached);
 static int column_id_present(int column_id);
 static int extend_column_list(columns_t *cols);
 static void init_new_column(column_t *col, column_info_t info);
 static void mark_for_recalculation(columns_t *cols);
 static const column_desc_t * get_column_func(int column_id);
+static void format_line(columns_t *cols, void *format_data, const void *key,
+		uint64_t stamp, size_t max_line_width);
+static size_t format_value(columns_t *cols, size_t i, const void *key,
+		uint64_t stamp, const format_info_t *info, char buf[], size_t buf_len);
+static cache_slot_t * get_cache_slot(columns_t *cols, const void *key,
+		size_t i);
 static AlignType decorate_output(const column_t *col, char buf[],
-		size_t buf_len, size_t max_line_width);
+		size_t buf_len, size_t *width, size_t max_line_width);
 static size_t calculate_max_width(const column_t *col, size_t len,
 		size_t max_line_width);
-static size_t calculate_start_pos(const column_t *col, const char buf[],
+static size_t calculate_start_pos(const column_t *col, size_t width,
 		AlignType align);
 static void fill_gap_pos(void *format_data, size_t from, size_t to);
 static size_t get_width_on_screen(const char str[]);
@@ -107,10 +134,25 @@ columns_set_ellipsis(const char ell[])
 
 int
 columns_add_column_desc(int column_id, column_func func, void *data)
+{
+	return add_column_desc(column_id, func, data, 0);
+}
+
+int
+columns_add_cached_column_desc(int column_id, column_func func, void *data)
+{
+	return add_column_desc(column_id, func, data, 1);
+}
+
+/* Registers column func by its unique column_id.  Returns zero on success and
+ * non-zero otherwise. */
+static int
+add_column_desc(int column_id, column_func func, void *data, int cached)
 {
 	if(!column_id_present(column_id) && extend_column_desc_list() == 0)
 	{
-		init_new_column_desc(&col_descs[col_desc_count - 1], column_id, func, data);
+		init_new_column_desc(&col_descs[col_desc_count - 1], column_id, func, data,
+				cached);
 		return 0;
 	}
 	return 1;
@@ -135,11 +177,12 @@ extend_column_desc_list(void)
 /* Fills column description structure with initial values. */
 static void
 init_new_column_desc(column_desc_t *desc, int column_id, column_func func,
-		void *data)
+		void *data, int cached)
 {
 	desc->column_id = column_id;
 	desc->func = func;
 	desc->data = data;
+	desc->cached = cached;
 }
 
 columns_t *
@@ -152,6 +195,7 @@ columns_create(void)
 	}
 	result->count = 0;
 	result->list = NULL;
+	result->cache = NULL;
 	mark_for_recalculation(result);
 	return result;
 }
@@ -162,6 +206,7 @@ columns_free(columns_t *cols)
 	if(cols != NULL)
 	{
 		columns_clear(cols);
+		free(cols->cache);
 		free(cols);
 	}
 }
@@ -178,6 +223,29 @@ columns_clear(columns_t *cols)
 	free(cols->list);
 	cols->list = NULL;
 	cols->count = 0;
+
+	columns_drop_cache(cols);
+}
+
+void
+columns_drop_cache(columns_t *cols)
+{
+	if(cols->cache == NULL)
+	{
+		return;
+	}
+
+	size_t i;
+	for(i = 0U; i < CACHE_SIZE; ++i)
+	{
+		cache_slot_t *const slot = &cols->cache[i];
+		if(slot->key != NULL)
+		{
+			free(slot->value);
+			slot->value = NULL;
+			slot->key = NULL;
+		}
+	}
 }
 
 void
@@ -266,6 +334,10 @@ init_new_column(column_t *col, column_info_t info)
 	{
 		col->desc = *desc;
 	}
+	else
+	{
+		memset(&col->desc, 0, sizeof(col->desc));
+	}
 }
 
 /* Returns a pointer to column formatting function by the column id or NULL on
@@ -289,6 +361,21 @@ get_column_func(int column_id)
 
 void
 columns_format_line(columns_t *cols, void *format_data, size_t max_line_width)
+{
+	format_line(cols, format_data, NULL, 0U, max_line_width);
+}
+
+void
+columns_format_row(columns_t *cols, void *format_data, const void *key,
+		uint64_t stamp, size_t max_line_width)
+{
+	format_line(cols, format_data, key, stamp, max_line_width);
+}
+
+/* Performs actual formatting of columns using cache if key isn't NULL. */
+static void
+format_line(columns_t *cols, void *format_data, const void *key,
+		uint64_t stamp, size_t max_line_width)
 {
 	char prev_col_buf[1024 + 1];
 	size_t prev_col_start = 0UL;
@@ -314,19 +401,13 @@ columns_format_line(columns_t *cols, void *format_data, size_t max_line_width)
 			.width = col->print_width,
 		};
 
-		if(col->info.literal == NULL)
-		{
-			col->desc.func(col->desc.data, sizeof(col_buffer), col_buffer, &info);
-		}
-		else
-		{
-			copy_str(col_buffer, sizeof(col_buffer), col->info.literal);
-		}
+		size_t width = format_value(cols, i, key, stamp, &info, col_buffer,
+				sizeof(col_buffer));
 
 		strcpy(full_column, col_buffer);
-		align = decorate_output(col, col_buffer, sizeof(col_buffer),
+		align = decorate_output(col, col_buffer, sizeof(col_buffer), &width,
 				max_line_width);
-		cur_col_start = calculate_start_pos(col, col_buffer, align);
+		cur_col_start = calculate_start_pos(col, width, align);
 
 		/* Ensure that we are not trying to draw current column in the middle of a
 		 * character inside previous column. */
@@ -348,7 +429,7 @@ columns_format_line(columns_t *cols, void *format_data, size_t max_line_width)
 
 		print_func(col_buffer, cur_col_start, align, full_column, &info);
 
-		prev_col_end = cur_col_start + get_width_on_screen(col_buffer);
+		prev_col_end = cur_col_start + width;
 
 		/* Store information about the current column for usage on the next
 		 * iteration. */
@@ -359,13 +440,78 @@ columns_format_line(columns_t *cols, void *format_data, size_t max_line_width)
 	fill_gap_pos(format_data, prev_col_end, max_line_width);
 }
 
-/* Adds decorations like ellipsis to the output.  Returns actual align type used
- * for the column (might not match col->info.align). */
+/* Fills the buffer with value of ith column either by formatting it or by
+ * retrieving it from the cache.  Returns screen width of the value. */
+static size_t
+format_value(columns_t *cols, size_t i, const void *key, uint64_t stamp,
+		const format_info_t *info, char buf[], size_t buf_len)
+{
+	const column_t *const col = &cols->list[i];
+
+	if(col->info.literal != NULL)
+	{
+		copy_str(buf, buf_len, col->info.literal);
+		return get_width_on_screen(buf);
+	}
+
+	cache_slot_t *const slot = (key != NULL && col->desc.cached)
+	                         ? get_cache_slot(cols, key, i)
+	                         : NULL;
+	if(slot != NULL && slot->key == key && slot->column == i &&
+			slot->stamp == stamp)
+	{
+		copy_str(buf, buf_len, slot->value);
+		return slot->width;
+	}
+
+	col->desc.func(col->desc.data, buf_len, buf, info);
+	const size_t width = get_width_on_screen(buf);
+
+	if(slot != NULL)
+	{
+		char *const value = strdup(buf);
+		if(value != NULL)
+		{
+			free(slot->value);
+			slot->key = key;
+			slot->stamp = stamp;
+			slot->column = i;
+			slot->value = value;
+			slot->width = width;
+		}
+	}
+
+	return width;
+}
+
+/* Finds cache slot for ith column of a row allocating the cache on first use.
+ * Returns the slot, which might be occupied by another value, or NULL on memory
+ * error. */
+static cache_slot_t *
+get_cache_slot(columns_t *cols, const void *key, size_t i)
+{
+	if(cols->cache == NULL)
+	{
+		cols->cache = calloc(CACHE_SIZE, sizeof(*cols->cache));
+		if(cols->cache == NULL)
+		{
+			return NULL;
+		}
+	}
+
+	/* Multiplicative hashing, which takes highest bits of the product. */
+	const uint64_t hash = ((uint64_t)(uintptr_t)key*31U + i)*0x9e3779b97f4a7c15ULL;
+	return &cols->cache[hash >> (64 - CACHE_BITS)];
+}
+
+/* Adds decorations like ellipsis to the output.  Updates the width of the buffer
+ * if it changes.  Returns actual align type used for the column (might not
+ * match col->info.align). */
 static AlignType
-decorate_output(const column_t *col, char buf[], size_t buf_len,
+decorate_output(const column_t *col, char buf[], size_t buf_len, size_t *width,
 		size_t max_line_width)
 {
-	const size_t len = get_width_on_screen(buf);
+	const size_t len = *width;
 	const size_t max_col_width = calculate_max_width(col, len, max_line_width);
 	const int too_long = len > max_col_width;
 	AlignType result;
@@ -392,6 +538,7 @@ decorate_output(const column_t *col, char buf[], size_t buf_len,
 	copy_str(buf, buf_len, ellipsed);
 	free(ellipsed);
 
+	*width = get_width_on_screen(buf);
 	return result;
 }
 
@@ -411,9 +558,10 @@ calculate_max_width(const column_t *col, size_t len, size_t max_line_width)
 	}
 }
 
-/* Calculates start position for outputting content of the col. */
+/* Calculates start position for outputting content of the col, whose screen
+ * width is specified. */
 static size_t
-calculate_start_pos(const column_t *col, const char buf[], AlignType align)
+calculate_start_pos(const column_t *col, size_t width, AlignType align)
 {
 	if(align == AT_LEFT)
 	{
@@ -422,8 +570,7 @@ calculate_start_pos(const column_t *col, const char buf[], AlignType align)
 	else
 	{
 		const size_t end = col->start + col->width;
-		const size_t len = get_width_on_screen(buf);
-		return (end > len && align == AT_RIGHT) ? (end - len) : 0;
+		return (end > width && align == AT_RIGHT) ? (end - width) : 0;
 	}
 }
 
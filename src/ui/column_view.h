@@ -20,6 +20,7 @@
 #define VIFM__UI__COLUMN_VIEW_H__
 
 #include <stddef.h> /* size_t */
+#include <stdint.h> /* uint64_t */
 
 /* Special reserved column id for gap filling request. */
 #define FILL_COLUMN_ID ~0
@@ -97,6 +98,12 @@ void columns_set_ellipsis(const char ell[]);
  * Returns zero on success and non-zero otherwise. */
 int columns_add_column_desc(int column_id, column_func func, void *data);
 
+/* Same as columns_add_column_desc(), but values produced by the func are cached
+ * by columns_format_row() and thus must depend only on the row.  Returns zero
+ * on success and non-zero otherwise. */
+int columns_add_cached_column_desc(int column_id, column_func func,
+		void *data);
+
 /* Unregisters all column functions. */
 void columns_clear_column_descs(void);
 
@@ -117,6 +124,16 @@ void columns_clear(columns_t *cols);
 void columns_format_line(columns_t *cols, void *format_data,
 		size_t max_line_width);
 
+/* Same as columns_format_line(), but reuses values of cached columns formatted
+ * for the same row earlier.  A row is identified by its key (must be unique
+ * among existing rows) and stamp (must change when values of the row might
+ * change). */
+void columns_format_row(columns_t *cols, void *format_data, const void *key,
+		uint64_t stamp, size_t max_line_width);
+
+/* Forgets values cached by columns_format_row(). */
+void columns_drop_cache(columns_t *cols);
+
 /* Checks if recalculation is needed.  Returns non-zero if so, otherwise zero is
  * returned. */
 int columns_matches_width(const columns_t *cols, size_t max_width);
@@ -49,6 +49,7 @@
 #include "../flist_pos.h"
 #include "../opt_handlers.h"
 #include "../sort.h"
+#include "../trace.h"
 #include "../vifm.h"
 #include "color_scheme.h"
 #include "column_view.h"
@@ -72,6 +73,7 @@ static int count_digits(int num);
 static int calculate_top_position(view_t *view, int top);
 static int get_line_color(const view_t *view, const dir_entry_t *entry);
 static void draw_cell(columns_t *columns, column_data_t *cdt, size_t col_width);
+static uint64_t get_entry_stamp(const dir_entry_t *entry);
 static columns_t * get_view_columns(const view_t *view, int truncated);
 static columns_t * get_name_column(int truncated);
 static void consider_scroll_bind(view_t *view);
@@ -150,35 +152,36 @@ fview_setup(void)
 	static const struct {
 		SortingKey key;
 		column_func func;
+		int cached;
 	} sort_to_func[] = {
-		{ SK_BY_NAME,   &format_name },
-		{ SK_BY_INAME,  &format_name },
-		{ SK_BY_SIZE,   &format_size },
-		{ SK_BY_NITEMS, &format_nitems },
-		{ SK_BY_GROUPS, &format_primary_group },
-		{ SK_BY_TYPE,   &format_type },
-		{ SK_BY_TARGET, &format_target },
-
-		{ SK_BY_EXTENSION,     &format_ext },
-		{ SK_BY_FILEEXT,       &format_fileext },
-		{ SK_BY_TIME_ACCESSED, &format_time },
-		{ SK_BY_TIME_CHANGED,  &format_time },
-		{ SK_BY_TIME_MODIFIED, &format_time },
-		{ SK_BY_DIR,           &format_dir },
+		{ SK_BY_NAME,   &format_name,          0 },
+		{ SK_BY_INAME,  &format_name,          0 },
+		{ SK_BY_SIZE,   &format_size,          0 },
+		{ SK_BY_NITEMS, &format_nitems,        0 },
+		{ SK_BY_GROUPS, &format_primary_group, 0 },
+		{ SK_BY_TYPE,   &format_type,          1 },
+		{ SK_BY_TARGET, &format_target,        1 },
+
+		{ SK_BY_EXTENSION,     &format_ext,     0 },
+		{ SK_BY_FILEEXT,       &format_fileext, 0 },
+		{ SK_BY_TIME_ACCESSED, &format_time,    1 },
+		{ SK_BY_TIME_CHANGED,  &format_time,    1 },
+		{ SK_BY_TIME_MODIFIED, &format_time,    1 },
+		{ SK_BY_DIR,           &format_dir,     1 },
 
 #ifndef _WIN32
-		{ SK_BY_GROUP_ID,   &format_group },
-		{ SK_BY_GROUP_NAME, &format_group },
-		{ SK_BY_OWNER_ID,   &format_owner },
-		{ SK_BY_OWNER_NAME, &format_owner },
+		{ SK_BY_GROUP_ID,   &format_group, 1 },
+		{ SK_BY_GROUP_NAME, &format_group, 1 },
+		{ SK_BY_OWNER_ID,   &format_owner, 1 },
+		{ SK_BY_OWNER_NAME, &format_owner, 1 },
 
-		{ SK_BY_MODE, &format_mode },
+		{ SK_BY_MODE, &format_mode, 1 },
 
-		{ SK_BY_PERMISSIONS, &format_perms },
+		{ SK_BY_PERMISSIONS, &format_perms, 1 },
 
-		{ SK_BY_NLINKS, &format_nlinks },
+		{ SK_BY_NLINKS, &format_nlinks, 1 },
 
-		{ SK_BY_INODE, &format_inode },
+		{ SK_BY_INODE, &format_inode, 1 },
 #endif
 	};
 	ARRAY_GUARD(sort_to_func, SK_COUNT);
@@ -188,7 +191,15 @@ fview_setup(void)
 	columns_set_line_print_func(&column_line_print);
 	for(i = 0U; i < ARRAY_LEN(sort_to_func); ++i)
 	{
-		columns_add_column_desc(sort_to_func[i].key, sort_to_func[i].func, NULL);
+		if(sort_to_func[i].cached)
+		{
+			columns_add_cached_column_desc(sort_to_func[i].key, sort_to_func[i].func,
+					NULL);
+		}
+		else
+		{
+			columns_add_column_desc(sort_to_func[i].key, sort_to_func[i].func, NULL);
+		}
 	}
 	columns_add_column_desc(SK_BY_ID, &format_id, NULL);
 	columns_add_column_desc(SK_BY_ROOT, &format_name, NULL);
@@ -279,6 +290,8 @@ draw_dir_list_only(view_t *view)
 		return;
 	}
 
+	const long long start = trace_begin();
+
 	calculate_table_conf(view, &col_count, &col_width);
 
 	ui_view_title_update(view);
@@ -332,6 +345,8 @@ draw_dir_list_only(view_t *view)
 	ui_view_win_changed(view);
 
 	ui_view_redrawn(view);
+
+	trace_end(TP_DRAW_VIEW, start);
 }
 
 /* Draws a column to the left of the main part of the view. */
@@ -699,7 +714,13 @@ draw_cell(columns_t *columns, column_data_t *cdt, size_t col_width)
 		column_line_print(" ", -1, AT_LEFT, " ", &info);
 	}
 
-	columns_format_line(columns, cdt, MIN(col_width, width_left));
+	/* Name of an entry is unique while the entry exists, which makes it a good
+	 * key for caching values of columns.  Cached columns depend only on data
+	 * that's part of the stamp, so reuse of a freed name is harmless.  Fake
+	 * entries (not from a list) aren't cached. */
+	const void *key = (cdt->line_pos < 0 ? NULL : cdt->entry->name);
+	columns_format_row(columns, cdt, key, get_entry_stamp(cdt->entry),
+			MIN(col_width, width_left));
 
 	if(cfg.extra_padding && width_left >= col_width)
 	{
@@ -707,6 +728,27 @@ draw_cell(columns_t *columns, column_data_t *cdt, size_t col_width)
 	}
 }
 
+/* Computes value that changes along with properties of the entry which affect
+ * how its columns are displayed.  Returns the value. */
+static uint64_t
+get_entry_stamp(const dir_entry_t *entry)
+{
+	uint64_t stamp = (uint64_t)entry->mtime;
+	stamp = stamp*31U + (uint64_t)entry->atime;
+	stamp = stamp*31U + (uint64_t)entry->ctime;
+	stamp = stamp*31U + entry->type;
+#ifndef _WIN32
+	stamp = stamp*31U + (uint64_t)entry->inode;
+	stamp = stamp*31U + entry->mode;
+	stamp = stamp*31U + entry->uid;
+	stamp = stamp*31U + entry->gid;
+	stamp = stamp*31U + (uint64_t)entry->nlinks;
+#else
+	stamp = stamp*31U + entry->attrs;
+#endif
+	return stamp;
+}
+
 /* Retrieves active view columns handle of the view considering 'lsview' option
  * status.  Returns the handle. */
 static columns_t *
@@ -1879,6 +1921,8 @@ fview_list_updated(view_t *view)
 {
 	/* Invalidate maximum file name widths cache. */
 	view->max_filename_width = 0;
+	/* Values cached for previous entries won't be used anymore. */
+	fview_formats_updated(view);
 	/* Even if position will remain the same, we might need to redraw it. */
 	invalidate_cursor_pos_cache(view);
 }
@@ -1890,6 +1934,15 @@ fview_decors_updated(view_t *view)
 	view->max_filename_width = 0;
 }
 
+void
+fview_formats_updated(view_t *view)
+{
+	if(view->columns != NULL)
+	{
+		columns_drop_cache(view->columns);
+	}
+}
+
 /* Evaluates number of columns in the view.  Returns the number. */
 static size_t
 calculate_columns_count(view_t *view)
@@ -1938,7 +1991,11 @@ get_filename_width(const view_t *view, int i)
 	}
 	else
 	{
-		name_len = utf8_strsw(entry->name);
+		if(entry->name_width == 0)
+		{
+			((dir_entry_t *)entry)->name_width = utf8_strsw(entry->name);
+		}
+		name_len = entry->name_width;
 	}
 	return name_len + get_filetype_decoration_width(entry);
 }
@@ -160,6 +160,10 @@ void fview_list_updated(struct view_t *view);
  * decorations of files change. */
 void fview_decors_updated(struct view_t *view);
 
+/* Callback-like function which triggers some view-specific updates after format
+ * of values displayed in columns changes. */
+void fview_formats_updated(struct view_t *view);
+
 /* Callback-like function which triggers some view-specific updates after cursor
  * position in the list changed. */
 void fview_position_updated(struct view_t *view);
@@ -20,14 +20,16 @@
 #include "quickview.h"
 
 #include <curses.h> /* mvwaddstr() */
+#include <sys/stat.h> /* stat */
+#include <dirent.h> /* DIR dirent */
 #include <unistd.h> /* usleep() */
 
 #include <limits.h> /* INT_MAX */
 #include <stddef.h> /* NULL size_t */
-#include <stdio.h> /* FILE SEEK_SET fclose() fdopen() feof() fseek()
-                      tmpfile() */
-#include <stdlib.h> /* free() */
-#include <string.h> /* strcat() strlen() strncat() */
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* FILE fclose() fprintf() */
+#include <stdlib.h> /* free() malloc() */
+#include <string.h> /* strcat() strdup() strlen() strncat() */
 
 #include "../cfg/config.h"
 #include "../compat/fs_limits.h"
@@ -46,6 +48,7 @@
 #include "../utils/utils.h"
 #include "../filelist.h"
 #include "../filetype.h"
+#include "../background.h"
 #include "../macros.h"
 #include "../status.h"
 #include "../types.h"
@@ -80,7 +83,9 @@ quickview_cache_t;
 /* State of directory tree print functions. */
 typedef struct
 {
-	FILE *fp;          /* Output preview stream. */
+	strlist_t lines;   /* Printed lines. */
+	char *line;        /* Line that's being printed or NULL. */
+	size_t line_len;   /* Length of the line. */
 	int n;             /* Current line number (zero based). */
 	int ndirs;         /* Number of seen directories. */
 	int nfiles;        /* Number of seen files. */
@@ -88,9 +93,25 @@ typedef struct
 	int full_stats;    /* Collect statistics for the whole tree. */
 	int depth;         /* Current depth of the traversal. */
 	char prefix[4096]; /* Prefix character for each tree level. */
+
+	/* Entries after the line limit, which weren't classified for statistics. */
+	strlist_t pending_entries;
+	/* Directories after the line limit, whose contents wasn't counted. */
+	strlist_t pending_dirs;
 }
 tree_print_state_t;
 
+/* State of counting statistics of a tree, which might happen in background. */
+typedef struct
+{
+	strlist_t entries; /* Entries to count along with their subtrees. */
+	strlist_t dirs;    /* Directories to count contents of. */
+	int ndirs;         /* Number of seen directories. */
+	int nfiles;        /* Number of seen files. */
+	bg_op_t *bg_op;    /* Cancellation source or NULL for the main thread. */
+}
+tree_stats_t;
+
 static const char * view_entry(const dir_entry_t *entry,
 		const preview_area_t *parea, quickview_cache_t *cache);
 static const char * view_file(const char path[], const preview_area_t *parea,
@@ -101,9 +122,14 @@ static void update_cache(quickview_cache_t *cache, const char path[],
 		const char viewer[], ViewerKind kind, const preview_area_t *parea,
 		int max_lines);
 static strlist_t get_lines(const quickview_cache_t *cache);
-static void print_tree_stats(tree_print_state_t *s);
+static void free_tree_print_state(tree_print_state_t *s);
+static char * format_tree_stats(int ndirs, int nfiles, int partial);
+static void count_stats_task(bg_op_t *bg_op, FILE *out, void *arg);
+static void count_stats(tree_stats_t *stats);
+static int stats_cancelled(const tree_stats_t *stats);
+static void free_tree_stats(tree_stats_t *stats);
 static int print_dir_tree(tree_print_state_t *s, const char path[], int last);
-static void collect_subtree_stats(tree_print_state_t *s, const char path[]);
+static void collect_subtree_stats(tree_stats_t *stats, const char path[]);
 static int enter_dir(tree_print_state_t *s, const char path[], int last);
 static int visit_file(tree_print_state_t *s, const char path[], int last);
 static int visit_link(tree_print_state_t *s, const char path[], int last,
@@ -115,6 +141,8 @@ static void set_prefix_char(tree_print_state_t *s, char c);
 static void print_tree_entry(tree_print_state_t *s, const char path[],
 		int end_line);
 static void print_entry_prefix(tree_print_state_t *s);
+static void print_str(tree_print_state_t *s, const char str[]);
+static void finish_line(tree_print_state_t *s);
 static void draw_lines(const strlist_t *lines, int wrapped,
 		const preview_area_t *parea, ViewerKind kind);
 static void write_message(const char msg[], const preview_area_t *parea);
@@ -451,19 +479,11 @@ get_lines(const quickview_cache_t *cache)
 	return lines;
 }
 
-FILE *
-qv_view_dir(const char path[], int max_lines)
+int
+qv_view_dir(const char path[], int max_lines, strlist_t *lines,
+		bg_job_t **stats_job)
 {
-	enum { NSPACES = 64 };
-
-	FILE *fp = os_tmpfile();
-	if(fp == NULL)
-	{
-		return NULL;
-	}
-
 	tree_print_state_t s = {
-		.fp = fp,
 		/* Increase by one to cause cached data to be recognized as incomplete
 		 * when max_lines isn't enough. */
 		.max = (max_lines == INT_MAX ? max_lines : max_lines + 1),
@@ -471,48 +491,167 @@ qv_view_dir(const char path[], int max_lines)
 		.n = (cfg.top_tree_stats ? 2 : 0),
 	};
 
-	/* Spare blank line on the top of the view to put the (files, directories)
-	 * count in case "toptreestats" option is set. */
-	fprintf(fp, "%*s\n", NSPACES, "");
+	*lines = (strlist_t){};
+	*stats_job = NULL;
 
-	const int whole_tree = (print_dir_tree(&s, path, 0) == 0 && s.n != 0);
-	if(!whole_tree && ui_cancellation_requested())
+	if(cfg.top_tree_stats)
 	{
-		fputs("(cancelled)", fp);
+		/* Reserve the first line for statistics and the second one for a spacer
+		 * or a notice about cancellation. */
+		s.lines.nitems = add_to_string_array(&s.lines.items, s.lines.nitems, "");
+		s.lines.nitems = add_to_string_array(&s.lines.items, s.lines.nitems, "");
 	}
 
+	const int whole_tree = (print_dir_tree(&s, path, 0) == 0 && s.n != 0);
 	if(s.n == 0)
 	{
-		fclose(fp);
-		return NULL;
+		free_tree_print_state(&s);
+		return 1;
+	}
+
+	const int cancelled = (!whole_tree && ui_cancellation_requested());
+	const int pending = (s.pending_entries.nitems != 0 ||
+	                     s.pending_dirs.nitems != 0);
+
+	tree_stats_t *stats = NULL;
+	if(pending && !cancelled)
+	{
+		stats = malloc(sizeof(*stats));
+	}
+
+	if(stats != NULL)
+	{
+		*stats = (tree_stats_t) {
+			.entries = s.pending_entries,
+			.dirs = s.pending_dirs,
+			.ndirs = s.ndirs,
+			.nfiles = s.nfiles,
+		};
+		s.pending_entries = (strlist_t){};
+		s.pending_dirs = (strlist_t){};
+
+		*stats_job = bg_execute_capture("Counting files of tree preview",
+				&count_stats_task, stats);
+		if(*stats_job == NULL)
+		{
+			/* Fall back to counting right away. */
+			count_stats(stats);
+			s.ndirs = stats->ndirs;
+			s.nfiles = stats->nfiles;
+			free_tree_stats(stats);
+		}
 	}
 
+	char *const stats_line = format_tree_stats(s.ndirs, s.nfiles,
+			*stats_job != NULL);
+	const char *const notice = (cancelled ? "(cancelled)" : "");
 	if(cfg.top_tree_stats)
 	{
-		/* Print count on the top, spare line. */
-		fseek(fp, 0, SEEK_SET);
-		print_tree_stats(&s);
-		fseek(fp, 0, SEEK_SET);
+		replace_string(&s.lines.items[0], stats_line);
+		replace_string(&s.lines.items[1], notice);
 	}
 	else
 	{
-		/* Print count at the bottom and "hide" the spare line away. */
-		fputs("\n", fp);
-		print_tree_stats(&s);
-		fseek(fp, NSPACES + 1, SEEK_SET);
+		s.lines.nitems = add_to_string_array(&s.lines.items, s.lines.nitems,
+				notice);
+		s.lines.nitems = add_to_string_array(&s.lines.items, s.lines.nitems,
+				stats_line);
+	}
+	free(stats_line);
+
+	*lines = s.lines;
+	s.lines = (strlist_t){};
+	free_tree_print_state(&s);
+	return 0;
+}
+
+/* Frees resources of tree print state. */
+static void
+free_tree_print_state(tree_print_state_t *s)
+{
+	free_string_array(s->lines.items, s->lines.nitems);
+	free(s->line);
+	free_string_array(s->pending_entries.items, s->pending_entries.nitems);
+	free_string_array(s->pending_dirs.items, s->pending_dirs.nitems);
+}
+
+/* Formats one-line tree statistics, which are lower bounds of the counts if
+ * partial is non-zero.  Returns newly allocated string. */
+static char *
+format_tree_stats(int ndirs, int nfiles, int partial)
+{
+	if(partial)
+	{
+		return format_str("%d+ directories, %d+ files", ndirs, nfiles);
+	}
+
+	return format_str("%d director%s, %d file%s", ndirs,
+			(ndirs == 1) ? "y" : "ies", nfiles, (nfiles == 1) ? "" : "s");
+}
+
+/* Entry point of a background task that finishes counting statistics of a tree
+ * and prints them. */
+static void
+count_stats_task(bg_op_t *bg_op, FILE *out, void *arg)
+{
+	tree_stats_t *const stats = arg;
+	stats->bg_op = bg_op;
+
+	count_stats(stats);
+	if(!bg_op_cancelled(bg_op))
+	{
+		char *const line = format_tree_stats(stats->ndirs, stats->nfiles, 0);
+		fprintf(out, "%s\n", line);
+		free(line);
+	}
+
+	free_tree_stats(stats);
+}
+
+/* Counts entries that were left out of statistics while printing a tree. */
+static void
+count_stats(tree_stats_t *stats)
+{
+	int i;
+	for(i = 0; i < stats->entries.nitems && !stats_cancelled(stats); ++i)
+	{
+		const char *const path = stats->entries.items[i];
+		if(is_symlink(path))
+		{
+			++stats->nfiles;
+		}
+		else if(is_dir(path))
+		{
+			++stats->ndirs;
+			collect_subtree_stats(stats, path);
+		}
+		else
+		{
+			++stats->nfiles;
+		}
+	}
+
+	for(i = 0; i < stats->dirs.nitems && !stats_cancelled(stats); ++i)
+	{
+		collect_subtree_stats(stats, stats->dirs.items[i]);
 	}
+}
 
-	return fp;
+/* Checks whether counting should stop.  Returns non-zero if so. */
+static int
+stats_cancelled(const tree_stats_t *stats)
+{
+	return (stats->bg_op == NULL ? ui_cancellation_requested()
+	                             : bg_op_cancelled(stats->bg_op));
 }
 
-/* Prints one-line tree statistics. */
+/* Frees statistics counting state. */
 static void
-print_tree_stats(tree_print_state_t *s)
+free_tree_stats(tree_stats_t *stats)
 {
-	fprintf(s->fp, "%s%d director%s, %d file%s\n",
-			ui_cancellation_requested() ? "(cancelled)\n" : "",
-			s->ndirs, (s->ndirs == 1) ? "y" : "ies",
-			s->nfiles, (s->nfiles == 1) ? "" : "s");
+	free_string_array(stats->entries.items, stats->entries.nitems);
+	free_string_array(stats->dirs.items, stats->dirs.nitems);
+	free(stats);
 }
 
 /* Produces tree preview of the path.  Returns non-zero to request stopping of
@@ -530,7 +669,11 @@ print_dir_tree(tree_print_state_t *s, const char path[], int last)
 	if(enter_dir(s, path, last) != 0)
 	{
 		free_string_array(lst, len);
-		collect_subtree_stats(s, path);
+		if(s->full_stats)
+		{
+			s->pending_dirs.nitems = add_to_string_array(&s->pending_dirs.items,
+					s->pending_dirs.nitems, path);
+		}
 		return 1;
 	}
 
@@ -593,23 +736,13 @@ print_dir_tree(tree_print_state_t *s, const char path[], int last)
 
 	if(reached_limit && s->full_stats)
 	{
-		for(; i < len && !ui_cancellation_requested(); ++i)
+		/* Classifying the rest of entries requires querying file system, so leave
+		 * it for later. */
+		for(; i < len; ++i)
 		{
 			char *const full_path = format_str("%s/%s", path, lst[i]);
-			if(is_symlink(full_path))
-			{
-				++s->nfiles;
-			}
-			else if(is_dir(full_path))
-			{
-				++s->ndirs;
-				collect_subtree_stats(s, full_path);
-			}
-			else
-			{
-				++s->nfiles;
-			}
-			free(full_path);
+			s->pending_entries.nitems = put_into_string_array(
+					&s->pending_entries.items, s->pending_entries.nitems, full_path);
 		}
 	}
 
@@ -620,9 +753,10 @@ print_dir_tree(tree_print_state_t *s, const char path[], int last)
 }
 
 /* Collects stats for items of a directory in a much faster way than traversal
- * for printing. */
+ * for printing.  Number of items in each directory is stored in dcache, so
+ * file lists can display it without listing directories again. */
 static void
-collect_subtree_stats(tree_print_state_t *s, const char path[])
+collect_subtree_stats(tree_stats_t *stats, const char path[])
 {
 	DIR *dir = os_opendir(path);
 	if(dir == NULL)
@@ -630,6 +764,7 @@ collect_subtree_stats(tree_print_state_t *s, const char path[])
 		return;
 	}
 
+	uint64_t nitems = 0;
 	struct dirent *d;
 	while((d = os_readdir(dir)) != NULL)
 	{
@@ -638,23 +773,34 @@ collect_subtree_stats(tree_print_state_t *s, const char path[])
 			continue;
 		}
 
+		++nitems;
+
 		char *const full_path = format_str("%s/%s", path, d->d_name);
 		if(entry_is_dir(full_path, d))
 		{
-			++s->ndirs;
-			collect_subtree_stats(s, full_path);
+			++stats->ndirs;
+			if(!stats_cancelled(stats))
+			{
+				collect_subtree_stats(stats, full_path);
+			}
 		}
 		else if(is_dirent_targets_dir(full_path, d))
 		{
-			++s->ndirs;
+			++stats->ndirs;
 		}
 		else
 		{
-			++s->nfiles;
+			++stats->nfiles;
 		}
 		free(full_path);
 	}
 	os_closedir(dir);
+
+	struct stat st;
+	if(os_stat(path, &st) == 0)
+	{
+		(void)dcache_set_at(path, st.st_ino, DCACHE_UNKNOWN, nitems);
+	}
 }
 
 /* Handles entering directory on directory tree traversal.  Returns non-zero to
@@ -695,9 +841,9 @@ visit_link(tree_print_state_t *s, const char path[], int last,
 {
 	set_prefix_char(s, last ? '`' : '|');
 	print_tree_entry(s, path, 0);
-	fputs(" -> ", s->fp);
-	fputs(target, s->fp);
-	fputc('\n', s->fp);
+	print_str(s, " -> ");
+	print_str(s, target);
+	finish_line(s);
 
 	return (++s->n >= s->max);
 }
@@ -743,14 +889,14 @@ static void
 print_tree_entry(tree_print_state_t *s, const char path[], int end_line)
 {
 	print_entry_prefix(s);
-	fputs(get_last_path_component(path), s->fp);
+	print_str(s, get_last_path_component(path));
 	if(is_dir(path) && !ends_with_slash(path))
 	{
-		fputc('/', s->fp);
+		print_str(s, "/");
 	}
 	if(end_line)
 	{
-		fputc('\n', s->fp);
+		finish_line(s);
 	}
 }
 
@@ -763,12 +909,35 @@ print_entry_prefix(tree_print_state_t *s)
 	/* Expand " |`" into "    |   `-- ". */
 	while(p[0] != '\0')
 	{
-		fputc(p[0], s->fp);
-		fputs(p[1] == '\0' ? "-- " : "   ", s->fp);
+		(void)strappendch(&s->line, &s->line_len, p[0]);
+		print_str(s, p[1] == '\0' ? "-- " : "   ");
 		++p;
 	}
 }
 
+/* Appends string to the line that's being printed. */
+static void
+print_str(tree_print_state_t *s, const char str[])
+{
+	(void)strappend(&s->line, &s->line_len, str);
+}
+
+/* Finishes the line that's being printed. */
+static void
+finish_line(tree_print_state_t *s)
+{
+	char *const line = (s->line == NULL ? strdup("") : s->line);
+	const int len = s->lines.nitems;
+	s->lines.nitems = put_into_string_array(&s->lines.items, len, line);
+	if(s->lines.nitems == len)
+	{
+		free(line);
+	}
+
+	s->line = NULL;
+	s->line_len = 0U;
+}
+
 /* Displays lines in the other pane.  The wrapped parameter determines whether
  * lines should be wrapped. */
 static void
@@ -21,11 +21,12 @@
 #define VIFM__UI__QUICKVIEW_H__
 
 #include <stddef.h> /* size_t */
-#include <stdio.h> /* FILE */
 
+#include "../utils/string_array.h"
 #include "../macros.h"
 #include "colors.h"
 
+struct bg_job_t;
 struct dir_entry_t;
 struct view_t;
 
@@ -82,9 +83,12 @@ void qv_cleanup_area(const preview_area_t *parea, const char cmd[]);
  * string stored internally. */
 const char * qv_get_viewer(const char path[]);
 
-/* Previews directory, actual preview is to be read from returned stream.
- * Returns the stream or NULL on error. */
-FILE * qv_view_dir(const char path[], int max_lines);
+/* Builds tree preview of a directory in memory.  If statistics of the tree
+ * take long to count, it's done in background and *stats_job is set to a job
+ * which outputs final version of the first line, otherwise *stats_job is set to
+ * NULL.  Returns zero on success, otherwise non-zero is returned. */
+int qv_view_dir(const char path[], int max_lines, strlist_t *lines,
+		struct bg_job_t **stats_job);
 
 /* Decides on path that should be explored when cursor points to the given
  * entry. */
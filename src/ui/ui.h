@@ -235,6 +235,7 @@ struct dir_entry_t
 	                     INT_MAX signifies absence of a match. */
 	int name_dec_num; /* File decoration parameters cache (initially -1).  The
 	                     value is shifted by one, 0 means no type decoration. */
+	int name_width;   /* Screen width of the name cache, 0 if not computed. */
 
 	int child_count; /* Number of child entries (all, not just direct). */
 	int child_pos;   /* Position of this entry in among children of its parent.
@@ -315,6 +316,12 @@ struct cv_data_t
 	/* Names of files in custom view while it's being composed.  Used for
 	 * duplicate elimination during construction of custom list. */
 	struct trie_t *paths_cache;
+
+	/* Source of entries that are still being added to the list or NULL. */
+	struct flist_stream_t *stream;
+
+	/* Listing of subtrees that are yet to be added to tree-view or NULL. */
+	struct tree_unfold_t *unfolding;
 };
 
 /* Various parameters related to local filter. */
@@ -335,6 +342,14 @@ struct local_filter_t
 	size_t unfiltered_count;
 	/* Number of entries filtered in other ways. */
 	size_t prefiltered_count;
+	/* Flags for elements of the unfiltered array that are set for entries which
+	 * didn't pass the last applied filter. */
+	char *rejected;
+	/* Value of the last applied filter or NULL if the rejected array isn't
+	 * valid. */
+	char *rejected_by;
+	/* Compilation flags of the last applied filter. */
+	int rejected_cflags;
 
 	/* List of previous cursor positions in the unfiltered array. */
 	int *poshist;
@@ -391,6 +406,8 @@ struct view_t
 	int matches;
 	/* Last used search pattern, empty if none. */
 	char last_search[NAME_MAX + 1];
+	/* Flags with which last search pattern was compiled. */
+	int last_search_cflags;
 
 	int hide_dot, hide_dot_g; /* Whether dot files are hidden. */
 	int prev_invert;
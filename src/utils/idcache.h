@@ -0,0 +1,64 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__IDCACHE_H__
+#define VIFM__UTILS__IDCACHE_H__
+
+#include <stddef.h> /* size_t */
+
+#include "test_helpers.h"
+
+/* This unit maps user and group ids to their names.  Looking up a name can
+ * involve a network request (LDAP, NIS, etc.), so results (including missing
+ * ids) are cached for a while and ids are resolved on a background thread while
+ * their numbers are used as placeholders. */
+
+/* Kind of an id. */
+typedef enum
+{
+	IK_USER,  /* User id. */
+	IK_GROUP, /* Group id. */
+}
+IdKind;
+
+/* Retrieves name of the id or its number if the name isn't known yet, in which
+ * case the id is queued for resolution.  Ids without a name are represented by
+ * their numbers as well.  Returns non-zero if the buffer contains a
+ * placeholder, otherwise zero is returned. */
+int idcache_get(IdKind kind, unsigned long id, char buf[], size_t buf_len);
+
+/* Queues resolution of the id unless its name is already known. */
+void idcache_request(IdKind kind, unsigned long id);
+
+/* Makes sure that name of the id is known by resolving it synchronously if
+ * necessary. */
+void idcache_resolve(IdKind kind, unsigned long id);
+
+/* Checks whether new names became available since the last call.  Returns
+ * non-zero if so, otherwise zero is returned. */
+int idcache_check(void);
+
+TSTATIC_DEFS(
+	void idcache_wait(void);
+	void idcache_reset(int positive_ttl, int negative_ttl);
+)
+
+#endif /* VIFM__UTILS__IDCACHE_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,445 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "idcache.h"
+
+#include <grp.h> /* getgrgid_r() group */
+#include <pthread.h> /* PTHREAD_* pthread_* */
+#include <pwd.h> /* getpwuid_r() passwd */
+#include <unistd.h> /* _SC_GETGR_R_SIZE_MAX _SC_GETPW_R_SIZE_MAX sysconf() */
+
+#include <stdio.h> /* snprintf() */
+#include <stdlib.h> /* free() malloc() */
+#include <string.h> /* strdup() */
+#include <time.h> /* time() time_t */
+
+#include "../compat/fs_limits.h"
+#include "darray.h"
+#include "macros.h"
+#include "str.h"
+#include "trie.h"
+#include "utils.h"
+
+/* Cached information about a single id. */
+typedef struct
+{
+	char *name;     /* Name of the id or NULL if there is no such id. */
+	time_t expires; /* When the record needs to be refreshed. */
+	int known;      /* Whether the record was resolved at least once. */
+	int pending;    /* Whether the id is queued for resolution. */
+}
+record_t;
+
+/* Id queued for resolution. */
+typedef struct
+{
+	IdKind kind;      /* Kind of the id. */
+	unsigned long id; /* The id itself. */
+}
+request_t;
+
+static record_t * get_record(IdKind kind, unsigned long id, int create);
+static void format_key(IdKind kind, unsigned long id, char buf[],
+		size_t buf_len);
+static int is_fresh(const record_t *record);
+static int queue_request(record_t *record, IdKind kind, unsigned long id);
+static int start_worker(void);
+static void * worker(void *arg);
+static void store_name(IdKind kind, unsigned long id, char name[]);
+static char * lookup_name(IdKind kind, unsigned long id);
+static char * lookup_user_name(uid_t uid);
+static char * lookup_group_name(gid_t gid);
+static void free_record(void *ptr);
+
+/* Protects all of the state below. */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+/* Signaled when new requests are queued. */
+static pthread_cond_t queued = PTHREAD_COND_INITIALIZER;
+/* Signaled when the worker is done with all requests. */
+static pthread_cond_t idle = PTHREAD_COND_INITIALIZER;
+
+/* Maps "u<id>" and "g<id>" strings to record_t. */
+static trie_t *records;
+/* Ids waiting for resolution. */
+static request_t *queue;
+static DA_INSTANCE(queue);
+/* Whether worker thread is processing a batch of requests. */
+static int busy;
+/* Whether worker thread has been started. */
+static int worker_started;
+
+/* Incremented on every batch of resolved names. */
+static unsigned int generation;
+/* Value of generation at the moment of the last idcache_check() call. */
+static unsigned int checked_generation;
+
+/* For how long names and knowledge that an id has no name are kept. */
+static int positive_ttl = 10*60;
+static int negative_ttl = 60;
+
+int
+idcache_get(IdKind kind, unsigned long id, char buf[], size_t buf_len)
+{
+	int has_name = 0, known = 0, queued = 1;
+
+	pthread_mutex_lock(&lock);
+
+	record_t *const record = get_record(kind, id, 1);
+	if(record != NULL)
+	{
+		known = record->known;
+		if(record->name != NULL)
+		{
+			/* Stale name is still a better placeholder than a number. */
+			copy_str(buf, buf_len, record->name);
+			has_name = 1;
+		}
+
+		if(!known || !is_fresh(record))
+		{
+			queued = (queue_request(record, kind, id) == 0);
+		}
+	}
+
+	pthread_mutex_unlock(&lock);
+
+	if(!queued)
+	{
+		/* Resolve synchronously if there is no thread to do it. */
+		char *const name = lookup_name(kind, id);
+		has_name = (name != NULL);
+		if(has_name)
+		{
+			copy_str(buf, buf_len, name);
+		}
+		known = 1;
+		store_name(kind, id, name);
+	}
+
+	if(!has_name)
+	{
+		snprintf(buf, buf_len, "%lu", id);
+	}
+	return !known;
+}
+
+void
+idcache_request(IdKind kind, unsigned long id)
+{
+	pthread_mutex_lock(&lock);
+
+	record_t *record = get_record(kind, id, 1);
+	if(record != NULL && (!record->known || !is_fresh(record)))
+	{
+		(void)queue_request(record, kind, id);
+	}
+
+	pthread_mutex_unlock(&lock);
+}
+
+void
+idcache_resolve(IdKind kind, unsigned long id)
+{
+	pthread_mutex_lock(&lock);
+	const record_t *record = get_record(kind, id, 0);
+	const int fresh = (record != NULL && record->known && is_fresh(record));
+	pthread_mutex_unlock(&lock);
+
+	if(!fresh)
+	{
+		store_name(kind, id, lookup_name(kind, id));
+	}
+}
+
+int
+idcache_check(void)
+{
+	pthread_mutex_lock(&lock);
+	const int changed = (generation != checked_generation);
+	checked_generation = generation;
+	pthread_mutex_unlock(&lock);
+	return changed;
+}
+
+/* Waits until all queued requests are processed. */
+TSTATIC void
+idcache_wait(void)
+{
+	pthread_mutex_lock(&lock);
+	while(DA_SIZE(queue) != 0U || busy)
+	{
+		pthread_cond_wait(&idle, &lock);
+	}
+	pthread_mutex_unlock(&lock);
+}
+
+/* Drops all cached data and sets lifetime of records in seconds. */
+TSTATIC void
+idcache_reset(int pos_ttl, int neg_ttl)
+{
+	idcache_wait();
+
+	pthread_mutex_lock(&lock);
+	trie_free(records);
+	records = NULL;
+	positive_ttl = pos_ttl;
+	negative_ttl = neg_ttl;
+	checked_generation = generation;
+	pthread_mutex_unlock(&lock);
+}
+
+/* Finds record of the id optionally creating it.  Must be called with the lock
+ * held.  Returns the record or NULL. */
+static record_t *
+get_record(IdKind kind, unsigned long id, int create)
+{
+	char key[32];
+	format_key(kind, id, key, sizeof(key));
+
+	void *data;
+	if(trie_get(records, key, &data) == 0)
+	{
+		return data;
+	}
+
+	if(!create)
+	{
+		return NULL;
+	}
+
+	if(records == NULL)
+	{
+		records = trie_create(&free_record);
+		if(records == NULL)
+		{
+			return NULL;
+		}
+	}
+
+	record_t *const record = malloc(sizeof(*record));
+	if(record == NULL)
+	{
+		return NULL;
+	}
+
+	record->name = NULL;
+	record->expires = 0;
+	record->known = 0;
+	record->pending = 0;
+
+	if(trie_set(records, key, record) < 0)
+	{
+		free(record);
+		return NULL;
+	}
+	return record;
+}
+
+/* Formats key of the id for the trie. */
+static void
+format_key(IdKind kind, unsigned long id, char buf[], size_t buf_len)
+{
+	snprintf(buf, buf_len, "%c%lu", (kind == IK_USER ? 'u' : 'g'), id);
+}
+
+/* Checks whether the record can be used without refreshing it.  Returns
+ * non-zero if so, otherwise zero is returned. */
+static int
+is_fresh(const record_t *record)
+{
+	return (time(NULL) < record->expires);
+}
+
+/* Queues resolution of the id unless it's already queued.  Must be called with
+ * the lock held.  Returns zero on success, otherwise non-zero is returned. */
+static int
+queue_request(record_t *record, IdKind kind, unsigned long id)
+{
+	if(record->pending)
+	{
+		return 0;
+	}
+
+	if(!worker_started && start_worker() != 0)
+	{
+		return 1;
+	}
+
+	request_t *const request = DA_EXTEND(queue);
+	if(request == NULL)
+	{
+		return 1;
+	}
+
+	request->kind = kind;
+	request->id = id;
+	DA_COMMIT(queue);
+
+	record->pending = 1;
+	pthread_cond_signal(&queued);
+	return 0;
+}
+
+/* Starts the thread that resolves ids.  Returns zero on success, otherwise
+ * non-zero is returned. */
+static int
+start_worker(void)
+{
+	pthread_attr_t attr;
+	if(pthread_attr_init(&attr) != 0)
+	{
+		return 1;
+	}
+
+	pthread_t id;
+	if(pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED) == 0 &&
+			pthread_create(&id, &attr, &worker, NULL) == 0)
+	{
+		worker_started = 1;
+	}
+
+	pthread_attr_destroy(&attr);
+	return !worker_started;
+}
+
+/* Entry point of the thread that resolves queued ids in batches. */
+static void *
+worker(void *arg)
+{
+	block_all_thread_signals();
+
+	pthread_mutex_lock(&lock);
+	while(1)
+	{
+		while(DA_SIZE(queue) == 0U)
+		{
+			pthread_cond_wait(&queued, &lock);
+		}
+
+		request_t *const batch = queue;
+		const size_t count = DA_SIZE(queue);
+		queue = NULL;
+		DA_SIZE(queue) = 0U;
+		busy = 1;
+
+		pthread_mutex_unlock(&lock);
+
+		size_t i;
+		for(i = 0U; i < count; ++i)
+		{
+			store_name(batch[i].kind, batch[i].id,
+					lookup_name(batch[i].kind, batch[i].id));
+		}
+		free(batch);
+
+		pthread_mutex_lock(&lock);
+
+		busy = 0;
+		if(DA_SIZE(queue) == 0U)
+		{
+			pthread_cond_broadcast(&idle);
+		}
+	}
+	return NULL;
+}
+
+/* Updates record of the id taking ownership of the name. */
+static void
+store_name(IdKind kind, unsigned long id, char name[])
+{
+	pthread_mutex_lock(&lock);
+
+	record_t *const record = get_record(kind, id, 1);
+	if(record == NULL)
+	{
+		free(name);
+	}
+	else
+	{
+		free(record->name);
+		record->name = name;
+		record->expires = time(NULL) + (name == NULL ? negative_ttl : positive_ttl);
+		record->known = 1;
+		record->pending = 0;
+		++generation;
+	}
+
+	pthread_mutex_unlock(&lock);
+}
+
+/* Queries system for name of the id.  Returns newly allocated string or NULL if
+ * there is no such id or on error. */
+static char *
+lookup_name(IdKind kind, unsigned long id)
+{
+	return (kind == IK_USER ? lookup_user_name(id) : lookup_group_name(id));
+}
+
+/* Queries system for user name.  Returns newly allocated string or NULL. */
+static char *
+lookup_user_name(uid_t uid)
+{
+	enum { MAX_TRIES = 4 };
+	size_t size = MAX(sysconf(_SC_GETPW_R_SIZE_MAX) + 1, PATH_MAX);
+	int i;
+	for(i = 0; i < MAX_TRIES; ++i, size *= 2)
+	{
+		char buf[size];
+		struct passwd pwd_b;
+		struct passwd *pwd_buf;
+
+		if(getpwuid_r(uid, &pwd_b, buf, sizeof(buf), &pwd_buf) == 0)
+		{
+			return (pwd_buf == NULL ? NULL : strdup(pwd_buf->pw_name));
+		}
+	}
+	return NULL;
+}
+
+/* Queries system for group name.  Returns newly allocated string or NULL. */
+static char *
+lookup_group_name(gid_t gid)
+{
+	enum { MAX_TRIES = 4 };
+	size_t size = MAX(sysconf(_SC_GETGR_R_SIZE_MAX) + 1, PATH_MAX);
+	int i;
+	for(i = 0; i < MAX_TRIES; ++i, size *= 2)
+	{
+		char buf[size];
+		struct group group_b;
+		struct group *group_buf;
+
+		if(getgrgid_r(gid, &group_b, buf, sizeof(buf), &group_buf) == 0)
+		{
+			return (group_buf == NULL ? NULL : strdup(group_buf->gr_name));
+		}
+	}
+	return NULL;
+}
+
+/* Frees a record.  Implements trie_free_func. */
+static void
+free_record(void *ptr)
+{
+	record_t *const record = ptr;
+	free(record->name);
+	free(record);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -593,6 +593,12 @@ matcher_is_full_path(const matcher_t *matcher)
 	return matcher->full_path;
 }
 
+int
+matcher_is_mime(const matcher_t *matcher)
+{
+	return matcher->type == MT_MIME;
+}
+
 TSTATIC int
 matcher_is_fast(const matcher_t *matcher)
 {
@@ -22,11 +22,13 @@
 
 #include <ctype.h> /* isdigit() */
 #include <stdlib.h> /* free() malloc() */
-#include <string.h> /* strlen() */
+#include <string.h> /* strlen() strpbrk() strstr() */
 
 #include "../cfg/config.h"
 #include "str.h"
 
+static int is_literal_pattern(const char pattern[]);
+
 int
 get_regexp_cflags(const char pattern[])
 {
@@ -115,6 +117,34 @@ regexp_compile(regex_t *re, const char pattern[], int cflags)
 	return result;
 }
 
+int
+regexp_narrows(const char prev[], int prev_cflags, const char pattern[],
+		int cflags)
+{
+	if(prev[0] == '\0')
+	{
+		return 0;
+	}
+
+	/* Case-insensitive pattern can match more than case-sensitive one. */
+	if(!(prev_cflags & REG_ICASE) && (cflags & REG_ICASE))
+	{
+		return 0;
+	}
+
+	return is_literal_pattern(prev)
+	    && is_literal_pattern(pattern)
+	    && strstr(pattern, prev) != NULL;
+}
+
+/* Checks whether extended regular expression doesn't contain any special
+ * characters.  Returns non-zero if so, otherwise zero is returned. */
+static int
+is_literal_pattern(const char pattern[])
+{
+	return strpbrk(pattern, "\\^$.[]|()*+?{}") == NULL;
+}
+
 const char *
 get_regexp_error(int err, const regex_t *re)
 {
@@ -35,6 +35,13 @@ int regexp_should_ignore_case(const char pattern[]);
 /* Wrapper around regcomp() that handles \c and \C sequences. */
 int regexp_compile(regex_t *re, const char pattern[], int cflags);
 
+/* Checks whether pattern can't match anything that wasn't matched by the
+ * previous one (e.g., when incremental search input gets longer).  Only literal
+ * patterns are analyzed, so false negatives are possible.  Returns non-zero if
+ * so, otherwise zero is returned. */
+int regexp_narrows(const char prev[], int prev_cflags, const char pattern[],
+		int cflags);
+
 /* Turns error code into error message.  Returns pointer to a statically
  * allocated buffer. */
 const char * get_regexp_error(int err, const regex_t *re);
@@ -23,7 +23,7 @@
 #include <stdio.h> /* FILE SEEK_END SEEK_SET fclose() fprintf() fread()
                       ftell() fseek() */
 #include <stdlib.h> /* free() malloc() realloc() */
-#include <string.h> /* strcspn() */
+#include <string.h> /* memchr() memcpy() memmove() strcspn() */
 
 #include "../compat/os.h"
 #include "../compat/reallocarray.h"
@@ -435,6 +435,90 @@ break_into_lines(char text[], size_t text_len, int *nlines, int null_sep)
 	return list;
 }
 
+void
+split_lines(line_splitter_t *ls, const char piece[], size_t len, int final,
+		line_cb handler, void *arg)
+{
+	char *const buf = realloc(ls->buf, ls->len + len + 1U);
+	if(buf == NULL)
+	{
+		return;
+	}
+
+	memcpy(buf + ls->len, piece, len);
+	ls->buf = buf;
+	ls->len += len;
+	ls->buf[ls->len] = '\0';
+
+	/* Same heuristic as read_stream_lines() uses, but it's sticky here. */
+	if(memchr(piece, '\0', len) != NULL)
+	{
+		ls->null_sep = 1;
+	}
+
+	const char *const seps = ls->null_sep ? "" : "\n\r";
+	char *const end = ls->buf + ls->len;
+	char *text = ls->buf;
+
+	while(text < end)
+	{
+		const size_t line_len = strcspn(text, seps);
+
+		/* Separators at the end of the text might continue in the next piece, so
+		 * such line is considered to be incomplete. */
+		char *after_line = text + line_len;
+		if(after_line == end)
+		{
+			if(!final)
+			{
+				break;
+			}
+		}
+		else if(after_line[0] == '\n')
+		{
+			after_line += 1;
+		}
+		else if(after_line[0] == '\r')
+		{
+			if(after_line + 1 == end && !final)
+			{
+				break;
+			}
+			after_line += (after_line[1] == '\n') ? 2 : 1;
+		}
+		else
+		{
+			do
+			{
+				++after_line;
+			}
+			while(after_line < end && after_line[0] == '\0');
+
+			if(after_line == end && !final)
+			{
+				break;
+			}
+		}
+
+		text[line_len] = '\0';
+		handler(text, arg);
+
+		text = after_line;
+	}
+
+	ls->len = end - text;
+	memmove(ls->buf, text, ls->len + 1U);
+}
+
+void
+split_lines_reset(line_splitter_t *ls)
+{
+	free(ls->buf);
+	ls->buf = NULL;
+	ls->len = 0U;
+	ls->null_sep = 0;
+}
+
 int
 write_file_of_lines(const char filepath[], char *strs[], size_t nstrs)
 {
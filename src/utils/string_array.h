@@ -35,6 +35,18 @@ strlist_t;
  * data. */
 typedef void (*progress_cb)(const void *arg);
 
+/* Type of callback function that receives lines of text one by one. */
+typedef void (*line_cb)(const char line[], void *arg);
+
+/* State of splitting text that arrives in pieces into lines. */
+typedef struct line_splitter_t
+{
+	char *buf;    /* Part of the text that doesn't form a complete line yet. */
+	size_t len;   /* Length of the text in the buf. */
+	int null_sep; /* Whether lines are separated by null characters. */
+}
+line_splitter_t;
+
 /* Adds copy of a string to a string array.  Input pointer can be NULL.  Returns
  * new length of the array, which is unchanged on allocation failure. */
 int add_to_string_array(char ***array, int len, const char item[]);
@@ -114,6 +126,17 @@ char * read_nonseekable_stream(FILE *fp, size_t *read, progress_cb cb,
 char ** break_into_lines(char text[], size_t text_len, int *nlines,
 		int null_sep);
 
+/* Appends piece of text of length len to the splitter and calls the handler
+ * for every line that became complete.  Lines are separated as by
+ * break_into_lines(), null separation is enabled on encountering a null
+ * character.  Non-zero final means that no more text will follow, which
+ * completes the last line. */
+void split_lines(line_splitter_t *ls, const char piece[], size_t len,
+		int final, line_cb handler, void *arg);
+
+/* Frees resources of the splitter and returns it to the initial state. */
+void split_lines_reset(line_splitter_t *ls);
+
 /* Overwrites file specified by filepath with lines.  Returns zero on success,
  * otherwise non-zero is returned and errno contains error code. */
 int write_file_of_lines(const char filepath[], char *strs[], size_t nstrs);
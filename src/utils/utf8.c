@@ -24,14 +24,17 @@
 
 #include <assert.h> /* assert() */
 #include <stddef.h> /* size_t wchar_t */
+#include <stdint.h> /* uint64_t */
 #include <stdlib.h> /* malloc() */
-#include <string.h> /* strlen() */
+#include <string.h> /* memcpy() strlen() */
 
 #include "../compat/reallocarray.h"
 #include "macros.h"
 #include "utils.h"
 
 static size_t guess_char_width(char c);
+static size_t count_simple_chars(const char str[], size_t len);
+static int is_simple_char(char c);
 static wchar_t utf8_char_to_wchar(const char str[], size_t char_width);
 static size_t chrsw(const char str[], size_t char_width);
 
@@ -71,6 +74,16 @@ utf8_strsnlen(const char str[], size_t max_screen_width)
 
 	while(*str != '\0' && max_screen_width != 0)
 	{
+		/* Length of the string isn't known here and computing it can be costly for
+		 * long strings, so skip simple characters one by one. */
+		if(is_simple_char(*str))
+		{
+			--max_screen_width;
+			++width;
+			++str;
+			continue;
+		}
+
 		size_t char_width = utf8_chrw(str);
 		size_t char_screen_width = chrsw(str, char_width);
 		if(char_screen_width > max_screen_width)
@@ -93,6 +106,43 @@ utf8_strsnlen(const char str[], size_t max_screen_width)
 	return width;
 }
 
+/* Counts leading characters of the string that are encoded by a single byte and
+ * occupy a single screen cell, which are printable ASCII characters and DEL.
+ * Checks several bytes at a time, so the string must be at least len bytes
+ * long.  Returns the count. */
+static size_t
+count_simple_chars(const char str[], size_t len)
+{
+	size_t count = 0U;
+	while(len - count >= sizeof(uint64_t))
+	{
+		uint64_t word;
+		memcpy(&word, str + count, sizeof(word));
+		/* Highest bit of a byte ends up being set if it's below 0x20 or above 0x7f
+		 * (subtraction can also set it for bytes that follow such a byte). */
+		if((((word - 0x2020202020202020ULL) | word) & 0x8080808080808080ULL) != 0U)
+		{
+			break;
+		}
+		count += sizeof(uint64_t);
+	}
+
+	while(count < len && is_simple_char(str[count]))
+	{
+		++count;
+	}
+	return count;
+}
+
+/* Checks whether the byte is a character that occupies a single screen cell
+ * (printable ASCII character or DEL).  Returns non-zero if so, otherwise zero is
+ * returned. */
+static int
+is_simple_char(char c)
+{
+	return ((unsigned char)c >= 0x20 && (unsigned char)c < 0x80);
+}
+
 size_t
 utf8_nstrlen(const char str[])
 {
@@ -100,6 +150,15 @@ utf8_nstrlen(const char str[])
 	size_t length = 0;
 	while(length_left != 0)
 	{
+		const size_t simple = count_simple_chars(str, length_left);
+		if(simple != 0)
+		{
+			length += simple;
+			str += simple;
+			length_left -= simple;
+			continue;
+		}
+
 		const size_t char_width = utf8_chrw(str);
 		if(char_width > length_left)
 		{
@@ -122,6 +181,24 @@ utf8_nstrsnlen(const char str[], size_t max_screen_width)
 	/* The loop includes composite characters. */
 	while(length_left != 0)
 	{
+		size_t simple = count_simple_chars(str, length_left);
+		if(simple != 0)
+		{
+			if(simple > max_screen_width)
+			{
+				simple = max_screen_width;
+				if(simple == 0)
+				{
+					break;
+				}
+			}
+			length += simple;
+			max_screen_width -= simple;
+			str += simple;
+			length_left -= simple;
+			continue;
+		}
+
 		size_t char_screen_width;
 		const size_t char_width = utf8_chrw(str);
 		if(char_width > length_left)
@@ -168,12 +245,23 @@ utf8_char_to_wchar(const char str[], size_t char_width)
 size_t
 utf8_strsw(const char str[])
 {
+	size_t length_left = strlen(str);
 	size_t length = 0;
-	while(*str != '\0')
+	while(length_left != 0)
 	{
+		const size_t simple = count_simple_chars(str, length_left);
+		if(simple != 0)
+		{
+			str += simple;
+			length_left -= simple;
+			length += simple;
+			continue;
+		}
+
 		const size_t char_width = utf8_chrw(str);
 		const size_t char_screen_width = chrsw(str, char_width);
 		str += char_width;
+		length_left -= char_width;
 		length += char_screen_width;
 	}
 	return length;
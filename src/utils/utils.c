@@ -38,7 +38,7 @@
 #include <stdio.h> /* snprintf() */
 #include <stdlib.h> /* free() malloc() qsort() */
 #include <string.h> /* memcpy() strdup() strchr() strlen() strpbrk() strtol() */
-#include <time.h> /* tm localtime() strftime() */
+#include <time.h> /* tm clock_gettime() localtime() strftime() */
 #include <wchar.h> /* wcwidth() */
 
 #include "../cfg/config.h"
@@ -949,6 +949,30 @@ format_iso_time(time_t t, char buf[], size_t buf_size)
 	strftime(buf, buf_size, "%a, %d %b %Y %H:%M:%S", tm);
 }
 
+long long
+time_in_ms(void)
+{
+	struct timespec current_time;
+	if(clock_gettime(CLOCK_MONOTONIC, &current_time) != 0)
+	{
+		return 0;
+	}
+
+	return current_time.tv_sec*1000LL + current_time.tv_nsec/1000000;
+}
+
+long long
+time_in_us(void)
+{
+	struct timespec current_time;
+	if(clock_gettime(CLOCK_MONOTONIC, &current_time) != 0)
+	{
+		return 0;
+	}
+
+	return current_time.tv_sec*1000000LL + current_time.tv_nsec/1000;
+}
+
 int
 unichar_bisearch(wchar_t ucs, const interval_t table[], int max)
 {
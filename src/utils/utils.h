@@ -218,6 +218,14 @@ void write_marked_paths(FILE *file, struct view_t *view, int null_sep);
  * error. */
 void format_iso_time(time_t t, char buf[], size_t buf_size);
 
+/* Retrieves current time of a monotonic clock in milliseconds.  Returns the
+ * time or zero on error. */
+long long time_in_ms(void);
+
+/* Retrieves current time of a monotonic clock in microseconds.  Returns the
+ * time or zero on error. */
+long long time_in_us(void);
+
 /* Checks line for path in it.  Ignores empty lines and attempts to parse it as
  * location line (path followed by a colon and optional line and column
  * numbers).  Returns canonicalized path as a newly allocated string or NULL. */
@@ -286,12 +294,14 @@ void stop_process(void);
 void update_terminal_settings(void);
 
 /* Fills the buffer with string representation of owner user for the entry.  The
- * as_num flag forces formatting as integer. */
+ * as_num flag forces formatting as integer.  Number is also used as a
+ * placeholder until name of the user is resolved in background. */
 void get_uid_string(const struct dir_entry_t *entry, int as_num, size_t buf_len,
 		char buf[]);
 
 /* Fills the buffer with string representation of owner group for the entry.
- * The as_num flag forces formatting as integer. */
+ * The as_num flag forces formatting as integer.  Number is also used as a
+ * placeholder until name of the group is resolved in background. */
 void get_gid_string(const struct dir_entry_t *entry, int as_num, size_t buf_len,
 		char buf[]);
 
@@ -36,9 +36,9 @@
 #include <sys/time.h> /* timeval futimens() utimes() */
 #include <sys/wait.h> /* WEXITSTATUS() WIFEXITED() WIFSIGNALED() waitpid() */
 #include <fcntl.h> /* open() close() */
-#include <grp.h> /* getgrnam() getgrgid_r() */
+#include <grp.h> /* getgrnam() */
 #include <pthread.h> /* pthread_sigmask() */
-#include <pwd.h> /* getpwnam() getpwuid_r() */
+#include <pwd.h> /* getpwnam() */
 #include <unistd.h> /* X_OK chown() dup() dup2() getpid() isatty() pause()
                        sysconf() ttyname() */
 
@@ -67,6 +67,7 @@
 #include "filemon.h"
 #include "fs.h"
 #include "fswatch.h"
+#include "idcache.h"
 #include "log.h"
 #include "macros.h"
 #include "path.h"
@@ -862,79 +863,27 @@ update_terminal_settings(void)
 void
 get_uid_string(const dir_entry_t *entry, int as_num, size_t buf_len, char buf[])
 {
-	/* Cache for the last requested user id. */
-	static uid_t last_uid = (uid_t)-1;
-	static char uid_buf[26];
-
-	if(entry->uid == last_uid)
+	if(as_num)
 	{
-		copy_str(buf, buf_len, uid_buf);
-		return;
+		snprintf(buf, buf_len, "%lu", (unsigned long)entry->uid);
 	}
-
-	last_uid = entry->uid;
-	snprintf(uid_buf, sizeof(uid_buf), "%d", (int)last_uid);
-
-	if(!as_num)
+	else
 	{
-		enum { MAX_TRIES = 4 };
-		size_t size = MAX(sysconf(_SC_GETPW_R_SIZE_MAX) + 1, PATH_MAX);
-		int i;
-		for(i = 0; i < MAX_TRIES; ++i, size *= 2)
-		{
-			char buf[size];
-			struct passwd pwd_b;
-			struct passwd *pwd_buf;
-
-			if(getpwuid_r(last_uid, &pwd_b, buf, sizeof(buf), &pwd_buf) == 0 &&
-					pwd_buf != NULL)
-			{
-				copy_str(uid_buf, sizeof(uid_buf), pwd_buf->pw_name);
-				break;
-			}
-		}
+		(void)idcache_get(IK_USER, entry->uid, buf, buf_len);
 	}
-
-	copy_str(buf, buf_len, uid_buf);
 }
 
 void
 get_gid_string(const dir_entry_t *entry, int as_num, size_t buf_len, char buf[])
 {
-	/* Cache for the last requested group id. */
-	static gid_t last_gid = (gid_t)-1;
-	static char gid_buf[26];
-
-	if(entry->gid == last_gid)
+	if(as_num)
 	{
-		copy_str(buf, buf_len, gid_buf);
-		return;
+		snprintf(buf, buf_len, "%lu", (unsigned long)entry->gid);
 	}
-
-	last_gid = entry->gid;
-	snprintf(gid_buf, sizeof(gid_buf), "%d", (int)last_gid);
-
-	if(!as_num)
+	else
 	{
-		enum { MAX_TRIES = 4 };
-		size_t size = MAX(sysconf(_SC_GETGR_R_SIZE_MAX) + 1, PATH_MAX);
-		int i;
-		for(i = 0; i < MAX_TRIES; ++i, size *= 2)
-		{
-			char buf[size];
-			struct group group_b;
-			struct group *group_buf;
-
-			if(getgrgid_r(last_gid, &group_b, buf, sizeof(buf), &group_buf) == 0 &&
-					group_buf != NULL)
-			{
-				copy_str(gid_buf, sizeof(gid_buf), group_buf->gr_name);
-				break;
-			}
-		}
+		(void)idcache_get(IK_GROUP, entry->gid, buf, buf_len);
 	}
-
-	copy_str(buf, buf_len, gid_buf);
 }
 
 FILE *
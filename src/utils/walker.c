@@ -0,0 +1,457 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include "walker.h"
+
+#include <sys/stat.h> /* S_IS*() stat */
+#include <dirent.h> /* DIR dirent */
+
+#include <stddef.h> /* NULL size_t */
+#include <stdlib.h> /* calloc() free() */
+#include <string.h> /* strdup() */
+
+#include "../compat/dtype.h"
+#include "../compat/fs_limits.h"
+#include "../compat/os.h"
+#include "../compat/pthread.h"
+#include "cancellation.h"
+#include "darray.h"
+#include "path.h"
+#include "str.h"
+#include "utils.h"
+
+/* Queued directory or root. */
+typedef struct
+{
+	char *path;      /* Path as displayed. */
+	char *full_path; /* Path for accessing the entry. */
+	int depth;       /* Depth of the entry. */
+	int is_root;     /* Whether the root itself still needs to be visited. */
+}
+item_t;
+
+struct walker_t;
+
+/* State of a single worker thread. */
+typedef struct
+{
+	struct walker_t *w;       /* Traversal this worker belongs to. */
+	int index;                /* Index of this worker. */
+	pthread_t thread;         /* Thread of the worker (unused for index 0). */
+	item_t *queue;            /* Directories to process, the last one is the
+	                             newest. */
+	DA_INSTANCE_FIELD(queue); /* Declarations to enable use of DA_* on it. */
+}
+worker_t;
+
+/* State of traversal. */
+typedef struct walker_t
+{
+	walker_visitor visitor;             /* Function to call for each entry. */
+	void *arg;                          /* Argument for the visitor. */
+	const cancellation_t *cancellation; /* Cancellation state. */
+
+	pthread_mutex_t lock;   /* Protects fields below and queues of workers. */
+	pthread_cond_t changed; /* Signaled on new work and on stopping. */
+	worker_t *workers;      /* All workers. */
+	int nworkers;           /* Number of elements in the workers array. */
+	int pending;            /* Number of queued and processed items. */
+	int cancelled;          /* Whether traversal should stop. */
+}
+walker_t;
+
+static void * worker_thread(void *arg);
+static void work(worker_t *worker);
+static int take_item(worker_t *worker, item_t *item);
+static int process_item(worker_t *worker, item_t *item, item_t **found,
+		size_t *nfound);
+static int visit_root(worker_t *worker, item_t *item);
+static int list_dir(worker_t *worker, const item_t *item, item_t **found,
+		size_t *nfound);
+static char * append_name(const char dir[], const char name[]);
+static WalkerType get_entry_type(const struct dirent *d, const char path[]);
+static WalkerType mode_to_type(mode_t mode);
+static int queue_root(worker_t *worker, const char root[],
+		const char base[]);
+
+int
+walker_run(char *roots[], int nroots, const char base[], int nthreads,
+		walker_visitor visitor, void *arg, const cancellation_t *cancellation)
+{
+	walker_t w = {
+		.visitor = visitor,
+		.arg = arg,
+		.cancellation = cancellation,
+		.nworkers = (nthreads < 1 ? 1 : nthreads),
+	};
+
+	w.workers = calloc(w.nworkers, sizeof(*w.workers));
+	if(w.workers == NULL)
+	{
+		return 1;
+	}
+
+	pthread_mutex_init(&w.lock, NULL);
+	pthread_cond_init(&w.changed, NULL);
+
+	int i;
+	for(i = 0; i < w.nworkers; ++i)
+	{
+		w.workers[i].w = &w;
+		w.workers[i].index = i;
+	}
+
+	/* Spread roots evenly among workers. */
+	for(i = 0; i < nroots; ++i)
+	{
+		worker_t *const worker = &w.workers[i%w.nworkers];
+		if(queue_root(worker, roots[i], base) == 0)
+		{
+			++w.pending;
+		}
+	}
+
+	int nstarted = 1;
+	for(i = 1; i < w.nworkers; ++i)
+	{
+		if(pthread_create(&w.workers[i].thread, NULL, &worker_thread,
+					&w.workers[i]) != 0)
+		{
+			break;
+		}
+		++nstarted;
+	}
+
+	/* Queues of workers that failed to start are emptied by others. */
+	work(&w.workers[0]);
+
+	for(i = 1; i < nstarted; ++i)
+	{
+		(void)pthread_join(w.workers[i].thread, NULL);
+	}
+
+	/* Queues aren't necessarily empty on cancellation. */
+	for(i = 0; i < w.nworkers; ++i)
+	{
+		worker_t *const worker = &w.workers[i];
+		size_t j;
+		for(j = 0U; j < DA_SIZE(worker->queue); ++j)
+		{
+			free(worker->queue[j].path);
+			free(worker->queue[j].full_path);
+		}
+		DA_REMOVE_ALL(worker->queue);
+	}
+
+	pthread_cond_destroy(&w.changed);
+	pthread_mutex_destroy(&w.lock);
+	free(w.workers);
+
+	return w.cancelled;
+}
+
+/* Entry point of worker threads.  Returns NULL. */
+static void *
+worker_thread(void *arg)
+{
+	block_all_thread_signals();
+	work(arg);
+	return NULL;
+}
+
+/* Processes items until there are none left anywhere or traversal gets
+ * cancelled. */
+static void
+work(worker_t *worker)
+{
+	walker_t *const w = worker->w;
+
+	pthread_mutex_lock(&w->lock);
+	while(1)
+	{
+		item_t item;
+		while(!w->cancelled && w->pending != 0 && !take_item(worker, &item))
+		{
+			pthread_cond_wait(&w->changed, &w->lock);
+		}
+		if(w->cancelled || w->pending == 0)
+		{
+			break;
+		}
+		pthread_mutex_unlock(&w->lock);
+
+		item_t *found = NULL;
+		size_t nfound = 0U;
+		const int cancelled = process_item(worker, &item, &found, &nfound);
+		free(item.path);
+		free(item.full_path);
+
+		pthread_mutex_lock(&w->lock);
+
+		size_t i;
+		for(i = 0U; i < nfound; ++i)
+		{
+			item_t *const queued = DA_EXTEND(worker->queue);
+			if(queued == NULL)
+			{
+				free(found[i].path);
+				free(found[i].full_path);
+				continue;
+			}
+
+			*queued = found[i];
+			DA_COMMIT(worker->queue);
+			++w->pending;
+		}
+		free(found);
+
+		--w->pending;
+		w->cancelled |= cancelled;
+		if(nfound != 0U || w->pending == 0 || w->cancelled)
+		{
+			pthread_cond_broadcast(&w->changed);
+		}
+	}
+	pthread_mutex_unlock(&w->lock);
+}
+
+/* Picks next item to process: the newest one from own queue to go deeper first
+ * or the oldest one from a queue of another worker, which is likely to be the
+ * largest piece of work there.  Must be called under the lock.  Returns
+ * non-zero if *item was set, otherwise zero is returned. */
+static int
+take_item(worker_t *worker, item_t *item)
+{
+	if(DA_SIZE(worker->queue) != 0U)
+	{
+		item_t *const last = &worker->queue[DA_SIZE(worker->queue) - 1U];
+		*item = *last;
+		DA_REMOVE_AFTER(worker->queue, last);
+		return 1;
+	}
+
+	walker_t *const w = worker->w;
+	int i;
+	for(i = 1; i < w->nworkers; ++i)
+	{
+		worker_t *const victim = &w->workers[(worker->index + i)%w->nworkers];
+		if(DA_SIZE(victim->queue) != 0U)
+		{
+			*item = victim->queue[0];
+			DA_REMOVE(victim->queue, &victim->queue[0]);
+			return 1;
+		}
+	}
+
+	return 0;
+}
+
+/* Visits a root or children of a directory collecting subdirectories that need
+ * to be processed.  Returns non-zero if traversal got cancelled. */
+static int
+process_item(worker_t *worker, item_t *item, item_t **found, size_t *nfound)
+{
+	if(cancellation_requested(worker->w->cancellation))
+	{
+		return 1;
+	}
+
+	if(item->is_root && !visit_root(worker, item))
+	{
+		return 0;
+	}
+
+	return list_dir(worker, item, found, nfound);
+}
+
+/* Visits root of a tree.  Returns non-zero if it's a directory that should be
+ * descended into. */
+static int
+visit_root(worker_t *worker, item_t *item)
+{
+	struct stat st;
+	if(os_stat(item->full_path, &st) != 0)
+	{
+		return 0;
+	}
+
+	char *const name = get_last_path_component(item->path);
+	const walker_entry_t entry = {
+		.path = item->path,
+		.full_path = item->full_path,
+		.name = name,
+		.type = mode_to_type(st.st_mode),
+		.depth = 0,
+		.worker = worker->index,
+	};
+
+	const int descend = worker->w->visitor(&entry, worker->w->arg);
+	return (entry.type == WT_DIR && descend);
+}
+
+/* Visits children of a directory.  Returns non-zero if traversal got
+ * cancelled. */
+static int
+list_dir(worker_t *worker, const item_t *item, item_t **found, size_t *nfound)
+{
+	walker_t *const w = worker->w;
+
+	DIR *const dir = os_opendir(item->full_path);
+	if(dir == NULL)
+	{
+		return 0;
+	}
+
+	item_t *subdirs = NULL;
+	DA_INSTANCE(subdirs);
+	int cancelled = 0;
+
+	struct dirent *d;
+	while((d = os_readdir(dir)) != NULL)
+	{
+		if(is_builtin_dir(d->d_name))
+		{
+			continue;
+		}
+
+		if(cancellation_requested(w->cancellation))
+		{
+			cancelled = 1;
+			break;
+		}
+
+		char *const path = append_name(item->path, d->d_name);
+		char *const full_path = append_name(item->full_path, d->d_name);
+		if(path == NULL || full_path == NULL)
+		{
+			free(path);
+			free(full_path);
+			continue;
+		}
+
+		const walker_entry_t entry = {
+			.path = path,
+			.full_path = full_path,
+			.name = d->d_name,
+			.type = get_entry_type(d, full_path),
+			.depth = item->depth + 1,
+			.worker = worker->index,
+		};
+
+		item_t *subdir;
+		if(w->visitor(&entry, w->arg) && entry.type == WT_DIR &&
+				(subdir = DA_EXTEND(subdirs)) != NULL)
+		{
+			subdir->path = path;
+			subdir->full_path = full_path;
+			subdir->depth = entry.depth;
+			subdir->is_root = 0;
+			DA_COMMIT(subdirs);
+			continue;
+		}
+
+		free(path);
+		free(full_path);
+	}
+	os_closedir(dir);
+
+	*found = subdirs;
+	*nfound = DA_SIZE(subdirs);
+	return cancelled;
+}
+
+/* Appends name to a path of a directory.  Returns newly allocated string or
+ * NULL on error. */
+static char *
+append_name(const char dir[], const char name[])
+{
+	return format_str("%s%s%s", dir, ends_with_slash(dir) ? "" : "/", name);
+}
+
+/* Determines type of a directory entry.  Returns the type. */
+static WalkerType
+get_entry_type(const struct dirent *d, const char path[])
+{
+	switch(get_dirent_type(d, path))
+	{
+		case DT_DIR: return WT_DIR;
+		case DT_REG: return WT_FILE;
+#ifndef _WIN32
+		case DT_LNK: return WT_LINK;
+#endif
+		case DT_UNKNOWN: break;
+		default: return WT_OTHER;
+	}
+
+	struct stat st;
+	return (os_lstat(path, &st) == 0 ? mode_to_type(st.st_mode) : WT_OTHER);
+}
+
+/* Maps file mode onto entry type.  Returns the type. */
+static WalkerType
+mode_to_type(mode_t mode)
+{
+	if(S_ISDIR(mode))
+	{
+		return WT_DIR;
+	}
+	if(S_ISREG(mode))
+	{
+		return WT_FILE;
+	}
+#ifndef _WIN32
+	if(S_ISLNK(mode))
+	{
+		return WT_LINK;
+	}
+#endif
+	return WT_OTHER;
+}
+
+/* Adds a root to the queue of the worker.  Returns zero on success, otherwise
+ * non-zero is returned. */
+static int
+queue_root(worker_t *worker, const char root[], const char base[])
+{
+	item_t *const item = DA_EXTEND(worker->queue);
+	if(item == NULL)
+	{
+		return 1;
+	}
+
+	/* Canonical form keeps paths like "." out of full paths. */
+	char full_path[PATH_MAX + 1];
+	to_canonic_path(root, base, full_path, sizeof(full_path));
+
+	item->path = strdup(root);
+	item->full_path = strdup(full_path);
+	item->depth = 0;
+	item->is_root = 1;
+	if(item->path == NULL || item->full_path == NULL)
+	{
+		free(item->path);
+		free(item->full_path);
+		return 1;
+	}
+
+	DA_COMMIT(worker->queue);
+	return 0;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
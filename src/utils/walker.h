@@ -0,0 +1,67 @@
+/* vifm
+ * Copyright (C) 2026 xaizek.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#ifndef VIFM__UTILS__WALKER_H__
+#define VIFM__UTILS__WALKER_H__
+
+/* Parallel traversal of file system trees.  Directories are distributed among
+ * worker threads, each of which has its own queue of directories to process
+ * and takes work from queues of other threads once it runs out of its own. */
+
+struct cancellation_t;
+
+/* Type of a file system entry. */
+typedef enum
+{
+	WT_FILE,  /* Regular file. */
+	WT_DIR,   /* Directory. */
+	WT_LINK,  /* Symbolic link, which is never followed unless it's a root. */
+	WT_OTHER, /* Any other kind of entry. */
+}
+WalkerType;
+
+/* Information about an entry passed to a visitor. */
+typedef struct
+{
+	const char *path;      /* Path composed of a root and names below it. */
+	const char *full_path; /* Path to use for accessing the entry. */
+	const char *name;      /* Last component of the path. */
+	WalkerType type;       /* Type of the entry. */
+	int depth;             /* Zero for roots. */
+	int worker;            /* Index of the thread that visits the entry. */
+}
+walker_entry_t;
+
+/* Visitor of file system entries, which is called from several threads at the
+ * same time.  Returns non-zero to descend into a directory, the value is
+ * ignored for other entries. */
+typedef int (*walker_visitor)(const walker_entry_t *entry, void *arg);
+
+/* Visits roots and entries under them using the specified number of threads
+ * (the calling thread is one of them and has index zero).  Roots are followed
+ * if they are symbolic links.  Relative roots are resolved against the base.
+ * The order of visiting is unspecified.  Returns zero on success and non-zero
+ * if traversal was cancelled. */
+int walker_run(char *roots[], int nroots, const char base[], int nthreads,
+		walker_visitor visitor, void *arg,
+		const struct cancellation_t *cancellation);
+
+#endif /* VIFM__UTILS__WALKER_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
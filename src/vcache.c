@@ -18,11 +18,9 @@
 
 #include "vcache.h"
 
-#include <fcntl.h> /* F_GETFL O_NONBLOCK fcntl() */
-
 #include <stdio.h> /* FILE */
 #include <stdlib.h> /* free() */
-#include <string.h> /* memmove() memset() strcmp() */
+#include <string.h> /* memmove() memset() strcmp() strcspn() */
 #include <time.h> /* time_t time() */
 
 #include "cfg/config.h"
@@ -31,18 +29,19 @@
 #include "ui/cancellation.h"
 #include "ui/quickview.h"
 #include "ui/ui.h"
+#include "utils/cancellation.h"
 #include "utils/darray.h"
 #include "utils/file_streams.h"
 #include "utils/filemon.h"
 #include "utils/fs.h"
 #include "utils/path.h"
-#include "utils/selector.h"
 #include "utils/str.h"
 #include "utils/string_array.h"
 #include "utils/test_helpers.h"
 #include "background.h"
 #include "filetype.h"
 #include "status.h"
+#include "trace.h"
 
 /* Maximum number of seconds to wait for data. */
 enum { MAX_RUN_TIME_S = 60 };
@@ -71,10 +70,16 @@ typedef struct vcache_entry_t
 	unsigned int truncated : 1;
 	/* Value of toptreestats for this entry. */
 	unsigned int top_tree_stats : 1;
+	/* Whether the job counts statistics of a tree, which replace the first
+	 * line. */
+	unsigned int stats_pending : 1;
 }
 vcache_entry_t;
 
 TSTATIC size_t vcache_entry_size(void);
+static strlist_t lookup(const char full_path[], const char viewer[],
+		MacroFlags flags, ViewerKind kind, int max_lines, int sync,
+		const char **error);
 static void wait_async_finish(vcache_entry_t *centry);
 static vcache_entry_t * find_cache_entry(const char full_path[],
 		const char viewer[], int max_lines);
@@ -93,7 +98,6 @@ static void update_sizes(vcache_entry_t *centry);
 static int pull_async(vcache_entry_t *centry);
 static int read_async_output(vcache_entry_t *centry);
 static void cancel_job(vcache_entry_t *centry);
-static int is_ready_for_read(FILE *stream);
 static int need_more_async_output(vcache_entry_t *centry);
 static strlist_t view_entry(vcache_entry_t *centry, MacroFlags flags,
 		const char **error);
@@ -162,6 +166,18 @@ vcache_check(vcache_is_previewed_cb is_previewed)
 strlist_t
 vcache_lookup(const char full_path[], const char viewer[], MacroFlags flags,
 		ViewerKind kind, int max_lines, int sync, const char **error)
+{
+	const long long start = trace_begin();
+	strlist_t lines = lookup(full_path, viewer, flags, kind, max_lines, sync,
+			error);
+	trace_end(TP_VCACHE_LOOKUP, start);
+	return lines;
+}
+
+/* Implementation of vcache_lookup(). */
+static strlist_t
+lookup(const char full_path[], const char viewer[], MacroFlags flags,
+		ViewerKind kind, int max_lines, int sync, const char **error)
 {
 	*error = NULL;
 
@@ -230,9 +246,14 @@ wait_async_finish(vcache_entry_t *centry)
 
 	ui_cancellation_push_on();
 
+	/* Tasks have no process to interrupt, they are cancelled below. */
+	const cancellation_t *const cancellation = (job->type == BJT_TASK)
+	                                         ? &no_cancellation
+	                                         : &ui_cancellation_info;
+
 	do
 	{
-		wait_for_data_from(job->pid, job->output, 0, &ui_cancellation_info);
+		wait_for_data_from(job->pid, job->output, 0, cancellation);
 
 		if(ui_cancellation_requested())
 		{
@@ -260,11 +281,17 @@ wait_async_finish(vcache_entry_t *centry)
 
 	if(ui_cancellation_requested())
 	{
+		if(job->type == BJT_TASK)
+		{
+			(void)bg_job_cancel(job);
+		}
 		centry->lines.nitems = add_to_string_array(&centry->lines.items,
 				centry->lines.nitems, "[cancelled]");
 	}
 	ui_cancellation_pop();
 
+	centry->stats_pending = 0;
+
 	bg_job_decref(centry->job);
 	centry->job = NULL;
 }
@@ -448,6 +475,15 @@ update_cache_entry(vcache_entry_t *centry, const char path[],
 	replace_string(&centry->path, path);
 	update_string(&centry->viewer, viewer);
 
+	if(centry->job != NULL && centry->stats_pending)
+	{
+		/* Preview of a tree is going to be rebuilt from scratch. */
+		(void)bg_job_cancel(centry->job);
+		bg_job_decref(centry->job);
+		centry->job = NULL;
+		centry->stats_pending = 0;
+	}
+
 	if(centry->job == NULL)
 	{
 		free_string_array(centry->lines.items, centry->lines.nitems);
@@ -514,9 +550,15 @@ pull_async(vcache_entry_t *centry)
 
 	if(!bg_job_is_running(centry->job))
 	{
-		centry->complete = (read_async_output(centry) <= 0)
-		                && (centry->kill_timer == 0 ||
-		                    !bg_job_was_killed(centry->job));
+		const int complete = (read_async_output(centry) <= 0)
+		                  && (centry->kill_timer == 0 ||
+		                      !bg_job_was_killed(centry->job));
+		/* Completeness of a tree preview doesn't depend on its statistics. */
+		if(!centry->stats_pending)
+		{
+			centry->complete = complete;
+		}
+		centry->stats_pending = 0;
 		bg_job_decref(centry->job);
 		centry->job = NULL;
 		changed = 1;
@@ -539,44 +581,28 @@ cancel_job(vcache_entry_t *centry)
 static int
 read_async_output(vcache_entry_t *centry)
 {
-	if(!is_ready_for_read(centry->job->output))
-	{
-		return 0;
-	}
-
 	char piece[4096];
-	size_t to_read = sizeof(piece) - 1;
-
-#ifdef _WIN32
-	/* Simulate asynchronous reading by not reading more than stream has. */
-	HANDLE hpipe = (HANDLE)_get_osfhandle(fileno(centry->job->output));
-	DWORD bytes_available = 0;
-	if(!PeekNamedPipe(hpipe, NULL, 0, NULL, &bytes_available, NULL))
+	const int len = bg_job_read_output(centry->job, piece, sizeof(piece) - 1);
+	if(len <= 0)
 	{
-		return -1;
+		return len;
 	}
-	if(bytes_available == 0)
-	{
-		return 0;
-	}
-	if(bytes_available < to_read)
-	{
-		to_read = bytes_available;
-	}
-#endif
 
-	size_t len = fread(piece, 1, to_read, centry->job->output);
 	piece[len] = '\0';
+	centry->size += len;
+	cache_size += len;
 
-	if(len == 0)
+	if(centry->stats_pending)
 	{
-		return -1;
+		/* The output is a single line that replaces a placeholder. */
+		piece[strcspn(piece, "\r\n")] = '\0';
+		if(centry->lines.nitems > 0)
+		{
+			replace_string(&centry->lines.items[0], piece);
+		}
+		return 1;
 	}
 
-	clearerr(centry->job->output);
-	centry->size += len;
-	cache_size += len;
-
 	int new_truncated = (len > 0)
 	                 && (piece[len - 1] != '\r' && piece[len - 1] != '\n');
 
@@ -604,35 +630,17 @@ read_async_output(vcache_entry_t *centry)
 	return 1;
 }
 
-/* Checks whether stream contains data to be read.  Returns non-zero if so,
+/* Checks whether entry is full with data already.  Returns non-zero if so,
  * otherwise zero is returned. */
 static int
-is_ready_for_read(FILE *stream)
+need_more_async_output(vcache_entry_t *centry)
 {
-	selector_t *selector = selector_alloc();
-	if(selector == NULL)
+	if(centry->stats_pending)
 	{
-		return 0;
+		/* Tree preview is already there, waiting for its statistics. */
+		return 1;
 	}
 
-	int fd = fileno(stream);
-#ifndef _WIN32
-	selector_add(selector, fd);
-#else
-	HANDLE handle = (HANDLE)_get_osfhandle(fd);
-	selector_add(selector, handle);
-#endif
-
-	int has_data = selector_wait(selector, 0);
-	selector_free(selector);
-	return has_data;
-}
-
-/* Checks whether entry is full with data already.  Returns non-zero if so,
- * otherwise zero is returned. */
-static int
-need_more_async_output(vcache_entry_t *centry)
-{
 	int effective_lines = centry->lines.nitems;
 	if(centry->truncated)
 	{
@@ -668,22 +676,42 @@ view_builtin(vcache_entry_t *centry, const char **error)
 {
 	ui_cancellation_push_on();
 
-	int dir = is_dir(centry->path);
+	strlist_t lines = {};
 
-	FILE *fp = NULL;
-	if(dir)
+	if(is_dir(centry->path))
 	{
 		centry->top_tree_stats = cfg.top_tree_stats;
 		centry->max_tree_depth = cfg.max_tree_depth;
-		fp = qv_view_dir(centry->path, centry->max_lines);
-	}
-	else
-	{
-		/* Binary mode is important on Windows. */
-		fp = os_fopen(centry->path, "rb");
+
+		bg_job_t *stats_job;
+		if(qv_view_dir(centry->path, centry->max_lines, &lines, &stats_job) != 0)
+		{
+			*error = "Failed to list directory's contents";
+		}
+		else
+		{
+			centry->complete = (lines.nitems <= centry->max_lines);
+			while(lines.nitems > centry->max_lines)
+			{
+				free(lines.items[--lines.nitems]);
+			}
+		}
+
+		if(stats_job != NULL)
+		{
+			centry->job = stats_job;
+			centry->kill_timer = 0;
+			centry->started_at = time(NULL);
+			centry->truncated = 0;
+			centry->stats_pending = 1;
+		}
+
+		ui_cancellation_pop();
+		return lines;
 	}
 
-	strlist_t lines = {};
+	/* Binary mode is important on Windows. */
+	FILE *fp = os_fopen(centry->path, "rb");
 	if(fp != NULL)
 	{
 		int complete;
@@ -693,8 +721,7 @@ view_builtin(vcache_entry_t *centry, const char **error)
 	}
 	else
 	{
-		*error = dir ? "Failed to list directory's contents"
-		             : "Failed to read file's contents";
+		*error = "Failed to read file's contents";
 	}
 
 	ui_cancellation_pop();
@@ -751,14 +778,6 @@ view_external(vcache_entry_t *centry, MacroFlags flags, const char **error)
 		fclose(input);
 	}
 
-#ifndef _WIN32
-	/* Enable non-blocking read from output pipe.  On Windows we read the
-		* exact amount of data present in the stream. */
-	int fd = fileno(centry->job->output);
-	int file_flags = fcntl(fd, F_GETFL, 0);
-	fcntl(fd, F_SETFL, file_flags | O_NONBLOCK);
-#endif
-
 	return lines;
 }
 
@@ -27,6 +27,7 @@
 #include "utils/str.h"
 #include "utils/utils.h"
 #include "status.h"
+#include "trace.h"
 #include "vcache.h"
 
 /* This variable is automatically updated during build. */
@@ -35,7 +36,7 @@ extern const char GIT_INFO[];
 int
 fill_version_info(char **list, int include_stats)
 {
-	const int LEN = 22;
+	const int LEN = 23 + TP_COUNT;
 	int x = 0;
 
 	if(list == NULL)
@@ -130,6 +131,14 @@ fill_version_info(char **list, int include_stats)
 
 		list[x++] = strdup("");
 		list[x++] = format_str("Preview cache size: %s", size);
+
+		list[x++] = strdup("");
+		int i;
+		for(i = 0; i < TP_COUNT; ++i)
+		{
+			char line[128];
+			list[x++] = strdup(trace_format_stats(i, line, sizeof(line)));
+		}
 	}
 
 	assert(x <= LEN);
@@ -73,6 +73,7 @@
 #include "args.h"
 #include "background.h"
 #include "bracket_notation.h"
+#include "builtin_find.h"
 #include "builtin_functions.h"
 #include "cmd_completion.h"
 #include "cmd_core.h"
@@ -90,6 +91,7 @@
 #include "registers.h"
 #include "running.h"
 #include "signals.h"
+#include "startup_time.h"
 #include "status.h"
 #include "trash.h"
 #include "undo.h"
@@ -178,6 +180,13 @@ vifm_main(int argc, char *argv[])
 	args_parse(&vifm_args, argc, argv, dir);
 	args_process(&vifm_args, AS_GENERAL, curr_stats.ipc);
 
+	if(vifm_args.startup_time_path != NULL &&
+			stime_open(vifm_args.startup_time_path) != 0)
+	{
+		fprintf(stderr, "Failed to open startup time file: %s\n",
+				vifm_args.startup_time_path);
+	}
+
 	lwin_cv = (strcmp(vifm_args.lwin_path, "-") == 0 && vifm_args.lwin_handle);
 	rwin_cv = (strcmp(vifm_args.rwin_path, "-") == 0 && vifm_args.rwin_handle);
 	if(lwin_cv || rwin_cv)
@@ -209,6 +218,7 @@ vifm_main(int argc, char *argv[])
 		return -1;
 	}
 	args_process(&vifm_args, AS_IPC, ipc);
+	stime_mark("IPC initialization");
 
 	cfg_init();
 	init_filelists();
@@ -222,6 +232,7 @@ vifm_main(int argc, char *argv[])
 
 	init_builtin_functions();
 	update_path_env(1);
+	stime_mark("initialization of units");
 
 	if(stats_init(&cfg) != 0)
 	{
@@ -240,12 +251,14 @@ vifm_main(int argc, char *argv[])
 	ft_reset(curr_stats.exec_env_type == EET_EMULATOR_WITH_X);
 
 	init_option_handlers();
+	stime_mark("initialization of options");
 
 	if(!vifm_args.no_configs)
 	{
 		/* vifminfo must be processed this early so that it can restore last visited
-		 * directory. */
-		state_load(0);
+		 * directory.  What's not needed for drawing is loaded after it. */
+		state_load_deferred();
+		stime_mark("reading vifminfo");
 	}
 
 	/* Export chosen IPC server name to parsing unit. */
@@ -271,6 +284,7 @@ vifm_main(int argc, char *argv[])
 
 	load_initial_directory(&lwin, dir);
 	load_initial_directory(&rwin, dir);
+	stime_mark("loading initial directories");
 
 	/* Force split view when two paths are specified on command-line. */
 	if(vifm_args.lwin_path[0] != '\0' && vifm_args.rwin_path[0] != '\0')
@@ -296,16 +310,20 @@ vifm_main(int argc, char *argv[])
 	un_init(&undo_perform_func, NULL, &ui_cancellation_requested,
 			&cfg.undo_levels);
 	load_view_options(curr_view);
+	stime_mark("terminal initialization");
 
 	curr_stats.load_stage = 1;
 
 	curr_stats.vlua = vlua_init();
 	curr_stats.plugs = plugs_create(curr_stats.vlua);
+	stime_mark("Lua initialization");
 
 	if(!vifm_args.no_configs)
 	{
 		load_scheme();
+		stime_mark("loading color scheme");
 		cfg_load();
+		stime_mark("sourcing configuration");
 	}
 
 	if(lwin_cv || rwin_cv)
@@ -324,8 +342,6 @@ vifm_main(int argc, char *argv[])
 		(void)trash_set_specs(cfg.trash_dir);
 	}
 
-	plugs_load(curr_stats.plugs, cfg.config_dir);
-
 	check_path_for_file(&lwin, vifm_args.lwin_path, vifm_args.lwin_handle);
 	check_path_for_file(&rwin, vifm_args.rwin_path, vifm_args.rwin_handle);
 
@@ -348,9 +364,24 @@ vifm_main(int argc, char *argv[])
 	{
 		vle_aucmd_execute("DirEnter", flist_get_dir(&rwin), &rwin);
 	}
+	stime_mark("DirEnter autocommands");
 
 	update_screen(UT_FULL);
 	modes_update();
+	stime_mark("first drawing");
+
+	/* These don't affect the first drawing, so they are postponed to show the
+	 * interface sooner.  Startup commands might need them though. */
+	state_load_rest();
+	stime_mark("reading rest of vifminfo");
+	plugs_load(curr_stats.plugs, cfg.config_dir);
+	const plug_t *plug;
+	if(plugs_get(curr_stats.plugs, 0, &plug))
+	{
+		/* Plugins can define things that affect how views look. */
+		stats_redraw_later();
+	}
+	stime_mark("loading plugins");
 
 	/* Run startup commands after loading file lists into views, so that commands
 	 * like +1 work. */
@@ -361,6 +392,8 @@ vifm_main(int argc, char *argv[])
 	/* Update screen after startup commands while in load state 3 so CHPOS_STARTUP
 	 * has no effect and doesn't reset cursor position after `+"goto path"`. */
 	update_screen(stats_update_fetch());
+	stime_mark("startup commands");
+	stime_close();
 
 	event_loop(&quit, /*manage_marking=*/1);
 
@@ -488,6 +521,8 @@ check_path_for_file(view_t *view, const char path[], int handle)
 	{
 		if(handle)
 		{
+			/* Plugins aren't loaded yet, but they might provide a handler. */
+			plugs_load(curr_stats.plugs, cfg.config_dir);
 			rn_open(view, FHE_RUN);
 		}
 	}
@@ -668,6 +703,7 @@ void _gnuc_noreturn
 vifm_exit(int exit_code)
 {
 	vcache_finish();
+	bfind_drop_snapshot();
 	plugs_free(curr_stats.plugs);
 	vlua_finish(curr_stats.vlua);
 	ipc_free(curr_stats.ipc);
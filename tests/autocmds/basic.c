@@ -163,6 +163,41 @@ TEST(sub_tree_star)
 	assert_string_equal("action", action);
 }
 
+TEST(literal_patterns_ignore_case)
+{
+	assert_success(vle_aucmd_on_execute("cd", "/Path/Dir", "action", &handler));
+
+	vle_aucmd_execute("cd", "/path/dir/", NULL);
+	assert_string_equal("action", action);
+
+	action = NULL;
+
+	vle_aucmd_execute("cd", "/path/dir2", NULL);
+	assert_string_equal(NULL, action);
+}
+
+TEST(literal_names_match_last_component)
+{
+	assert_success(vle_aucmd_on_execute("cd", "name", "action", &handler));
+
+	vle_aucmd_execute("cd", "/name/sub", NULL);
+	assert_string_equal(NULL, action);
+
+	vle_aucmd_execute("cd", "/some/NAME", NULL);
+	assert_string_equal("action", action);
+}
+
+TEST(negated_literal_patterns)
+{
+	assert_success(vle_aucmd_on_execute("cd", "!/path", "action", &handler));
+
+	vle_aucmd_execute("cd", "/PATH", NULL);
+	assert_string_equal(NULL, action);
+
+	vle_aucmd_execute("cd", "/other", NULL);
+	assert_string_equal("action", action);
+}
+
 static void
 handler(const char a[], void *arg)
 {
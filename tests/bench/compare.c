@@ -0,0 +1,96 @@
+#include <stic.h>
+
+#include <test-utils.h>
+
+#include "../../src/ui/ui.h"
+#include "../../src/compare.h"
+#include "../../src/filelist.h"
+
+#include "utils.h"
+
+static void compare_prepare(void *arg);
+static void compare_names(void *arg);
+static void compare_sizes(void *arg);
+static void compare_contents(void *arg);
+
+static int ntree;
+
+SETUP_ONCE()
+{
+	/* 2^8 - 1 directories with 40 files in each. */
+	ntree = bench_make_tree(SANDBOX_PATH "/left", 7, 2, bench_scaled(40));
+	(void)bench_make_tree(SANDBOX_PATH "/right", 7, 2, bench_scaled(40));
+}
+
+TEARDOWN_ONCE()
+{
+	bench_remove(SANDBOX_PATH "/left");
+	bench_remove(SANDBOX_PATH "/right");
+}
+
+SETUP()
+{
+	columns_setup_column(SK_BY_NAME);
+	columns_setup_column(SK_BY_SIZE);
+}
+
+TEARDOWN()
+{
+	columns_teardown();
+}
+
+TEST(compare_by_names)
+{
+	bench_run("compare_two_panes/name", ntree, &compare_prepare, &compare_names,
+			NULL);
+	assert_true(flist_custom_active(&lwin));
+}
+
+TEST(compare_by_sizes)
+{
+	bench_run("compare_two_panes/size", ntree, &compare_prepare, &compare_sizes,
+			NULL);
+	assert_true(flist_custom_active(&lwin));
+}
+
+TEST(compare_by_contents)
+{
+	bench_run("compare_two_panes/contents", ntree, &compare_prepare,
+			&compare_contents, NULL);
+	assert_true(flist_custom_active(&lwin));
+}
+
+static void
+compare_prepare(void *arg)
+{
+	view_teardown(&lwin);
+	view_teardown(&rwin);
+	view_setup(&lwin);
+	view_setup(&rwin);
+
+	make_abs_path(lwin.curr_dir, sizeof(lwin.curr_dir), SANDBOX_PATH, "left",
+			NULL);
+	make_abs_path(rwin.curr_dir, sizeof(rwin.curr_dir), SANDBOX_PATH, "right",
+			NULL);
+}
+
+static void
+compare_names(void *arg)
+{
+	assert_success(compare_two_panes(CT_NAME, LT_ALL, CF_SHOW));
+}
+
+static void
+compare_sizes(void *arg)
+{
+	assert_success(compare_two_panes(CT_SIZE, LT_ALL, CF_SHOW));
+}
+
+static void
+compare_contents(void *arg)
+{
+	assert_success(compare_two_panes(CT_CONTENTS, LT_ALL, CF_SHOW));
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
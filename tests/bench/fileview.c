@@ -0,0 +1,135 @@
+#include <stic.h>
+
+#include <stdio.h> /* FILE fclose() fopen() */
+
+#include <stubs.h>
+#include <test-utils.h>
+
+#include "../../src/cfg/config.h"
+#include "../../src/compat/curses.h"
+#include "../../src/engine/cmds.h"
+#include "../../src/ui/column_view.h"
+#include "../../src/ui/fileview.h"
+#include "../../src/ui/ui.h"
+#include "../../src/cmd_core.h"
+#include "../../src/status.h"
+
+#include "utils.h"
+
+static int have_screen(void);
+static void draw(void *arg);
+
+/* Terminal that draws into /dev/null. */
+static SCREEN *screen;
+static FILE *term_in;
+static FILE *term_out;
+
+static int count;
+
+SETUP_ONCE()
+{
+	term_in = fopen("/dev/null", "r");
+	term_out = fopen("/dev/null", "w");
+	if(term_in != NULL && term_out != NULL)
+	{
+		screen = newterm("xterm", term_out, term_in);
+	}
+}
+
+TEARDOWN_ONCE()
+{
+	if(screen != NULL)
+	{
+		endwin();
+		delscreen(screen);
+		screen = NULL;
+	}
+	if(term_in != NULL)
+	{
+		fclose(term_in);
+	}
+	if(term_out != NULL)
+	{
+		fclose(term_out);
+	}
+}
+
+SETUP()
+{
+	if(screen == NULL)
+	{
+		return;
+	}
+
+	init_commands();
+
+	count = bench_scaled(100000);
+	bench_fill_view(&lwin, count);
+
+	cfg.columns = 200;
+	cfg.lines = 50;
+	lwin.window_cols = 200;
+	lwin.window_rows = 50;
+	lwin.win = newwin(lwin.window_rows, lwin.window_cols, 1, 0);
+	lwin.title = newwin(1, lwin.window_cols, 0, 0);
+
+	fview_setup();
+	lwin.columns = columns_create();
+	assert_success(exec_commands("set viewcolumns=-{name}..,6{size},12{mtime}",
+				&lwin, CIT_COMMAND));
+
+	curr_stats.load_stage = 2;
+	vifm_tests_testing = 0;
+}
+
+TEARDOWN()
+{
+	if(screen == NULL)
+	{
+		return;
+	}
+
+	vifm_tests_testing = 1;
+	curr_stats.load_stage = 0;
+
+	vle_cmds_reset();
+
+	columns_free(lwin.columns);
+	lwin.columns = NULL;
+	columns_teardown();
+
+	delwin(lwin.win);
+	delwin(lwin.title);
+	lwin.win = NULL;
+	lwin.title = NULL;
+}
+
+TEST(draw_table, IF(have_screen))
+{
+	bench_run("draw_dir_list/table", count, NULL, &draw, &lwin);
+}
+
+TEST(draw_grid, IF(have_screen))
+{
+	lwin.ls_view = 1;
+	bench_run("draw_dir_list/grid", count, NULL, &draw, &lwin);
+	lwin.ls_view = 0;
+}
+
+static int
+have_screen(void)
+{
+	return (screen != NULL);
+}
+
+static void
+draw(void *arg)
+{
+	view_t *view = arg;
+	/* Drop cached widths to get the full cost of a redraw after a change. */
+	view->max_filename_width = 0;
+	draw_dir_list(view);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
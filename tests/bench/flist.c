@@ -0,0 +1,123 @@
+#include <stic.h>
+
+#include <limits.h> /* INT_MAX */
+#include <string.h> /* strcpy() */
+
+#include <test-utils.h>
+
+#include "../../src/compat/fs_limits.h"
+#include "../../src/ui/ui.h"
+#include "../../src/filelist.h"
+#include "../../src/filtering.h"
+
+#include "utils.h"
+
+static void load(void *arg);
+static void load_tree(void *arg);
+static void cancel_filter(void *arg);
+static void set_filter(void *arg);
+static void apply_filter(void *arg);
+
+static int nfiles;
+static int ntree;
+
+SETUP_ONCE()
+{
+	nfiles = bench_scaled(10000);
+	bench_make_files(SANDBOX_PATH "/files", nfiles);
+	if(not_windows())
+	{
+		bench_make_links(SANDBOX_PATH "/links", SANDBOX_PATH "/files", nfiles);
+	}
+	/* 2^10 - 1 directories with 10 files in each. */
+	ntree = bench_make_tree(SANDBOX_PATH "/tree", 9, 2, bench_scaled(10));
+}
+
+TEARDOWN_ONCE()
+{
+	bench_remove(SANDBOX_PATH "/files");
+	if(not_windows())
+	{
+		bench_remove(SANDBOX_PATH "/links");
+	}
+	bench_remove(SANDBOX_PATH "/tree");
+}
+
+TEST(load_files)
+{
+	make_abs_path(lwin.curr_dir, sizeof(lwin.curr_dir), SANDBOX_PATH, "files",
+			NULL);
+	bench_run("load_dir_list/files", nfiles, NULL, &load, &lwin);
+	assert_int_equal(nfiles, lwin.list_rows);
+}
+
+TEST(load_symlinks, IF(not_windows))
+{
+	make_abs_path(lwin.curr_dir, sizeof(lwin.curr_dir), SANDBOX_PATH, "links",
+			NULL);
+	bench_run("load_dir_list/symlinks", nfiles, NULL, &load, &lwin);
+	assert_int_equal(nfiles, lwin.list_rows);
+}
+
+TEST(load_deep_tree)
+{
+	bench_run("flist_load_tree/deep", ntree, NULL, &load_tree, &lwin);
+	assert_int_equal(ntree, lwin.list_rows);
+}
+
+TEST(interactive_local_filter)
+{
+	make_abs_path(lwin.curr_dir, sizeof(lwin.curr_dir), SANDBOX_PATH, "files",
+			NULL);
+	load_dir_list(&lwin, 1);
+
+	bench_run("local_filter_set", nfiles, &cancel_filter, &set_filter, &lwin);
+	local_filter_cancel(&lwin);
+}
+
+TEST(applied_local_filter)
+{
+	make_abs_path(lwin.curr_dir, sizeof(lwin.curr_dir), SANDBOX_PATH, "files",
+			NULL);
+	load_dir_list(&lwin, 1);
+
+	bench_run("local_filter_apply", nfiles, NULL, &apply_filter, &lwin);
+	assert_true(lwin.list_rows < nfiles);
+	local_filter_remove(&lwin);
+}
+
+static void
+load(void *arg)
+{
+	load_dir_list(arg, 1);
+}
+
+static void
+load_tree(void *arg)
+{
+	char path[PATH_MAX + 1];
+	make_abs_path(path, sizeof(path), SANDBOX_PATH, "tree", NULL);
+	assert_success(flist_load_tree(arg, path, INT_MAX));
+}
+
+static void
+cancel_filter(void *arg)
+{
+	local_filter_cancel(arg);
+}
+
+static void
+set_filter(void *arg)
+{
+	assert_success(local_filter_set(arg, "1"));
+}
+
+static void
+apply_filter(void *arg)
+{
+	local_filter_apply(arg, "1");
+	load_dir_list(arg, 1);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
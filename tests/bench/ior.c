@@ -0,0 +1,76 @@
+#include <stic.h>
+
+#include <unistd.h> /* F_OK access() */
+
+#include "../../src/io/ioc.h"
+#include "../../src/io/ior.h"
+
+#include "utils.h"
+
+static void cp_prepare(void *arg);
+static void cp(void *arg);
+static void rm_prepare(void *arg);
+static void rm(void *arg);
+
+static int ntree;
+
+SETUP_ONCE()
+{
+	/* 2^8 - 1 directories with 40 files in each. */
+	ntree = bench_make_tree(SANDBOX_PATH "/tree", 7, 2, bench_scaled(40));
+}
+
+TEARDOWN_ONCE()
+{
+	bench_remove(SANDBOX_PATH "/tree");
+}
+
+TEST(copy_tree)
+{
+	bench_run("ior_cp/tree", ntree, &cp_prepare, &cp, NULL);
+	bench_remove(SANDBOX_PATH "/copy");
+}
+
+TEST(remove_tree)
+{
+	bench_run("ior_rm/tree", ntree, &rm_prepare, &rm, NULL);
+}
+
+static void
+cp_prepare(void *arg)
+{
+	if(access(SANDBOX_PATH "/copy", F_OK) == 0)
+	{
+		bench_remove(SANDBOX_PATH "/copy");
+	}
+}
+
+static void
+cp(void *arg)
+{
+	io_args_t args = {
+		.arg1.src = SANDBOX_PATH "/tree",
+		.arg2.dst = SANDBOX_PATH "/copy",
+	};
+	ioe_errlst_init(&args.result.errors);
+
+	assert_int_equal(IO_RES_SUCCEEDED, ior_cp(&args));
+	assert_int_equal(0, args.result.errors.error_count);
+	ioe_errlst_free(&args.result.errors);
+}
+
+static void
+rm_prepare(void *arg)
+{
+	cp_prepare(arg);
+	cp(arg);
+}
+
+static void
+rm(void *arg)
+{
+	bench_remove(SANDBOX_PATH "/copy");
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
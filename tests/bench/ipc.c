@@ -0,0 +1,126 @@
+#include <stic.h>
+
+#include <stdlib.h> /* free() */
+#include <string.h> /* strdup() */
+
+#include "../../src/compat/pthread.h"
+#include "../../src/ipc.h"
+
+#include "utils.h"
+
+static void send_all(void *arg);
+static void eval_all(void *arg);
+static void * serve(void *arg);
+static void args_cb(char *args[]);
+static char * eval_cb(const char expr[]);
+static int enabled_and_not_windows(void);
+
+/* Number of requests to send. */
+static int count;
+/* Number of requests handled by the server. */
+static int served;
+/* Instance that plays the role of --remote client. */
+static ipc_t *client;
+/* Instance that plays the role of running vifm. */
+static ipc_t *server;
+
+SETUP()
+{
+	count = bench_scaled(1000);
+
+	client = ipc_init("vifm-bench", &args_cb, &eval_cb);
+	server = ipc_init("vifm-bench", &args_cb, &eval_cb);
+	assert_non_null(client);
+	assert_non_null(server);
+}
+
+TEARDOWN()
+{
+	ipc_free(client);
+	ipc_free(server);
+}
+
+TEST(remote_args_are_delivered, IF(enabled_and_not_windows))
+{
+	bench_run("ipc/remote", count, NULL, &send_all, NULL);
+}
+
+TEST(remote_expr_round_trip, IF(enabled_and_not_windows))
+{
+	bench_run("ipc/remote-expr", count, NULL, &eval_all, NULL);
+}
+
+/* Sends all requests like --remote does and waits for them to be handled. */
+static void
+send_all(void *arg)
+{
+	pthread_t id;
+	assert_success(pthread_create(&id, NULL, &serve, NULL));
+
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		char cmd[] = "+echo";
+		char *data[] = { cmd, NULL };
+		assert_success(ipc_send(client, ipc_get_name(server), data));
+	}
+
+	assert_success(pthread_join(id, NULL));
+}
+
+/* Evaluates expressions like --remote-expr does waiting for every reply. */
+static void
+eval_all(void *arg)
+{
+	pthread_t id;
+	assert_success(pthread_create(&id, NULL, &serve, NULL));
+
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		char *const result = ipc_eval(client, ipc_get_name(server), "expr");
+		assert_non_null(result);
+		free(result);
+	}
+
+	assert_success(pthread_join(id, NULL));
+}
+
+/* Entry point of a thread that handles requests until all of them are
+ * served. */
+static void *
+serve(void *arg)
+{
+	served = 0;
+	while(served < count)
+	{
+		(void)ipc_check(server);
+	}
+	return NULL;
+}
+
+static void
+args_cb(char *args[])
+{
+	++served;
+}
+
+static char *
+eval_cb(const char expr[])
+{
+	++served;
+	return strdup("result");
+}
+
+static int
+enabled_and_not_windows(void)
+{
+#ifndef _WIN32
+	return ipc_enabled();
+#else
+	return 0;
+#endif
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,70 @@
+#include <stic.h>
+
+#include "../../src/engine/functions.h"
+#include "../../src/engine/parsing.h"
+#include "../../src/engine/var.h"
+#include "../../src/utils/macros.h"
+
+#include "utils.h"
+
+static void parse_all(void *arg);
+static var_t identity(const call_info_t *call_info);
+
+/* Expressions of the kind that appear in conditions of autocommands, mappings
+ * and such. */
+static const char *const exprs[] = {
+	"1 + 2 * 3 == 7 && 'abc' . 'def' != ''",
+	"id('long string literal') . ' ' . id(\"and another one\")",
+	"-10 < 10 || !(1 == 1) && 'a' <= 'b'",
+	"id(id(id(1 + 1))) >= 2",
+	"(1 + (2 + (3 + (4 + (5 + (6 + (7 + 8))))))) - 36",
+	"'x' == 'y' || 'yes' != 'no'",
+};
+
+static int count;
+
+SETUP()
+{
+	static const function_t id_function = { "id", "descr", {1,1}, &identity };
+	assert_success(function_register(&id_function));
+
+	init_parser(NULL);
+
+	count = bench_scaled(10000);
+}
+
+TEARDOWN()
+{
+	function_reset_all();
+}
+
+TEST(repeated_parsing_of_same_expressions)
+{
+	bench_run("parse/repeated", count*ARRAY_LEN(exprs), NULL, &parse_all,
+			NULL);
+}
+
+static void
+parse_all(void *arg)
+{
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		size_t j;
+		for(j = 0U; j < ARRAY_LEN(exprs); ++j)
+		{
+			var_t result = var_false();
+			(void)parse(exprs[j], 0, &result);
+			var_free(result);
+		}
+	}
+}
+
+static var_t
+identity(const call_info_t *call_info)
+{
+	return var_clone(call_info->argv[0]);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,66 @@
+#include <stic.h>
+
+#include <string.h> /* memset() */
+
+#include "../../src/ui/ui.h"
+#include "../../src/sort.h"
+
+#include "utils.h"
+
+static void sort_prepare(void *arg);
+static void sort(void *arg);
+
+static int count;
+
+SETUP()
+{
+	count = bench_scaled(100000);
+	bench_fill_view(&lwin, count);
+	memset(&lwin.sort[1], SK_NONE, sizeof(lwin.sort) - 1);
+}
+
+TEST(sort_by_name)
+{
+	lwin.sort[0] = SK_BY_NAME;
+	bench_run("sort_view/name", count, &sort_prepare, &sort, &lwin);
+}
+
+TEST(sort_by_extension)
+{
+	lwin.sort[0] = SK_BY_EXTENSION;
+	bench_run("sort_view/extension", count, &sort_prepare, &sort, &lwin);
+}
+
+TEST(sort_by_size)
+{
+	lwin.sort[0] = SK_BY_SIZE;
+	bench_run("sort_view/size", count, &sort_prepare, &sort, &lwin);
+}
+
+TEST(sort_by_mtime)
+{
+	lwin.sort[0] = SK_BY_TIME_MODIFIED;
+	bench_run("sort_view/mtime", count, &sort_prepare, &sort, &lwin);
+}
+
+TEST(sort_by_type_and_name)
+{
+	lwin.sort[0] = SK_BY_DIR;
+	lwin.sort[1] = SK_BY_NAME;
+	bench_run("sort_view/dir,name", count, &sort_prepare, &sort, &lwin);
+}
+
+static void
+sort_prepare(void *arg)
+{
+	bench_shuffle_view(arg);
+}
+
+static void
+sort(void *arg)
+{
+	sort_view(arg);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,56 @@
+#include <stic.h>
+
+#include <test-utils.h>
+
+#include "../../src/cfg/config.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/str.h"
+#include "../../src/status.h"
+
+#include "utils.h"
+
+/* This suite measures performance of hot paths instead of checking
+ * correctness.  It's built along with tests, but is run only on explicit
+ * request, see utils.h for how to configure it. */
+
+DEFINE_SUITE();
+
+SETUP_ONCE()
+{
+	fix_environ();
+	stub_colmgr();
+	assert_success(stats_init(&cfg));
+
+	bench_init();
+}
+
+TEARDOWN_ONCE()
+{
+	bench_report();
+}
+
+SETUP()
+{
+	update_string(&cfg.fuse_home, "no");
+	update_string(&cfg.slow_fs_list, "");
+
+	curr_view = &lwin;
+	other_view = &rwin;
+
+	view_setup(&lwin);
+	view_setup(&rwin);
+	opt_handlers_setup();
+}
+
+TEARDOWN()
+{
+	opt_handlers_teardown();
+	view_teardown(&lwin);
+	view_teardown(&rwin);
+
+	update_string(&cfg.slow_fs_list, NULL);
+	update_string(&cfg.fuse_home, NULL);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,309 @@
+#include "utils.h"
+
+#include <stic.h>
+
+#include <unistd.h> /* symlink() */
+
+#include <stdio.h> /* FILE fclose() fopen() fprintf() fputc() snprintf() */
+#include <stdlib.h> /* atoi() free() qsort() */
+#include <string.h> /* strdup() */
+
+#include "../../src/compat/fs_limits.h"
+#include "../../src/compat/os.h"
+#include "../../src/compat/reallocarray.h"
+#include "../../src/io/ioc.h"
+#include "../../src/io/ior.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/dynarray.h"
+#include "../../src/utils/env.h"
+#include "../../src/utils/macros.h"
+#include "../../src/utils/str.h"
+#include "../../src/utils/utils.h"
+
+/* Result of measuring a single benchmark. */
+typedef struct
+{
+	char *name;       /* Name of the benchmark. */
+	int size;         /* Number of items processed by the benchmark. */
+	int runs;         /* Number of measured runs. */
+	long long min;    /* Time of the fastest run in microseconds. */
+	long long median; /* Median time in microseconds. */
+	long long max;    /* Time of the slowest run in microseconds. */
+}
+result_t;
+
+static int get_env_int(const char name[], int def);
+static int time_cmp(const void *a, const void *b);
+static void print_ms(FILE *fp, const char key[], long long us);
+static void make_tree(const char dir[], int depth, int fanout, int files,
+		int *count);
+
+/* Extensions of generated files. */
+static const char *const exts[] = { "c", "h", "txt", "tar.gz", "png", "" };
+
+/* Number of measured runs of each benchmark. */
+static int nruns;
+/* Multiplier for number of items. */
+static int scale;
+
+/* Recorded results. */
+static result_t *results;
+/* Number of elements in the results array. */
+static int nresults;
+
+void
+bench_init(void)
+{
+	nruns = get_env_int("BENCH_RUNS", 5);
+	scale = get_env_int("BENCH_SCALE", 1);
+}
+
+/* Reads a positive integer from the environment.  Returns the value or the
+ * default. */
+static int
+get_env_int(const char name[], int def)
+{
+	const char *value = env_get(name);
+	const int n = (value == NULL ? 0 : atoi(value));
+	return (n > 0 ? n : def);
+}
+
+void
+bench_report(void)
+{
+	const char *path = env_get("BENCH_JSON");
+	FILE *fp = (is_null_or_empty(path) ? stdout : fopen(path, "w"));
+	if(fp == NULL)
+	{
+		fprintf(stderr, "Failed to open %s for writing\n", path);
+		fp = stdout;
+	}
+
+	fprintf(fp, "{\n  \"runs\": %d,\n  \"scale\": %d,\n  \"benchmarks\": [",
+			nruns, scale);
+
+	int i;
+	for(i = 0; i < nresults; ++i)
+	{
+		const result_t *r = &results[i];
+		fprintf(fp, "%s\n    { \"name\": \"%s\", \"size\": %d, \"runs\": %d",
+				(i == 0 ? "" : ","), r->name, r->size, r->runs);
+		print_ms(fp, "min_ms", r->min);
+		print_ms(fp, "median_ms", r->median);
+		print_ms(fp, "max_ms", r->max);
+		fputs(" }", fp);
+
+		free(r->name);
+	}
+
+	fputs("\n  ]\n}\n", fp);
+	if(fp != stdout)
+	{
+		fclose(fp);
+	}
+
+	free(results);
+	results = NULL;
+	nresults = 0;
+}
+
+/* Prints JSON field with time in milliseconds. */
+static void
+print_ms(FILE *fp, const char key[], long long us)
+{
+	fprintf(fp, ", \"%s\": %lld.%03lld", key, us/1000, us%1000);
+}
+
+int
+bench_scaled(int count)
+{
+	return count*scale;
+}
+
+void
+bench_run(const char name[], int size, bench_func prepare, bench_func func,
+		void *arg)
+{
+	long long times[nruns];
+
+	int i;
+	for(i = 0; i < nruns; ++i)
+	{
+		if(prepare != NULL)
+		{
+			prepare(arg);
+		}
+
+		const long long start = time_in_us();
+		func(arg);
+		times[i] = time_in_us() - start;
+	}
+
+	qsort(times, nruns, sizeof(times[0]), &time_cmp);
+
+	result_t *new_results = reallocarray(results, nresults + 1,
+			sizeof(*results));
+	assert_non_null(new_results);
+	if(new_results == NULL)
+	{
+		return;
+	}
+	results = new_results;
+
+	result_t *r = &results[nresults++];
+	r->name = strdup(name);
+	r->size = size;
+	r->runs = nruns;
+	r->min = times[0];
+	r->median = times[nruns/2];
+	r->max = times[nruns - 1];
+}
+
+/* qsort() comparer for times.  Returns standard -1, 0, 1 for comparisons. */
+static int
+time_cmp(const void *a, const void *b)
+{
+	const long long x = *(const long long *)a;
+	const long long y = *(const long long *)b;
+	return (x > y) - (x < y);
+}
+
+void
+bench_make_files(const char dir[], int count)
+{
+	assert_success(os_mkdir(dir, 0700));
+
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		const char *ext = exts[i%ARRAY_LEN(exts)];
+
+		char path[PATH_MAX + 1];
+		snprintf(path, sizeof(path), "%s/file%d%s%s", dir, i,
+				(ext[0] == '\0' ? "" : "."), ext);
+
+		FILE *fp = fopen(path, "w");
+		assert_non_null(fp);
+		if(fp != NULL)
+		{
+			int j;
+			for(j = 0; j < i%64; ++j)
+			{
+				fputc('x', fp);
+			}
+			fclose(fp);
+		}
+	}
+}
+
+void
+bench_make_links(const char dir[], const char target_dir[], int count)
+{
+	assert_success(os_mkdir(dir, 0700));
+
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		const char *ext = exts[i%ARRAY_LEN(exts)];
+		const char *dot = (ext[0] == '\0' ? "" : ".");
+
+		char target[PATH_MAX + 1];
+		snprintf(target, sizeof(target), "%s/file%d%s%s", target_dir, i, dot, ext);
+		char path[PATH_MAX + 1];
+		snprintf(path, sizeof(path), "%s/link%d%s%s", dir, i, dot, ext);
+
+#ifndef _WIN32
+		assert_success(symlink(target, path));
+#endif
+	}
+}
+
+int
+bench_make_tree(const char dir[], int depth, int fanout, int files)
+{
+	int count = 0;
+	make_tree(dir, depth, fanout, files, &count);
+	return count - 1;
+}
+
+/* Recursive implementation of bench_make_tree(). */
+static void
+make_tree(const char dir[], int depth, int fanout, int files, int *count)
+{
+	bench_make_files(dir, files);
+	*count += 1 + files;
+
+	if(depth == 0)
+	{
+		return;
+	}
+
+	int i;
+	for(i = 0; i < fanout; ++i)
+	{
+		char path[PATH_MAX + 1];
+		snprintf(path, sizeof(path), "%s/dir%d", dir, i);
+		make_tree(path, depth - 1, fanout, files, count);
+	}
+}
+
+void
+bench_remove(const char path[])
+{
+	io_args_t args = {
+		.arg1.src = path,
+	};
+	ioe_errlst_init(&args.result.errors);
+
+	assert_int_equal(IO_RES_SUCCEEDED, ior_rm(&args));
+	assert_int_equal(0, args.result.errors.error_count);
+	ioe_errlst_free(&args.result.errors);
+}
+
+void
+bench_fill_view(view_t *view, int count)
+{
+	view->dir_entry = dynarray_cextend(NULL, count*sizeof(*view->dir_entry));
+	view->list_rows = count;
+
+	int i;
+	for(i = 0; i < count; ++i)
+	{
+		dir_entry_t *entry = &view->dir_entry[i];
+		const char *ext = exts[i%ARRAY_LEN(exts)];
+
+		entry->name = format_str("file%d%s%s", i, (ext[0] == '\0' ? "" : "."),
+				ext);
+		entry->origin = view->curr_dir;
+		entry->type = (i%10 == 0 ? FT_DIR : FT_REG);
+		entry->size = (i*7919LL)%100000;
+		entry->mtime = 1000000000 + (i*104729LL)%100000000;
+		entry->atime = entry->mtime;
+		entry->ctime = entry->mtime;
+		entry->mode = (entry->type == FT_DIR ? 0040755 : 0100644);
+		entry->nlinks = 1;
+		entry->hi_num = -1;
+		entry->name_dec_num = -1;
+	}
+}
+
+void
+bench_shuffle_view(view_t *view)
+{
+	/* Linear congruential generator to be independent of rand(). */
+	unsigned int state = 12345U;
+
+	int i;
+	for(i = view->list_rows - 1; i > 0; --i)
+	{
+		state = state*1103515245U + 12345U;
+		const int j = (state >> 8)%(i + 1);
+
+		const dir_entry_t tmp = view->dir_entry[i];
+		view->dir_entry[i] = view->dir_entry[j];
+		view->dir_entry[j] = tmp;
+	}
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
@@ -0,0 +1,56 @@
+#ifndef VIFM_TESTS__BENCH__UTILS_H__
+#define VIFM_TESTS__BENCH__UTILS_H__
+
+/* Harness for benchmarks.  Their number and size can be controlled via
+ * environment:
+ *  - $BENCH_RUNS  -- number of measured runs of each benchmark (5 by default)
+ *  - $BENCH_SCALE -- multiplier for number of items (1 by default)
+ *  - $BENCH_JSON  -- path to write results to (standard output by default) */
+
+struct view_t;
+
+/* Function to measure or to prepare state before measuring. */
+typedef void (*bench_func)(void *arg);
+
+/* Reads settings from the environment. */
+void bench_init(void);
+
+/* Writes all recorded results as a JSON document and frees them. */
+void bench_report(void);
+
+/* Computes number of items for a benchmark.  Returns the count multiplied by
+ * the scale factor. */
+int bench_scaled(int count);
+
+/* Measures the function several times calling prepare (if it's not NULL)
+ * before each run outside of measured time and records the result under the
+ * name. */
+void bench_run(const char name[], int size, bench_func prepare,
+		bench_func func, void *arg);
+
+/* Creates the directory and fills it with the number of files of different
+ * names, extensions and sizes. */
+void bench_make_files(const char dir[], int count);
+
+/* Creates the directory and fills it with the number of symbolic links to
+ * files created by bench_make_files() in another directory. */
+void bench_make_links(const char dir[], const char target_dir[], int count);
+
+/* Creates the directory and a tree of subdirectories of the specified depth
+ * in it, each directory has fanout subdirectories and the number of files.
+ * Returns number of created files and directories excluding the root. */
+int bench_make_tree(const char dir[], int depth, int fanout, int files);
+
+/* Removes file or directory recursively. */
+void bench_remove(const char path[]);
+
+/* Fills the view with the number of entries that aren't backed by files. */
+void bench_fill_view(struct view_t *view, int count);
+
+/* Reorders entries of the view pseudo-randomly in a reproducible manner. */
+void bench_shuffle_view(struct view_t *view);
+
+#endif /* VIFM_TESTS__BENCH__UTILS_H__ */
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 : */
@@ -122,6 +122,20 @@ TEST(udc_can_be_removed)
 	assert_false(move_cmd_called);
 }
 
+TEST(removed_udc_does_not_shadow_longer_one)
+{
+	assert_success(vle_cmds_run("command udfa b"));
+	assert_success(vle_cmds_run("udf"));
+	assert_string_equal("udf", user_cmd_info.user_cmd);
+
+	assert_success(vle_cmds_run("delcommand udf"));
+	assert_success(vle_cmds_run("udf"));
+	assert_string_equal("udfa", user_cmd_info.user_cmd);
+
+	assert_success(vle_cmds_run("comclear"));
+	assert_int_equal(CMDS_ERR_INVALID_CMD, vle_cmds_run("udfa"));
+}
+
 TEST(all_udcs_are_listed)
 {
 	char **list = vle_cmds_list_udcs();
@@ -0,0 +1,151 @@
+#include <stic.h>
+
+#include <stddef.h> /* NULL size_t */
+#include <stdio.h> /* snprintf() */
+#include <string.h> /* memset() strcpy() strlen() */
+
+#include "../../src/ui/column_view.h"
+#include "test.h"
+
+#define CACHED_ID 3
+
+static void column_line_print(const void *data, int column_id,
+		const char buf[], size_t offset, AlignType align);
+static void cached_func(void *data, size_t buf_len, char buf[],
+		const format_info_t *info);
+static void column1_func(void *data, size_t buf_len, char buf[],
+		const format_info_t *info);
+static void format(const void *key, int stamp);
+
+static const size_t MAX_WIDTH = 20;
+
+static char print_buffer[80 + 1];
+static int ncached_calls;
+static int ncol1_calls;
+static columns_t *cols;
+
+SETUP()
+{
+	static column_info_t cached_column = {
+		.column_id = CACHED_ID, .full_width = 10UL,    .text_width = 10UL,
+		.align = AT_LEFT,       .sizing = ST_ABSOLUTE, .cropping = CT_TRUNCATE,
+	};
+	static column_info_t col1_column = {
+		.column_id = COL1_ID, .full_width = 10UL,    .text_width = 10UL,
+		.align = AT_RIGHT,    .sizing = ST_ABSOLUTE, .cropping = CT_TRUNCATE,
+	};
+
+	print_next = &column_line_print;
+	col1_next = &column1_func;
+
+	assert_success(columns_add_cached_column_desc(CACHED_ID, &cached_func,
+				NULL));
+
+	cols = columns_create();
+	columns_add_column(cols, cached_column);
+	columns_add_column(cols, col1_column);
+
+	ncached_calls = 0;
+	ncol1_calls = 0;
+}
+
+TEARDOWN()
+{
+	columns_free(cols);
+
+	print_next = NULL;
+	col1_next = NULL;
+}
+
+static void
+column_line_print(const void *data, int column_id, const char buf[],
+		size_t offset, AlignType align)
+{
+	memcpy(print_buffer + offset, buf, strlen(buf));
+}
+
+static void
+cached_func(void *data, size_t buf_len, char buf[], const format_info_t *info)
+{
+	++ncached_calls;
+	snprintf(buf, buf_len, "%s", (const char *)info->data);
+}
+
+static void
+column1_func(void *data, size_t buf_len, char buf[], const format_info_t *info)
+{
+	++ncol1_calls;
+	strcpy(buf, "col1");
+}
+
+TEST(values_are_cached_per_key_and_stamp)
+{
+	char key1[] = "key1";
+	char key2[] = "key2";
+
+	format(key1, 1);
+	assert_string_equal("key1            col1", print_buffer);
+	format(key1, 1);
+	assert_string_equal("key1            col1", print_buffer);
+	assert_int_equal(1, ncached_calls);
+	assert_int_equal(2, ncol1_calls);
+
+	format(key2, 1);
+	assert_string_equal("key2            col1", print_buffer);
+	assert_int_equal(2, ncached_calls);
+
+	format(key1, 1);
+	assert_string_equal("key1            col1", print_buffer);
+	assert_int_equal(2, ncached_calls);
+
+	/* Change of stamp invalidates the value. */
+	format(key1, 2);
+	assert_int_equal(3, ncached_calls);
+	format(key1, 2);
+	assert_int_equal(3, ncached_calls);
+}
+
+TEST(cache_can_be_dropped)
+{
+	char key[] = "key";
+
+	format(key, 1);
+	format(key, 1);
+	assert_int_equal(1, ncached_calls);
+
+	columns_drop_cache(cols);
+	format(key, 1);
+	assert_int_equal(2, ncached_calls);
+}
+
+TEST(no_caching_without_key)
+{
+	memset(print_buffer, '\0', MAX_WIDTH);
+	columns_format_row(cols, "abc", NULL, 1, MAX_WIDTH);
+	assert_string_equal("abc             col1", print_buffer);
+	columns_format_line(cols, "abc", MAX_WIDTH);
+	assert_string_equal("abc             col1", print_buffer);
+	assert_int_equal(2, ncached_calls);
+}
+
+TEST(cached_values_are_truncated)
+{
+	char key[] = "long-enough-key";
+
+	format(key, 1);
+	assert_string_equal("long-enoug      col1", print_buffer);
+	format(key, 1);
+	assert_string_equal("long-enoug      col1", print_buffer);
+	assert_int_equal(1, ncached_calls);
+}
+
+/* Formats a line using key as both row key and its value. */
+static void
+format(const void *key, int stamp)
+{
+	memset(print_buffer, '\0', MAX_WIDTH);
+	columns_format_row(cols, (void *)key, key, stamp, MAX_WIDTH);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,276 @@
+#include <stic.h>
+
+#include <unistd.h> /* usleep() */
+
+#include <stdlib.h> /* free() qsort() */
+#include <string.h> /* memset() strcmp() */
+
+#include <test-utils.h>
+
+#include "../../src/cfg/config.h"
+#include "../../src/compat/fs_limits.h"
+#include "../../src/engine/options.h"
+#include "../../src/menus/find_menu.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/str.h"
+#include "../../src/utils/string_array.h"
+#include "../../src/background.h"
+#include "../../src/builtin_find.h"
+#include "../../src/filelist.h"
+#include "../../src/flist_stream.h"
+
+static void run_find(const char pattern[], const char target[], int snapshot);
+static void line_handler(const char line[], void *arg);
+static int str_cmp(const void *a, const void *b);
+static void find_fails(const char pattern[], const char error[]);
+static void find_into_custom_view(int with_path, const char args[]);
+
+/* Output of the last search split into sorted lines. */
+static strlist_t lines;
+
+SETUP()
+{
+	create_file(SANDBOX_PATH "/a.txt");
+	create_file(SANDBOX_PATH "/a.c");
+	create_dir(SANDBOX_PATH "/sub");
+	create_file(SANDBOX_PATH "/sub/b.txt");
+}
+
+TEARDOWN()
+{
+	free_string_array(lines.items, lines.nitems);
+	lines.items = NULL;
+	lines.nitems = 0;
+
+	wait_for_all_bg();
+	bfind_drop_snapshot();
+
+	remove_file(SANDBOX_PATH "/a.txt");
+	remove_file(SANDBOX_PATH "/a.c");
+	remove_file(SANDBOX_PATH "/sub/b.txt");
+	remove_dir(SANDBOX_PATH "/sub");
+}
+
+TEST(names_are_matched_by_globs)
+{
+	run_find("*.txt", ".", 0);
+	assert_int_equal(2, lines.nitems);
+	assert_string_equal("./a.txt", lines.items[0]);
+	assert_string_equal("./sub/b.txt", lines.items[1]);
+}
+
+TEST(directories_are_found_but_targets_are_not_reported)
+{
+	run_find("*", "sub", 0);
+	assert_int_equal(1, lines.nitems);
+	assert_string_equal("sub/b.txt", lines.items[0]);
+
+	run_find("sub", ".", 0);
+	assert_int_equal(1, lines.nitems);
+	assert_string_equal("./sub", lines.items[0]);
+}
+
+TEST(file_targets_are_matched)
+{
+	run_find("*.c", "a.c", 0);
+	assert_int_equal(1, lines.nitems);
+	assert_string_equal("a.c", lines.items[0]);
+
+	run_find("*.txt", "a.c", 0);
+	assert_int_equal(0, lines.nitems);
+}
+
+TEST(regular_expressions_are_supported)
+{
+	run_find("/^a\\./", ".", 0);
+	assert_int_equal(2, lines.nitems);
+	assert_string_equal("./a.c", lines.items[0]);
+	assert_string_equal("./a.txt", lines.items[1]);
+
+	run_find("//sub/b//", ".", 0);
+	assert_int_equal(1, lines.nitems);
+	assert_string_equal("./sub/b.txt", lines.items[0]);
+}
+
+TEST(errors_are_reported)
+{
+	find_fails("", "No pattern specified");
+	find_fails("<text/plain>", "Mime-type patterns aren't supported");
+	find_fails("/(/", NULL);
+}
+
+TEST(snapshot_is_reused_until_dropped)
+{
+	run_find("*.txt", ".", 1);
+	assert_int_equal(2, lines.nitems);
+
+	create_file(SANDBOX_PATH "/new.txt");
+
+	/* Other targets don't use snapshot. */
+	run_find("*.txt", "sub", 1);
+	assert_int_equal(1, lines.nitems);
+
+	run_find("*.txt", ".", 1);
+	assert_int_equal(2, lines.nitems);
+
+	run_find("*.txt", ".", 0);
+	assert_int_equal(3, lines.nitems);
+
+	bfind_drop_snapshot();
+	run_find("*.txt", ".", 1);
+	assert_int_equal(3, lines.nitems);
+
+	remove_file(SANDBOX_PATH "/new.txt");
+}
+
+TEST(snapshot_is_dropped_on_changing_findprg)
+{
+	view_setup(&lwin);
+	curr_view = &lwin;
+	other_view = &lwin;
+	opt_handlers_setup();
+
+	run_find("*.txt", ".", 1);
+	assert_int_equal(2, lines.nitems);
+
+	create_file(SANDBOX_PATH "/new.txt");
+
+	assert_success(vle_opts_set("findprg=builtin", OPT_GLOBAL));
+	run_find("*.txt", ".", 1);
+	assert_int_equal(3, lines.nitems);
+
+	remove_file(SANDBOX_PATH "/new.txt");
+
+	opt_handlers_teardown();
+	view_teardown(&lwin);
+}
+
+TEST(find_command_can_fill_custom_view)
+{
+	find_into_custom_view(0, "*.txt");
+	assert_string_equal("Find *.txt", lwin.custom.title);
+	assert_int_equal(2, lwin.list_rows);
+	assert_string_equal("a.txt", lwin.dir_entry[0].name);
+	assert_string_equal("b.txt", lwin.dir_entry[1].name);
+
+	opt_handlers_teardown();
+	view_teardown(&lwin);
+}
+
+TEST(find_command_with_path_can_fill_custom_view)
+{
+	find_into_custom_view(1, "sub *.txt");
+	assert_int_equal(1, lwin.list_rows);
+	assert_string_equal("b.txt", lwin.dir_entry[0].name);
+
+	opt_handlers_teardown();
+	view_teardown(&lwin);
+}
+
+/* Runs builtin find collecting its output into the lines. */
+static void
+run_find(const char pattern[], const char target[], int snapshot)
+{
+	free_string_array(lines.items, lines.nitems);
+	lines.items = NULL;
+	lines.nitems = 0;
+
+	char *targets[] = { (char *)target };
+	char *error = NULL;
+	bg_job_t *const job = bfind_run(pattern, targets, 1, SANDBOX_PATH, snapshot,
+			&error);
+	assert_non_null(job);
+	assert_null(error);
+
+	line_splitter_t splitter = {};
+	int i;
+	for(i = 0; i < 500; ++i)
+	{
+		char buf[1024];
+		const int len = bg_job_read_output(job, buf, sizeof(buf));
+		if(len < 0)
+		{
+			break;
+		}
+		if(len == 0)
+		{
+			usleep(10000);
+			continue;
+		}
+		split_lines(&splitter, buf, len, 0, &line_handler, &lines);
+	}
+	split_lines(&splitter, "", 0U, 1, &line_handler, &lines);
+	split_lines_reset(&splitter);
+
+	bg_job_decref(job);
+
+	qsort(lines.items, lines.nitems, sizeof(*lines.items), &str_cmp);
+}
+
+/* Collects lines of output. */
+static void
+line_handler(const char line[], void *arg)
+{
+	strlist_t *const list = arg;
+	list->nitems = add_to_string_array(&list->items, list->nitems, line);
+}
+
+/* qsort() comparer for strings.  Returns standard -1, 0, 1 for comparisons. */
+static int
+str_cmp(const void *a, const void *b)
+{
+	return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/* Checks that searching can't be started and error message is as expected if
+ * it's not NULL. */
+static void
+find_fails(const char pattern[], const char error[])
+{
+	char *targets[] = { "." };
+	char *msg = NULL;
+	assert_null(bfind_run(pattern, targets, 1, SANDBOX_PATH, 0, &msg));
+	assert_non_null(msg);
+	if(error != NULL)
+	{
+		assert_string_equal(error, msg);
+	}
+	free(msg);
+}
+
+/* Runs :find with builtin 'findprg' in the sandbox waiting for custom view to
+ * be loaded.  The view should be torn down by the caller. */
+static void
+find_into_custom_view(int with_path, const char args[])
+{
+	view_setup(&lwin);
+	curr_view = &lwin;
+	other_view = &lwin;
+	opt_handlers_setup();
+
+	update_string(&cfg.slow_fs_list, "");
+	lwin.sort[0] = SK_BY_NAME;
+	memset(&lwin.sort[1], SK_NONE, sizeof(lwin.sort) - 1);
+	char cwd[PATH_MAX + 1];
+	assert_non_null(get_cwd(cwd, sizeof(cwd)));
+	make_abs_path(lwin.curr_dir, sizeof(lwin.curr_dir), SANDBOX_PATH, "", cwd);
+
+	update_string(&cfg.find_prg, "builtin %u");
+	(void)show_find_menu(&lwin, with_path, args);
+
+	int i;
+	for(i = 0; i < 500 && lwin.custom.stream != NULL; ++i)
+	{
+		flist_stream_update(&lwin);
+		usleep(10000);
+	}
+	assert_null(lwin.custom.stream);
+	assert_true(flist_custom_active(&lwin));
+
+	update_string(&cfg.find_prg, NULL);
+	update_string(&cfg.slow_fs_list, NULL);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
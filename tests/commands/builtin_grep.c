@@ -0,0 +1,252 @@
+#include <stic.h>
+
+#include <unistd.h> /* usleep() */
+
+#include <stdio.h> /* FILE fclose() fopen() fputs() fwrite() */
+#include <stdlib.h> /* free() qsort() */
+#include <string.h> /* memset() strcmp() */
+
+#include <test-utils.h>
+
+#include "../../src/cfg/config.h"
+#include "../../src/compat/fs_limits.h"
+#include "../../src/menus/grep_menu.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/str.h"
+#include "../../src/utils/string_array.h"
+#include "../../src/background.h"
+#include "../../src/builtin_grep.h"
+#include "../../src/filelist.h"
+#include "../../src/flist_stream.h"
+
+static void run_grep(const char args[], int invert, const char target[]);
+static void line_handler(const char line[], void *arg);
+static int str_cmp(const void *a, const void *b);
+static void grep_fails(const char args[], const char error[]);
+
+/* Output of the last search split into sorted lines. */
+static strlist_t lines;
+
+SETUP()
+{
+	make_file(SANDBOX_PATH "/a.txt",
+			"first line\nsecond match\nthird\nac\nabbc\n");
+	create_dir(SANDBOX_PATH "/sub");
+	make_file(SANDBOX_PATH "/sub/b.txt", "Match upper\nno");
+
+	FILE *const fp = fopen(SANDBOX_PATH "/bin", "wb");
+	assert_non_null(fp);
+	fwrite("match\0binary\n", 1, 13, fp);
+	fclose(fp);
+}
+
+TEARDOWN()
+{
+	free_string_array(lines.items, lines.nitems);
+	lines.items = NULL;
+	lines.nitems = 0;
+
+	wait_for_all_bg();
+
+	remove_file(SANDBOX_PATH "/a.txt");
+	remove_file(SANDBOX_PATH "/sub/b.txt");
+	remove_dir(SANDBOX_PATH "/sub");
+	remove_file(SANDBOX_PATH "/bin");
+}
+
+TEST(matches_are_printed_in_grep_format)
+{
+	run_grep("match", 0, ".");
+	assert_int_equal(1, lines.nitems);
+	assert_string_equal("./a.txt:2:second match", lines.items[0]);
+}
+
+TEST(case_can_be_ignored)
+{
+	run_grep("-i match", 0, ".");
+	assert_int_equal(2, lines.nitems);
+	assert_string_equal("./a.txt:2:second match", lines.items[0]);
+	assert_string_equal("./sub/b.txt:1:Match upper", lines.items[1]);
+}
+
+TEST(matching_can_be_inverted)
+{
+	run_grep("Match", 1, "sub/b.txt");
+	assert_int_equal(1, lines.nitems);
+	assert_string_equal("sub/b.txt:2:no", lines.items[0]);
+}
+
+TEST(optional_parts_of_pattern_are_not_required)
+{
+	run_grep("ab*c", 0, "a.txt");
+	assert_int_equal(2, lines.nitems);
+	assert_string_equal("a.txt:4:ac", lines.items[0]);
+	assert_string_equal("a.txt:5:abbc", lines.items[1]);
+}
+
+TEST(alternatives_are_matched)
+{
+	run_grep("-E first|hir", 0, "a.txt");
+	assert_int_equal(2, lines.nitems);
+	assert_string_equal("a.txt:1:first line", lines.items[0]);
+	assert_string_equal("a.txt:3:third", lines.items[1]);
+}
+
+TEST(fixed_strings_are_matched_literally)
+{
+	run_grep("-F b*c", 0, "a.txt");
+	assert_int_equal(0, lines.nitems);
+
+	run_grep("-F -- bbc", 0, "a.txt");
+	assert_int_equal(1, lines.nitems);
+	assert_string_equal("a.txt:5:abbc", lines.items[0]);
+}
+
+TEST(binary_files_are_skipped)
+{
+	run_grep("binary", 0, "bin");
+	assert_int_equal(0, lines.nitems);
+}
+
+TEST(large_files_are_searched)
+{
+	FILE *const fp = fopen(SANDBOX_PATH "/large", "wb");
+	assert_non_null(fp);
+	int i;
+	for(i = 0; i < 64*1024; ++i)
+	{
+		fputs("0123456789abcde\n", fp);
+	}
+	fputs("match at the end\n", fp);
+	fclose(fp);
+
+	run_grep("match", 0, "large");
+	assert_int_equal(1, lines.nitems);
+	assert_string_equal("large:65537:match at the end", lines.items[0]);
+
+	/* Pattern without a literal runs on every line. */
+	run_grep("-E ^(m|n)a", 0, "large");
+	assert_int_equal(1, lines.nitems);
+	assert_string_equal("large:65537:match at the end", lines.items[0]);
+
+	remove_file(SANDBOX_PATH "/large");
+}
+
+TEST(errors_are_reported)
+{
+	grep_fails("-x pattern", "Unknown option: -x");
+	grep_fails("-i", "No pattern specified");
+	grep_fails("-E (", NULL);
+}
+
+TEST(grep_command_can_fill_custom_view)
+{
+	view_setup(&lwin);
+	curr_view = &lwin;
+	other_view = &lwin;
+	opt_handlers_setup();
+
+	update_string(&cfg.slow_fs_list, "");
+	lwin.sort[0] = SK_BY_NAME;
+	memset(&lwin.sort[1], SK_NONE, sizeof(lwin.sort) - 1);
+	char cwd[PATH_MAX + 1];
+	assert_non_null(get_cwd(cwd, sizeof(cwd)));
+	make_abs_path(lwin.curr_dir, sizeof(lwin.curr_dir), SANDBOX_PATH, "", cwd);
+
+	update_string(&cfg.grep_prg, "builtin %u");
+	(void)show_grep_menu(&lwin, "-i match", 0);
+
+	int i;
+	for(i = 0; i < 500 && lwin.custom.stream != NULL; ++i)
+	{
+		flist_stream_update(&lwin);
+		usleep(10000);
+	}
+	assert_null(lwin.custom.stream);
+
+	assert_true(flist_custom_active(&lwin));
+	assert_string_equal("Grep -i match", lwin.custom.title);
+	assert_int_equal(2, lwin.list_rows);
+	assert_string_equal("a.txt", lwin.dir_entry[0].name);
+	assert_string_equal("b.txt", lwin.dir_entry[1].name);
+
+	update_string(&cfg.grep_prg, NULL);
+	update_string(&cfg.slow_fs_list, NULL);
+	opt_handlers_teardown();
+	view_teardown(&lwin);
+}
+
+/* Runs builtin grep collecting its output into the lines. */
+static void
+run_grep(const char args[], int invert, const char target[])
+{
+	free_string_array(lines.items, lines.nitems);
+	lines.items = NULL;
+	lines.nitems = 0;
+
+	char *targets[] = { (char *)target };
+	char *error = NULL;
+	bg_job_t *const job = bgrep_run(args, invert, targets, 1, SANDBOX_PATH,
+			&error);
+	assert_non_null(job);
+	assert_null(error);
+
+	line_splitter_t splitter = {};
+	int i;
+	for(i = 0; i < 500; ++i)
+	{
+		char buf[1024];
+		const int len = bg_job_read_output(job, buf, sizeof(buf));
+		if(len < 0)
+		{
+			break;
+		}
+		if(len == 0)
+		{
+			usleep(10000);
+			continue;
+		}
+		split_lines(&splitter, buf, len, 0, &line_handler, &lines);
+	}
+	split_lines(&splitter, "", 0U, 1, &line_handler, &lines);
+	split_lines_reset(&splitter);
+
+	bg_job_decref(job);
+
+	qsort(lines.items, lines.nitems, sizeof(*lines.items), &str_cmp);
+}
+
+/* Collects lines of output. */
+static void
+line_handler(const char line[], void *arg)
+{
+	strlist_t *const list = arg;
+	list->nitems = add_to_string_array(&list->items, list->nitems, line);
+}
+
+/* qsort() comparer for strings.  Returns standard -1, 0, 1 for comparisons. */
+static int
+str_cmp(const void *a, const void *b)
+{
+	return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/* Checks that searching can't be started and error message is as expected if
+ * it's not NULL. */
+static void
+grep_fails(const char args[], const char error[])
+{
+	char *targets[] = { "." };
+	char *msg = NULL;
+	assert_null(bgrep_run(args, 0, targets, 1, SANDBOX_PATH, &msg));
+	assert_non_null(msg);
+	if(error != NULL)
+	{
+		assert_string_equal(error, msg);
+	}
+	free(msg);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
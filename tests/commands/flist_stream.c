@@ -0,0 +1,140 @@
+#include <stic.h>
+
+#include <unistd.h> /* usleep() */
+
+#include <stdio.h> /* snprintf() */
+#include <string.h> /* memset() */
+
+#include <test-utils.h>
+
+#include "../../src/cfg/config.h"
+#include "../../src/compat/fs_limits.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/path.h"
+#include "../../src/utils/str.h"
+#include "../../src/filelist.h"
+#include "../../src/flist_stream.h"
+#include "../../src/macros.h"
+#include "../../src/running.h"
+#include "../../src/status.h"
+
+static void wait_for_stream(view_t *view);
+
+static char test_data[PATH_MAX + 1];
+static char cmd[PATH_MAX*2 + 64];
+
+SETUP_ONCE()
+{
+	char cwd[PATH_MAX + 1];
+	assert_non_null(get_cwd(cwd, sizeof(cwd)));
+	make_abs_path(test_data, sizeof(test_data), TEST_DATA_PATH, "", cwd);
+
+	/* The second file is printed after a delay, which is longer than the time
+	 * spent on waiting before displaying the view. */
+	snprintf(cmd, sizeof(cmd), "echo %s/existing-files/b; sleep 0.5; "
+			"echo %s/existing-files/a", test_data, test_data);
+}
+
+SETUP()
+{
+	update_string(&cfg.slow_fs_list, "");
+
+	/* So that nothing is written into directory history. */
+	rwin.list_rows = 0;
+
+	view_setup(&lwin);
+	curr_view = &lwin;
+	other_view = &lwin;
+	opt_handlers_setup();
+
+	copy_str(lwin.curr_dir, sizeof(lwin.curr_dir), test_data);
+
+	lwin.sort[0] = SK_BY_NAME;
+	memset(&lwin.sort[1], SK_NONE, sizeof(lwin.sort) - 1);
+
+	replace_string(&cfg.shell, "/bin/sh");
+	update_string(&cfg.shell_cmd_flag, "-c");
+	stats_update_shell_type(cfg.shell);
+}
+
+TEARDOWN()
+{
+	stats_update_shell_type("/bin/sh");
+	update_string(&cfg.shell_cmd_flag, NULL);
+	update_string(&cfg.shell, NULL);
+	update_string(&cfg.slow_fs_list, NULL);
+
+	opt_handlers_teardown();
+	view_teardown(&lwin);
+}
+
+TEST(quick_command_produces_complete_view, IF(not_windows))
+{
+	char quick_cmd[PATH_MAX*2 + 64];
+	snprintf(quick_cmd, sizeof(quick_cmd), "echo %s/existing-files/b; "
+			"echo %s/existing-files/a", test_data, test_data);
+	assert_success(rn_for_flist(&lwin, quick_cmd, "title",
+				MF_CUSTOMVIEW_OUTPUT));
+
+	assert_true(flist_custom_active(&lwin));
+	assert_null(lwin.custom.stream);
+	assert_int_equal(2, lwin.list_rows);
+	assert_string_equal("a", lwin.dir_entry[0].name);
+	assert_string_equal("b", lwin.dir_entry[1].name);
+}
+
+TEST(sorted_view_is_sorted_once_command_is_done, IF(not_windows))
+{
+	assert_success(rn_for_flist(&lwin, cmd, "title", MF_CUSTOMVIEW_OUTPUT));
+
+	assert_true(flist_custom_active(&lwin));
+	assert_non_null(lwin.custom.stream);
+	assert_int_equal(1, lwin.list_rows);
+	assert_string_equal("b", lwin.dir_entry[0].name);
+
+	wait_for_stream(&lwin);
+
+	assert_int_equal(2, lwin.list_rows);
+	assert_string_equal("a", lwin.dir_entry[0].name);
+	assert_string_equal("b", lwin.dir_entry[1].name);
+}
+
+TEST(very_custom_view_keeps_order_of_streamed_files, IF(not_windows))
+{
+	assert_success(rn_for_flist(&lwin, cmd, "title", MF_VERYCUSTOMVIEW_OUTPUT));
+
+	assert_true(flist_custom_active(&lwin));
+	assert_int_equal(1, lwin.list_rows);
+
+	wait_for_stream(&lwin);
+
+	assert_int_equal(2, lwin.list_rows);
+	assert_string_equal("b", lwin.dir_entry[0].name);
+	assert_string_equal("a", lwin.dir_entry[1].name);
+}
+
+TEST(leaving_custom_view_stops_streaming, IF(not_windows))
+{
+	assert_success(rn_for_flist(&lwin, cmd, "title", MF_CUSTOMVIEW_OUTPUT));
+	assert_non_null(lwin.custom.stream);
+
+	assert_success(change_directory(&lwin, test_data));
+	assert_null(lwin.custom.stream);
+}
+
+/* Processes output of the command until it's over. */
+static void
+wait_for_stream(view_t *view)
+{
+	int i;
+	for(i = 0; i < 500 && view->custom.stream != NULL; ++i)
+	{
+		flist_stream_update(view);
+		usleep(10000);
+	}
+	assert_null(view->custom.stream);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
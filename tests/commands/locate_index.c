@@ -0,0 +1,471 @@
+#include <stic.h>
+
+#include <unistd.h> /* unlink() usleep() */
+
+#include <stdio.h> /* FILE fclose() fopen() fprintf() snprintf() */
+#include <stdlib.h> /* free() qsort() */
+#include <string.h> /* memset() strcmp() strlen() */
+
+#include <test-utils.h>
+
+#include "../../src/cfg/config.h"
+#include "../../src/compat/fs_limits.h"
+#include "../../src/menus/locate_menu.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/fs.h"
+#include "../../src/utils/path.h"
+#include "../../src/utils/str.h"
+#include "../../src/utils/string_array.h"
+#include "../../src/background.h"
+#include "../../src/filelist.h"
+#include "../../src/flist_stream.h"
+#include "../../src/locate_index.h"
+
+static void run_query(const char args[]);
+static void run_fuzzy_query(const char pattern[]);
+static void read_lines(bg_job_t *job);
+static void line_handler(const char line[], void *arg);
+static int str_cmp(const void *a, const void *b);
+static void query_fails(const char args[], const char error[]);
+static const char * sandbox(const char suffix[]);
+
+/* Output of the last query split into sorted lines. */
+static strlist_t lines;
+/* Absolute path to the sandbox. */
+static char sandbox_dir[PATH_MAX + 1];
+/* Absolute path to the root of the index. */
+static char root[PATH_MAX + 1];
+/* Value of cfg.config_dir before the test. */
+static char saved_config_dir[PATH_MAX + 1];
+
+SETUP()
+{
+	char cwd[PATH_MAX + 1];
+	assert_non_null(get_cwd(cwd, sizeof(cwd)));
+	make_abs_path(sandbox_dir, sizeof(sandbox_dir), SANDBOX_PATH, "", cwd);
+	snprintf(root, sizeof(root), "%s/root", sandbox_dir);
+
+	copy_str(saved_config_dir, sizeof(saved_config_dir), cfg.config_dir);
+	copy_str(cfg.config_dir, sizeof(cfg.config_dir), sandbox_dir);
+
+	create_dir(SANDBOX_PATH "/root");
+	create_file(SANDBOX_PATH "/root/Read.me");
+	create_dir(SANDBOX_PATH "/root/sub");
+	create_file(SANDBOX_PATH "/root/sub/file.c");
+}
+
+TEARDOWN()
+{
+	free_string_array(lines.items, lines.nitems);
+	lines.items = NULL;
+	lines.nitems = 0;
+
+	wait_for_all_bg();
+	locidx_reset();
+
+	copy_str(cfg.config_dir, sizeof(cfg.config_dir), saved_config_dir);
+
+	(void)unlink(SANDBOX_PATH "/locate-index");
+	remove_file(SANDBOX_PATH "/root/Read.me");
+	remove_file(SANDBOX_PATH "/root/sub/file.c");
+	remove_dir(SANDBOX_PATH "/root/sub");
+	remove_dir(SANDBOX_PATH "/root");
+}
+
+TEST(substrings_are_found)
+{
+	run_query("sub");
+	assert_int_equal(2, lines.nitems);
+	assert_string_equal(sandbox("/root/sub"), lines.items[0]);
+	assert_string_equal(sandbox("/root/sub/file.c"), lines.items[1]);
+
+	run_query("read");
+	assert_int_equal(0, lines.nitems);
+	run_query("-i read");
+	assert_int_equal(1, lines.nitems);
+	assert_string_equal(sandbox("/root/Read.me"), lines.items[0]);
+}
+
+TEST(globs_match_whole_path)
+{
+	run_query("*.c");
+	assert_int_equal(1, lines.nitems);
+	assert_string_equal(sandbox("/root/sub/file.c"), lines.items[0]);
+
+	run_query("file.?");
+	assert_int_equal(0, lines.nitems);
+}
+
+TEST(regular_expressions_are_supported)
+{
+	run_query("/\\.(c|me)$/");
+	assert_int_equal(2, lines.nitems);
+	assert_string_equal(sandbox("/root/Read.me"), lines.items[0]);
+	assert_string_equal(sandbox("/root/sub/file.c"), lines.items[1]);
+}
+
+TEST(many_matches_are_written_in_portions)
+{
+	enum { NFILES = 1000 };
+
+	create_dir(SANDBOX_PATH "/root/many");
+	char path[PATH_MAX + 1];
+	int i;
+	for(i = 0; i < NFILES; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/root/many/%s-%04d", SANDBOX_PATH,
+				"a-long-name-to-produce-more-output-than-fits-in-one-portion", i);
+		create_file(path);
+	}
+
+	run_query("many/");
+	assert_int_equal(NFILES, lines.nitems);
+	assert_true(ends_with(lines.items[0], "-0000"));
+	assert_true(ends_with(lines.items[NFILES - 1], "-0999"));
+
+	for(i = 0; i < NFILES; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/root/many/%s-%04d", SANDBOX_PATH,
+				"a-long-name-to-produce-more-output-than-fits-in-one-portion", i);
+		remove_file(path);
+	}
+	remove_dir(SANDBOX_PATH "/root/many");
+}
+
+TEST(errors_are_reported)
+{
+	query_fails("-x name", "Unknown option: -x");
+	query_fails("-i", "No pattern specified");
+	query_fails("/(/", NULL);
+}
+
+TEST(index_is_stored_with_prefix_compression)
+{
+	run_query("file");
+
+	int nlines;
+	char **const file = read_file_of_lines(SANDBOX_PATH "/locate-index",
+			&nlines);
+	assert_int_equal(7, nlines);
+	assert_string_equal("vifm-locate-index 1", file[0]);
+	assert_string_equal(root, file[1]);
+	assert_string_equal("", file[2]);
+	assert_string_equal(format_str("0\t%s", root), file[3]);
+	assert_string_equal(format_str("%d\t/Read.me", (int)strlen(root)), file[4]);
+	assert_string_equal(format_str("%d\tsub", (int)strlen(root) + 1), file[5]);
+	assert_string_equal(format_str("%d\t/file.c", (int)strlen(root) + 4),
+			file[6]);
+	free_string_array(file, nlines);
+}
+
+TEST(index_is_loaded_from_disk)
+{
+	run_query("file");
+	assert_int_equal(1, lines.nitems);
+
+	locidx_reset();
+	create_file(SANDBOX_PATH "/root/sub/file.h");
+
+	/* New file isn't in the index. */
+	run_query("file");
+	assert_int_equal(1, lines.nitems);
+
+	remove_file(SANDBOX_PATH "/root/sub/file.h");
+}
+
+TEST(entries_longer_than_path_max_are_loaded)
+{
+	char long_name[2*PATH_MAX];
+	memset(long_name, 'x', sizeof(long_name) - 1U);
+	long_name[sizeof(long_name) - 1U] = '\0';
+
+	FILE *const fp = fopen(SANDBOX_PATH "/locate-index", "w");
+	assert_non_null(fp);
+	fprintf(fp, "vifm-locate-index 1\n%s\n\n", root);
+	fprintf(fp, "0\t%s\n", root);
+	fprintf(fp, "%d\t/%s\n", (int)strlen(root), long_name);
+	fprintf(fp, "%d\t/ghost\n", (int)strlen(root));
+	fclose(fp);
+
+	/* Entry after the long one is there, so the index wasn't rebuilt. */
+	run_query("ghost");
+	assert_int_equal(1, lines.nitems);
+	assert_string_equal(sandbox("/root/ghost"), lines.items[0]);
+
+	run_query("xxx");
+	assert_int_equal(1, lines.nitems);
+	assert_int_equal(strlen(root) + 1U + strlen(long_name),
+			strlen(lines.items[0]));
+}
+
+TEST(changed_directories_are_updated)
+{
+	run_query("file");
+	assert_int_equal(1, lines.nitems);
+
+	create_file(SANDBOX_PATH "/root/file.h");
+	create_dir(SANDBOX_PATH "/root/new");
+	create_file(SANDBOX_PATH "/root/new/file.txt");
+	remove_file(SANDBOX_PATH "/root/sub/file.c");
+	remove_dir(SANDBOX_PATH "/root/sub");
+
+	locidx_dir_changed(root);
+	wait_for_all_bg();
+
+	run_query("file");
+	assert_int_equal(2, lines.nitems);
+	assert_string_equal(sandbox("/root/file.h"), lines.items[0]);
+	assert_string_equal(sandbox("/root/new/file.txt"), lines.items[1]);
+
+	/* The update is saved. */
+	locidx_reset();
+	run_query("/root/");
+	assert_int_equal(5, lines.nitems);
+
+	remove_file(SANDBOX_PATH "/root/file.h");
+	remove_file(SANDBOX_PATH "/root/new/file.txt");
+	remove_dir(SANDBOX_PATH "/root/new");
+	create_dir(SANDBOX_PATH "/root/sub");
+	create_file(SANDBOX_PATH "/root/sub/file.c");
+}
+
+TEST(removed_directory_is_dropped_despite_siblings_in_between)
+{
+	create_file(SANDBOX_PATH "/root/sub.txt");
+	create_file(SANDBOX_PATH "/root/sub-x");
+
+	run_query("/root/sub");
+	assert_int_equal(4, lines.nitems);
+
+	remove_file(SANDBOX_PATH "/root/sub/file.c");
+	remove_dir(SANDBOX_PATH "/root/sub");
+
+	char sub[PATH_MAX + 1];
+	snprintf(sub, sizeof(sub), "%s/sub", root);
+	locidx_dir_changed(sub);
+	wait_for_all_bg();
+
+	run_query("/root/sub");
+	assert_int_equal(2, lines.nitems);
+	assert_string_equal(sandbox("/root/sub-x"), lines.items[0]);
+	assert_string_equal(sandbox("/root/sub.txt"), lines.items[1]);
+
+	remove_file(SANDBOX_PATH "/root/sub.txt");
+	remove_file(SANDBOX_PATH "/root/sub-x");
+	create_dir(SANDBOX_PATH "/root/sub");
+	create_file(SANDBOX_PATH "/root/sub/file.c");
+}
+
+TEST(changes_outside_of_roots_are_ignored)
+{
+	run_query("file");
+
+	create_file(SANDBOX_PATH "/file");
+	locidx_dir_changed(sandbox_dir);
+	wait_for_all_bg();
+
+	run_query("file");
+	assert_int_equal(1, lines.nitems);
+
+	remove_file(SANDBOX_PATH "/file");
+}
+
+TEST(fuzzy_matches_are_ranked)
+{
+	create_file(SANDBOX_PATH "/root/sub/xqz.c");
+	create_dir(SANDBOX_PATH "/root/xq");
+	create_file(SANDBOX_PATH "/root/xq/zed");
+
+	run_fuzzy_query("xqz");
+	assert_int_equal(2, lines.nitems);
+	assert_string_equal(sandbox("/root/sub/xqz.c"), lines.items[0]);
+	assert_string_equal(sandbox("/root/xq/zed"), lines.items[1]);
+
+	/* Upper case letters make matching case sensitive. */
+	run_fuzzy_query("XQZ");
+	assert_int_equal(0, lines.nitems);
+
+	remove_file(SANDBOX_PATH "/root/sub/xqz.c");
+	remove_file(SANDBOX_PATH "/root/xq/zed");
+	remove_dir(SANDBOX_PATH "/root/xq");
+}
+
+TEST(fuzzy_query_requires_pattern)
+{
+	char *roots[] = { root };
+	char *error = NULL;
+	assert_null(locidx_fuzzy_query(roots, 1, "", &error));
+	assert_string_equal("No pattern specified", error);
+	free(error);
+}
+
+TEST(jump_command_navigates_to_best_match)
+{
+	view_setup(&lwin);
+	curr_view = &lwin;
+	other_view = &rwin;
+	opt_handlers_setup();
+
+	update_string(&cfg.slow_fs_list, "");
+	lwin.sort[0] = SK_BY_NAME;
+	memset(&lwin.sort[1], SK_NONE, sizeof(lwin.sort) - 1);
+	copy_str(lwin.curr_dir, sizeof(lwin.curr_dir), sandbox_dir);
+
+	char *const prg = format_str("builtin %s", root);
+	update_string(&cfg.locate_prg, prg);
+	free(prg);
+	assert_success(jump_to_best_match(&lwin, "sfc"));
+	assert_string_equal(sandbox("/root/sub"), lwin.curr_dir);
+	assert_string_equal("file.c", get_current_file_name(&lwin));
+
+	assert_true(jump_to_best_match(&lwin, "XQZ"));
+	assert_string_equal(sandbox("/root/sub"), lwin.curr_dir);
+
+	update_string(&cfg.locate_prg, NULL);
+	update_string(&cfg.slow_fs_list, NULL);
+	opt_handlers_teardown();
+	view_teardown(&lwin);
+}
+
+TEST(locate_command_can_fill_custom_view)
+{
+	view_setup(&lwin);
+	curr_view = &lwin;
+	other_view = &lwin;
+	opt_handlers_setup();
+
+	update_string(&cfg.slow_fs_list, "");
+	lwin.sort[0] = SK_BY_NAME;
+	memset(&lwin.sort[1], SK_NONE, sizeof(lwin.sort) - 1);
+	copy_str(lwin.curr_dir, sizeof(lwin.curr_dir), sandbox_dir);
+
+	char *const prg = format_str("builtin %s %%u", root);
+	update_string(&cfg.locate_prg, prg);
+	free(prg);
+	(void)show_locate_menu(&lwin, "/\\.(c|me)$/");
+
+	int i;
+	for(i = 0; i < 500 && lwin.custom.stream != NULL; ++i)
+	{
+		flist_stream_update(&lwin);
+		usleep(10000);
+	}
+	assert_null(lwin.custom.stream);
+
+	assert_true(flist_custom_active(&lwin));
+	assert_int_equal(2, lwin.list_rows);
+	assert_string_equal("Read.me", lwin.dir_entry[0].name);
+	assert_string_equal("file.c", lwin.dir_entry[1].name);
+
+	update_string(&cfg.locate_prg, NULL);
+	update_string(&cfg.slow_fs_list, NULL);
+	opt_handlers_teardown();
+	view_teardown(&lwin);
+}
+
+/* Queries index of the root collecting its output into the lines. */
+static void
+run_query(const char args[])
+{
+	free_string_array(lines.items, lines.nitems);
+	lines.items = NULL;
+	lines.nitems = 0;
+
+	char *roots[] = { root };
+	char *error = NULL;
+	bg_job_t *const job = locidx_query(roots, 1, args, &error);
+	assert_non_null(job);
+	assert_null(error);
+
+	read_lines(job);
+	qsort(lines.items, lines.nitems, sizeof(*lines.items), &str_cmp);
+}
+
+/* Queries index of the root for fuzzy matches collecting its output into the
+ * lines preserving their order. */
+static void
+run_fuzzy_query(const char pattern[])
+{
+	free_string_array(lines.items, lines.nitems);
+	lines.items = NULL;
+	lines.nitems = 0;
+
+	char *roots[] = { root };
+	char *error = NULL;
+	bg_job_t *const job = locidx_fuzzy_query(roots, 1, pattern, &error);
+	assert_non_null(job);
+	assert_null(error);
+
+	read_lines(job);
+}
+
+/* Reads output of the job into the lines and releases the job. */
+static void
+read_lines(bg_job_t *job)
+{
+	line_splitter_t splitter = {};
+	int i;
+	for(i = 0; i < 500; ++i)
+	{
+		char buf[1024];
+		const int len = bg_job_read_output(job, buf, sizeof(buf));
+		if(len < 0)
+		{
+			break;
+		}
+		if(len == 0)
+		{
+			usleep(10000);
+			continue;
+		}
+		split_lines(&splitter, buf, len, 0, &line_handler, &lines);
+	}
+	split_lines(&splitter, "", 0U, 1, &line_handler, &lines);
+	split_lines_reset(&splitter);
+
+	bg_job_decref(job);
+}
+
+/* Collects lines of output. */
+static void
+line_handler(const char line[], void *arg)
+{
+	strlist_t *const list = arg;
+	list->nitems = add_to_string_array(&list->items, list->nitems, line);
+}
+
+/* qsort() comparer for strings.  Returns standard -1, 0, 1 for comparisons. */
+static int
+str_cmp(const void *a, const void *b)
+{
+	return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/* Checks that query can't be started and error message is as expected if it's
+ * not NULL. */
+static void
+query_fails(const char args[], const char error[])
+{
+	char *roots[] = { root };
+	char *msg = NULL;
+	assert_null(locidx_query(roots, 1, args, &msg));
+	assert_non_null(msg);
+	if(error != NULL)
+	{
+		assert_string_equal(error, msg);
+	}
+	free(msg);
+}
+
+/* Forms absolute path to a file in the sandbox.  Returns pointer to a
+ * statically allocated buffer. */
+static const char *
+sandbox(const char suffix[])
+{
+	static char path[PATH_MAX + 1];
+	snprintf(path, sizeof(path), "%s%s", sandbox_dir, suffix);
+	return path;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -2,6 +2,7 @@
 
 #include "../../src/engine/keys.h"
 #include "../../src/modes/modes.h"
+#include "../../src/utils/macros.h"
 
 TEST(unmap_users)
 {
@@ -55,6 +56,34 @@ TEST(unmapping_removes_non_mapped_parents)
 	assert_false(vle_keys_user_exists(L"k", NORMAL_MODE));
 }
 
+TEST(siblings_are_found_after_unordered_additions_and_removals)
+{
+	const wchar_t *const keys[] = { L",z", L",a", L",m", L",b", L",y", L",c" };
+	size_t i;
+
+	for(i = 0U; i < ARRAY_LEN(keys); ++i)
+	{
+		assert_success(vle_keys_user_add(keys[i], L"", NORMAL_MODE,
+					KEYS_FLAG_NONE));
+	}
+
+	assert_success(vle_keys_user_remove(L",m", NORMAL_MODE));
+	assert_success(vle_keys_user_remove(L",a", NORMAL_MODE));
+
+	assert_false(vle_keys_user_exists(L",a", NORMAL_MODE));
+	assert_true(vle_keys_user_exists(L",b", NORMAL_MODE));
+	assert_true(vle_keys_user_exists(L",c", NORMAL_MODE));
+	assert_false(vle_keys_user_exists(L",m", NORMAL_MODE));
+	assert_true(vle_keys_user_exists(L",y", NORMAL_MODE));
+	assert_true(vle_keys_user_exists(L",z", NORMAL_MODE));
+
+	for(i = 0U; i < ARRAY_LEN(keys); ++i)
+	{
+		(void)vle_keys_user_remove(keys[i], NORMAL_MODE);
+	}
+	assert_int_equal(KEYS_UNKNOWN, vle_keys_exec(L","));
+}
+
 TEST(unmap_remapped)
 {
 	assert_success(vle_keys_exec(L"j"));
@@ -1,8 +1,12 @@
 #include <stic.h>
 
+#include <stdio.h> /* EOF FILE SEEK_END fclose() fgetc() fopen() fputc()
+                      fseek() */
+
 #include "../../src/cfg/config.h"
 #include "../../src/lua/vlua.h"
 #include "../../src/ui/statusbar.h"
+#include "../../src/utils/fs.h"
 #include "../../src/utils/str.h"
 #include "../../src/plugins.h"
 
@@ -325,5 +329,103 @@ TEST(print_without_arguments)
 	remove_file(SANDBOX_PATH "/plugins/plug/init.lua");
 }
 
+TEST(compiled_chunks_are_cached)
+{
+	char src[PATH_MAX + 1], cache[PATH_MAX + 1];
+	snprintf(src, sizeof(src), "%s/plugins/plug/init.lua", cfg.config_dir);
+	make_abs_path(cfg.luac_dir, sizeof(cfg.luac_dir), SANDBOX_PATH, "luac", NULL);
+	assert_success(get_chunk_cache_path(src, cache, sizeof(cache)));
+
+	make_file(src, "return {}");
+	assert_success(vlua_load_plugin(vlua, "plug", &plug_dummy));
+	assert_true(path_exists(cache, NODEREF));
+
+	/* Cache is used while the source file looks unchanged. */
+	reset_timestamp(src);
+	assert_success(vlua_load_plugin(vlua, "plug", &plug_dummy));
+	make_file(src, "return 12");
+	reset_timestamp(src);
+	assert_success(vlua_load_plugin(vlua, "plug", &plug_dummy));
+
+	/* Cache is updated once the source file changes. */
+	make_file(src, "return 123");
+	ui_sb_msg("");
+	assert_failure(vlua_load_plugin(vlua, "plug", &plug_dummy));
+	assert_string_equal("Failed to load 'plug' plugin: it didn't return a table",
+			ui_sb_last());
+
+	remove_file(src);
+	remove_file(cache);
+	remove_dir(cfg.luac_dir);
+	cfg.luac_dir[0] = '\0';
+}
+
+TEST(corrupted_cache_is_not_used)
+{
+	char src[PATH_MAX + 1], cache[PATH_MAX + 1];
+	snprintf(src, sizeof(src), "%s/plugins/plug/init.lua", cfg.config_dir);
+	make_abs_path(cfg.luac_dir, sizeof(cfg.luac_dir), SANDBOX_PATH, "luac", NULL);
+	assert_success(get_chunk_cache_path(src, cache, sizeof(cache)));
+
+	make_file(src, "return {}");
+	reset_timestamp(src);
+	assert_success(vlua_load_plugin(vlua, "plug", &plug_dummy));
+
+	/* Flip the last byte of the chunk. */
+	FILE *fp = fopen(cache, "r+b");
+	assert_non_null(fp);
+	assert_success(fseek(fp, -1, SEEK_END));
+	const int c = fgetc(fp);
+	assert_success(fseek(fp, -1, SEEK_END));
+	assert_true(fputc(c ^ 0xff, fp) != EOF);
+	assert_success(fclose(fp));
+
+	make_file(src, "return 12");
+	reset_timestamp(src);
+	ui_sb_msg("");
+	assert_failure(vlua_load_plugin(vlua, "plug", &plug_dummy));
+	assert_string_equal("Failed to load 'plug' plugin: it didn't return a table",
+			ui_sb_last());
+
+	remove_file(src);
+	remove_file(cache);
+	remove_dir(cfg.luac_dir);
+	cfg.luac_dir[0] = '\0';
+}
+
+TEST(cache_entries_of_removed_sources_are_pruned)
+{
+	char src[PATH_MAX + 1], cache[PATH_MAX + 1];
+	snprintf(src, sizeof(src), "%s/plugins/plug/init.lua", cfg.config_dir);
+	make_abs_path(cfg.luac_dir, sizeof(cfg.luac_dir), SANDBOX_PATH, "luac", NULL);
+	assert_success(get_chunk_cache_path(src, cache, sizeof(cache)));
+
+	make_file(src, "return {}");
+	assert_success(vlua_load_plugin(vlua, "plug", &plug_dummy));
+	make_file(SANDBOX_PATH "/luac/junk", "not a chunk");
+
+	vlua_prune_chunk_cache();
+	assert_true(path_exists(cache, NODEREF));
+	assert_false(path_exists(SANDBOX_PATH "/luac/junk", NODEREF));
+
+	remove_file(src);
+	vlua_prune_chunk_cache();
+	assert_false(path_exists(cache, NODEREF));
+
+	remove_dir(cfg.luac_dir);
+	cfg.luac_dir[0] = '\0';
+}
+
+TEST(no_caching_without_cache_directory)
+{
+	char src[PATH_MAX + 1], cache[PATH_MAX + 1];
+	snprintf(src, sizeof(src), "%s/plugins/plug/init.lua", cfg.config_dir);
+	assert_failure(get_chunk_cache_path(src, cache, sizeof(cache)));
+
+	make_file(src, "return {}");
+	assert_success(vlua_load_plugin(vlua, "plug", &plug_dummy));
+	remove_file(src);
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 : */
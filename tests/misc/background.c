@@ -2,10 +2,11 @@
 
 #include <unistd.h> /* chdir() usleep() */
 
-#include <stdio.h> /* FILE fclose() fputs() */
+#include <stdio.h> /* FILE fclose() fputs() tmpfile() */
 
 #include <test-utils.h>
 
+#include "../../src/cfg/config.h"
 #include "../../src/compat/pthread.h"
 #include "../../src/engine/var.h"
 #include "../../src/engine/variables.h"
@@ -19,6 +20,7 @@
 
 static void on_job_exit(struct bg_job_t *job, void *data);
 static void task(bg_op_t *bg_op, void *arg);
+static void failing_task(bg_op_t *bg_op, FILE *out, void *arg);
 static void wait_until_locked(pthread_spinlock_t *lock);
 
 SETUP_ONCE()
@@ -200,6 +202,71 @@ TEST(capture_output_of_external_command)
 	bg_job_decref(job);
 }
 
+TEST(large_input_can_be_supplied_from_a_file, IF(have_cat))
+{
+	enum { NLINES = 100*1000 };
+
+	FILE *const in = tmpfile();
+	assert_non_null(in);
+	int i;
+	for(i = 0; i < NLINES; ++i)
+	{
+		fputs("line of input\n", in);
+	}
+
+	bg_job_t *job = bg_run_external_job_in("cat", BJF_CAPTURE_OUT, in);
+	fclose(in);
+	assert_non_null(job);
+	assert_null(job->input);
+	assert_non_null(job->output);
+
+	int nlines;
+	char **lines = read_stream_lines(job->output, &nlines, 0, NULL, NULL);
+	assert_int_equal(NLINES, nlines);
+	assert_string_equal("line of input", lines[NLINES - 1]);
+	free_string_array(lines, nlines);
+
+	assert_success(bg_job_wait(job));
+	assert_int_equal(0, job->exit_code);
+
+	bg_job_decref(job);
+}
+
+TEST(posix_shell_can_be_requested, IF(not_windows))
+{
+	update_string(&cfg.shell, "/bin/false");
+
+	bg_job_t *job = bg_run_external_job("echo there",
+			BJF_CAPTURE_OUT | BJF_POSIX_SHELL);
+	assert_non_null(job);
+	assert_non_null(job->output);
+
+	int nlines;
+	char **lines = read_stream_lines(job->output, &nlines, 0, NULL, NULL);
+	assert_int_equal(1, nlines);
+	assert_string_equal("there", lines[0]);
+	free_string_array(lines, nlines);
+
+	assert_success(bg_job_wait(job));
+	assert_int_equal(0, job->exit_code);
+
+	bg_job_decref(job);
+}
+
+TEST(user_shell_is_used_despite_posix_shell_request, IF(not_windows))
+{
+	update_string(&cfg.shell, "/bin/false");
+
+	bg_job_t *job = bg_run_external_job("echo there",
+			BJF_CAPTURE_OUT | BJF_POSIX_SHELL | BJF_USER_SHELL);
+	assert_non_null(job);
+
+	assert_success(bg_job_wait(job));
+	assert_int_equal(1, job->exit_code);
+
+	bg_job_decref(job);
+}
+
 TEST(jobs_exit_cb_is_called)
 {
 	bg_job_t *job = bg_run_external_job("echo there", BJF_NONE);
@@ -260,6 +327,24 @@ TEST(supply_input_to_external_command, IF(have_cat))
 	bg_job_decref(job);
 }
 
+TEST(tasks_can_report_errors)
+{
+	bg_job_t *job = bg_execute_capture("failing", &failing_task, NULL);
+	assert_non_null(job);
+
+	/* Output is closed after the task is done. */
+	int nlines;
+	char **lines = read_stream_lines(job->output, &nlines, 0, NULL, NULL);
+	assert_int_equal(0, nlines);
+	free_string_array(lines, nlines);
+
+	pthread_spin_lock(&job->errors_lock);
+	assert_string_equal("task error", job->errors);
+	pthread_spin_unlock(&job->errors_lock);
+
+	bg_job_decref(job);
+}
+
 TEST(background_redirects_streams_properly, IF(not_windows))
 {
 	assert_success(bg_and_wait_for_errors("echo a", &no_cancellation));
@@ -274,6 +359,12 @@ task(bg_op_t *bg_op, void *arg)
 	pthread_spin_unlock(&locks[0]);
 }
 
+static void
+failing_task(bg_op_t *bg_op, FILE *out, void *arg)
+{
+	bg_task_report_error("task error");
+}
+
 static void
 wait_until_locked(pthread_spinlock_t *lock)
 {
@@ -6,7 +6,7 @@
 #include <limits.h> /* INT_MAX */
 #include <stddef.h> /* NULL */
 #include <stdlib.h> /* free() remove() */
-#include <string.h> /* strdup() */
+#include <string.h> /* strdup() strstr() */
 
 #include <test-utils.h>
 
@@ -25,6 +25,7 @@
 #include "../../src/compare.h"
 #include "../../src/filelist.h"
 #include "../../src/status.h"
+#include "../../src/trace.h"
 #include "../parsing/asserts.h"
 
 SETUP()
@@ -329,6 +330,28 @@ TEST(tabpagenr)
 	ASSERT_FAIL("tabpagenr('a')", PE_INVALID_EXPRESSION);
 }
 
+TEST(trace_actions)
+{
+	trace_reset();
+	ASSERT_OK("trace('reset')", "");
+
+	var_t res_var = var_false();
+	assert_int_equal(PE_NO_ERROR, parse("trace('stats')", 0, &res_var));
+	char *stats = var_to_str(res_var);
+	assert_non_null(strstr(stats, "\nsort_view: 0 calls"));
+	free(stats);
+	var_free(res_var);
+
+	ASSERT_OK("trace('dump', '" SANDBOX_PATH "/trace.json')", "");
+	assert_success(remove(SANDBOX_PATH "/trace.json"));
+
+	ASSERT_FAIL("trace('dump')", PE_INVALID_EXPRESSION);
+	ASSERT_FAIL("trace('stats', 'x')", PE_INVALID_EXPRESSION);
+	ASSERT_FAIL("trace('bla')", PE_INVALID_EXPRESSION);
+	ASSERT_FAIL("trace('dump', '" SANDBOX_PATH "/no/such/dir')",
+			PE_INVALID_EXPRESSION);
+}
+
 TEST(fnameescape)
 {
 	ASSERT_FAIL("fnameescape()", PE_INVALID_EXPRESSION);
@@ -97,7 +97,8 @@ TEST(vim_like_completion)
 	vle_compl_reset();
 	assert_int_equal(0, vle_cmds_complete("j", NULL));
 	ASSERT_NEXT_MATCH("jobs");
-	ASSERT_NEXT_MATCH("jobs");
+	ASSERT_NEXT_MATCH("jump");
+	ASSERT_NEXT_MATCH("j");
 }
 
 TEST(leave_spaces_at_begin)
@@ -329,6 +329,42 @@ TEST(cursor_is_moved_to_nearest_neighbour)
 	local_filter_cancel(&lwin);
 }
 
+TEST(local_filter_is_narrowed_and_widened_correctly)
+{
+	char path[PATH_MAX + 1];
+
+	flist_custom_start(&lwin, "test");
+	make_abs_path(path, sizeof(path), TEST_DATA_PATH, "read/binary-data", cwd);
+	flist_custom_add(&lwin, path);
+	make_abs_path(path, sizeof(path), TEST_DATA_PATH, "read/dos-eof", cwd);
+	flist_custom_add(&lwin, path);
+	make_abs_path(path, sizeof(path), TEST_DATA_PATH, "read/two-lines", cwd);
+	flist_custom_add(&lwin, path);
+	make_abs_path(path, sizeof(path), TEST_DATA_PATH, "read/very-long-line", cwd);
+	flist_custom_add(&lwin, path);
+	assert_true(flist_custom_finish(&lwin, CV_REGULAR, 0) == 0);
+
+	assert_int_equal(0, local_filter_set(&lwin, "l"));
+	assert_int_equal(2, lwin.list_rows);
+	assert_int_equal(0, local_filter_set(&lwin, "li"));
+	assert_int_equal(2, lwin.list_rows);
+	assert_int_equal(0, local_filter_set(&lwin, "lines"));
+	assert_int_equal(1, lwin.list_rows);
+	assert_string_equal("two-lines", lwin.dir_entry[0].name);
+
+	assert_int_equal(0, local_filter_set(&lwin, "l"));
+	assert_int_equal(2, lwin.list_rows);
+	assert_int_equal(0, local_filter_set(&lwin, "o"));
+	assert_int_equal(3, lwin.list_rows);
+	assert_int_equal(0, local_filter_set(&lwin, "o|y"));
+	assert_int_equal(4, lwin.list_rows);
+	assert_int_equal(0, local_filter_set(&lwin, "o|yz"));
+	assert_int_equal(3, lwin.list_rows);
+
+	local_filter_cancel(&lwin);
+	assert_int_equal(4, lwin.list_rows);
+}
+
 TEST(removed_filename_filter_is_stored)
 {
 	assert_success(filter_set(&lwin.auto_filter, "a"));
@@ -3,6 +3,7 @@
 #include <unistd.h> /* rmdir() symlink() */
 
 #include <stddef.h> /* NULL */
+#include <stdio.h> /* snprintf() */
 #include <stdlib.h> /* remove() */
 #include <string.h> /* memset() */
 
@@ -655,6 +656,60 @@ TEST(nesting_limit)
 	assert_int_equal(12, lwin.list_rows);
 }
 
+TEST(subtrees_listed_in_parallel_are_put_under_their_parents)
+{
+	char path[PATH_MAX + 1];
+
+	int i, j, k;
+	for(i = 0; i < 3; ++i)
+	{
+		snprintf(path, sizeof(path), "%s/top%d", SANDBOX_PATH, i);
+		create_dir(path);
+		for(j = 0; j < 3; ++j)
+		{
+			snprintf(path, sizeof(path), "%s/top%d/sub%d", SANDBOX_PATH, i, j);
+			create_dir(path);
+			for(k = 0; k < 2; ++k)
+			{
+				snprintf(path, sizeof(path), "%s/top%d/sub%d/file%d", SANDBOX_PATH, i,
+						j, k);
+				create_file(path);
+			}
+		}
+	}
+
+	assert_success(load_tree(&lwin, SANDBOX_PATH, cwd));
+	assert_int_equal(3 + 3*3 + 3*3*2, lwin.list_rows);
+	validate_tree(&lwin);
+
+	for(i = 0; i < lwin.list_rows; ++i)
+	{
+		const dir_entry_t *const entry = &lwin.dir_entry[i];
+		if(entry->child_pos != 0)
+		{
+			get_full_path_of(entry - entry->child_pos, sizeof(path), path);
+			assert_string_equal(path, entry->origin);
+		}
+	}
+
+	for(i = 0; i < 3; ++i)
+	{
+		for(j = 0; j < 3; ++j)
+		{
+			for(k = 0; k < 2; ++k)
+			{
+				snprintf(path, sizeof(path), "%s/top%d/sub%d/file%d", SANDBOX_PATH, i,
+						j, k);
+				remove_file(path);
+			}
+			snprintf(path, sizeof(path), "%s/top%d/sub%d", SANDBOX_PATH, i, j);
+			remove_dir(path);
+		}
+		snprintf(path, sizeof(path), "%s/top%d", SANDBOX_PATH, i);
+		remove_dir(path);
+	}
+}
+
 static void
 verify_tree_node(column_data_t *cdt, int idx, const char expected[])
 {
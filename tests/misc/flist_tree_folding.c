@@ -1,5 +1,7 @@
 #include <stic.h>
 
+#include <unistd.h> /* usleep() */
+
 #include <stdarg.h> /* va_list va_start() va_arg() va_end() */
 
 #include <test-utils.h>
@@ -22,6 +24,7 @@ static void column_line_print(const char buf[], size_t offset, AlignType align,
 		const char full_column[], const format_info_t *info);
 static int build_custom_view(view_t *view, ...);
 static void toggle_fold_and_update(view_t *view);
+static void wait_for_unfolding(view_t *view);
 
 static char cwd[PATH_MAX + 1];
 
@@ -432,6 +435,80 @@ TEST(lazy_unfolding_and_filtering)
 	assert_int_equal(2, lwin.list_rows);
 }
 
+TEST(unfolding_lists_subtree_in_background)
+{
+	(void)replace_matcher(&lwin.manual_filter, "^file4$");
+
+	assert_success(load_limited_tree(&lwin, TEST_DATA_PATH "/tree", cwd, 0));
+	assert_int_equal(3, lwin.list_rows);
+	assert_int_equal(0, lwin.filtered);
+
+	lwin.list_pos = 0;
+	assert_string_equal("dir1", lwin.dir_entry[lwin.list_pos].name);
+	flist_toggle_fold(&lwin);
+	assert_non_null(lwin.custom.unfolding);
+	assert_int_equal(3, lwin.list_rows);
+
+	lwin.list_pos = 1;
+	assert_string_equal("dir5", lwin.dir_entry[lwin.list_pos].name);
+	wait_for_unfolding(&lwin);
+
+	assert_int_equal(4, lwin.list_rows);
+	assert_int_equal(1, lwin.filtered);
+	assert_string_equal("dir5", lwin.dir_entry[lwin.list_pos].name);
+	validate_tree(&lwin);
+
+	/* Result must be the same as of building the tree. */
+	populate_dir_list(&lwin, /*reload=*/1);
+	assert_int_equal(4, lwin.list_rows);
+	assert_int_equal(1, lwin.filtered);
+}
+
+TEST(deep_levels_of_slow_tree_are_added_in_background)
+{
+	tree_build_budget_ms = 0;
+	assert_success(load_tree(&lwin, TEST_DATA_PATH "/tree", cwd));
+	tree_build_budget_ms = 250;
+
+	assert_int_equal(3, lwin.list_rows);
+	assert_non_null(lwin.custom.unfolding);
+	validate_tree(&lwin);
+
+	wait_for_unfolding(&lwin);
+
+	assert_int_equal(12, lwin.list_rows);
+	validate_tree(&lwin);
+}
+
+TEST(tree_is_not_built_progressively_on_reload)
+{
+	assert_success(load_tree(&lwin, TEST_DATA_PATH "/tree", cwd));
+	assert_int_equal(12, lwin.list_rows);
+
+	tree_build_budget_ms = 0;
+	populate_dir_list(&lwin, /*reload=*/1);
+	tree_build_budget_ms = 250;
+
+	assert_null(lwin.custom.unfolding);
+	assert_int_equal(12, lwin.list_rows);
+}
+
+TEST(listing_of_unfolded_directory_is_dropped_on_reload)
+{
+	assert_success(load_limited_tree(&lwin, TEST_DATA_PATH "/tree", cwd, 0));
+	assert_int_equal(3, lwin.list_rows);
+
+	lwin.list_pos = 0;
+	flist_toggle_fold(&lwin);
+	assert_non_null(lwin.custom.unfolding);
+	flist_toggle_fold(&lwin);
+
+	populate_dir_list(&lwin, /*reload=*/1);
+	assert_null(lwin.custom.unfolding);
+	assert_int_equal(3, lwin.list_rows);
+	validate_tree(&lwin);
+}
+
 static void
 column_line_print(const char buf[], size_t offset, AlignType align,
 		const char full_column[], const format_info_t *info)
@@ -465,6 +542,9 @@ toggle_fold_and_update(view_t *view)
 {
 	flist_toggle_fold(view);
 
+	/* Subtree of an unfolded directory is listed in background. */
+	wait_for_unfolding(view);
+
 	validate_tree(&lwin);
 
 	curr_stats.load_stage = 2;
@@ -474,5 +554,15 @@ toggle_fold_and_update(view_t *view)
 	validate_tree(&lwin);
 }
 
+static void
+wait_for_unfolding(view_t *view)
+{
+	while(view->custom.unfolding != NULL)
+	{
+		usleep(1000);
+		flist_finish_unfolding(view);
+	}
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 : */
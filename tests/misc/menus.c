@@ -207,5 +207,52 @@ TEST(null_pattern_causes_pattern_reuse)
 	assert_int_equal(2, m.pos);
 }
 
+TEST(extending_literal_pattern_narrows_matches)
+{
+	m.len = add_to_string_array(&m.items, m.len, "ab");
+	m.len = add_to_string_array(&m.items, m.len, "abc");
+
+	menus_search_reset(m.state, 0, 0);
+	assert_success(menus_search("a", &m, 1));
+	assert_int_equal(3, menus_search_matched(m.state));
+	assert_success(menus_search("ab", &m, 1));
+	assert_int_equal(2, menus_search_matched(m.state));
+	assert_success(menus_search("abc", &m, 1));
+	assert_int_equal(1, menus_search_matched(m.state));
+	assert_success(menus_search("abcd", &m, 1));
+	assert_int_equal(0, menus_search_matched(m.state));
+
+	assert_success(menus_search("b", &m, 1));
+	assert_int_equal(3, menus_search_matched(m.state));
+	assert_success(menus_search("\\cB", &m, 1));
+	assert_int_equal(3, menus_search_matched(m.state));
+}
+
+TEST(large_menu_is_searched_in_parts)
+{
+	int i;
+	for(i = 0; i < 100000; ++i)
+	{
+		char item[32];
+		snprintf(item, sizeof(item), "item%d", i);
+		m.len = add_to_string_array(&m.items, m.len, item);
+	}
+
+	menus_search_reset(m.state, 0, 1);
+	assert_true(menus_search("99", &m, 1));
+	assert_int_equal(3 + 99, m.pos);
+	assert_int_equal(3691, menus_search_matched(m.state));
+
+	assert_true(menus_search("999", &m, 1));
+	assert_int_equal(3 + 999, m.pos);
+	assert_int_equal(280, menus_search_matched(m.state));
+
+	m.pos = m.len - 1;
+	menus_search_repeat(m.state, 1);
+	assert_int_equal(3 + 99998, m.pos);
+	menus_search_repeat(m.state, 1);
+	assert_int_equal(3 + 99997, m.pos);
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
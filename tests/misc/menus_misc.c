@@ -1,5 +1,7 @@
 #include <stic.h>
 
+#include <unistd.h> /* usleep() */
+
 #include <stddef.h> /* NULL */
 #include <string.h> /* strcpy() */
 
@@ -7,6 +9,8 @@
 
 #include "../../src/cfg/config.h"
 #include "../../src/engine/keys.h"
+#include "../../src/engine/mode.h"
+#include "../../src/menus/menus.h"
 #include "../../src/modes/menu.h"
 #include "../../src/modes/modes.h"
 #include "../../src/modes/wk.h"
@@ -101,6 +105,58 @@ TEST(menu_is_built_from_a_command_with_input, IF(have_cat))
 	undo_teardown();
 }
 
+TEST(menu_is_populated_while_command_runs, IF(not_windows))
+{
+	undo_setup();
+
+	assert_success(exec_commands("!echo first; sleep 0.5; echo second %m", &lwin,
+				CIT_COMMAND));
+
+	menu_data_t *m = menu_get_current();
+	assert_true(menus_is_loading(m->state));
+	assert_int_equal(1, m->len);
+	assert_string_equal("first", m->items[0]);
+
+	/* Search results are updated for new items. */
+	assert_int_equal(0, menus_search("second", m, 0));
+	assert_int_equal(0, menus_search_matched(m->state));
+
+	while(menus_is_loading(m->state))
+	{
+		modmenu_check_for_updates();
+		usleep(10000);
+	}
+
+	assert_int_equal(2, m->len);
+	assert_string_equal("second", m->items[1]);
+	assert_int_equal(1, menus_search_matched(m->state));
+
+	(void)vle_keys_exec(WK_ESC);
+	undo_teardown();
+}
+
+TEST(ctrl_c_stops_loading_of_menu, IF(not_windows))
+{
+	undo_setup();
+
+	assert_success(exec_commands("!echo first; sleep 1; echo second %m", &lwin,
+				CIT_COMMAND));
+
+	menu_data_t *m = menu_get_current();
+	assert_true(menus_is_loading(m->state));
+
+	(void)vle_keys_exec(WK_C_c);
+	assert_true(vle_mode_is(MENU_MODE));
+	assert_false(menus_is_loading(m->state));
+	assert_int_equal(1, m->len);
+	assert_string_equal("!echo first; sleep 1; echo second %m(cancelled)",
+			m->title);
+
+	(void)vle_keys_exec(WK_C_c);
+	assert_false(vle_mode_is(MENU_MODE));
+	undo_teardown();
+}
+
 TEST(menu_is_turned_into_cv)
 {
 	undo_setup();
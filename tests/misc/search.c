@@ -7,9 +7,11 @@
 #include <test-utils.h>
 
 #include "../../src/cfg/config.h"
+#include "../../src/compat/fs_limits.h"
 #include "../../src/modes/normal.h"
 #include "../../src/utils/fs.h"
 #include "../../src/filelist.h"
+#include "../../src/filtering.h"
 #include "../../src/search.h"
 
 static char *saved_cwd;
@@ -90,6 +92,79 @@ TEST(search_finds_matching_files_and_numbers_them)
 	assert_int_equal(2, lwin.dir_entry[2].search_match);
 }
 
+TEST(extending_pattern_narrows_and_renumbers_matches)
+{
+	int found;
+
+	find_pattern(&lwin, "o", 0, 0, &found, 0);
+	assert_true(found);
+	assert_int_equal(5, lwin.matches);
+
+	find_pattern(&lwin, "os-", 0, 0, &found, 0);
+	assert_true(found);
+	assert_int_equal(2, lwin.matches);
+
+	find_pattern(&lwin, "dos-l", 0, 0, &found, 0);
+	assert_true(found);
+	assert_int_equal(1, lwin.matches);
+	assert_int_equal(0, lwin.dir_entry[1].search_match);
+	assert_string_equal("dos-line-endings", lwin.dir_entry[2].name);
+	assert_int_equal(1, lwin.dir_entry[2].search_match);
+
+	find_pattern(&lwin, "-", 0, 0, &found, 0);
+	assert_true(found);
+	assert_int_equal(6, lwin.matches);
+}
+
+TEST(entries_appended_between_searches_are_matched)
+{
+	int found;
+	char path[PATH_MAX + 1];
+	dir_entry_t entry;
+
+	curr_view = &lwin;
+	other_view = &rwin;
+	opt_handlers_setup();
+
+	flist_custom_start(&lwin, "test");
+	make_abs_path(path, sizeof(path), TEST_DATA_PATH, "read/dos-eof", saved_cwd);
+	assert_non_null(flist_custom_add(&lwin, path));
+	assert_true(flist_custom_finish(&lwin, CV_VERY, 0) == 0);
+
+	find_pattern(&lwin, "os", 0, 0, &found, 0);
+	assert_true(found);
+	assert_int_equal(1, lwin.matches);
+
+	make_abs_path(path, sizeof(path), TEST_DATA_PATH, "read/dos-line-endings",
+			saved_cwd);
+	assert_success(fentry_load(&entry, path));
+	assert_non_null(flist_custom_append(&lwin, &entry));
+
+	find_pattern(&lwin, "os-", 0, 0, &found, 0);
+	assert_true(found);
+	assert_int_equal(2, lwin.matches);
+	assert_int_equal(1, lwin.dir_entry[0].search_match);
+	assert_int_equal(2, lwin.dir_entry[1].search_match);
+
+	opt_handlers_teardown();
+}
+
+TEST(entries_restored_by_local_filter_are_matched)
+{
+	int found;
+
+	assert_success(local_filter_set(&lwin, "eof"));
+	find_pattern(&lwin, "o", 0, 0, &found, 0);
+	assert_true(found);
+	assert_int_equal(1, lwin.matches);
+
+	local_filter_cancel(&lwin);
+
+	find_pattern(&lwin, "os-", 0, 0, &found, 0);
+	assert_true(found);
+	assert_int_equal(2, lwin.matches);
+}
+
 TEST(cursor_can_be_positioned_on_first_match)
 {
 	int found;
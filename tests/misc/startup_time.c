@@ -0,0 +1,60 @@
+#include <stic.h>
+
+#include <unistd.h> /* unlink() */
+
+#include <string.h> /* strstr() */
+
+#include "../../src/cfg/config.h"
+#include "../../src/ui/ui.h"
+#include "../../src/utils/str.h"
+#include "../../src/utils/string_array.h"
+#include "../../src/cmd_core.h"
+#include "../../src/startup_time.h"
+
+SETUP()
+{
+	init_commands();
+	lwin.selected_files = 0;
+	curr_view = &lwin;
+}
+
+TEARDOWN()
+{
+	stime_close();
+}
+
+TEST(nothing_is_recorded_by_default)
+{
+	stime_mark("phase");
+	stime_end(stime_begin(), "item");
+	assert_int_equal(0, stime_begin());
+}
+
+TEST(phases_and_sourced_files_are_recorded)
+{
+	const char *const script = TEST_DATA_PATH "/scripts/append-env.vifm";
+
+	assert_success(stime_open(SANDBOX_PATH "/startuptime"));
+	assert_failure(stime_open(SANDBOX_PATH "/startuptime"));
+
+	stime_mark("phase #%d", 1);
+	assert_success(cfg_source_file(script));
+	stime_close();
+
+	int nlines;
+	char **lines = read_file_of_lines(SANDBOX_PATH "/startuptime", &nlines);
+	assert_int_equal(8, nlines);
+	assert_string_equal("times in msec", lines[0]);
+	assert_string_equal("", lines[3]);
+	assert_true(ends_with(lines[4], ": --- VIFM STARTING ---"));
+	assert_true(ends_with(lines[5], ": phase #1"));
+	assert_true(strstr(lines[6], ": sourcing ") != NULL);
+	assert_true(ends_with(lines[6], script));
+	assert_true(ends_with(lines[7], ": --- VIFM STARTED ---"));
+	free_string_array(lines, nlines);
+
+	assert_success(unlink(SANDBOX_PATH "/startuptime"));
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,155 @@
+#include <stic.h>
+
+#include <stdio.h> /* remove() */
+#include <stdlib.h> /* atoi() */
+#include <string.h> /* strstr() */
+
+#include "../../src/compat/pthread.h"
+#include "../../src/utils/str.h"
+#include "../../src/utils/string_array.h"
+#include "../../src/trace.h"
+
+static void * trace_thread(void *arg);
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+static int started;
+
+SETUP()
+{
+	trace_reset();
+}
+
+TEARDOWN()
+{
+	trace_reset();
+}
+
+TEST(operations_are_counted)
+{
+	trace_stats_t stats;
+
+	trace_get_stats(TP_SORT_VIEW, &stats);
+	assert_string_equal("sort_view", stats.name);
+	assert_ulong_equal(0, stats.count);
+
+	trace_end(TP_SORT_VIEW, trace_begin());
+	trace_end(TP_SORT_VIEW, trace_begin() - 5000);
+
+	trace_get_stats(TP_SORT_VIEW, &stats);
+	assert_ulong_equal(2, stats.count);
+	assert_true(stats.max >= 5000);
+	assert_true(stats.total >= stats.max);
+
+	trace_get_stats(TP_DRAW_VIEW, &stats);
+	assert_ulong_equal(0, stats.count);
+}
+
+TEST(stats_are_formatted)
+{
+	trace_end(TP_IOR_CP, trace_begin() - 1500);
+
+	char buf[128];
+	trace_format_stats(TP_IOR_CP, buf, sizeof(buf));
+	assert_true(starts_with_lit(buf, "ior_cp: 1 calls, 1."));
+	assert_non_null(strstr(buf, " ms max"));
+}
+
+TEST(reset_clears_stats)
+{
+	trace_end(TP_IOR_RM, trace_begin());
+	trace_reset();
+
+	trace_stats_t stats;
+	trace_get_stats(TP_IOR_RM, &stats);
+	assert_ulong_equal(0, stats.count);
+	assert_int_equal(0, stats.total);
+	assert_int_equal(0, stats.max);
+}
+
+TEST(recent_operations_are_dumped)
+{
+	int i;
+	for(i = 0; i < 5000; ++i)
+	{
+		trace_end(i%2 == 0 ? TP_IOR_CP : TP_IOR_MV, trace_begin());
+	}
+
+	assert_success(trace_dump(SANDBOX_PATH "/trace.json"));
+
+	int nlines;
+	char **lines = read_file_of_lines(SANDBOX_PATH "/trace.json", &nlines);
+	assert_int_equal(4096 + 2, nlines);
+	assert_string_equal("{\"traceEvents\":[", lines[0]);
+	assert_true(starts_with_lit(lines[1], "{\"name\":\"ior_cp\",\"ph\":\"X\","));
+	assert_non_null(strstr(lines[1], ",\"pid\":1,\"tid\":"));
+	assert_true(ends_with(lines[1], "},"));
+	assert_true(starts_with_lit(lines[4096], "{\"name\":\"ior_mv\","));
+	assert_true(ends_with(lines[4096], "}"));
+	assert_string_equal("]}", lines[4097]);
+	free_string_array(lines, nlines);
+
+	assert_success(remove(SANDBOX_PATH "/trace.json"));
+}
+
+TEST(operations_of_threads_are_collected_separately)
+{
+	pthread_t ids[2];
+	int i;
+	started = 0;
+	for(i = 0; i < 2; ++i)
+	{
+		assert_success(pthread_create(&ids[i], NULL, &trace_thread, NULL));
+	}
+	for(i = 0; i < 2; ++i)
+	{
+		assert_success(pthread_join(ids[i], NULL));
+	}
+
+	trace_stats_t stats;
+	trace_get_stats(TP_BG_JOB, &stats);
+	assert_ulong_equal(2*5000, stats.count);
+
+	/* History of each thread is limited separately. */
+	assert_success(trace_dump(SANDBOX_PATH "/trace.json"));
+	int nlines;
+	char **lines = read_file_of_lines(SANDBOX_PATH "/trace.json", &nlines);
+	assert_int_equal(2*4096 + 2, nlines);
+	assert_false(atoi(strstr(lines[1], "\"tid\":") + 6) ==
+	             atoi(strstr(lines[nlines - 2], "\"tid\":") + 6));
+	free_string_array(lines, nlines);
+
+	assert_success(remove(SANDBOX_PATH "/trace.json"));
+}
+
+TEST(dump_fails_for_bad_path)
+{
+	assert_failure(trace_dump(SANDBOX_PATH "/no/such/file"));
+}
+
+static void *
+trace_thread(void *arg)
+{
+	/* Make sure that threads don't reuse each other's ring by getting one before
+	 * any of them finishes. */
+	trace_end(TP_BG_JOB, trace_begin());
+
+	pthread_mutex_lock(&lock);
+	++started;
+	pthread_cond_broadcast(&cond);
+	while(started < 2)
+	{
+		pthread_cond_wait(&cond, &lock);
+	}
+	pthread_mutex_unlock(&lock);
+
+	int i;
+	for(i = 1; i < 5000; ++i)
+	{
+		trace_end(TP_BG_JOB, trace_begin());
+	}
+	return NULL;
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -75,6 +75,30 @@ TEST(nonempty_ro_dir_is_removed, IF(not_windows))
 	assert_failure(rmdir("dir"));
 }
 
+TEST(symlinks_to_directories_are_not_followed, IF(not_windows))
+{
+	char trash[PATH_MAX + 1];
+	make_abs_path(trash, sizeof(trash), SANDBOX_PATH, "trash", saved_cwd);
+
+	create_dir("trash");
+	create_dir("target");
+	create_file("target/file");
+#ifndef _WIN32
+	assert_success(symlink("../target", "trash/link"));
+#endif
+
+	assert_success(trash_set_specs(trash));
+	trash_empty(trash);
+	wait_for_bg();
+
+	assert_failure(unlink("trash/link"));
+	remove_file("target/file");
+	remove_dir("target");
+	remove_dir("trash");
+
+	assert_success(trash_set_specs(sandbox));
+}
+
 TEST(trash_allows_multiple_files_with_same_original_path)
 {
 	char path[PATH_MAX + 1];
@@ -127,5 +151,103 @@ TEST(trash_dir_can_be_a_symlink, IF(not_windows))
 	remove_dir("dir");
 }
 
+TEST(entries_are_found_by_trash_name)
+{
+	assert_success(trash_set_specs(sandbox));
+
+	char trashed_1[PATH_MAX + 1], trashed_2[PATH_MAX + 1];
+	snprintf(trashed_1, sizeof(trashed_1), "%s/000_name", sandbox);
+	snprintf(trashed_2, sizeof(trashed_2), "%s/001_name", sandbox);
+
+	const int size = trash_list_size;
+
+	assert_success(trash_add_entry("/orig/1", trashed_1));
+	assert_success(trash_add_entry("/orig/2", trashed_2));
+	assert_success(trash_add_entry("/orig/3", trashed_2));
+	assert_int_equal(size + 3, trash_list_size);
+
+	trash_file_moved(trashed_1, "/orig/1");
+	assert_int_equal(size + 2, trash_list_size);
+	assert_false(trash_has_entry("/orig/1", trashed_1));
+
+	/* Both entries that share trash name are removed one by one. */
+	trash_file_moved(trashed_2, "/orig/2");
+	assert_int_equal(size + 1, trash_list_size);
+	trash_file_moved(trashed_2, "/orig/3");
+	assert_int_equal(size, trash_list_size);
+	assert_false(trash_has_entry("/orig/2", trashed_2));
+	assert_false(trash_has_entry("/orig/3", trashed_2));
+
+	/* Removing unknown entry does nothing. */
+	trash_file_moved(trashed_2, "/orig/2");
+	assert_int_equal(size, trash_list_size);
+}
+
+TEST(deep_tree_is_removed)
+{
+	char trash[PATH_MAX + 1];
+	make_abs_path(trash, sizeof(trash), SANDBOX_PATH, "trash", saved_cwd);
+
+	create_dir("trash");
+
+	char path[PATH_MAX + 1] = "trash";
+	int i;
+	for(i = 0; i < 100; ++i)
+	{
+		strcat(path, "/d");
+		create_dir(path);
+	}
+	strcat(path, "/file");
+	create_file(path);
+
+	assert_success(trash_set_specs(trash));
+	trash_empty(trash);
+	wait_for_bg();
+
+	assert_failure(rmdir("trash/d"));
+	remove_dir("trash");
+
+	assert_success(trash_set_specs(sandbox));
+}
+
+TEST(entries_are_kept_until_their_files_are_removed)
+{
+	char trash[PATH_MAX + 1];
+	make_abs_path(trash, sizeof(trash), SANDBOX_PATH, "trash", saved_cwd);
+
+	create_dir("trash");
+	create_file("trash/000_removed");
+
+	char removed[PATH_MAX + 1], kept[PATH_MAX + 1];
+	snprintf(removed, sizeof(removed), "%s/000_removed", trash);
+	snprintf(kept, sizeof(kept), "%s/000_kept", trash);
+
+	/* Get rid of entries left by other tests. */
+	trash_prune_emptied_entries();
+
+	assert_success(trash_set_specs(trash));
+	const int size = trash_list_size;
+	assert_success(trash_add_entry("/orig/removed", removed));
+	assert_success(trash_add_entry("/orig/kept", kept));
+
+	trash_empty(trash);
+	assert_int_equal(size + 2, trash_list_size);
+	wait_for_bg();
+	assert_int_equal(size + 2, trash_list_size);
+
+	/* As if emptying was cancelled before getting to this file. */
+	create_file("trash/000_kept");
+
+	trash_prune_emptied_entries();
+	assert_int_equal(size + 1, trash_list_size);
+	assert_false(trash_has_entry("/orig/removed", removed));
+	assert_true(trash_has_entry("/orig/kept", kept));
+
+	remove_file("trash/000_kept");
+	remove_dir("trash");
+
+	assert_success(trash_set_specs(sandbox));
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 : */
@@ -7,6 +7,7 @@
 
 #include <test-utils.h>
 
+#include "../../src/cfg/config.h"
 #include "../../src/engine/var.h"
 #include "../../src/engine/variables.h"
 #include "../../src/lua/vlua.h"
@@ -391,6 +392,29 @@ TEST(vcache_check_reports_correct_status)
 	assert_false(vcache_check(&is_previewed));
 }
 
+TEST(tree_statistics_are_updated_in_background)
+{
+	cfg.top_tree_stats = 1;
+	assert_success(stats_init(&cfg));
+
+	strlist_t lines = vcache_lookup(TEST_DATA_PATH "/tree", NULL, MF_NONE,
+			VK_TEXTUAL, /*max_lines=*/5, VC_ASYNC, &error);
+	assert_string_equal(NULL, error);
+	assert_int_equal(5, lines.nitems);
+	assert_string_equal("2+ directories, 1+ files", lines.items[0]);
+
+	assert_true(wait_for_cache());
+
+	lines = vcache_lookup(TEST_DATA_PATH "/tree", NULL, MF_NONE, VK_TEXTUAL,
+			/*max_lines=*/5, VC_ASYNC, &error);
+	assert_string_equal(NULL, error);
+	assert_int_equal(5, lines.nitems);
+	assert_string_equal("5 directories, 7 files", lines.items[0]);
+	assert_string_equal("tree/", lines.items[2]);
+
+	cfg.top_tree_stats = 0;
+}
+
 TEST(kill_all_async_previews_on_exit, IF(not_windows))
 {
 	var_t var = var_from_int(0);
@@ -1,9 +1,14 @@
 #include <stic.h>
 
-#include <unistd.h> /* rmdir() symlink() */
+#include <sys/stat.h> /* stat */
+#include <unistd.h> /* rmdir() symlink() usleep() */
 
 #include <limits.h> /* INT_MAX */
-#include <stdio.h> /* remove() */
+#include <stdint.h> /* uint64_t */
+#include <stdio.h> /* remove() snprintf() */
+#include <stdlib.h> /* free() */
+#include <string.h> /* strdup() */
+#include <time.h> /* time() */
 
 #include <test-utils.h>
 
@@ -12,7 +17,13 @@
 #include "../../src/compat/os.h"
 #include "../../src/ui/quickview.h"
 #include "../../src/utils/fs.h"
+#include "../../src/utils/str.h"
 #include "../../src/utils/string_array.h"
+#include "../../src/background.h"
+#include "../../src/status.h"
+
+static char * read_job_output(bg_job_t *job);
+static uint64_t get_inode(const char path[]);
 
 static char *saved_cwd;
 
@@ -30,51 +41,50 @@ TEARDOWN()
 
 TEST(file_can_not_be_viewed)
 {
-	assert_null(qv_view_dir(TEST_DATA_PATH "/existing-files/a", INT_MAX));
+	strlist_t lines;
+	bg_job_t *stats_job;
+	assert_failure(qv_view_dir(TEST_DATA_PATH "/existing-files/a", INT_MAX,
+				&lines, &stats_job));
 }
 
 TEST(empty_dir_produces_single_line_and_dirs_have_trailing_slash)
 {
-	int nlines;
-	FILE *fp;
-	char **lines;
+	strlist_t lines;
+	bg_job_t *stats_job;
 
 	assert_success(os_mkdir("empty-dir", 0777));
 
-	fp = qv_view_dir("empty-dir", INT_MAX);
-	lines = read_file_lines(fp, &nlines);
+	assert_success(qv_view_dir("empty-dir", INT_MAX, &lines, &stats_job));
+	assert_null(stats_job);
 
-	assert_int_equal(3, nlines);
-	assert_string_equal("empty-dir/", lines[0]);
-	assert_string_equal("", lines[1]);
-	assert_string_equal("0 directories, 0 files", lines[2]);
+	assert_int_equal(3, lines.nitems);
+	assert_string_equal("empty-dir/", lines.items[0]);
+	assert_string_equal("", lines.items[1]);
+	assert_string_equal("0 directories, 0 files", lines.items[2]);
 
-	free_string_array(lines, nlines);
-	fclose(fp);
+	free_string_array(lines.items, lines.nitems);
 
 	assert_success(rmdir("empty-dir"));
 }
 
 TEST(single_file_is_displayed_correctly_file_without_slash)
 {
-	int nlines;
-	FILE *fp;
-	char **lines;
+	strlist_t lines;
+	bg_job_t *stats_job;
 
 	assert_success(os_mkdir("dir", 0777));
 	create_file("dir/file");
 
-	fp = qv_view_dir("dir", INT_MAX);
-	lines = read_file_lines(fp, &nlines);
+	assert_success(qv_view_dir("dir", INT_MAX, &lines, &stats_job));
+	assert_null(stats_job);
 
-	assert_int_equal(4, nlines);
-	assert_string_equal("dir/", lines[0]);
-	assert_string_equal("`-- file", lines[1]);
-	assert_string_equal("", lines[2]);
-	assert_string_equal("0 directories, 1 file", lines[3]);
+	assert_int_equal(4, lines.nitems);
+	assert_string_equal("dir/", lines.items[0]);
+	assert_string_equal("`-- file", lines.items[1]);
+	assert_string_equal("", lines.items[2]);
+	assert_string_equal("0 directories, 1 file", lines.items[3]);
 
-	free_string_array(lines, nlines);
-	fclose(fp);
+	free_string_array(lines.items, lines.nitems);
 
 	assert_success(remove("dir/file"));
 	assert_success(rmdir("dir"));
@@ -82,24 +92,22 @@ TEST(single_file_is_displayed_correctly_file_without_slash)
 
 TEST(single_subdir_is_displayed_correctly)
 {
-	int nlines;
-	FILE *fp;
-	char **lines;
+	strlist_t lines;
+	bg_job_t *stats_job;
 
 	assert_success(os_mkdir("dir", 0777));
 	assert_success(os_mkdir("dir/nested", 0777));
 
-	fp = qv_view_dir("dir", INT_MAX);
-	lines = read_file_lines(fp, &nlines);
+	assert_success(qv_view_dir("dir", INT_MAX, &lines, &stats_job));
+	assert_null(stats_job);
 
-	assert_int_equal(4, nlines);
-	assert_string_equal("dir/", lines[0]);
-	assert_string_equal("`-- nested/", lines[1]);
-	assert_string_equal("", lines[2]);
-	assert_string_equal("1 directory, 0 files", lines[3]);
+	assert_int_equal(4, lines.nitems);
+	assert_string_equal("dir/", lines.items[0]);
+	assert_string_equal("`-- nested/", lines.items[1]);
+	assert_string_equal("", lines.items[2]);
+	assert_string_equal("1 directory, 0 files", lines.items[3]);
 
-	free_string_array(lines, nlines);
-	fclose(fp);
+	free_string_array(lines.items, lines.nitems);
 
 	assert_success(rmdir("dir/nested"));
 	assert_success(rmdir("dir"));
@@ -107,26 +115,24 @@ TEST(single_subdir_is_displayed_correctly)
 
 TEST(multiple_nested_dirs_treated_correctly)
 {
-	int nlines;
-	FILE *fp;
-	char **lines;
+	strlist_t lines;
+	bg_job_t *stats_job;
 
 	assert_success(os_mkdir("dir", 0777));
 	assert_success(os_mkdir("dir/nested1", 0777));
 	assert_success(os_mkdir("dir/nested1/nested2", 0777));
 
-	fp = qv_view_dir("dir", INT_MAX);
-	lines = read_file_lines(fp, &nlines);
+	assert_success(qv_view_dir("dir", INT_MAX, &lines, &stats_job));
+	assert_null(stats_job);
 
-	assert_int_equal(5, nlines);
-	assert_string_equal("dir/", lines[0]);
-	assert_string_equal("`-- nested1/", lines[1]);
-	assert_string_equal("    `-- nested2/", lines[2]);
-	assert_string_equal("", lines[3]);
-	assert_string_equal("2 directories, 0 files", lines[4]);
+	assert_int_equal(5, lines.nitems);
+	assert_string_equal("dir/", lines.items[0]);
+	assert_string_equal("`-- nested1/", lines.items[1]);
+	assert_string_equal("    `-- nested2/", lines.items[2]);
+	assert_string_equal("", lines.items[3]);
+	assert_string_equal("2 directories, 0 files", lines.items[4]);
 
-	free_string_array(lines, nlines);
-	fclose(fp);
+	free_string_array(lines.items, lines.nitems);
 
 	assert_success(rmdir("dir/nested1/nested2"));
 	assert_success(rmdir("dir/nested1"));
@@ -135,26 +141,24 @@ TEST(multiple_nested_dirs_treated_correctly)
 
 TEST(multiple_files_treated_correctly)
 {
-	int nlines;
-	FILE *fp;
-	char **lines;
+	strlist_t lines;
+	bg_job_t *stats_job;
 
 	assert_success(os_mkdir("dir", 0777));
 	create_file("dir/file1");
 	create_file("dir/file2");
 
-	fp = qv_view_dir("dir", INT_MAX);
-	lines = read_file_lines(fp, &nlines);
+	assert_success(qv_view_dir("dir", INT_MAX, &lines, &stats_job));
+	assert_null(stats_job);
 
-	assert_int_equal(5, nlines);
-	assert_string_equal("dir/", lines[0]);
-	assert_string_equal("|-- file1", lines[1]);
-	assert_string_equal("`-- file2", lines[2]);
-	assert_string_equal("", lines[3]);
-	assert_string_equal("0 directories, 2 files", lines[4]);
+	assert_int_equal(5, lines.nitems);
+	assert_string_equal("dir/", lines.items[0]);
+	assert_string_equal("|-- file1", lines.items[1]);
+	assert_string_equal("`-- file2", lines.items[2]);
+	assert_string_equal("", lines.items[3]);
+	assert_string_equal("0 directories, 2 files", lines.items[4]);
 
-	free_string_array(lines, nlines);
-	fclose(fp);
+	free_string_array(lines.items, lines.nitems);
 
 	assert_success(remove("dir/file2"));
 	assert_success(remove("dir/file1"));
@@ -163,9 +167,8 @@ TEST(multiple_files_treated_correctly)
 
 TEST(multiple_non_empty_dirs_have_correct_prefixes_plus_sorting)
 {
-	int nlines;
-	FILE *fp;
-	char **lines;
+	strlist_t lines;
+	bg_job_t *stats_job;
 
 	assert_success(os_mkdir("dir", 0777));
 	assert_success(os_mkdir("dir/sub1", 0777));
@@ -173,20 +176,19 @@ TEST(multiple_non_empty_dirs_have_correct_prefixes_plus_sorting)
 	create_file("dir/sub1/file");
 	create_file("dir/sub2/file");
 
-	fp = qv_view_dir("dir", INT_MAX);
-	lines = read_file_lines(fp, &nlines);
+	assert_success(qv_view_dir("dir", INT_MAX, &lines, &stats_job));
+	assert_null(stats_job);
 
-	assert_int_equal(7, nlines);
-	assert_string_equal("dir/", lines[0]);
-	assert_string_equal("|-- sub1/", lines[1]);
-	assert_string_equal("|   `-- file", lines[2]);
-	assert_string_equal("`-- sub2/", lines[3]);
-	assert_string_equal("    `-- file", lines[4]);
-	assert_string_equal("", lines[5]);
-	assert_string_equal("2 directories, 2 files", lines[6]);
+	assert_int_equal(7, lines.nitems);
+	assert_string_equal("dir/", lines.items[0]);
+	assert_string_equal("|-- sub1/", lines.items[1]);
+	assert_string_equal("|   `-- file", lines.items[2]);
+	assert_string_equal("`-- sub2/", lines.items[3]);
+	assert_string_equal("    `-- file", lines.items[4]);
+	assert_string_equal("", lines.items[5]);
+	assert_string_equal("2 directories, 2 files", lines.items[6]);
 
-	free_string_array(lines, nlines);
-	fclose(fp);
+	free_string_array(lines.items, lines.nitems);
 
 	assert_success(remove("dir/sub1/file"));
 	assert_success(remove("dir/sub2/file"));
@@ -197,9 +199,8 @@ TEST(multiple_non_empty_dirs_have_correct_prefixes_plus_sorting)
 
 TEST(symlinks_are_not_resolved_in_tree_preview, IF(not_windows))
 {
-	int nlines;
-	FILE *fp;
-	char **lines;
+	strlist_t lines;
+	bg_job_t *stats_job;
 
 	restore_cwd(saved_cwd);
 	saved_cwd = save_cwd();
@@ -211,17 +212,16 @@ TEST(symlinks_are_not_resolved_in_tree_preview, IF(not_windows))
 	assert_success(symlink(".", SANDBOX_PATH "/dir/link"));
 #endif
 
-	fp = qv_view_dir(SANDBOX_PATH "/dir", INT_MAX);
-	lines = read_file_lines(fp, &nlines);
+	assert_success(qv_view_dir(SANDBOX_PATH "/dir", INT_MAX, &lines, &stats_job));
+	assert_null(stats_job);
 
-	assert_int_equal(4, nlines);
-	assert_string_equal("dir/", lines[0]);
-	assert_string_equal("`-- link/ -> .", lines[1]);
-	assert_string_equal("", lines[2]);
-	assert_string_equal("1 directory, 0 files", lines[3]);
+	assert_int_equal(4, lines.nitems);
+	assert_string_equal("dir/", lines.items[0]);
+	assert_string_equal("`-- link/ -> .", lines.items[1]);
+	assert_string_equal("", lines.items[2]);
+	assert_string_equal("1 directory, 0 files", lines.items[3]);
 
-	free_string_array(lines, nlines);
-	fclose(fp);
+	free_string_array(lines.items, lines.nitems);
 
 	assert_success(unlink(SANDBOX_PATH "/dir/link"));
 	assert_success(rmdir(SANDBOX_PATH "/dir"));
@@ -230,9 +230,8 @@ TEST(symlinks_are_not_resolved_in_tree_preview, IF(not_windows))
 TEST(top_tree_stats)
 {
 	int i;
-	int nlines;
-	FILE *fp;
-	char **lines;
+	strlist_t lines;
+	bg_job_t *stats_job;
 
 	cfg.top_tree_stats = 1;
 
@@ -240,21 +239,20 @@ TEST(top_tree_stats)
 	assert_success(os_mkdir("dir/nested1", 0777));
 	assert_success(os_mkdir("dir/nested1/nested2", 0777));
 
-	fp = qv_view_dir("dir", INT_MAX);
-	lines = read_file_lines(fp, &nlines);
+	assert_success(qv_view_dir("dir", INT_MAX, &lines, &stats_job));
+	assert_null(stats_job);
 
-	assert_int_equal(5, nlines);
-	assert_string_equal("2 directories, 0 files", lines[0]);
-	for(i = 0; lines[1][i] != '\0'; ++i)
+	assert_int_equal(5, lines.nitems);
+	assert_string_equal("2 directories, 0 files", lines.items[0]);
+	for(i = 0; lines.items[1][i] != '\0'; ++i)
 	{
-		assert_true(lines[1][i] == ' ');
+		assert_true(lines.items[1][i] == ' ');
 	}
-	assert_string_equal("dir/", lines[2]);
-	assert_string_equal("`-- nested1/", lines[3]);
-	assert_string_equal("    `-- nested2/", lines[4]);
+	assert_string_equal("dir/", lines.items[2]);
+	assert_string_equal("`-- nested1/", lines.items[3]);
+	assert_string_equal("    `-- nested2/", lines.items[4]);
 
-	free_string_array(lines, nlines);
-	fclose(fp);
+	free_string_array(lines.items, lines.nitems);
 
 	assert_success(rmdir("dir/nested1/nested2"));
 	assert_success(rmdir("dir/nested1"));
@@ -266,31 +264,45 @@ TEST(top_tree_stats)
 TEST(top_tree_stats_in_small_window)
 {
 	int i;
-	int nlines;
-	FILE *fp;
-	char **lines;
+	strlist_t lines;
+	bg_job_t *stats_job;
 	char dir_path[PATH_MAX + 1];
 
 	cfg.top_tree_stats = 1;
+	update_string(&cfg.shell, "");
+	assert_success(stats_init(&cfg));
 
 	make_abs_path(dir_path, sizeof(dir_path), TEST_DATA_PATH, "tree", saved_cwd);
-	fp = qv_view_dir(dir_path, 5);
-	lines = read_file_lines(fp, &nlines);
+	assert_success(qv_view_dir(dir_path, 5, &lines, &stats_job));
+	assert_non_null(stats_job);
 
-	assert_int_equal(6, nlines);
-	assert_string_equal("5 directories, 7 files", lines[0]);
-	for(i = 0; lines[1][i] != '\0'; ++i)
+	assert_int_equal(6, lines.nitems);
+	assert_string_equal("2+ directories, 1+ files", lines.items[0]);
+	for(i = 0; lines.items[1][i] != '\0'; ++i)
 	{
-		assert_true(lines[1][i] == ' ');
+		assert_true(lines.items[1][i] == ' ');
 	}
-	assert_string_equal("tree/", lines[2]);
-	assert_string_equal("|-- .hidden", lines[3]);
-	assert_string_equal("|-- dir1/", lines[4]);
-	assert_string_equal("|   |-- dir2/", lines[5]);
-
-	free_string_array(lines, nlines);
-	fclose(fp);
-
+	assert_string_equal("tree/", lines.items[2]);
+	assert_string_equal("|-- .hidden", lines.items[3]);
+	assert_string_equal("|-- dir1/", lines.items[4]);
+	assert_string_equal("|   |-- dir2/", lines.items[5]);
+
+	free_string_array(lines.items, lines.nitems);
+
+	/* Statistics are finished in background. */
+	char *const output = read_job_output(stats_job);
+	assert_string_equal("5 directories, 7 files\n", output);
+	free(output);
+	bg_job_decref(stats_job);
+
+	/* Number of items of traversed directories is remembered. */
+	char path[PATH_MAX + 1];
+	snprintf(path, sizeof(path), "%s/dir5", dir_path);
+	uint64_t nitems;
+	dcache_get_at(path, time(NULL) - 10, get_inode(path), NULL, &nitems);
+	assert_ulong_equal(2, nitems);
+
+	update_string(&cfg.shell, NULL);
 	cfg.top_tree_stats = 0;
 }
 
@@ -302,18 +314,18 @@ TEST(depth_limit)
 	assert_success(os_mkdir("dir/nested1", 0777));
 	assert_success(os_mkdir("dir/nested1/nested2", 0777));
 
-	int nlines;
-	FILE *fp = qv_view_dir("dir", INT_MAX);
-	char **lines = read_file_lines(fp, &nlines);
+	strlist_t lines;
+	bg_job_t *stats_job;
+	assert_success(qv_view_dir("dir", INT_MAX, &lines, &stats_job));
+	assert_null(stats_job);
 
-	assert_int_equal(4, nlines);
-	assert_string_equal("dir/", lines[0]);
-	assert_string_equal("`-- nested1/", lines[1]);
-	assert_string_equal("", lines[2]);
-	assert_string_equal("1 directory, 0 files", lines[3]);
+	assert_int_equal(4, lines.nitems);
+	assert_string_equal("dir/", lines.items[0]);
+	assert_string_equal("`-- nested1/", lines.items[1]);
+	assert_string_equal("", lines.items[2]);
+	assert_string_equal("1 directory, 0 files", lines.items[3]);
 
-	free_string_array(lines, nlines);
-	fclose(fp);
+	free_string_array(lines.items, lines.nitems);
 
 	assert_success(rmdir("dir/nested1/nested2"));
 	assert_success(rmdir("dir/nested1"));
@@ -322,5 +334,43 @@ TEST(depth_limit)
 	cfg.max_tree_depth = 0;
 }
 
+/* Reads output of a job until its end.  Returns newly allocated string. */
+static char *
+read_job_output(bg_job_t *job)
+{
+	char *output = NULL;
+	size_t len = 0U;
+
+	int i;
+	for(i = 0; i < 500; ++i)
+	{
+		char buf[256];
+		const int n = bg_job_read_output(job, buf, sizeof(buf) - 1);
+		if(n < 0)
+		{
+			break;
+		}
+		if(n == 0)
+		{
+			usleep(10000);
+			continue;
+		}
+
+		buf[n] = '\0';
+		(void)strappend(&output, &len, buf);
+	}
+
+	return (output == NULL ? strdup("") : output);
+}
+
+/* Retrieves inode of a file.  Returns the inode. */
+static uint64_t
+get_inode(const char path[])
+{
+	struct stat st;
+	assert_success(os_stat(path, &st));
+	return st.st_ino;
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -22,6 +22,7 @@
 #include "../../src/filetype.h"
 #include "../../src/flist_hist.h"
 #include "../../src/opt_handlers.h"
+#include "../../src/registers.h"
 #include "../../src/status.h"
 
 SETUP_ONCE()
@@ -502,5 +503,64 @@ TEST(active_pane_is_respected_both_ways)
 	remove_file(SANDBOX_PATH "/vifminfo.json");
 }
 
+TEST(histories_and_registers_can_be_loaded_later)
+{
+	regs_init();
+
+	make_file(SANDBOX_PATH "/vifminfo.json",
+			"{\"cmd-hist\":[{\"text\":\"cmd1\"},{\"text\":\"cmd2\"}],"
+			"\"regs\":{\"a\":[\"/file\"]}}");
+
+	state_load_deferred();
+	assert_int_equal(0, curr_stats.cmd_hist.size);
+	assert_int_equal(0, regs_find('a')->nfiles);
+
+	state_load_rest();
+	assert_int_equal(2, curr_stats.cmd_hist.size);
+	assert_string_equal("cmd2", curr_stats.cmd_hist.items[0].text);
+	assert_int_equal(1, regs_find('a')->nfiles);
+
+	/* Nothing is loaded the second time. */
+	regs_clear('a');
+	state_load_rest();
+	assert_int_equal(0, regs_find('a')->nfiles);
+
+	regs_reset();
+	remove_file(SANDBOX_PATH "/vifminfo.json");
+}
+
+TEST(histories_loaded_later_are_not_extended)
+{
+	cfg_resize_histories(1);
+
+	make_file(SANDBOX_PATH "/vifminfo.json",
+			"{\"cmd-hist\":[{\"text\":\"cmd1\"},{\"text\":\"cmd2\"}]}");
+
+	state_load_deferred();
+	state_load_rest();
+	assert_int_equal(1, cfg.history_len);
+	assert_int_equal(1, curr_stats.cmd_hist.size);
+	assert_string_equal("cmd2", curr_stats.cmd_hist.items[0].text);
+
+	remove_file(SANDBOX_PATH "/vifminfo.json");
+}
+
+TEST(full_loading_drops_deferred_state)
+{
+	make_file(SANDBOX_PATH "/vifminfo.json",
+			"{\"cmd-hist\":[{\"text\":\"cmd1\"}]}");
+	state_load_deferred();
+
+	make_file(SANDBOX_PATH "/vifminfo.json",
+			"{\"cmd-hist\":[{\"text\":\"cmd2\"}]}");
+	state_load(0);
+	state_load_rest();
+
+	assert_int_equal(1, curr_stats.cmd_hist.size);
+	assert_string_equal("cmd2", curr_stats.cmd_hist.items[0].text);
+
+	remove_file(SANDBOX_PATH "/vifminfo.json");
+}
+
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
 /* vim: set cinoptions+=t0 filetype=c : */
@@ -0,0 +1,83 @@
+#include <stic.h>
+
+#include <string.h> /* strcmp() */
+
+#include "../../src/engine/functions.h"
+#include "../../src/engine/parsing.h"
+#include "../../src/engine/var.h"
+
+#include "asserts.h"
+
+static var_t counter(const call_info_t *call_info);
+static const char * getenv_value(const char name[]);
+
+static int called;
+static const char *env_value;
+
+SETUP()
+{
+	static const function_t function_a = { "a", "descr", {0,0}, &counter };
+
+	assert_success(function_register(&function_a));
+	init_parser(&getenv_value);
+
+	called = 0;
+	env_value = "first";
+}
+
+TEARDOWN()
+{
+	function_reset_all();
+	init_parser(NULL);
+}
+
+static var_t
+counter(const call_info_t *call_info)
+{
+	return var_from_int(++called);
+}
+
+static const char *
+getenv_value(const char name[])
+{
+	return (strcmp(name, "VAR") == 0) ? env_value : "";
+}
+
+TEST(functions_are_called_on_each_evaluation)
+{
+	ASSERT_OK("a() . ''", "1");
+	ASSERT_OK("a() . ''", "2");
+	ASSERT_OK("a() . ''", "3");
+}
+
+TEST(positions_are_restored_for_partially_parsed_input)
+{
+	const char input[] = "'a' . 'b' 'c'";
+	int i;
+
+	for(i = 0; i < 2; ++i)
+	{
+		var_t res_var = var_false();
+		assert_int_equal(PE_INVALID_EXPRESSION, parse(input, 0, &res_var));
+		assert_string_equal("'c'", get_last_parsed_char());
+		assert_true(is_prev_token_whitespace());
+		var_free(res_var);
+	}
+}
+
+TEST(state_dependent_values_are_not_reused)
+{
+	ASSERT_OK("$VAR . '!'", "first!");
+	env_value = "second";
+	ASSERT_OK("$VAR . '!'", "second!");
+}
+
+TEST(unregistered_functions_are_detected)
+{
+	ASSERT_OK("a() . 'x'", "1x");
+	function_reset_all();
+	ASSERT_FAIL("a() . 'x'", PE_INVALID_EXPRESSION);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -7,6 +7,7 @@
 struct view_t;
 
 int vifm_tests_exited;
+int vifm_tests_testing = 1;
 
 void
 vifm_reexec_startup_commands(void)
@@ -41,7 +42,7 @@ vifm_exit(int exit_code)
 int
 vifm_testing(void)
 {
-	return 1;
+	return vifm_tests_testing;
 }
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
@@ -3,6 +3,9 @@
 
 extern int vifm_tests_exited;
 
+/* Value returned by vifm_testing() stub, resetting it enables drawing. */
+extern int vifm_tests_testing;
+
 #endif /* VIFM_TESTS__TEST_SUPPORT__STUBS_H__ */
 
 /* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
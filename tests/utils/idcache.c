@@ -0,0 +1,116 @@
+#include <stic.h>
+
+#ifndef _WIN32
+
+#include <sys/types.h> /* gid_t uid_t */
+#include <grp.h> /* getgrgid() */
+#include <pwd.h> /* getpwuid() */
+#include <unistd.h> /* getgid() getuid() */
+
+#include <stdio.h> /* snprintf() */
+
+#include "../../src/utils/idcache.h"
+
+/* Id that most likely doesn't exist. */
+#define NO_ID 3999999999UL
+
+SETUP()
+{
+	idcache_reset(/*positive_ttl=*/600, /*negative_ttl=*/600);
+	(void)idcache_check();
+}
+
+TEARDOWN()
+{
+	idcache_reset(/*positive_ttl=*/600, /*negative_ttl=*/60);
+}
+
+TEST(user_name_is_resolved_in_background)
+{
+	const uid_t uid = getuid();
+	const struct passwd *const pw = getpwuid(uid);
+	assert_non_null(pw);
+
+	char num[32];
+	snprintf(num, sizeof(num), "%lu", (unsigned long)uid);
+
+	char buf[64];
+	assert_true(idcache_get(IK_USER, uid, buf, sizeof(buf)));
+	assert_string_equal(num, buf);
+
+	idcache_wait();
+	assert_true(idcache_check());
+	assert_false(idcache_check());
+
+	assert_false(idcache_get(IK_USER, uid, buf, sizeof(buf)));
+	assert_string_equal(pw->pw_name, buf);
+}
+
+TEST(group_name_is_resolved_synchronously_on_request)
+{
+	const gid_t gid = getgid();
+	const struct group *const gr = getgrgid(gid);
+	assert_non_null(gr);
+
+	idcache_resolve(IK_GROUP, gid);
+
+	char buf[64];
+	assert_false(idcache_get(IK_GROUP, gid, buf, sizeof(buf)));
+	assert_string_equal(gr->gr_name, buf);
+}
+
+TEST(users_and_groups_are_distinguished)
+{
+	idcache_resolve(IK_USER, 0);
+	idcache_resolve(IK_GROUP, 0);
+
+	char buf[64];
+	assert_false(idcache_get(IK_USER, 0, buf, sizeof(buf)));
+	assert_string_equal(getpwuid(0)->pw_name, buf);
+	assert_false(idcache_get(IK_GROUP, 0, buf, sizeof(buf)));
+	assert_string_equal(getgrgid(0)->gr_name, buf);
+}
+
+TEST(missing_ids_are_cached)
+{
+	char buf[64];
+
+	idcache_request(IK_USER, NO_ID);
+	idcache_wait();
+	assert_true(idcache_check());
+
+	assert_false(idcache_get(IK_USER, NO_ID, buf, sizeof(buf)));
+	assert_string_equal("3999999999", buf);
+
+	idcache_wait();
+	assert_false(idcache_check());
+}
+
+TEST(expired_records_are_refreshed)
+{
+	idcache_reset(/*positive_ttl=*/0, /*negative_ttl=*/0);
+
+	char buf[64];
+
+	idcache_resolve(IK_USER, 0);
+	assert_true(idcache_check());
+
+	/* Stale name is returned while it's being refreshed. */
+	assert_false(idcache_get(IK_USER, 0, buf, sizeof(buf)));
+	assert_string_equal(getpwuid(0)->pw_name, buf);
+
+	idcache_wait();
+	assert_true(idcache_check());
+}
+
+TEST(numbers_are_truncated_to_fit_buffer)
+{
+	char buf[4];
+	assert_true(idcache_get(IK_USER, NO_ID, buf, sizeof(buf)));
+	assert_string_equal("399", buf);
+}
+
+#endif
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
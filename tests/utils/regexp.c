@@ -94,6 +94,31 @@ TEST(case_sequences_are_respected)
 				/*ignore_case=*/1));
 }
 
+TEST(narrowing_of_literal_patterns_is_detected)
+{
+	assert_true(regexp_narrows("a", REG_EXTENDED, "ab", REG_EXTENDED));
+	assert_true(regexp_narrows("b", REG_EXTENDED, "abc", REG_EXTENDED));
+	assert_true(regexp_narrows("a", REG_EXTENDED | REG_ICASE, "ab",
+				REG_EXTENDED));
+	assert_true(regexp_narrows("a", REG_EXTENDED | REG_ICASE, "ab",
+				REG_EXTENDED | REG_ICASE));
+
+	assert_false(regexp_narrows("", REG_EXTENDED, "ab", REG_EXTENDED));
+	assert_false(regexp_narrows("ab", REG_EXTENDED, "a", REG_EXTENDED));
+	assert_false(regexp_narrows("ac", REG_EXTENDED, "abc", REG_EXTENDED));
+	assert_false(regexp_narrows("a", REG_EXTENDED, "ab",
+				REG_EXTENDED | REG_ICASE));
+}
+
+TEST(narrowing_of_non_literal_patterns_is_not_detected)
+{
+	assert_false(regexp_narrows("a", REG_EXTENDED, "a|b", REG_EXTENDED));
+	assert_false(regexp_narrows("a", REG_EXTENDED, "ab?", REG_EXTENDED));
+	assert_false(regexp_narrows("a", REG_EXTENDED, "ab*", REG_EXTENDED));
+	assert_false(regexp_narrows("a.", REG_EXTENDED, "a.b", REG_EXTENDED));
+	assert_false(regexp_narrows("a", REG_EXTENDED, "a\\c", REG_EXTENDED));
+}
+
 static int
 has_empty_regexps(void)
 {
@@ -0,0 +1,72 @@
+#include <stic.h>
+
+#include "../../src/utils/string_array.h"
+
+static void line_handler(const char line[], void *arg);
+
+static strlist_t lines;
+static line_splitter_t splitter;
+
+TEARDOWN()
+{
+	free_string_array(lines.items, lines.nitems);
+	lines.items = NULL;
+	lines.nitems = 0;
+
+	split_lines_reset(&splitter);
+}
+
+TEST(lines_are_completed_by_next_pieces)
+{
+	split_lines(&splitter, "fir", 3, 0, &line_handler, &lines);
+	assert_int_equal(0, lines.nitems);
+	split_lines(&splitter, "st\nsec", 6, 0, &line_handler, &lines);
+	assert_int_equal(1, lines.nitems);
+	split_lines(&splitter, "ond\n", 4, 0, &line_handler, &lines);
+	assert_int_equal(2, lines.nitems);
+
+	assert_string_equal("first", lines.items[0]);
+	assert_string_equal("second", lines.items[1]);
+}
+
+TEST(last_line_is_completed_by_final_call)
+{
+	split_lines(&splitter, "a\nb", 3, 0, &line_handler, &lines);
+	assert_int_equal(1, lines.nitems);
+	split_lines(&splitter, "", 0, 1, &line_handler, &lines);
+	assert_int_equal(2, lines.nitems);
+
+	assert_string_equal("a", lines.items[0]);
+	assert_string_equal("b", lines.items[1]);
+}
+
+TEST(split_dos_line_ending_is_handled)
+{
+	split_lines(&splitter, "a\r", 2, 0, &line_handler, &lines);
+	assert_int_equal(0, lines.nitems);
+	split_lines(&splitter, "\nb\r\n", 4, 1, &line_handler, &lines);
+	assert_int_equal(2, lines.nitems);
+
+	assert_string_equal("a", lines.items[0]);
+	assert_string_equal("b", lines.items[1]);
+}
+
+TEST(null_separator_is_sticky)
+{
+	split_lines(&splitter, "a\nb\0", 4, 0, &line_handler, &lines);
+	split_lines(&splitter, "c\nd", 3, 1, &line_handler, &lines);
+	assert_int_equal(2, lines.nitems);
+
+	assert_string_equal("a\nb", lines.items[0]);
+	assert_string_equal("c\nd", lines.items[1]);
+}
+
+static void
+line_handler(const char line[], void *arg)
+{
+	strlist_t *const list = arg;
+	list->nitems = add_to_string_array(&list->items, list->nitems, line);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */
@@ -67,6 +67,38 @@ TEST(length_is_less_or_equal_to_string_length, IF(utf8_locale))
 	}
 }
 
+TEST(long_ascii_strings_are_handled)
+{
+	const char str[] = "0123456789abcdefghij~\177";
+	assert_int_equal(22, utf8_strsw(str));
+	assert_int_equal(22, utf8_nstrlen(str));
+	assert_int_equal(13, utf8_nstrsnlen(str, 13));
+	assert_int_equal(13, utf8_strsnlen(str, 13));
+	assert_int_equal(22, utf8_strsnlen(str, 100));
+}
+
+TEST(control_characters_inside_long_strings)
+{
+	const char str[] = "0123456789\001abcdefgh";
+	assert_int_equal(20, utf8_strsw(str));
+	assert_int_equal(19, utf8_nstrlen(str));
+	assert_int_equal(10, utf8_nstrsnlen(str, 11));
+	assert_int_equal(11, utf8_nstrsnlen(str, 12));
+	assert_int_equal(10, utf8_strsnlen(str, 11));
+	assert_int_equal(11, utf8_strsnlen(str, 12));
+}
+
+TEST(wide_characters_inside_long_strings, IF(utf8_locale))
+{
+	const char str[] = "abcdefghij师klmnopqr";
+	assert_int_equal(20, utf8_strsw(str));
+	assert_int_equal(19, utf8_nstrlen(str));
+	assert_int_equal(10, utf8_nstrsnlen(str, 11));
+	assert_int_equal(13, utf8_nstrsnlen(str, 12));
+	assert_int_equal(10, utf8_strsnlen(str, 11));
+	assert_int_equal(14, utf8_strsnlen(str, 13));
+}
+
 #ifdef _WIN32
 
 TEST(utf16_roundtrip, IF(utf8_locale))
@@ -0,0 +1,151 @@
+#include <stic.h>
+
+#include <stdlib.h> /* qsort() */
+#include <string.h> /* strcmp() */
+
+#include <test-utils.h>
+
+#include "../../src/compat/pthread.h"
+#include "../../src/utils/cancellation.h"
+#include "../../src/utils/str.h"
+#include "../../src/utils/string_array.h"
+#include "../../src/utils/walker.h"
+
+static int visitor(const walker_entry_t *entry, void *arg);
+static int cancel_hook(void *arg);
+static void sort_paths(void);
+static int str_cmp(const void *a, const void *b);
+
+/* Protects the list of visited paths. */
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+/* Paths visited by the walker in the form "depth:path". */
+static strlist_t visited;
+
+SETUP()
+{
+	create_dir(SANDBOX_PATH "/a");
+	create_dir(SANDBOX_PATH "/a/b");
+	create_file(SANDBOX_PATH "/a/b/file");
+	create_dir(SANDBOX_PATH "/c");
+	create_file(SANDBOX_PATH "/c/file");
+	create_file(SANDBOX_PATH "/top");
+}
+
+TEARDOWN()
+{
+	free_string_array(visited.items, visited.nitems);
+	visited.items = NULL;
+	visited.nitems = 0;
+
+	remove_file(SANDBOX_PATH "/a/b/file");
+	remove_dir(SANDBOX_PATH "/a/b");
+	remove_dir(SANDBOX_PATH "/a");
+	remove_file(SANDBOX_PATH "/c/file");
+	remove_dir(SANDBOX_PATH "/c");
+	remove_file(SANDBOX_PATH "/top");
+}
+
+TEST(all_entries_are_visited_once)
+{
+	char *roots[] = { "." };
+	int descend = 1;
+	assert_success(walker_run(roots, 1, SANDBOX_PATH, 4, &visitor, &descend,
+				&no_cancellation));
+
+	sort_paths();
+	assert_int_equal(7, visited.nitems);
+	assert_string_equal("0:.", visited.items[0]);
+	assert_string_equal("1:./a", visited.items[1]);
+	assert_string_equal("1:./c", visited.items[2]);
+	assert_string_equal("1:./top", visited.items[3]);
+	assert_string_equal("2:./a/b", visited.items[4]);
+	assert_string_equal("2:./c/file", visited.items[5]);
+	assert_string_equal("3:./a/b/file", visited.items[6]);
+}
+
+TEST(visitor_controls_descending)
+{
+	char *roots[] = { "a", "c" };
+	int descend = 0;
+	assert_success(walker_run(roots, 2, SANDBOX_PATH, 2, &visitor, &descend,
+				&no_cancellation));
+
+	sort_paths();
+	assert_int_equal(2, visited.nitems);
+	assert_string_equal("0:a", visited.items[0]);
+	assert_string_equal("0:c", visited.items[1]);
+}
+
+TEST(roots_can_be_files)
+{
+	char *roots[] = { "top", "c/file" };
+	int descend = 1;
+	assert_success(walker_run(roots, 2, SANDBOX_PATH, 3, &visitor, &descend,
+				&no_cancellation));
+
+	sort_paths();
+	assert_int_equal(2, visited.nitems);
+	assert_string_equal("0:c/file", visited.items[0]);
+	assert_string_equal("0:top", visited.items[1]);
+}
+
+TEST(missing_roots_are_skipped)
+{
+	char *roots[] = { "no-such-root", "c" };
+	int descend = 1;
+	assert_success(walker_run(roots, 2, SANDBOX_PATH, 1, &visitor, &descend,
+				&no_cancellation));
+
+	sort_paths();
+	assert_int_equal(2, visited.nitems);
+	assert_string_equal("0:c", visited.items[0]);
+	assert_string_equal("1:c/file", visited.items[1]);
+}
+
+TEST(traversal_can_be_cancelled)
+{
+	char *roots[] = { "." };
+	int descend = 1;
+	const cancellation_t cancellation = { .hook = &cancel_hook };
+	assert_failure(walker_run(roots, 1, SANDBOX_PATH, 4, &visitor, &descend,
+				&cancellation));
+	assert_int_equal(0, visited.nitems);
+}
+
+/* Records visited entries.  Returns value pointed to by the arg. */
+static int
+visitor(const walker_entry_t *entry, void *arg)
+{
+	char *const record = format_str("%d:%s", entry->depth, entry->path);
+
+	pthread_mutex_lock(&lock);
+	visited.nitems = put_into_string_array(&visited.items, visited.nitems,
+			record);
+	pthread_mutex_unlock(&lock);
+
+	return *(int *)arg;
+}
+
+/* Cancellation hook that always requests cancellation.  Returns non-zero. */
+static int
+cancel_hook(void *arg)
+{
+	return 1;
+}
+
+/* Sorts list of visited paths to make it independent of order of visiting. */
+static void
+sort_paths(void)
+{
+	qsort(visited.items, visited.nitems, sizeof(*visited.items), &str_cmp);
+}
+
+/* qsort() comparer for strings.  Returns standard -1, 0, 1 for comparisons. */
+static int
+str_cmp(const void *a, const void *b)
+{
+	return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+/* vim: set tabstop=2 softtabstop=2 shiftwidth=2 noexpandtab cinoptions-=(0 : */
+/* vim: set cinoptions+=t0 filetype=c : */